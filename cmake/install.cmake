@@ -88,6 +88,7 @@ if (TFM_PARTITION_PROTECTED_STORAGE)
                         ${INTERFACE_INC_DIR}/psa/storage_common.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR}/psa)
     install(FILES       ${INTERFACE_INC_DIR}/tfm_ps_defs.h
+                        ${INTERFACE_INC_DIR}/tfm_ps_api.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR})
 endif()
 
@@ -96,6 +97,7 @@ if (TFM_PARTITION_INTERNAL_TRUSTED_STORAGE)
                         ${INTERFACE_INC_DIR}/psa/storage_common.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR}/psa)
     install(FILES       ${INTERFACE_INC_DIR}/tfm_its_defs.h
+                        ${INTERFACE_INC_DIR}/tfm_its_api.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR})
 endif()
 
@@ -43,6 +43,14 @@
 #define CRYPTO_ENGINE_BUF_SIZE                 0x3000
 #endif
 
+/*
+ * Use a TLSF allocator with bounded allocation time and low fragmentation on
+ * the crypto backend heap, instead of the default Mbed TLS allocator.
+ */
+#ifndef CRYPTO_ENGINE_HEAP_TLSF
+#define CRYPTO_ENGINE_HEAP_TLSF                0
+#endif
+
 /* The max number of concurrent operations that can be active (allocated) at any time in Crypto */
 #ifndef CRYPTO_CONC_OPER_NUM
 #define CRYPTO_CONC_OPER_NUM                   8
@@ -98,6 +106,32 @@
 #define CRYPTO_IOVEC_BUFFER_SIZE               5120
 #endif
 
+/*
+ * Size of the window used to stream single-part AEAD encryptions which don't
+ * fit in the internal scratch buffer. Set to 0 to reject such requests.
+ */
+#ifndef CRYPTO_AEAD_STREAM_CHUNK_SIZE
+#define CRYPTO_AEAD_STREAM_CHUNK_SIZE          256
+#endif
+
+/*
+ * Number of requests after which the Crypto service throughput statistics are
+ * reported. Set to 0 to disable the instrumentation. When enabled, the platform
+ * must provide CRYPTO_STATS_GET_CYCLES() returning a free running cycle count.
+ */
+#ifndef CRYPTO_STATS_REPORT_INTERVAL
+#define CRYPTO_STATS_REPORT_INTERVAL           0
+#endif
+
+/*
+ * Use precomputed comb tables of the curve generators, stored in ROM, to speed
+ * up fixed-base point multiplications such as ECDSA signing with the builtin
+ * keys. Costs 4n bytes of code per enabled n-bit curve (8n if n >= 384).
+ */
+#ifndef CRYPTO_ECP_FIXED_POINT_OPTIM
+#define CRYPTO_ECP_FIXED_POINT_OPTIM           0
+#endif
+
 /* Use stored NV seed to provide entropy */
 #ifndef CRYPTO_NV_SEED
 #define CRYPTO_NV_SEED                         1
@@ -174,11 +208,68 @@
 #define ITS_RAM_FS                             0
 #endif
 
-/* Validate filesystem metadata every time it is read from flash */
+/*
+ * Validate filesystem metadata every time it is read from flash. The metadata
+ * XOR is only maintained incrementally with ITS_FILE_INDEX, it is computed from
+ * the whole metadata block on each update otherwise.
+ */
 #ifndef ITS_VALIDATE_METADATA_FROM_FLASH
 #define ITS_VALIDATE_METADATA_FROM_FLASH       1
 #endif
 
+/* Index the file metadata in RAM to avoid scanning the whole table in flash */
+#ifndef ITS_FILE_INDEX
+#define ITS_FILE_INDEX                         1
+#endif
+
+/* Use the log-structured filesystem instead of the metadata block one */
+#ifndef ITS_FLASH_FS_LOG
+#define ITS_FLASH_FS_LOG                       0
+#endif
+
+/* The number of delta records of a file in the log-structured filesystem */
+#ifndef ITS_FLASH_FS_LOG_MAX_DELTAS
+#define ITS_FLASH_FS_LOG_MAX_DELTAS            4
+#endif
+
+/* Count the flash accesses of the ITS filesystems */
+#ifndef ITS_FLASH_FS_STATS
+#define ITS_FLASH_FS_STATS                     0
+#endif
+
+/* The number of blocks whose erases are counted by ITS_FLASH_FS_STATS */
+#ifndef ITS_FLASH_FS_STATS_MAX_BLOCKS
+#define ITS_FLASH_FS_STATS_MAX_BLOCKS          16
+#endif
+
+/*
+ * Size in bytes of the cache of flash lines shared by the ITS filesystems.
+ * Set to 0 to disable the cache.
+ */
+#ifndef ITS_FLASH_FS_CACHE_SIZE
+#define ITS_FLASH_FS_CACHE_SIZE                0
+#endif
+
+/* The size in bytes of a line of the ITS flash cache */
+#ifndef ITS_FLASH_FS_CACHE_LINE_SIZE
+#define ITS_FLASH_FS_CACHE_LINE_SIZE           64
+#endif
+
+/* Leave the scratch erases and log compactions to tfm_its_maintain() */
+#ifndef ITS_BACKGROUND_MAINTENANCE
+#define ITS_BACKGROUND_MAINTENANCE             0
+#endif
+
+/* Enable transactions committing several ITS writes and removals at once */
+#ifndef ITS_TRANSACTION
+#define ITS_TRANSACTION                        0
+#endif
+
+/* The maximum number of writes and removals staged in an ITS transaction */
+#ifndef ITS_TRANSACTION_MAX_OPS
+#define ITS_TRANSACTION_MAX_OPS                8
+#endif
+
 /* The maximum asset size to be stored in the Internal Trusted Storage */
 #ifndef ITS_MAX_ASSET_SIZE
 #define ITS_MAX_ASSET_SIZE                     512
@@ -192,6 +283,11 @@
 #define ITS_BUF_SIZE                           ITS_MAX_ASSET_SIZE
 #endif
 
+/* Size of the buffer holding the data staged in an ITS transaction */
+#ifndef ITS_TRANSACTION_BUF_SIZE
+#define ITS_TRANSACTION_BUF_SIZE               ITS_MAX_ASSET_SIZE
+#endif
+
 /* The maximum number of assets to be stored in the Internal Trusted Storage */
 #ifndef ITS_NUM_ASSETS
 #define ITS_NUM_ASSETS                         10
@@ -217,6 +313,11 @@
 #define TFM_ITS_ENC_NONCE_LENGTH               12
 #endif
 
+/* The size of the plaintext of each chunk of an encrypted ITS file */
+#ifndef ITS_ENCRYPTION_CHUNK_SIZE
+#define ITS_ENCRYPTION_CHUNK_SIZE              256
+#endif
+
 /* PS Partition Configs */
 
 /* Create flash FS if it doesn't exist for Protected Storage partition */
@@ -249,6 +350,70 @@
 #define PS_NUM_ASSETS                          10
 #endif
 
+/* Index the object table in RAM to avoid scanning it on each request */
+#ifndef PS_OBJ_TABLE_INDEX
+#define PS_OBJ_TABLE_INDEX                     1
+#endif
+
+/*
+ * Number of object table changes appended to a journal before the whole table
+ * is rewritten. Set to 0 to rewrite the table on each change.
+ */
+#ifndef PS_OBJ_TABLE_JOURNAL_SIZE
+#define PS_OBJ_TABLE_JOURNAL_SIZE              0
+#endif
+
+/*
+ * Number of object table changes which share one increment of the PS NV
+ * counters. Up to this number minus 1 of the latest changes can be rolled back.
+ */
+#ifndef PS_NV_COUNTER_BATCH_SIZE
+#define PS_NV_COUNTER_BATCH_SIZE               1
+#endif
+
+/*
+ * Number of object table entries per leaf of the hash tree which authenticates
+ * the object table, so that a change only hashes again the path of its leaf.
+ * The whole table is still checked when it is loaded. Set to 0 to
+ * authenticate the whole table at each change.
+ */
+#ifndef PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES
+#define PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES       0
+#endif
+
+/*
+ * The size of the plaintext of each chunk of an encrypted PS object. Set to 0
+ * to encrypt each object as a whole.
+ */
+#ifndef PS_ENCRYPTION_CHUNK_SIZE
+#define PS_ENCRYPTION_CHUNK_SIZE               0
+#endif
+
+/*
+ * The size of the window of plaintext through which the data of a PS object
+ * encrypted in chunks is streamed between the client and the storage. Set to 0
+ * to buffer each object as a whole.
+ */
+#ifndef PS_STREAM_WINDOW_SIZE
+#define PS_STREAM_WINDOW_SIZE                  0
+#endif
+
+/*
+ * Size in bytes of the cache of the plaintext data of recently read PS objects.
+ * Set to 0 to disable the cache.
+ */
+#ifndef PS_OBJECT_CACHE_SIZE
+#define PS_OBJECT_CACHE_SIZE                   0
+#endif
+
+/*
+ * Number of derived storage keys kept resident in the Crypto service for
+ * reuse by Protected Storage. Set to 0 to derive the key on every operation.
+ */
+#ifndef PS_CRYPTO_KEY_CACHE_SIZE
+#define PS_CRYPTO_KEY_CACHE_SIZE               2
+#endif
+
 /* The stack size of the Protected Storage Secure Partition */
 #ifndef PS_STACK_SIZE
 #define PS_STACK_SIZE                          0x700
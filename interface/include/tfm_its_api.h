@@ -0,0 +1,254 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file tfm_its_api.h
+ *
+ * \brief TF-M specific extensions of the PSA Internal Trusted Storage API.
+ *
+ *        A transaction stages writes and removals of the caller's assets in
+ *        the ITS service, and commits them together: after a power failure,
+ *        either all of them or none of them are applied. The service holds a
+ *        single transaction, so a client cannot start one while another
+ *        client has not committed or aborted its own, and only secure
+ *        partitions may use transactions. The transaction
+ *        functions are only available when the service is built with
+ *        ITS_TRANSACTION, they return PSA_ERROR_NOT_SUPPORTED otherwise.
+ *
+ *        The flash access counters of the service are available when it is
+ *        built with ITS_FLASH_FS_STATS, the flash cache counters when it is
+ *        built with ITS_FLASH_FS_CACHE_SIZE, and the background maintenance
+ *        when it is built with ITS_BACKGROUND_MAINTENANCE.
+ */
+
+#ifndef __TFM_ITS_API_H__
+#define __TFM_ITS_API_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "psa/error.h"
+#include "psa/storage_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Starts a transaction, discarding the writes and removals staged in a
+ *        transaction of the caller which has not been committed.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS              The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE      Another client has a transaction in
+ *                                  progress
+ * \retval PSA_ERROR_NOT_PERMITTED  The caller is a non-secure client
+ * \retval PSA_ERROR_NOT_SUPPORTED  Transactions are not supported
+ */
+psa_status_t tfm_its_transaction_begin(void);
+
+/**
+ * \brief Stages the creation or modification of a uid/value pair, with the
+ *        same semantics as psa_its_set().
+ *
+ * \param[in] uid           The identifier for the data
+ * \param[in] data_length   The size in bytes of the data in `p_data`
+ * \param[in] p_data        A buffer containing the data
+ * \param[in] create_flags  The flags that the data will be stored with
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                     The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE             The caller has no transaction in
+ *                                         progress
+ * \retval PSA_ERROR_NOT_PERMITTED         The operation failed because the
+ *                                         provided uid value was already
+ *                                         created with
+ *                                         PSA_STORAGE_FLAG_WRITE_ONCE, or
+ *                                         staged with it in the transaction,
+ *                                         or the caller is a non-secure
+ *                                         client
+ * \retval PSA_ERROR_INSUFFICIENT_MEMORY   The transaction cannot stage more
+ *                                         operations or data
+ */
+psa_status_t tfm_its_transaction_set(psa_storage_uid_t uid,
+                                     size_t data_length,
+                                     const void *p_data,
+                                     psa_storage_create_flags_t create_flags);
+
+/**
+ * \brief Stages the removal of a uid and its associated data, with the same
+ *        semantics as psa_its_remove().
+ *
+ * \param[in] uid  The `uid` value
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                    The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE            The caller has no transaction in
+ *                                        progress
+ * \retval PSA_ERROR_DOES_NOT_EXIST       The provided uid value was not found
+ *                                        in the storage nor in the transaction
+ * \retval PSA_ERROR_NOT_PERMITTED        The provided uid value was created
+ *                                        or staged in the transaction with
+ *                                        PSA_STORAGE_FLAG_WRITE_ONCE, or the
+ *                                        caller is a non-secure client
+ * \retval PSA_ERROR_INSUFFICIENT_MEMORY  The transaction cannot stage more
+ *                                        operations
+ */
+psa_status_t tfm_its_transaction_remove(psa_storage_uid_t uid);
+
+/**
+ * \brief Applies the staged writes and removals at once, and ends the
+ *        transaction whatever the result.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                     The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE             The caller has no transaction in
+ *                                         progress
+ * \retval PSA_ERROR_NOT_PERMITTED         The caller is a non-secure client
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE  There was insufficient space on the
+ *                                         storage medium
+ * \retval PSA_ERROR_NOT_SUPPORTED         The assets staged are spread over too
+ *                                         many storage blocks to be updated at
+ *                                         once. The transaction can be split.
+ * \retval PSA_ERROR_STORAGE_FAILURE       The physical storage has failed
+ *                                         (Fatal error)
+ */
+psa_status_t tfm_its_transaction_commit(void);
+
+/**
+ * \brief Ends the transaction without applying the staged writes and
+ *        removals.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS              The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE      The caller has no transaction in progress
+ * \retval PSA_ERROR_NOT_PERMITTED  The caller is a non-secure client
+ */
+psa_status_t tfm_its_transaction_abort(void);
+
+/**
+ * \brief Flash access counters of the ITS filesystem, counted since boot.
+ *
+ *        The write amplification of the filesystem is prog_bytes / user_bytes.
+ */
+struct tfm_its_stats_t {
+    uint32_t num_blocks;         /*!< Number of blocks of the filesystem */
+    uint32_t num_counted_blocks; /*!< Number of blocks whose erases are
+                                  *   counted individually
+                                  */
+    uint32_t read_bytes;         /*!< Bytes read from flash */
+    uint32_t prog_bytes;         /*!< Bytes programmed to flash */
+    uint32_t user_bytes;         /*!< Bytes of asset data written */
+    uint32_t moved_bytes;        /*!< Bytes copied from one block to another
+                                  *   by the filesystem
+                                  */
+    uint32_t erases;             /*!< Blocks erased */
+    uint32_t metablock_swaps;    /*!< Metadata block swaps */
+    uint32_t compactions;        /*!< Compactions of the log-structured
+                                  *   filesystem
+                                  */
+};
+
+/**
+ * \brief Gets the flash access counters of the filesystem storing the
+ *        caller's assets.
+ *
+ * \note The counters include the accesses made for all the clients of the
+ *       filesystem, so only secure partitions can read them. They are meant
+ *       for debug and characterisation builds.
+ *
+ * \param[out] p_stats          Counters of the filesystem
+ * \param[out] p_block_erases   Buffer to store the number of erases of each
+ *                              block, from block 0. The first
+ *                              `num_counted_blocks` entries are written. Can
+ *                              be NULL if `num_blocks` is 0.
+ * \param[in]  num_blocks       Number of entries in `p_block_erases`
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_INVALID_ARGUMENT  `p_stats` is NULL
+ * \retval PSA_ERROR_NOT_PERMITTED     The caller is a non-secure client
+ * \retval PSA_ERROR_NOT_SUPPORTED     The counters are not supported
+ */
+psa_status_t tfm_its_get_stats(struct tfm_its_stats_t *p_stats,
+                               uint32_t *p_block_erases,
+                               size_t num_blocks);
+
+/**
+ * \brief Counters of the flash cache of the ITS service for a filesystem,
+ *        counted since boot.
+ *
+ *        The cache is shared by the filesystems of the service. The hit rate
+ *        of the filesystem is hits / (hits + misses).
+ */
+struct tfm_its_cache_stats_t {
+    uint32_t capacity;      /*!< Size of the cache in bytes */
+    uint32_t line_size;     /*!< Size of a line of the cache in bytes */
+    uint32_t num_lines;     /*!< Lines of the cache holding flash content of
+                             *   the filesystem
+                             */
+    uint32_t hits;          /*!< Lines read from the cache */
+    uint32_t misses;        /*!< Lines read from flash into the cache */
+    uint32_t bypasses;      /*!< Reads too large to be cached */
+    uint32_t evictions;     /*!< Lines evicted to make room for others */
+    uint32_t invalidations; /*!< Lines dropped as their flash content was
+                             *   programmed or erased
+                             */
+};
+
+/**
+ * \brief Gets the counters of the flash cache for the filesystem storing the
+ *        caller's assets.
+ *
+ * \note The counters include the reads made for all the clients of the
+ *       filesystem, so only secure partitions can read them. They are meant
+ *       for debug and characterisation builds.
+ *
+ * \param[out] p_stats  Counters of the cache
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_INVALID_ARGUMENT  `p_stats` is NULL
+ * \retval PSA_ERROR_NOT_PERMITTED     The caller is a non-secure client
+ * \retval PSA_ERROR_NOT_SUPPORTED     The cache is not enabled
+ */
+psa_status_t tfm_its_get_cache_stats(struct tfm_its_cache_stats_t *p_stats);
+
+/**
+ * \brief Performs ahead of time the flash maintenance of the filesystems of
+ *        the service, so that the following writes do not have to: erasing
+ *        the scratch blocks of the metadata block filesystem, or compacting
+ *        the oldest block and erasing the next free block of the
+ *        log-structured filesystem.
+ *
+ * \note This function is meant to be called when the system is idle, for
+ *       instance from the idle hook of the NS RTOS. Each call does a bounded
+ *       amount of work, of a few block erases at most, and returns
+ *       immediately if there is nothing to do.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_NOT_SUPPORTED    The background maintenance is not
+ *                                    supported
+ * \retval PSA_ERROR_STORAGE_FAILURE  The physical storage has failed
+ *                                    (Fatal error)
+ */
+psa_status_t tfm_its_maintain(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFM_ITS_API_H__ */
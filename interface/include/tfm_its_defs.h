@@ -20,6 +20,14 @@ extern "C" {
 #define TFM_ITS_GET                1002
 #define TFM_ITS_GET_INFO           1003
 #define TFM_ITS_REMOVE             1004
+#define TFM_ITS_TXN_BEGIN          1005
+#define TFM_ITS_TXN_SET            1006
+#define TFM_ITS_TXN_REMOVE         1007
+#define TFM_ITS_TXN_COMMIT         1008
+#define TFM_ITS_TXN_ABORT          1009
+#define TFM_ITS_GET_STATS          1010
+#define TFM_ITS_MAINTAIN           1011
+#define TFM_ITS_GET_CACHE_STATS    1012
 
 #ifdef __cplusplus
 }
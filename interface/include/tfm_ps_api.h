@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file tfm_ps_api.h
+ *
+ * \brief TF-M specific extensions of the PSA Protected Storage API.
+ *
+ *        The counters of the cache of plaintext objects are available when
+ *        the service is built with a non-zero PS_OBJECT_CACHE_SIZE.
+ */
+
+#ifndef __TFM_PS_API_H__
+#define __TFM_PS_API_H__
+
+#include <stdint.h>
+
+#include "psa/error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Counters of the PS object cache, counted since boot.
+ *
+ *        The hit rate of the cache is hits / (hits + misses).
+ */
+struct tfm_ps_cache_stats_t {
+    uint32_t capacity;      /*!< Size of the cache in bytes */
+    uint32_t used_bytes;    /*!< Bytes of object data in the cache */
+    uint32_t num_objects;   /*!< Number of objects in the cache */
+    uint32_t hits;          /*!< Reads served from the cache */
+    uint32_t misses;        /*!< Reads of objects which were not cached */
+    uint32_t evictions;     /*!< Objects evicted to make room for others */
+    uint32_t invalidations; /*!< Objects removed as they were written or
+                             *   removed
+                             */
+    uint32_t wipes;         /*!< Times the whole cache was wiped */
+};
+
+/**
+ * \brief Gets the counters of the PS object cache.
+ *
+ * \note The counters include the reads made by all the clients of the
+ *       service, so only secure partitions can read them. They are meant for
+ *       debug and characterisation builds.
+ *
+ * \param[out] p_stats  Counters of the cache
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_INVALID_ARGUMENT  `p_stats` is NULL
+ * \retval PSA_ERROR_NOT_PERMITTED     The caller is a non-secure client
+ * \retval PSA_ERROR_NOT_SUPPORTED     The cache is not enabled
+ */
+psa_status_t tfm_ps_get_cache_stats(struct tfm_ps_cache_stats_t *p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFM_PS_API_H__ */
@@ -21,6 +21,7 @@ extern "C" {
 #define TFM_PS_GET_INFO           1003
 #define TFM_PS_REMOVE             1004
 #define TFM_PS_GET_SUPPORT        1005
+#define TFM_PS_GET_CACHE_STATS    1006
 
 #ifdef __cplusplus
 }
@@ -8,6 +8,7 @@
 #include "psa/client.h"
 #include "psa/internal_trusted_storage.h"
 #include "psa_manifest/sid.h"
+#include "tfm_its_api.h"
 #include "tfm_its_defs.h"
 
 struct rot_psa_its_storage_info_t {
@@ -115,3 +116,92 @@ psa_status_t psa_its_remove(psa_storage_uid_t uid)
 
     return status;
 }
+
+psa_status_t tfm_its_transaction_begin(void)
+{
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_TXN_BEGIN, NULL, 0, NULL, 0);
+}
+
+psa_status_t tfm_its_transaction_set(psa_storage_uid_t uid,
+                                     size_t data_length,
+                                     const void *p_data,
+                                     psa_storage_create_flags_t create_flags)
+{
+    psa_status_t status;
+
+    psa_invec in_vec[] = {
+        { .base = &uid, .len = sizeof(uid) },
+        { .base = p_data, .len = data_length },
+        { .base = &create_flags, .len = sizeof(create_flags) }
+    };
+
+    status = psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                      TFM_ITS_TXN_SET, in_vec, IOVEC_LEN(in_vec), NULL, 0);
+
+    return status;
+}
+
+psa_status_t tfm_its_transaction_remove(psa_storage_uid_t uid)
+{
+    psa_status_t status;
+
+    psa_invec in_vec[] = {
+        { .base = &uid, .len = sizeof(uid) }
+    };
+
+    status = psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                      TFM_ITS_TXN_REMOVE, in_vec, IOVEC_LEN(in_vec), NULL, 0);
+
+    return status;
+}
+
+psa_status_t tfm_its_transaction_commit(void)
+{
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_TXN_COMMIT, NULL, 0, NULL, 0);
+}
+
+psa_status_t tfm_its_transaction_abort(void)
+{
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_TXN_ABORT, NULL, 0, NULL, 0);
+}
+
+psa_status_t tfm_its_get_stats(struct tfm_its_stats_t *p_stats,
+                               uint32_t *p_block_erases,
+                               size_t num_blocks)
+{
+    psa_outvec out_vec[] = {
+        { .base = p_stats, .len = sizeof(*p_stats) },
+        { .base = p_block_erases, .len = num_blocks * sizeof(uint32_t) }
+    };
+
+    if (p_stats == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_GET_STATS, NULL, 0, out_vec, IOVEC_LEN(out_vec));
+}
+
+psa_status_t tfm_its_get_cache_stats(struct tfm_its_cache_stats_t *p_stats)
+{
+    psa_outvec out_vec[] = {
+        { .base = p_stats, .len = sizeof(*p_stats) }
+    };
+
+    if (p_stats == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_GET_CACHE_STATS, NULL, 0, out_vec,
+                    IOVEC_LEN(out_vec));
+}
+
+psa_status_t tfm_its_maintain(void)
+{
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_MAINTAIN, NULL, 0, NULL, 0);
+}
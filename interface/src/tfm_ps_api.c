@@ -8,6 +8,7 @@
 #include "psa/client.h"
 #include "psa/protected_storage.h"
 #include "psa_manifest/sid.h"
+#include "tfm_ps_api.h"
 #include "tfm_ps_defs.h"
 
 struct rot_psa_ps_storage_info_t {
@@ -154,3 +155,18 @@ uint32_t psa_ps_get_support(void)
 
     return support_flags;
 }
+
+psa_status_t tfm_ps_get_cache_stats(struct tfm_ps_cache_stats_t *p_stats)
+{
+    psa_outvec out_vec[] = {
+        { .base = p_stats, .len = sizeof(*p_stats) }
+    };
+
+    if (p_stats == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    return psa_call(TFM_PROTECTED_STORAGE_SERVICE_HANDLE,
+                    TFM_PS_GET_CACHE_STATS, NULL, 0, out_vec,
+                    IOVEC_LEN(out_vec));
+}
@@ -537,7 +537,7 @@
 #define MBEDTLS_HAVE_ASM
 
 /* ECP options */
-#define MBEDTLS_ECP_FIXED_POINT_OPTIM        0 /**< Disable fixed-point speed-up */
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM        CRYPTO_ECP_FIXED_POINT_OPTIM
 
 /** \} name SECTION: Builtin drivers */
 
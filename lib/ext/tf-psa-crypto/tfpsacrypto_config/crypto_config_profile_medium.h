@@ -627,7 +627,7 @@
 #define MBEDTLS_SHA256_SMALLER
 
 /* ECP options */
-#define MBEDTLS_ECP_FIXED_POINT_OPTIM        0 /**< Disable fixed-point speed-up */
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM        CRYPTO_ECP_FIXED_POINT_OPTIM
 
 /** \} name SECTION: Builtin drivers */
 
@@ -0,0 +1,258 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host tests of the TLSF heap of the Crypto service. The soak test runs a
+ * long random sequence of allocations and frees of mixed sizes on a heap of
+ * CRYPTO_ENGINE_BUF_SIZE bytes, checking that the blocks are zeroed, aligned
+ * and not overwritten by other blocks, and that the heap coalesces back to a
+ * single free block once everything is freed. The other tests check the
+ * corner cases of calloc and free, and the statistics of the heap.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "crypto_heap.h"
+
+/* Number of random operations of the soak test, and of live blocks */
+#define TEST_NUM_OPS         2000000u
+#define TEST_NUM_BLOCKS      64u
+
+/* Most blocks are small, like the bignums of ECC, some are large like the
+ * RSA contexts
+ */
+#define TEST_SMALL_MAX       64u
+#define TEST_LARGE_MAX       1024u
+
+/* The buffer is given misaligned, as a static buffer of the target may be */
+#define TEST_BUF_OFFSET      3u
+
+static uint8_t heap_buf[CRYPTO_ENGINE_BUF_SIZE + TEST_BUF_OFFSET];
+
+static uint32_t rand_state;
+static uint32_t failures;
+
+#define TEST_CHECK(cond, ...)                               \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            failures++;                                     \
+            fprintf(stderr, "%s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            return -1;                                      \
+        }                                                   \
+    } while (0)
+
+static uint32_t test_rand(void)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+static int start(uint32_t seed)
+{
+    rand_state = seed;
+
+    TEST_CHECK(tfm_crypto_heap_init(heap_buf + TEST_BUF_OFFSET,
+                                    CRYPTO_ENGINE_BUF_SIZE) == 0,
+               "cannot initialise the heap");
+
+    return 0;
+}
+
+/* Checks that the heap is back to a single free block */
+static int check_empty(void)
+{
+    struct tfm_crypto_heap_stats_t stats;
+
+    tfm_crypto_heap_get_stats(&stats);
+    TEST_CHECK(stats.used == 0, "%zu bytes still used", stats.used);
+    TEST_CHECK(stats.largest_free == stats.total,
+               "largest free block of %zu bytes out of %zu",
+               stats.largest_free, stats.total);
+
+    return 0;
+}
+
+static int test_soak(void)
+{
+    static uint8_t *blocks[TEST_NUM_BLOCKS];
+    static size_t sizes[TEST_NUM_BLOCKS];
+    struct tfm_crypto_heap_stats_t stats;
+    uint32_t allocs = 0;
+    uint32_t n;
+    uint32_t i;
+    size_t k;
+
+    if (start(1) != 0) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_OPS; n++) {
+        i = test_rand() % TEST_NUM_BLOCKS;
+
+        if (blocks[i] != NULL) {
+            for (k = 0; k < sizes[i]; k++) {
+                TEST_CHECK(blocks[i][k] == (uint8_t)i,
+                           "block %u overwritten at %zu", i, k);
+            }
+            tfm_crypto_heap_free(blocks[i]);
+            blocks[i] = NULL;
+            continue;
+        }
+
+        sizes[i] = 1 + (test_rand() % (((test_rand() % 8) != 0) ?
+                                       TEST_SMALL_MAX : TEST_LARGE_MAX));
+        blocks[i] = tfm_crypto_heap_calloc(1, sizes[i]);
+        if (blocks[i] == NULL) {
+            /* The heap is full, which is counted as a failure */
+            continue;
+        }
+        allocs++;
+
+        TEST_CHECK(((uintptr_t)blocks[i] & 7u) == 0,
+                   "block %u is not aligned", i);
+        for (k = 0; k < sizes[i]; k++) {
+            TEST_CHECK(blocks[i][k] == 0, "block %u is not zeroed", i);
+        }
+        (void)memset(blocks[i], (int)i, sizes[i]);
+    }
+
+    for (i = 0; i < TEST_NUM_BLOCKS; i++) {
+        tfm_crypto_heap_free(blocks[i]);
+        blocks[i] = NULL;
+    }
+
+    tfm_crypto_heap_get_stats(&stats);
+    TEST_CHECK(stats.allocs == allocs, "%u allocations counted instead of %u",
+               stats.allocs, allocs);
+    TEST_CHECK(stats.peak <= CRYPTO_ENGINE_BUF_SIZE, "peak of %zu bytes",
+               stats.peak);
+    printf("soak: %u allocations, %u failures, peak of %zu bytes\n",
+           stats.allocs, stats.failures, stats.peak);
+
+    return check_empty();
+}
+
+static int test_calloc_zero(void)
+{
+    struct tfm_crypto_heap_stats_t stats;
+
+    if (start(2) != 0) {
+        return -1;
+    }
+
+    TEST_CHECK(tfm_crypto_heap_calloc(0, 16) == NULL,
+               "an allocation of 0 elements is not NULL");
+    TEST_CHECK(tfm_crypto_heap_calloc(16, 0) == NULL,
+               "an allocation of 0 bytes is not NULL");
+    TEST_CHECK(tfm_crypto_heap_calloc(0, 0) == NULL,
+               "an empty allocation is not NULL");
+
+    tfm_crypto_heap_get_stats(&stats);
+    TEST_CHECK(stats.allocs == 0 && stats.failures == 0,
+               "empty allocations counted as %u allocations, %u failures",
+               stats.allocs, stats.failures);
+
+    return check_empty();
+}
+
+static int test_failures(void)
+{
+    struct tfm_crypto_heap_stats_t stats;
+    uint8_t *blocks[CRYPTO_ENGINE_BUF_SIZE / 256];
+    uint32_t num_blocks = 0;
+    uint32_t i;
+
+    if (start(3) != 0) {
+        return -1;
+    }
+
+    TEST_CHECK(tfm_crypto_heap_calloc(SIZE_MAX / 2, 4) == NULL,
+               "an overflowing allocation is not NULL");
+    TEST_CHECK(tfm_crypto_heap_calloc(1, CRYPTO_ENGINE_BUF_SIZE) == NULL,
+               "an allocation larger than the heap is not NULL");
+
+    /* Fill the heap */
+    while (num_blocks < sizeof(blocks) / sizeof(blocks[0])) {
+        blocks[num_blocks] = tfm_crypto_heap_calloc(1, 256);
+        if (blocks[num_blocks] == NULL) {
+            break;
+        }
+        num_blocks++;
+    }
+    TEST_CHECK(num_blocks < sizeof(blocks) / sizeof(blocks[0]),
+               "the heap is not full after %u blocks", num_blocks);
+
+    tfm_crypto_heap_get_stats(&stats);
+    TEST_CHECK(stats.failures == 3, "%u failures counted instead of 3",
+               stats.failures);
+    TEST_CHECK(stats.allocs == num_blocks,
+               "%u allocations counted instead of %u", stats.allocs,
+               num_blocks);
+    TEST_CHECK(stats.peak == stats.used, "peak of %zu bytes, %zu used",
+               stats.peak, stats.used);
+
+    /* Free every other block, then a double free, then the others */
+    for (i = 0; i < num_blocks; i += 2) {
+        tfm_crypto_heap_free(blocks[i]);
+    }
+    tfm_crypto_heap_free(blocks[0]);
+    tfm_crypto_heap_free(NULL);
+    for (i = 1; i < num_blocks; i += 2) {
+        tfm_crypto_heap_free(blocks[i]);
+    }
+
+    return check_empty();
+}
+
+static int test_init(void)
+{
+    TEST_CHECK(tfm_crypto_heap_init(NULL, CRYPTO_ENGINE_BUF_SIZE) != 0,
+               "a heap is initialised without a buffer");
+    TEST_CHECK(tfm_crypto_heap_init(heap_buf, 16) != 0,
+               "a heap is initialised on 16 bytes");
+
+    if (start(4) != 0) {
+        return -1;
+    }
+
+    return check_empty();
+}
+
+static const struct {
+    const char *name;
+    int (*run)(void);
+} tests[] = {
+    { "soak", test_soak },
+    { "calloc_zero", test_calloc_zero },
+    { "failures", test_failures },
+    { "init", test_init },
+};
+
+int main(int argc, char *argv[])
+{
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if ((argc > 1) && (strcmp(argv[1], tests[i].name) != 0)) {
+            continue;
+        }
+
+        ret = tests[i].run();
+        printf("%s: %s\n", tests[i].name, (ret == 0) ? "PASS" : "FAIL");
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -10,6 +10,7 @@
 
 #include "config_tfm.h"
 #include "coverity_check.h"
+#include "psa/framework_feature.h"
 #include "tfm_mbedcrypto_include.h"
 
 #include "tfm_crypto_api.h"
@@ -18,6 +19,15 @@
 
 #include "crypto_library.h"
 
+#if (PSA_FRAMEWORK_HAS_MM_IOVEC != 1) && (CRYPTO_AEAD_STREAM_CHUNK_SIZE > 0)
+#include "psa/service.h"
+
+/* The input window is reused to hold the tag at the end of the stream */
+#if (CRYPTO_AEAD_STREAM_CHUNK_SIZE < PSA_AEAD_TAG_MAX_SIZE)
+#error "CRYPTO_AEAD_STREAM_CHUNK_SIZE must be able to hold an AEAD tag"
+#endif
+#endif
+
 TFM_COVERITY_DEVIATE_BLOCK(MISRA_C_2023_Rule_11_5, "It's PSA API design to use pointer to void")
 /*!
  * \defgroup tfm_crypto_api_shim_layer Set of functions implementing a thin shim
@@ -263,6 +273,124 @@ release_operation_and_return:
     (void)tfm_crypto_operation_release(p_handle);
     return status;
 }
+
+#if (PSA_FRAMEWORK_HAS_MM_IOVEC != 1) && (CRYPTO_AEAD_STREAM_CHUNK_SIZE > 0) && \
+    !CRYPTO_SINGLE_PART_FUNCS_DISABLED
+psa_status_t tfm_crypto_aead_encrypt_stream(psa_handle_t msg_handle,
+                                            const struct tfm_crypto_pack_iovec *iov,
+                                            struct tfm_crypto_key_id_s *encoded_key,
+                                            const uint8_t *additional_data,
+                                            size_t additional_data_length,
+                                            size_t plaintext_length,
+                                            size_t ciphertext_size,
+                                            uint8_t *in_chunk,
+                                            uint8_t *out_chunk)
+{
+    psa_status_t status;
+    /* The operation is kept on the stack as in the single-part functions of
+     * the library, so that streaming does not depend on a free slot in the
+     * operation table, which is shared with the multipart clients.
+     */
+    psa_aead_operation_t operation = PSA_AEAD_OPERATION_INIT;
+    psa_key_attributes_t key_attributes = PSA_KEY_ATTRIBUTES_INIT;
+    size_t required_size;
+    size_t chunk_length;
+    size_t output_length;
+    size_t tag_length;
+    const struct tfm_crypto_aead_pack_input *aead_pack_input = &iov->aead_in;
+
+    tfm_crypto_library_key_id_t library_key = tfm_crypto_library_key_id_init(
+                                                  encoded_key->owner, encoded_key->key_id);
+
+    if (aead_pack_input->nonce_length > TFM_CRYPTO_MAX_NONCE_LENGTH) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* The ciphertext is written back as it is produced, so make sure upfront
+     * that the whole of it, including the tag, fits in the client buffer.
+     */
+    status = psa_get_key_attributes(library_key, &key_attributes);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+    required_size = PSA_AEAD_ENCRYPT_OUTPUT_SIZE(psa_get_key_type(&key_attributes),
+                                                 iov->alg, plaintext_length);
+    psa_reset_key_attributes(&key_attributes);
+    if ((required_size == 0) || (required_size < plaintext_length)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+    if (ciphertext_size < required_size) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    status = psa_aead_encrypt_setup(&operation, library_key, iov->alg);
+    if (status != PSA_SUCCESS) {
+        goto abort_operation_and_return;
+    }
+
+    /* Lengths are known upfront, which is required by some algorithms (CCM) */
+    status = psa_aead_set_lengths(&operation, additional_data_length,
+                                  plaintext_length);
+    if (status != PSA_SUCCESS) {
+        goto abort_operation_and_return;
+    }
+
+    status = psa_aead_set_nonce(&operation, aead_pack_input->nonce,
+                                aead_pack_input->nonce_length);
+    if (status != PSA_SUCCESS) {
+        goto abort_operation_and_return;
+    }
+
+    status = psa_aead_update_ad(&operation, additional_data,
+                                additional_data_length);
+    if (status != PSA_SUCCESS) {
+        goto abort_operation_and_return;
+    }
+
+    /* Read the plaintext from the client one window at a time and write the
+     * corresponding ciphertext back straight away, so that the amount of
+     * secure memory used does not depend on the size of the request.
+     */
+    while (plaintext_length > 0) {
+        chunk_length = (plaintext_length < CRYPTO_AEAD_STREAM_CHUNK_SIZE) ?
+                       plaintext_length : CRYPTO_AEAD_STREAM_CHUNK_SIZE;
+
+        if (psa_read(msg_handle, 1, in_chunk, chunk_length) != chunk_length) {
+            status = PSA_ERROR_GENERIC_ERROR;
+            goto abort_operation_and_return;
+        }
+
+        status = psa_aead_update(&operation, in_chunk, chunk_length,
+                                 out_chunk, TFM_CRYPTO_AEAD_STREAM_OUT_SIZE,
+                                 &output_length);
+        if (status != PSA_SUCCESS) {
+            goto abort_operation_and_return;
+        }
+
+        psa_write(msg_handle, 0, out_chunk, output_length);
+        plaintext_length -= chunk_length;
+    }
+
+    /* The input window is free at this point and is reused for the tag */
+    status = psa_aead_finish(&operation,
+                             out_chunk, TFM_CRYPTO_AEAD_STREAM_OUT_SIZE,
+                             &output_length,
+                             in_chunk, CRYPTO_AEAD_STREAM_CHUNK_SIZE,
+                             &tag_length);
+    if (status != PSA_SUCCESS) {
+        goto abort_operation_and_return;
+    }
+
+    psa_write(msg_handle, 0, out_chunk, output_length);
+    psa_write(msg_handle, 0, in_chunk, tag_length);
+
+    return PSA_SUCCESS;
+
+abort_operation_and_return:
+    (void)psa_aead_abort(&operation);
+    return status;
+}
+#endif /* (PSA_FRAMEWORK_HAS_MM_IOVEC != 1) && (CRYPTO_AEAD_STREAM_CHUNK_SIZE > 0) */
 #else /* CRYPTO_AEAD_MODULE_ENABLED */
 psa_status_t tfm_crypto_aead_interface(psa_invec in_vec[],
                                        psa_outvec out_vec[],
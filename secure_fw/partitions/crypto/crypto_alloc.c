@@ -38,6 +38,11 @@ struct tfm_crypto_operation_s {
                                      *   the context
                                      */
     enum tfm_crypto_operation_type type; /*!< Type of the operation */
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+    psa_algorithm_t alg;            /*!< Algorithm the operation was set up
+                                     *   with, to account its requests
+                                     */
+#endif
     union {
         psa_cipher_operation_t cipher;    /*!< Cipher operation context */
         psa_mac_operation_t mac;          /*!< MAC operation context */
@@ -49,6 +54,11 @@ struct tfm_crypto_operation_s {
 
 static struct tfm_crypto_operation_s operations[CRYPTO_CONC_OPER_NUM] = {{0}};
 
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+/* Algorithm of the request being serviced, given to the operation it sets up */
+static psa_algorithm_t request_alg = PSA_ALG_NONE;
+#endif
+
 /*
  * \brief Function used to clear the memory associated to a backend context
  *
@@ -107,6 +117,9 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
             operations[i].in_use = TFM_CRYPTO_IN_USE;
             operations[i].owner = partition_id;
             operations[i].type = type;
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+            operations[i].alg = request_alg;
+#endif
             *handle = i + 1;
             *ctx = (void *) &(operations[i].operation);
             return PSA_SUCCESS;
@@ -142,6 +155,9 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle)
         operations[h_val - 1].in_use = TFM_CRYPTO_NOT_IN_USE;
         operations[h_val - 1].type = TFM_CRYPTO_OPERATION_NONE;
         operations[h_val - 1].owner = 0;
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+        operations[h_val - 1].alg = PSA_ALG_NONE;
+#endif
 
         return PSA_SUCCESS;
     }
@@ -179,4 +195,25 @@ psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
 
     return PSA_ERROR_BAD_STATE;
 }
+
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+psa_algorithm_t tfm_crypto_operation_request_alg(
+                                    const struct tfm_crypto_pack_iovec *iov)
+{
+    uint32_t handle = iov->op_handle;
+
+    /* Only the requests which set up an operation carry the algorithm, the
+     * others are given the algorithm of the operation they refer to.
+     */
+    request_alg = iov->alg;
+    if ((request_alg == PSA_ALG_NONE) &&
+        (handle != TFM_CRYPTO_INVALID_HANDLE) &&
+        (handle <= CRYPTO_CONC_OPER_NUM) &&
+        (operations[handle - 1].in_use == TFM_CRYPTO_IN_USE)) {
+        request_alg = operations[handle - 1].alg;
+    }
+
+    return request_alg;
+}
+#endif /* CRYPTO_STATS_REPORT_INTERVAL > 0 */
 /*!@}*/
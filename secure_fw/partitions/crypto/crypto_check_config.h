@@ -114,4 +114,13 @@
 #error "CRYPTO_KEY_DERIVATION_MODULE_ENABLED enabled, but not all prerequisites (missing key derivation algorithms)!"
 #endif
 
+/* The TLSF heap is plugged with mbedtls_platform_set_calloc_free(), which only
+ * exists when the allocator of the library can be changed at runtime.
+ */
+#if CRYPTO_ENGINE_HEAP_TLSF && \
+    (!defined(MBEDTLS_PLATFORM_MEMORY) || \
+     (defined(MBEDTLS_PLATFORM_CALLOC_MACRO) && defined(MBEDTLS_PLATFORM_FREE_MACRO)))
+#error "CRYPTO_ENGINE_HEAP_TLSF enabled, but not all prerequisites (missing MBEDTLS_PLATFORM_MEMORY without MBEDTLS_PLATFORM_{CALLOC,FREE}_MACRO)!"
+#endif
+
 #endif /* __CRYPTO_CHECK_CONFIG_H__ */
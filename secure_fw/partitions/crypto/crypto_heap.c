@@ -0,0 +1,345 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "crypto_heap.h"
+
+#if CRYPTO_ENGINE_HEAP_TLSF
+
+/* Alignment of the blocks returned, suitable for any type on the targets */
+#define HEAP_ALIGN_SIZE      8U
+#define HEAP_ALIGN_UP(x)     (((x) + (HEAP_ALIGN_SIZE - 1)) & \
+                              ~((size_t)HEAP_ALIGN_SIZE - 1))
+
+/* Number of second level lists per power of two, as log2 */
+#define HEAP_SL_INDEX_LOG2   4U
+#define HEAP_SL_INDEX_COUNT  (1U << HEAP_SL_INDEX_LOG2)
+
+/* Blocks below this size are kept in linearly spaced lists on first level 0 */
+#define HEAP_FL_INDEX_SHIFT  (HEAP_SL_INDEX_LOG2 + 3U)
+#define HEAP_SMALL_BLOCK     (1U << HEAP_FL_INDEX_SHIFT)
+
+/* Largest supported heap, as log2 */
+#define HEAP_FL_INDEX_MAX    24U
+#define HEAP_FL_INDEX_COUNT  (HEAP_FL_INDEX_MAX - HEAP_FL_INDEX_SHIFT + 1U)
+
+#define HEAP_BLOCK_FREE      1U
+#define HEAP_BLOCK_FLAGS     (HEAP_ALIGN_SIZE - 1U)
+
+/**
+ * \brief Header of each block of the heap. The free list links overlap with
+ *        the payload, so they are only valid while the block is free.
+ */
+struct heap_block_t {
+    struct heap_block_t *prev_phys;  /*!< Previous block in memory */
+    size_t size;                     /*!< Payload size, ORed with the flags */
+    struct heap_block_t *next_free;  /*!< Next block in the same free list */
+    struct heap_block_t *prev_free;  /*!< Previous block in the same list */
+};
+
+#define HEAP_BLOCK_HEADER    offsetof(struct heap_block_t, next_free)
+#define HEAP_BLOCK_SIZE_MIN  (sizeof(struct heap_block_t) - HEAP_BLOCK_HEADER)
+
+static struct {
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[HEAP_FL_INDEX_COUNT];
+    struct heap_block_t *lists[HEAP_FL_INDEX_COUNT][HEAP_SL_INDEX_COUNT];
+    struct heap_block_t *first;
+    struct tfm_crypto_heap_stats_t stats;
+} heap;
+
+/* Index of the most significant bit set, word must not be 0 */
+static uint32_t heap_fls(uint32_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 31U - (uint32_t)__builtin_clz(word);
+#else
+    uint32_t bit = 0;
+
+    while ((word >>= 1) != 0) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/* Index of the least significant bit set, word must not be 0 */
+static uint32_t heap_ffs(uint32_t word)
+{
+    return heap_fls(word & (~word + 1U));
+}
+
+static size_t block_size(const struct heap_block_t *block)
+{
+    return block->size & ~(size_t)HEAP_BLOCK_FLAGS;
+}
+
+static int block_is_free(const struct heap_block_t *block)
+{
+    return (block->size & HEAP_BLOCK_FREE) != 0;
+}
+
+static struct heap_block_t *block_next(const struct heap_block_t *block)
+{
+    return (struct heap_block_t *)((uint8_t *)block + HEAP_BLOCK_HEADER +
+                                   block_size(block));
+}
+
+static void mapping_insert(size_t size, uint32_t *fl, uint32_t *sl)
+{
+    uint32_t msb;
+
+    if (size < HEAP_SMALL_BLOCK) {
+        *fl = 0;
+        *sl = (uint32_t)size / (HEAP_SMALL_BLOCK / HEAP_SL_INDEX_COUNT);
+    } else {
+        msb = heap_fls((uint32_t)size);
+        *sl = ((uint32_t)size >> (msb - HEAP_SL_INDEX_LOG2)) &
+              (HEAP_SL_INDEX_COUNT - 1U);
+        *fl = msb - (HEAP_FL_INDEX_SHIFT - 1U);
+    }
+}
+
+/* Rounds the size up to the next list, so that any block found there fits */
+static void mapping_search(size_t size, uint32_t *fl, uint32_t *sl)
+{
+    if (size >= HEAP_SMALL_BLOCK) {
+        size += (1U << (heap_fls((uint32_t)size) - HEAP_SL_INDEX_LOG2)) - 1U;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static struct heap_block_t *find_suitable_block(uint32_t *fl, uint32_t *sl)
+{
+    uint32_t sl_map, fl_map;
+
+    if (*fl >= HEAP_FL_INDEX_COUNT) {
+        return NULL;
+    }
+
+    sl_map = heap.sl_bitmap[*fl] & (~0U << *sl);
+    if (sl_map == 0) {
+        /* Move to the next non-empty first level list with larger blocks */
+        fl_map = heap.fl_bitmap & (~0U << (*fl + 1U));
+        if (fl_map == 0) {
+            return NULL;
+        }
+        *fl = heap_ffs(fl_map);
+        sl_map = heap.sl_bitmap[*fl];
+    }
+    *sl = heap_ffs(sl_map);
+
+    return heap.lists[*fl][*sl];
+}
+
+static void insert_free_block(struct heap_block_t *block)
+{
+    uint32_t fl, sl;
+
+    mapping_insert(block_size(block), &fl, &sl);
+
+    block->prev_free = NULL;
+    block->next_free = heap.lists[fl][sl];
+    if (block->next_free != NULL) {
+        block->next_free->prev_free = block;
+    }
+    heap.lists[fl][sl] = block;
+
+    heap.fl_bitmap |= (1U << fl);
+    heap.sl_bitmap[fl] |= (1U << sl);
+}
+
+static void remove_free_block(struct heap_block_t *block)
+{
+    uint32_t fl, sl;
+
+    mapping_insert(block_size(block), &fl, &sl);
+
+    if (block->next_free != NULL) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    if (block->prev_free != NULL) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        heap.lists[fl][sl] = block->next_free;
+        if (heap.lists[fl][sl] == NULL) {
+            heap.sl_bitmap[fl] &= ~(1U << sl);
+            if (heap.sl_bitmap[fl] == 0) {
+                heap.fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+}
+
+/* Merges the free block with the block physically following it */
+static void merge_with_next(struct heap_block_t *block)
+{
+    struct heap_block_t *next = block_next(block);
+
+    block->size = (block_size(block) + HEAP_BLOCK_HEADER + block_size(next)) |
+                  HEAP_BLOCK_FREE;
+    block_next(block)->prev_phys = block;
+}
+
+static void *heap_malloc(size_t size)
+{
+    struct heap_block_t *block, *remainder;
+    size_t adjusted;
+    uint32_t fl, sl;
+
+    if ((size == 0) || (size > heap.stats.total)) {
+        return NULL;
+    }
+
+    adjusted = HEAP_ALIGN_UP(size);
+    if (adjusted < HEAP_BLOCK_SIZE_MIN) {
+        adjusted = HEAP_BLOCK_SIZE_MIN;
+    }
+
+    mapping_search(adjusted, &fl, &sl);
+    block = find_suitable_block(&fl, &sl);
+    if (block == NULL) {
+        return NULL;
+    }
+    remove_free_block(block);
+
+    /* Give back the tail of the block if it can hold another block */
+    if (block_size(block) >= adjusted + sizeof(struct heap_block_t)) {
+        remainder = (struct heap_block_t *)((uint8_t *)block +
+                                            HEAP_BLOCK_HEADER + adjusted);
+        remainder->prev_phys = block;
+        remainder->size = (block_size(block) - adjusted - HEAP_BLOCK_HEADER) |
+                          HEAP_BLOCK_FREE;
+        block_next(remainder)->prev_phys = remainder;
+        block->size = adjusted;
+        insert_free_block(remainder);
+    }
+
+    block->size = block_size(block);
+
+    heap.stats.used += block_size(block) + HEAP_BLOCK_HEADER;
+    if (heap.stats.used > heap.stats.peak) {
+        heap.stats.peak = heap.stats.used;
+    }
+
+    return (uint8_t *)block + HEAP_BLOCK_HEADER;
+}
+
+int tfm_crypto_heap_init(uint8_t *buf, size_t size)
+{
+    struct heap_block_t *sentinel;
+    uintptr_t start = HEAP_ALIGN_UP((uintptr_t)buf);
+
+    if ((buf == NULL) || (size < start - (uintptr_t)buf)) {
+        return -1;
+    }
+    size = (size - (start - (uintptr_t)buf)) & ~(size_t)(HEAP_ALIGN_SIZE - 1);
+
+    /* Room for the first free block and for the sentinel closing the heap */
+    if ((size < 2 * HEAP_BLOCK_HEADER + HEAP_BLOCK_SIZE_MIN) ||
+        (size >= (1UL << HEAP_FL_INDEX_MAX))) {
+        return -1;
+    }
+
+    (void)memset(&heap, 0, sizeof(heap));
+
+    heap.first = (struct heap_block_t *)start;
+    heap.first->prev_phys = NULL;
+    heap.first->size = (size - 2 * HEAP_BLOCK_HEADER) | HEAP_BLOCK_FREE;
+
+    sentinel = block_next(heap.first);
+    sentinel->prev_phys = heap.first;
+    sentinel->size = 0;
+
+    insert_free_block(heap.first);
+    heap.stats.total = block_size(heap.first);
+
+    return 0;
+}
+
+void *tfm_crypto_heap_calloc(size_t nmemb, size_t size)
+{
+    void *ptr;
+
+    /* An empty allocation returns NULL, which is not a failure */
+    if ((nmemb == 0) || (size == 0)) {
+        return NULL;
+    }
+
+    if (size > SIZE_MAX / nmemb) {
+        heap.stats.failures++;
+        return NULL;
+    }
+
+    ptr = heap_malloc(nmemb * size);
+    if (ptr == NULL) {
+        heap.stats.failures++;
+        return NULL;
+    }
+    heap.stats.allocs++;
+
+    (void)memset(ptr, 0, nmemb * size);
+
+    return ptr;
+}
+
+void tfm_crypto_heap_free(void *ptr)
+{
+    struct heap_block_t *block, *neighbour;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    block = (struct heap_block_t *)((uint8_t *)ptr - HEAP_BLOCK_HEADER);
+    if (block_is_free(block)) {
+        /* Double free, leave the lists untouched */
+        return;
+    }
+
+    heap.stats.used -= block_size(block) + HEAP_BLOCK_HEADER;
+    block->size |= HEAP_BLOCK_FREE;
+
+    /* Coalesce with the free neighbours so that free blocks never touch */
+    neighbour = block->prev_phys;
+    if ((neighbour != NULL) && block_is_free(neighbour)) {
+        remove_free_block(neighbour);
+        merge_with_next(neighbour);
+        block = neighbour;
+    }
+
+    neighbour = block_next(block);
+    if (block_is_free(neighbour)) {
+        remove_free_block(neighbour);
+        merge_with_next(block);
+    }
+
+    insert_free_block(block);
+}
+
+void tfm_crypto_heap_get_stats(struct tfm_crypto_heap_stats_t *stats)
+{
+    const struct heap_block_t *block;
+
+    *stats = heap.stats;
+    stats->largest_free = 0;
+
+    /* The sentinel is the only block with a size of 0 */
+    for (block = heap.first;
+         (block != NULL) && (block_size(block) != 0);
+         block = block_next(block)) {
+        if (block_is_free(block) && (block_size(block) > stats->largest_free)) {
+            stats->largest_free = block_size(block);
+        }
+    }
+}
+
+#endif /* CRYPTO_ENGINE_HEAP_TLSF */
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file crypto_heap.h
+ *
+ * \brief Two-level segregated fit (TLSF) allocator which can be plugged in the
+ *        underlying cryptographic library in place of its default allocator
+ *        for the static heap of the Crypto service. Allocations and frees are
+ *        bounded in time and the free blocks are kept segregated by size, so
+ *        the fragmentation stays low under long sequences of mixed
+ *        operations.
+ */
+
+#ifndef __CRYPTO_HEAP_H__
+#define __CRYPTO_HEAP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Statistics about the usage of the heap
+ */
+struct tfm_crypto_heap_stats_t {
+    size_t total;         /*!< Bytes available for allocations once empty */
+    size_t used;          /*!< Bytes currently allocated, with overheads */
+    size_t peak;          /*!< Maximum value reached by \a used */
+    size_t largest_free;  /*!< Size of the largest free block */
+    uint32_t allocs;      /*!< Number of successful allocations */
+    uint32_t failures;    /*!< Number of allocations which failed */
+};
+
+/**
+ * \brief Initialises the heap on the provided buffer
+ *
+ * \param[in] buf   Buffer to be used as heap
+ * \param[in] size  Size in bytes of \a buf
+ *
+ * \return 0 on success, -1 if the buffer is too small or too large
+ */
+int tfm_crypto_heap_init(uint8_t *buf, size_t size);
+
+/**
+ * \brief Allocates a zero-initialised array from the heap, with the
+ *        semantics of the standard calloc()
+ *
+ * \param[in] nmemb  Number of elements
+ * \param[in] size   Size of each element
+ *
+ * \return Pointer to the allocated memory, or NULL on failure. An empty
+ *         allocation returns NULL and is not counted as a failure.
+ */
+void *tfm_crypto_heap_calloc(size_t nmemb, size_t size);
+
+/**
+ * \brief Returns memory to the heap, with the semantics of the standard
+ *        free()
+ *
+ * \param[in] ptr  Pointer returned by \ref tfm_crypto_heap_calloc, or NULL
+ */
+void tfm_crypto_heap_free(void *ptr);
+
+/**
+ * \brief Gets the usage statistics of the heap. The fragmentation can be
+ *        estimated from the ratio between \a largest_free and the free bytes.
+ *
+ * \param[out] stats  Statistics of the heap
+ */
+void tfm_crypto_heap_get_stats(struct tfm_crypto_heap_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_HEAP_H__ */
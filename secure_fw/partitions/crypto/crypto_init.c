@@ -19,6 +19,7 @@
 #include "tfm_plat_crypto_keys.h"
 
 #include "crypto_library.h"
+#include "crypto_stats.h"
 
 #if CRYPTO_NV_SEED
 #include "tfm_plat_crypto_nv_seed.h"
@@ -191,6 +192,91 @@ static psa_status_t tfm_crypto_init_iovecs(const psa_msg_t *msg,
 
     return PSA_SUCCESS;
 }
+
+#if CRYPTO_AEAD_MODULE_ENABLED && !CRYPTO_SINGLE_PART_FUNCS_DISABLED && \
+    (CRYPTO_AEAD_STREAM_CHUNK_SIZE > 0)
+/**
+ * \brief Checks whether all the IOVecs of a request can be allocated in the
+ *        internal scratch at the same time.
+ */
+static bool tfm_crypto_iovecs_fit_scratch(const psa_msg_t *msg,
+                                          size_t in_len,
+                                          size_t out_len)
+{
+    size_t total_size = 0;
+    uint32_t i;
+
+    /* Skip the first element as it is read when parsing */
+    for (i = 1; i < in_len; i++) {
+        if (msg->in_size[i] > sizeof(scratch.buf)) {
+            return false;
+        }
+        total_size += ALIGN(msg->in_size[i], TFM_CRYPTO_IOVEC_ALIGNMENT);
+    }
+
+    for (i = 0; i < out_len; i++) {
+        if (msg->out_size[i] > sizeof(scratch.buf)) {
+            return false;
+        }
+        total_size += ALIGN(msg->out_size[i], TFM_CRYPTO_IOVEC_ALIGNMENT);
+    }
+
+    return (total_size <= sizeof(scratch.buf));
+}
+
+/**
+ * \brief Serves a single-part AEAD encryption which does not fit in the
+ *        internal scratch. Only the additional data and two fixed-size windows
+ *        are allocated in the scratch, while plaintext and ciphertext are
+ *        streamed between the client and the service.
+ */
+static psa_status_t tfm_crypto_aead_encrypt_stream_srv(
+                                        const psa_msg_t *msg,
+                                        const struct tfm_crypto_pack_iovec *iov)
+{
+    psa_status_t status;
+    void *additional_data = NULL;
+    void *in_chunk = NULL;
+    void *out_chunk = NULL;
+    struct tfm_crypto_key_id_s encoded_key = TFM_CRYPTO_KEY_ID_S_INIT;
+
+    /* The additional data is consumed in one go, so it must fit entirely */
+    status = tfm_crypto_alloc_scratch(msg->in_size[2], &additional_data);
+    if (status == PSA_SUCCESS) {
+        status = tfm_crypto_alloc_scratch(CRYPTO_AEAD_STREAM_CHUNK_SIZE,
+                                          &in_chunk);
+    }
+    if (status == PSA_SUCCESS) {
+        status = tfm_crypto_alloc_scratch(TFM_CRYPTO_AEAD_STREAM_OUT_SIZE,
+                                          &out_chunk);
+    }
+    if (status != PSA_SUCCESS) {
+        tfm_crypto_clear_scratch();
+        return status;
+    }
+
+    if (psa_read(msg->handle, 2, additional_data, msg->in_size[2])
+        != msg->in_size[2]) {
+        tfm_crypto_clear_scratch();
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    tfm_crypto_set_caller_id(msg->client_id);
+
+    encoded_key.key_id = iov->key_id;
+    encoded_key.owner = msg->client_id;
+
+    status = tfm_crypto_aead_encrypt_stream(msg->handle, iov, &encoded_key,
+                                            additional_data, msg->in_size[2],
+                                            msg->in_size[1], msg->out_size[0],
+                                            in_chunk, out_chunk);
+
+    /* Clear the allocated internal scratch before returning */
+    tfm_crypto_clear_scratch();
+
+    return status;
+}
+#endif /* CRYPTO_AEAD_MODULE_ENABLED && CRYPTO_AEAD_STREAM_CHUNK_SIZE > 0 */
 #endif /* PSA_FRAMEWORK_HAS_MM_IOVEC == 1 */
 
 static psa_status_t tfm_crypto_api_dispatcher(psa_invec in_vec[],
@@ -257,35 +343,77 @@ static psa_status_t tfm_crypto_api_dispatcher(psa_invec in_vec[],
     }
 }
 
-static psa_status_t tfm_crypto_call_srv(const psa_msg_t *msg)
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+static void tfm_crypto_stats_account(const psa_msg_t *msg, uint16_t function_id,
+                                     psa_algorithm_t alg, uint32_t call_start,
+                                     uint32_t dispatch_cycles)
 {
-    psa_status_t status = PSA_SUCCESS;
-    size_t in_len = PSA_MAX_IOVEC, out_len = PSA_MAX_IOVEC, i;
-    psa_invec in_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
-    psa_outvec out_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
-    struct tfm_crypto_pack_iovec iov = {0};
+    uint32_t call_cycles = TFM_CRYPTO_STATS_TIMESTAMP() - call_start;
+    size_t in_size = 0, out_size = 0, i;
 
-    /* Check the number of in_vec filled */
-    while ((in_len > 0) && (msg->in_size[in_len - 1] == 0)) {
-        in_len--;
+    /* The first invec only carries the parameters of the request */
+    for (i = 1; i < PSA_MAX_IOVEC; i++) {
+        in_size += msg->in_size[i];
     }
-
-    /* Check the number of out_vec filled */
-    while ((out_len > 0) && (msg->out_size[out_len - 1] == 0)) {
-        out_len--;
+    for (i = 0; i < PSA_MAX_IOVEC; i++) {
+        out_size += msg->out_size[i];
     }
 
-    /* There will always be a tfm_crypto_pack_iovec in the first iovec */
-    if (in_len < 1) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
+    /* Some requests only consume data (e.g. hash update), others only produce
+     * it (e.g. generate random), so account for the larger of the two.
+     */
+    tfm_crypto_stats_record(function_id, alg,
+                            (in_size > out_size) ? in_size : out_size,
+                            call_cycles, dispatch_cycles);
+}
+#endif /* CRYPTO_STATS_REPORT_INTERVAL > 0 */
 
-    if (psa_read(msg->handle, 0, &iov, sizeof(iov)) != sizeof(iov)) {
-        return PSA_ERROR_GENERIC_ERROR;
+/**
+ * \brief Serves a request whose parameters have been read, through the API
+ *        dispatcher or, for large single-part AEAD encryptions, by streaming.
+ *
+ * \param[in]  msg              Message of the request
+ * \param[in]  iov              Packed parameters of the request
+ * \param[in]  in_len           Number of input vectors filled
+ * \param[in]  out_len          Number of output vectors filled
+ * \param[out] dispatch_cycles  Cycles spent in the API implementation, only
+ *                              set when CRYPTO_STATS_REPORT_INTERVAL > 0
+ *
+ * \return Return values as described in \ref psa_status_t
+ */
+static psa_status_t tfm_crypto_call_dispatch(const psa_msg_t *msg,
+                                             const struct tfm_crypto_pack_iovec *iov,
+                                             size_t in_len, size_t out_len,
+                                             uint32_t *dispatch_cycles)
+{
+    psa_status_t status = PSA_SUCCESS;
+    size_t i;
+    psa_invec in_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
+    psa_outvec out_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+    uint32_t dispatch_start;
+#endif
+
+    (void)dispatch_cycles;
+
+#if (PSA_FRAMEWORK_HAS_MM_IOVEC != 1) && CRYPTO_AEAD_MODULE_ENABLED && \
+    !CRYPTO_SINGLE_PART_FUNCS_DISABLED && (CRYPTO_AEAD_STREAM_CHUNK_SIZE > 0)
+    /* Large single-part AEAD encryptions are streamed instead of copied */
+    if ((iov->function_id == TFM_CRYPTO_AEAD_ENCRYPT_SID) &&
+        !tfm_crypto_iovecs_fit_scratch(msg, in_len, out_len)) {
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+        dispatch_start = TFM_CRYPTO_STATS_TIMESTAMP();
+        status = tfm_crypto_aead_encrypt_stream_srv(msg, iov);
+        *dispatch_cycles = TFM_CRYPTO_STATS_TIMESTAMP() - dispatch_start;
+        return status;
+#else
+        return tfm_crypto_aead_encrypt_stream_srv(msg, iov);
+#endif
     }
+#endif
 
     /* Initialise the first iovec with the IOV read when parsing */
-    in_vec[0].base = &iov;
+    in_vec[0].base = iov;
     in_vec[0].len = sizeof(struct tfm_crypto_pack_iovec);
 
     status = tfm_crypto_init_iovecs(msg, in_vec, in_len, out_vec, out_len);
@@ -295,9 +423,17 @@ static psa_status_t tfm_crypto_call_srv(const psa_msg_t *msg)
 
     tfm_crypto_set_caller_id(msg->client_id);
 
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+    dispatch_start = TFM_CRYPTO_STATS_TIMESTAMP();
+#endif
+
     /* Call the dispatcher to the functions that implement the PSA Crypto API */
     status = tfm_crypto_api_dispatcher(in_vec, in_len, out_vec, out_len);
 
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+    *dispatch_cycles = TFM_CRYPTO_STATS_TIMESTAMP() - dispatch_start;
+#endif
+
 #if PSA_FRAMEWORK_HAS_MM_IOVEC == 1
     for (i = 0; i < out_len; i++) {
         if (out_vec[i].base != NULL) {
@@ -327,6 +463,53 @@ static psa_status_t tfm_crypto_call_srv(const psa_msg_t *msg)
     return status;
 }
 
+static psa_status_t tfm_crypto_call_srv(const psa_msg_t *msg)
+{
+    psa_status_t status;
+    size_t in_len = PSA_MAX_IOVEC, out_len = PSA_MAX_IOVEC;
+    struct tfm_crypto_pack_iovec iov = {0};
+    uint32_t dispatch_cycles = 0;
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+    uint32_t call_start = TFM_CRYPTO_STATS_TIMESTAMP();
+    psa_algorithm_t alg;
+#endif
+
+    /* Check the number of in_vec filled */
+    while ((in_len > 0) && (msg->in_size[in_len - 1] == 0)) {
+        in_len--;
+    }
+
+    /* Check the number of out_vec filled */
+    while ((out_len > 0) && (msg->out_size[out_len - 1] == 0)) {
+        out_len--;
+    }
+
+    /* There will always be a tfm_crypto_pack_iovec in the first iovec */
+    if (in_len < 1) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    if (psa_read(msg->handle, 0, &iov, sizeof(iov)) != sizeof(iov)) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+    /* Resolved before the dispatch, which may release the operation */
+    alg = tfm_crypto_operation_request_alg(&iov);
+#endif
+
+    status = tfm_crypto_call_dispatch(msg, &iov, in_len, out_len,
+                                      &dispatch_cycles);
+
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+    /* Every request is accounted, including the ones which fail */
+    tfm_crypto_stats_account(msg, iov.function_id, alg, call_start,
+                             dispatch_cycles);
+#endif
+
+    return status;
+}
+
 static psa_status_t tfm_crypto_engine_init(void)
 {
     psa_status_t status = PSA_ERROR_GENERIC_ERROR;
@@ -15,6 +15,7 @@
 #include "psa/crypto.h"
 #include "psa/error.h"
 #include "crypto_library.h"
+#include "crypto_heap.h"
 
 /**
  * \brief This include is required to get the underlying platform function
@@ -56,7 +57,7 @@ static char tfpsacrypto_version_full[20];
  * \brief Static buffer to be used by Mbed Crypto for memory allocations
  *
  */
-#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C) || CRYPTO_ENGINE_HEAP_TLSF
 static uint8_t mbedtls_mem_buf[CRYPTO_ENGINE_BUF_SIZE] = {0};
 #endif
 
@@ -87,7 +88,16 @@ char *tfm_crypto_library_get_info(void)
 
 psa_status_t tfm_crypto_core_library_init(void)
 {
-#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+#if CRYPTO_ENGINE_HEAP_TLSF
+    /* Plug the TLSF allocator in place of the default Mbed TLS allocator, on
+     * the same static buffer
+     */
+    if (tfm_crypto_heap_init(mbedtls_mem_buf, CRYPTO_ENGINE_BUF_SIZE) != 0) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+    (void)mbedtls_platform_set_calloc_free(tfm_crypto_heap_calloc,
+                                           tfm_crypto_heap_free);
+#elif defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
     /* Initialise the Mbed Crypto memory allocator to use static memory
      * allocation from the provided buffer instead of using the heap
      */
@@ -97,7 +107,7 @@ psa_status_t tfm_crypto_core_library_init(void)
 
     mbedtls_platform_set_printf(null_printf);
 
-#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C) || CRYPTO_ENGINE_HEAP_TLSF
     VERBOSE("[Crypto] Internal heap size is %d bytes\n", sizeof(mbedtls_mem_buf));
 #else
     VERBOSE("[Crypto] No internal heap");
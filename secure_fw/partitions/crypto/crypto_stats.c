@@ -0,0 +1,151 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdint.h>
+
+#include "config_tfm.h"
+#include "crypto_stats.h"
+#if CRYPTO_ENGINE_HEAP_TLSF
+#include "crypto_heap.h"
+#endif
+#include "tfm_crypto_defs.h"
+#include "tfm_log.h"
+
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+
+#define TFM_CRYPTO_STATS_NUM_GROUPS (TFM_CRYPTO_GROUP_ID_KEY_DERIVATION + 1)
+
+/**
+ * \brief Number of (group, algorithm) pairs accounted separately. Requests of
+ *        further pairs are only counted as untracked.
+ */
+#define TFM_CRYPTO_STATS_NUM_ENTRIES (24u)
+
+/**
+ * \brief Counters accumulated for each algorithm used in a group of functions
+ */
+struct tfm_crypto_stats_entry_t {
+    psa_algorithm_t alg;       /*!< Algorithm, PSA_ALG_NONE for requests
+                                *   without one, e.g. key management
+                                */
+    uint8_t group_id;          /*!< Group of functions, 0 if the entry is free */
+    uint32_t calls;            /*!< Number of requests serviced */
+    uint64_t bytes;            /*!< Payload bytes processed */
+    uint64_t call_cycles;      /*!< Cycles spent in the service entry point */
+    uint64_t dispatch_cycles;  /*!< Cycles spent in the API implementation */
+};
+
+static const char * const group_names[TFM_CRYPTO_STATS_NUM_GROUPS] = {
+    [TFM_CRYPTO_GROUP_ID_RANDOM]         = "random",
+    [TFM_CRYPTO_GROUP_ID_KEY_MANAGEMENT] = "key_mgmt",
+    [TFM_CRYPTO_GROUP_ID_HASH]           = "hash",
+    [TFM_CRYPTO_GROUP_ID_MAC]            = "mac",
+    [TFM_CRYPTO_GROUP_ID_CIPHER]         = "cipher",
+    [TFM_CRYPTO_GROUP_ID_AEAD]           = "aead",
+    [TFM_CRYPTO_GROUP_ID_ASYM_SIGN]      = "asym_sign",
+    [TFM_CRYPTO_GROUP_ID_ASYM_ENCRYPT]   = "asym_encrypt",
+    [TFM_CRYPTO_GROUP_ID_KEY_DERIVATION] = "key_derivation",
+};
+
+static struct tfm_crypto_stats_entry_t stats[TFM_CRYPTO_STATS_NUM_ENTRIES];
+static uint32_t untracked_calls;
+static uint32_t calls_since_report;
+
+static uint32_t stats_saturate(uint64_t value)
+{
+    return (value > UINT32_MAX) ? UINT32_MAX : (uint32_t)value;
+}
+
+static struct tfm_crypto_stats_entry_t *stats_get_entry(uint8_t group_id,
+                                                        psa_algorithm_t alg)
+{
+    uint32_t i;
+
+    /* Entries are taken in order and never freed, so the first free entry
+     * ends the search.
+     */
+    for (i = 0; i < TFM_CRYPTO_STATS_NUM_ENTRIES; i++) {
+        if (stats[i].group_id == 0) {
+            stats[i].group_id = group_id;
+            stats[i].alg = alg;
+            return &stats[i];
+        }
+        if ((stats[i].group_id == group_id) && (stats[i].alg == alg)) {
+            return &stats[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void tfm_crypto_stats_report(void)
+{
+    uint32_t i;
+    uint64_t overhead, per_byte;
+#if CRYPTO_ENGINE_HEAP_TLSF
+    struct tfm_crypto_heap_stats_t heap_stats;
+#endif
+
+    INFO("[Crypto] Stats: group alg calls bytes overhead/call cycles/byte(x100)\n");
+
+    for (i = 0; (i < TFM_CRYPTO_STATS_NUM_ENTRIES) && (stats[i].group_id != 0);
+         i++) {
+        /* The fixed cost of a request is whatever is spent outside of the API
+         * implementation, i.e. the parameter marshalling and the copies. The
+         * throughput is derived from the time spent in the implementation.
+         */
+        overhead = (stats[i].call_cycles - stats[i].dispatch_cycles) /
+                   stats[i].calls;
+        per_byte = (stats[i].bytes == 0) ? 0 :
+                   (stats[i].dispatch_cycles * 100) / stats[i].bytes;
+
+        INFO("[Crypto] Stats: %s 0x%08x %u %u %u %u\n",
+             group_names[stats[i].group_id], (uint32_t)stats[i].alg,
+             stats[i].calls, stats_saturate(stats[i].bytes),
+             stats_saturate(overhead), stats_saturate(per_byte));
+    }
+
+    if (untracked_calls != 0) {
+        INFO("[Crypto] Stats: %u calls untracked\n", untracked_calls);
+    }
+
+#if CRYPTO_ENGINE_HEAP_TLSF
+    tfm_crypto_heap_get_stats(&heap_stats);
+    INFO("[Crypto] Heap: total %u used %u peak %u largest free %u failures %u\n",
+         (uint32_t)heap_stats.total, (uint32_t)heap_stats.used,
+         (uint32_t)heap_stats.peak, (uint32_t)heap_stats.largest_free,
+         heap_stats.failures);
+#endif
+}
+
+void tfm_crypto_stats_record(uint16_t function_id, psa_algorithm_t alg,
+                             size_t payload_size, uint32_t call_cycles,
+                             uint32_t dispatch_cycles)
+{
+    enum tfm_crypto_group_id_t group_id = TFM_CRYPTO_GET_GROUP_ID(function_id);
+    struct tfm_crypto_stats_entry_t *entry = NULL;
+
+    if ((group_id != 0) && ((uint32_t)group_id < TFM_CRYPTO_STATS_NUM_GROUPS)) {
+        entry = stats_get_entry((uint8_t)group_id, alg);
+    }
+
+    if (entry != NULL) {
+        entry->calls++;
+        entry->bytes += payload_size;
+        entry->call_cycles += call_cycles;
+        entry->dispatch_cycles += dispatch_cycles;
+    } else {
+        untracked_calls++;
+    }
+
+    if (++calls_since_report >= CRYPTO_STATS_REPORT_INTERVAL) {
+        calls_since_report = 0;
+        tfm_crypto_stats_report();
+    }
+}
+
+#endif /* CRYPTO_STATS_REPORT_INTERVAL > 0 */
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file crypto_stats.h
+ *
+ * \brief Throughput instrumentation of the Crypto service. When enabled, the
+ *        cost of each request is sampled around the service entry point and
+ *        around the API dispatcher, and the accumulated figures are reported
+ *        periodically per algorithm, within each group of functions, as fixed
+ *        per-call overhead and cycles per byte of payload.
+ */
+
+#ifndef __CRYPTO_STATS_H__
+#define __CRYPTO_STATS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config_tfm.h"
+#include "psa/crypto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+
+#ifndef CRYPTO_STATS_GET_CYCLES
+#error "CRYPTO_STATS_GET_CYCLES() must be provided by the platform when CRYPTO_STATS_REPORT_INTERVAL > 0"
+#endif
+
+/**
+ * \brief Reads the free running cycle counter used for the measurements
+ */
+#define TFM_CRYPTO_STATS_TIMESTAMP() ((uint32_t)CRYPTO_STATS_GET_CYCLES())
+
+/**
+ * \brief Accounts for one request serviced by the Crypto partition
+ *
+ * \param[in] function_id      Function ID of the request, as in
+ *                             \ref tfm_crypto_func_sid_t
+ * \param[in] alg              Algorithm of the request, or of the multipart
+ *                             operation it belongs to, PSA_ALG_NONE if none
+ * \param[in] payload_size     Number of payload bytes processed by the
+ *                             request, i.e. excluding the parameter vector
+ * \param[in] call_cycles      Cycles spent in the service for the request,
+ *                             including the marshalling of the iovecs
+ * \param[in] dispatch_cycles  Cycles spent in the API implementation only
+ */
+void tfm_crypto_stats_record(uint16_t function_id, psa_algorithm_t alg,
+                             size_t payload_size, uint32_t call_cycles,
+                             uint32_t dispatch_cycles);
+
+#endif /* CRYPTO_STATS_REPORT_INTERVAL > 0 */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_STATS_H__ */
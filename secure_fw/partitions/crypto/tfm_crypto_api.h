@@ -92,6 +92,18 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle);
 psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
                                          uint32_t handle,
                                          void **ctx);
+/**
+ * \brief Gets the algorithm a request is accounted to by the statistics: the
+ *        one it carries, or the one its multipart operation was set up with.
+ *        An operation set up while servicing the request is given it. Only
+ *        available when CRYPTO_STATS_REPORT_INTERVAL is non-zero.
+ *
+ * \param[in] iov  Packed parameters of the request
+ *
+ * \return The algorithm, or PSA_ALG_NONE if the request has none
+ */
+psa_algorithm_t tfm_crypto_operation_request_alg(
+                                    const struct tfm_crypto_pack_iovec *iov);
 /**
  * \brief This function acts as interface for the Key management module
  *
@@ -141,6 +153,46 @@ psa_status_t tfm_crypto_aead_interface(psa_invec in_vec[],
                                        psa_outvec out_vec[],
                                        struct tfm_crypto_key_id_s *encoded_key);
 
+/**
+ * \brief Size of the output window used by \ref tfm_crypto_aead_encrypt_stream
+ *        to hold the ciphertext produced from each input window, or the final
+ *        part of the ciphertext.
+ */
+#define TFM_CRYPTO_AEAD_STREAM_OUT_SIZE \
+    ((PSA_AEAD_UPDATE_OUTPUT_MAX_SIZE(CRYPTO_AEAD_STREAM_CHUNK_SIZE) > \
+      PSA_AEAD_FINISH_OUTPUT_MAX_SIZE) ? \
+     PSA_AEAD_UPDATE_OUTPUT_MAX_SIZE(CRYPTO_AEAD_STREAM_CHUNK_SIZE) : \
+     PSA_AEAD_FINISH_OUTPUT_MAX_SIZE)
+
+/**
+ * \brief Performs a single-part AEAD encryption by streaming the plaintext from
+ *        the client and the ciphertext back to it through fixed-size windows.
+ *        Used when the request does not fit in the internal scratch buffer.
+ *
+ * \param[in]  msg_handle             Handle of the message being served
+ * \param[in]  iov                    Packed parameters of the request
+ * \param[in]  encoded_key            Key encoded with partition_id and key_id
+ * \param[in]  additional_data        Additional data, already read
+ * \param[in]  additional_data_length Size in bytes of the additional data
+ * \param[in]  plaintext_length       Size in bytes of the plaintext in invec 1
+ * \param[in]  ciphertext_size        Size in bytes of the client output buffer
+ * \param[in]  in_chunk               Input window of
+ *                                    CRYPTO_AEAD_STREAM_CHUNK_SIZE bytes
+ * \param[in]  out_chunk              Output window of
+ *                                    TFM_CRYPTO_AEAD_STREAM_OUT_SIZE bytes
+ *
+ * \return Return values as described in \ref psa_status_t
+ */
+psa_status_t tfm_crypto_aead_encrypt_stream(psa_handle_t msg_handle,
+                                            const struct tfm_crypto_pack_iovec *iov,
+                                            struct tfm_crypto_key_id_s *encoded_key,
+                                            const uint8_t *additional_data,
+                                            size_t additional_data_length,
+                                            size_t plaintext_length,
+                                            size_t ciphertext_size,
+                                            uint8_t *in_chunk,
+                                            uint8_t *out_chunk);
+
 /**
  * \brief This function acts as interface for the Asymmetric signing module
  *
@@ -0,0 +1,486 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "flash_emu.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FLASH_EMU_DRV_VERSION      ARM_DRIVER_VERSION_MAJOR_MINOR(1, 0)
+#define FLASH_EMU_ERASE_VALUE      0xFF
+
+struct flash_emu_dev_t {
+    const struct flash_emu_config_t *cfg;
+    ARM_FLASH_INFO info;
+    uint8_t *image;              /* Memory mapped image file */
+    size_t size;                 /* Size of the image in bytes */
+    int fd;                      /* Image file descriptor */
+    uint8_t *programmed;         /* One flag per program unit, NAND only */
+    uint32_t *sector_erases;     /* Erase count of each sector */
+    uint8_t *sector_torn;        /* Sectors with an interrupted operation,
+                                  * NAND only
+                                  */
+    uint32_t num_sectors;        /* Number of sectors of the arrays above */
+    uint32_t ops_to_cut;         /* Program and erase operations before the
+                                  * power cut, 0 if none is scheduled
+                                  */
+    uint32_t cut_seed;           /* Selects how much of the interrupted
+                                  * operation is applied
+                                  */
+    bool power_lost;
+    struct flash_emu_stats_t stats;
+};
+
+static struct flash_emu_dev_t emu = { .fd = -1 };
+
+static const ARM_DRIVER_VERSION DriverVersion = {
+    ARM_FLASH_API_VERSION,
+    FLASH_EMU_DRV_VERSION
+};
+
+static const ARM_FLASH_CAPABILITIES DriverCapabilities = {
+    0, /* event_ready */
+    0, /* data_width = 0:8-bit, 1:16-bit, 2:32-bit */
+    1  /* erase_chip */
+};
+
+static void charge(uint64_t ns)
+{
+    struct timespec ts;
+
+    emu.stats.busy_ns += ns;
+
+    if (emu.cfg->sleep && (ns != 0)) {
+        ts.tv_sec = ns / 1000000000u;
+        ts.tv_nsec = ns % 1000000000u;
+        (void)nanosleep(&ts, NULL);
+    }
+}
+
+static bool is_range_valid(uint32_t addr, uint32_t cnt)
+{
+    return (addr <= emu.size) && (cnt <= emu.size - addr);
+}
+
+/* A NAND device detects, with its ECC, the sectors left partially programmed
+ * or erased by a power cut, and fails to read them until they are erased.
+ */
+static bool is_range_torn(uint32_t addr, uint32_t cnt)
+{
+    uint32_t sector;
+
+    if (!emu.cfg->nand || (cnt == 0)) {
+        return false;
+    }
+
+    for (sector = addr / emu.cfg->sector_size;
+         sector <= (addr + cnt - 1) / emu.cfg->sector_size; sector++) {
+        if (emu.sector_torn[sector]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void set_range_torn(uint32_t addr, uint32_t cnt)
+{
+    uint32_t sector;
+
+    for (sector = addr / emu.cfg->sector_size;
+         sector <= (addr + cnt - 1) / emu.cfg->sector_size; sector++) {
+        emu.sector_torn[sector] = 1;
+    }
+}
+
+static void violation(const char *rule, uint32_t addr)
+{
+    emu.stats.violations++;
+    fprintf(stderr, "flash_emu: %s at 0x%08x\n", rule, (unsigned)addr);
+}
+
+/* Counts a program or erase operation towards a scheduled power cut. Returns
+ * true if the power is cut during this operation.
+ */
+static bool is_cut_now(void)
+{
+    if (emu.ops_to_cut == 0) {
+        return false;
+    }
+
+    emu.ops_to_cut--;
+    if (emu.ops_to_cut == 0) {
+        emu.power_lost = true;
+        return true;
+    }
+
+    return false;
+}
+
+static ARM_DRIVER_VERSION ARM_Flash_GetVersion(void)
+{
+    return DriverVersion;
+}
+
+static ARM_FLASH_CAPABILITIES ARM_Flash_GetCapabilities(void)
+{
+    return DriverCapabilities;
+}
+
+static int32_t ARM_Flash_Initialize(ARM_Flash_SignalEvent_t cb_event)
+{
+    (void)cb_event;
+
+    if (emu.image == NULL) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    return ARM_DRIVER_OK;
+}
+
+static int32_t ARM_Flash_Uninitialize(void)
+{
+    return ARM_DRIVER_OK;
+}
+
+static int32_t ARM_Flash_PowerControl(ARM_POWER_STATE state)
+{
+    switch (state) {
+    case ARM_POWER_FULL:
+        return ARM_DRIVER_OK;
+
+    case ARM_POWER_OFF:
+    case ARM_POWER_LOW:
+    default:
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+    }
+}
+
+static int32_t ARM_Flash_ReadData(uint32_t addr, void *data, uint32_t cnt)
+{
+    if (emu.power_lost) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    if (!is_range_valid(addr, cnt)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    if (is_range_torn(addr, cnt)) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    (void)memcpy(data, emu.image + addr, cnt);
+
+    emu.stats.reads++;
+    emu.stats.read_bytes += cnt;
+    charge(emu.cfg->read_ns + (uint64_t)cnt * emu.cfg->read_byte_ns);
+
+    return (int32_t)cnt;
+}
+
+static int32_t ARM_Flash_ProgramData(uint32_t addr, const void *data,
+                                     uint32_t cnt)
+{
+    const uint32_t unit = emu.cfg->program_unit;
+    const uint8_t *src = data;
+    uint8_t *dst = emu.image + addr;
+    uint32_t num_units;
+    uint32_t i;
+
+    if (emu.power_lost) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    if (!is_range_valid(addr, cnt)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    if (((addr % unit) != 0) || ((cnt % unit) != 0)) {
+        violation("unaligned program", addr);
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    num_units = cnt / unit;
+
+    /* Check the whole operation before programming anything */
+    for (i = 0; i < cnt; i++) {
+        if (emu.cfg->nand) {
+            if (emu.programmed[(addr + i) / unit]) {
+                violation("page programmed twice", addr + i);
+                return ARM_DRIVER_ERROR;
+            }
+        } else if ((dst[i] & src[i]) != src[i]) {
+            violation("bit set by a program", addr + i);
+            return ARM_DRIVER_ERROR;
+        }
+    }
+
+    if (is_cut_now()) {
+        /* Only the first units reach the flash */
+        num_units = emu.cut_seed % (num_units + 1);
+        if (emu.cfg->nand) {
+            set_range_torn(addr, cnt);
+        }
+    }
+
+    for (i = 0; i < num_units * unit; i++) {
+        dst[i] &= src[i];
+    }
+
+    if (emu.cfg->nand) {
+        (void)memset(&emu.programmed[addr / unit], 1, num_units);
+    }
+
+    emu.stats.programs++;
+    emu.stats.program_bytes += (uint64_t)num_units * unit;
+    charge((uint64_t)num_units * emu.cfg->program_ns);
+
+    if (emu.power_lost) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    return (int32_t)cnt;
+}
+
+static int32_t ARM_Flash_EraseSector(uint32_t addr)
+{
+    const uint32_t sector_size = emu.cfg->sector_size;
+    const uint32_t unit = emu.cfg->program_unit;
+    uint32_t size = sector_size;
+
+    if (emu.power_lost) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    if (!is_range_valid(addr, sector_size) || ((addr % sector_size) != 0)) {
+        violation("invalid erase", addr);
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    if (is_cut_now()) {
+        /* The erase stops part of the way through the sector */
+        size = (emu.cut_seed % (sector_size / unit)) * unit;
+    }
+
+    (void)memset(emu.image + addr, FLASH_EMU_ERASE_VALUE, size);
+    emu.sector_torn[addr / sector_size] = (size != sector_size) ? 1u : 0u;
+
+    if (emu.cfg->nand) {
+        (void)memset(&emu.programmed[addr / unit], 0, size / unit);
+    }
+
+    emu.sector_erases[addr / sector_size]++;
+    emu.stats.erases++;
+    charge((uint64_t)emu.cfg->erase_us * 1000u);
+
+    if (emu.power_lost) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    return ARM_DRIVER_OK;
+}
+
+static int32_t ARM_Flash_EraseChip(void)
+{
+    uint32_t addr;
+    int32_t err;
+
+    for (addr = 0; addr < emu.size; addr += emu.cfg->sector_size) {
+        err = ARM_Flash_EraseSector(addr);
+        if (err != ARM_DRIVER_OK) {
+            return err;
+        }
+    }
+
+    return ARM_DRIVER_OK;
+}
+
+static ARM_FLASH_STATUS ARM_Flash_GetStatus(void)
+{
+    ARM_FLASH_STATUS status = {0, 0, 0};
+
+    status.error = emu.power_lost ? 1u : 0u;
+
+    return status;
+}
+
+static ARM_FLASH_INFO *ARM_Flash_GetInfo(void)
+{
+    return &emu.info;
+}
+
+ARM_DRIVER_FLASH Driver_FLASH_EMU = {
+    ARM_Flash_GetVersion,
+    ARM_Flash_GetCapabilities,
+    ARM_Flash_Initialize,
+    ARM_Flash_Uninitialize,
+    ARM_Flash_PowerControl,
+    ARM_Flash_ReadData,
+    ARM_Flash_ProgramData,
+    ARM_Flash_EraseSector,
+    ARM_Flash_EraseChip,
+    ARM_Flash_GetStatus,
+    ARM_Flash_GetInfo
+};
+
+int flash_emu_open(const struct flash_emu_config_t *cfg)
+{
+    struct stat st;
+    size_t size;
+    size_t unit;
+    bool fresh;
+
+    if ((emu.image != NULL) || (cfg->program_unit == 0) ||
+        (cfg->sector_size == 0) || (cfg->sector_count == 0) ||
+        ((cfg->sector_size % cfg->program_unit) != 0)) {
+        return -1;
+    }
+
+    size = (size_t)cfg->sector_size * cfg->sector_count;
+
+    emu.fd = open(cfg->image_path, O_RDWR | O_CREAT, 0644);
+    if (emu.fd < 0) {
+        perror(cfg->image_path);
+        return -1;
+    }
+
+    if (fstat(emu.fd, &st) != 0) {
+        goto fail;
+    }
+
+    /* An image of a different geometry is discarded */
+    fresh = ((size_t)st.st_size != size);
+    if (fresh && (ftruncate(emu.fd, (off_t)size) != 0)) {
+        goto fail;
+    }
+
+    emu.size = size;
+
+    emu.image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, emu.fd, 0);
+    if (emu.image == MAP_FAILED) {
+        emu.image = NULL;
+        goto fail;
+    }
+
+    if (fresh) {
+        (void)memset(emu.image, FLASH_EMU_ERASE_VALUE, size);
+    }
+
+    emu.programmed = calloc(size / cfg->program_unit, 1);
+    if (emu.num_sectors != cfg->sector_count) {
+        free(emu.sector_erases);
+        free(emu.sector_torn);
+        emu.sector_erases = calloc(cfg->sector_count, sizeof(uint32_t));
+        emu.sector_torn = calloc(cfg->sector_count, 1);
+        emu.num_sectors = cfg->sector_count;
+    }
+    if ((emu.programmed == NULL) || (emu.sector_erases == NULL) ||
+        (emu.sector_torn == NULL)) {
+        goto fail;
+    }
+
+    /* The programmed state of a page is not stored in the image. A page
+     * holding anything but the erase value has been programmed.
+     */
+    for (unit = 0; unit < size / cfg->program_unit; unit++) {
+        const uint8_t *page = emu.image + unit * cfg->program_unit;
+        size_t i;
+
+        for (i = 0; i < cfg->program_unit; i++) {
+            if (page[i] != FLASH_EMU_ERASE_VALUE) {
+                emu.programmed[unit] = 1;
+                break;
+            }
+        }
+    }
+
+    emu.cfg = cfg;
+    emu.power_lost = false;
+    emu.ops_to_cut = 0;
+    emu.info = (ARM_FLASH_INFO) {
+        .sector_info = NULL,
+        .sector_count = cfg->sector_count,
+        .sector_size = cfg->sector_size,
+        .page_size = cfg->program_unit,
+        .program_unit = cfg->program_unit,
+        .erased_value = FLASH_EMU_ERASE_VALUE,
+    };
+
+    return 0;
+
+fail:
+    flash_emu_close();
+    return -1;
+}
+
+void flash_emu_close(void)
+{
+    if (emu.image != NULL) {
+        (void)msync(emu.image, emu.size, MS_SYNC);
+        (void)munmap(emu.image, emu.size);
+        emu.image = NULL;
+    }
+
+    if (emu.fd >= 0) {
+        (void)close(emu.fd);
+        emu.fd = -1;
+    }
+
+    /* The sector erase counts and the torn sectors are kept until the end of
+     * the process, so that they persist across emulated reboots.
+     */
+    free(emu.programmed);
+    emu.programmed = NULL;
+}
+
+void flash_emu_set_power_cut(uint32_t num_ops, uint32_t seed)
+{
+    emu.ops_to_cut = num_ops;
+    emu.cut_seed = seed;
+}
+
+bool flash_emu_power_lost(void)
+{
+    return emu.power_lost;
+}
+
+void flash_emu_power_on(void)
+{
+    emu.power_lost = false;
+    emu.ops_to_cut = 0;
+}
+
+const struct flash_emu_stats_t *flash_emu_get_stats(void)
+{
+    uint32_t i;
+
+    emu.stats.min_sector_erases = UINT32_MAX;
+    emu.stats.max_sector_erases = 0;
+
+    for (i = 0; i < emu.num_sectors; i++) {
+        if (emu.sector_erases[i] < emu.stats.min_sector_erases) {
+            emu.stats.min_sector_erases = emu.sector_erases[i];
+        }
+        if (emu.sector_erases[i] > emu.stats.max_sector_erases) {
+            emu.stats.max_sector_erases = emu.sector_erases[i];
+        }
+    }
+
+    return &emu.stats;
+}
+
+void flash_emu_reset_stats(void)
+{
+    (void)memset(&emu.stats, 0, sizeof(emu.stats));
+}
@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  flash_emu.h
+ *
+ * \brief CMSIS flash driver emulating a NOR or NAND flash device on the host.
+ *        The flash content is kept in a memory mapped image file, so it
+ *        survives an emulated power cut or the end of the process.
+ *
+ * \details The emulator rejects the operations the emulated device does not
+ *          support:
+ *          - programs and erases not aligned with the program unit or sector;
+ *          - on NOR flash, programs setting a bit which is already cleared;
+ *          - on NAND flash, programs of a page which has already been
+ *            programmed since it was last erased.
+ *
+ *          Each operation is charged a latency from a simple model. The total
+ *          is reported as the modelled flash busy time and the emulator can
+ *          also sleep for it.
+ *
+ *          A power cut can be scheduled after a number of program and erase
+ *          operations. The interrupted operation is only partially applied and
+ *          the device fails all the operations until flash_emu_power_on() is
+ *          called. On NAND flash, as the ECC would, reads of a sector left
+ *          partially programmed or erased fail until the sector is erased.
+ */
+
+#ifndef __FLASH_EMU_H__
+#define __FLASH_EMU_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Driver_Flash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \struct flash_emu_config_t
+ *
+ * \brief Geometry and latency model of the emulated flash device.
+ */
+struct flash_emu_config_t {
+    const char *image_path;  /*!< Image file, created if it does not exist */
+    uint32_t sector_size;    /*!< Size of an erase sector in bytes */
+    uint32_t sector_count;   /*!< Number of sectors */
+    uint32_t program_unit;   /*!< NOR program unit or NAND page in bytes */
+    bool nand;               /*!< Emulate NAND program rules instead of NOR */
+    uint32_t read_ns;        /*!< Latency of a read operation */
+    uint32_t read_byte_ns;   /*!< Latency of each byte read */
+    uint32_t program_ns;     /*!< Latency of each program unit programmed */
+    uint32_t erase_us;       /*!< Latency of a sector erase */
+    bool sleep;              /*!< Sleep for the modelled latencies */
+};
+
+/*!
+ * \struct flash_emu_stats_t
+ *
+ * \brief Operations performed on the emulated device since it was opened or
+ *        the statistics were last reset.
+ */
+struct flash_emu_stats_t {
+    uint64_t reads;          /*!< Read operations */
+    uint64_t read_bytes;     /*!< Bytes read */
+    uint64_t programs;       /*!< Program operations */
+    uint64_t program_bytes;  /*!< Bytes programmed */
+    uint64_t erases;         /*!< Sectors erased */
+    uint64_t busy_ns;        /*!< Modelled time the device was busy */
+    uint32_t violations;     /*!< Operations rejected by the program rules */
+    uint32_t min_sector_erases; /*!< Erases of the least erased sector */
+    uint32_t max_sector_erases; /*!< Erases of the most erased sector */
+};
+
+/* CMSIS driver of the emulated device */
+extern ARM_DRIVER_FLASH Driver_FLASH_EMU;
+
+/**
+ * \brief Opens the emulated device. A new image file is created erased. An
+ *        existing image file of the right size is used as it is.
+ *
+ * \param[in] cfg  Device configuration. It must stay valid until the device
+ *                 is closed.
+ *
+ * \return Returns 0 on success, -1 otherwise.
+ */
+int flash_emu_open(const struct flash_emu_config_t *cfg);
+
+/**
+ * \brief Writes the image back to its file and closes the emulated device.
+ */
+void flash_emu_close(void);
+
+/**
+ * \brief Schedules a power cut.
+ *
+ * \param[in] num_ops  The power is cut during the num_ops-th program or erase
+ *                     operation from now. 0 cancels a scheduled power cut.
+ * \param[in] seed     Seed selecting how much of the interrupted operation is
+ *                     applied
+ */
+void flash_emu_set_power_cut(uint32_t num_ops, uint32_t seed);
+
+/**
+ * \brief Checks whether the power of the emulated device has been cut.
+ *
+ * \return Returns true if the device has lost power.
+ */
+bool flash_emu_power_lost(void);
+
+/**
+ * \brief Restores the power of the emulated device after a power cut.
+ */
+void flash_emu_power_on(void);
+
+/**
+ * \brief Gets the operation statistics of the emulated device.
+ *
+ * \return Returns a pointer to the statistics.
+ */
+const struct flash_emu_stats_t *flash_emu_get_stats(void);
+
+/**
+ * \brief Resets the operation statistics, except the erase count of each
+ *        sector.
+ */
+void flash_emu_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLASH_EMU_H__ */
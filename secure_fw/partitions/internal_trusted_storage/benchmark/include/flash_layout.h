@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  flash_layout.h
+ *
+ * \brief Flash layout of the host benchmark. Both ITS and PS use the file
+ *        backed flash emulator. The program units are the largest ones the
+ *        benchmark accepts for NOR flash, the filesystem configuration sets the
+ *        program unit actually used at run time.
+ */
+
+#ifndef __FLASH_LAYOUT_H__
+#define __FLASH_LAYOUT_H__
+
+#define TFM_HAL_ITS_FLASH_DRIVER Driver_FLASH_EMU
+#define TFM_HAL_ITS_PROGRAM_UNIT 16
+
+#define TFM_HAL_PS_FLASH_DRIVER  Driver_FLASH_EMU
+#define TFM_HAL_PS_PROGRAM_UNIT  16
+
+#endif /* __FLASH_LAYOUT_H__ */
@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  framework_feature.h
+ *
+ * \brief Framework features of the host tests, which are otherwise generated
+ *        from the build configuration. The services copy the client data with
+ *        the request manager, as with the IPC model without memory mapped
+ *        vectors.
+ */
+
+#ifndef __PSA_FRAMEWORK_FEATURE_H__
+#define __PSA_FRAMEWORK_FEATURE_H__
+
+#define PSA_FRAMEWORK_ISOLATION_LEVEL  1
+#define PSA_FRAMEWORK_HAS_MM_IOVEC     0
+
+#endif /* __PSA_FRAMEWORK_FEATURE_H__ */
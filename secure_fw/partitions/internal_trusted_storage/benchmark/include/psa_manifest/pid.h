@@ -0,0 +1,21 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  pid.h
+ *
+ * \brief Partition IDs of the host benchmark, which are otherwise generated
+ *        from the partition manifests.
+ */
+
+#ifndef __PSA_MANIFEST_PID_H__
+#define __PSA_MANIFEST_PID_H__
+
+#define TFM_SP_PS   (256)
+#define TFM_SP_ITS  (257)
+
+#endif /* __PSA_MANIFEST_PID_H__ */
@@ -0,0 +1,945 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host benchmark of the ITS flash filesystem. It runs a random workload of
+ * ITS or PS shaped storage requests on the file backed flash emulator and
+ * reports the modelled flash time and the flash wear. In crash mode, it cuts
+ * the power at random points, remounts the filesystem from the image file and
+ * checks that every file holds either its old or its new content.
+ */
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config_tfm.h"
+#include "flash_emu.h"
+#include "flash/its_flash_nand.h"
+#include "flash/its_flash_nor.h"
+#include "flash_fs/its_flash_fs.h"
+#include "its_utils.h"
+#include "ps_object_defs.h"
+
+/* Approximate size of the PS object table: the table header and, per entry,
+ * an authentication tag, a UID and a client ID.
+ */
+#define BENCH_PS_TABLE_SIZE  (32u + ((PS_NUM_ASSETS + 1u) * 32u))
+
+/* File IDs of the two PS object tables */
+#define BENCH_PS_TABLE_FILE_0  0u
+#define BENCH_PS_TABLE_FILE_1  1u
+#define BENCH_PS_NUM_TABLES    2u
+
+enum bench_profile_t {
+    BENCH_PROFILE_ITS,
+    BENCH_PROFILE_PS,
+};
+
+enum bench_op_t {
+    BENCH_OP_SET,
+    BENCH_OP_GET,
+    BENCH_OP_REMOVE,
+    BENCH_NUM_OPS,
+};
+
+static const char *const op_names[BENCH_NUM_OPS] = { "set", "get", "remove" };
+
+struct bench_file_t {
+    bool exists;
+    size_t size;
+    uint8_t *data;
+};
+
+/* A file write or delete interrupted by a power cut. After the reboot, the
+ * file must hold either the content of the model or the new content.
+ */
+struct bench_pending_t {
+    bool valid;
+    uint32_t idx;
+    bool exists;
+    size_t size;
+    uint8_t *data;
+};
+
+struct bench_op_stats_t {
+    uint32_t count;
+    uint32_t failed;
+    uint64_t busy_ns;
+};
+
+static struct {
+    /* Options */
+    const char *image_path;
+    enum bench_profile_t profile;
+    bool nand;
+    uint32_t num_ops;
+    uint32_t get_percent;
+    uint32_t seed;
+    uint32_t num_cuts;
+    uint32_t cut_window;
+    uint32_t num_blocks;
+    uint32_t update_size;
+    bool maintain;
+    struct flash_emu_config_t emu_cfg;
+
+    /* Filesystem */
+    struct its_flash_fs_config_t fs_cfg;
+    const struct its_flash_fs_ops_t *fs_ops;
+    struct its_flash_fs_ctx_t fs_ctx;
+    struct its_flash_nand_dev_t nand_dev;
+
+    /* Model of the filesystem content */
+    struct bench_file_t *files;
+    struct bench_pending_t pending;
+    uint32_t num_uids;
+    int32_t *uid_file;      /* PS profile: file holding each UID */
+    uint32_t table_file;    /* PS profile: file holding the latest table */
+    uint8_t *buf;
+
+    /* Results */
+    struct bench_op_stats_t ops[BENCH_NUM_OPS];
+    uint64_t user_bytes;
+    uint32_t cuts;
+    uint64_t mount_ns;
+    uint64_t maintain_ns;
+    uint32_t errors;
+#if ITS_FLASH_FS_STATS
+    struct its_flash_fs_stats_t fs_stats;
+#endif
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    struct its_flash_fs_cache_stats_t cache_stats;
+#endif
+} bench = {
+    .image_path = "its_bench.img",
+    .num_ops = 10000,
+    .get_percent = 35,
+    .seed = 1,
+    .cut_window = 50,
+    .emu_cfg = {
+        .sector_size = 4096,
+        .read_ns = 100,
+        .read_byte_ns = 10,
+        .program_ns = 10000,
+        .erase_us = 20000,
+    },
+};
+
+static uint32_t rand_state;
+
+static uint32_t bench_rand(void)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+static void make_fid(uint32_t idx, uint8_t *fid)
+{
+    (void)memset(fid, 0, ITS_FILE_ID_SIZE);
+    /* An all-zero file ID is not valid */
+    (void)memcpy(fid, &(uint32_t){ idx + 1u }, sizeof(uint32_t));
+}
+
+static void fill(uint8_t *data, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        data[i] = (uint8_t)bench_rand();
+    }
+}
+
+static size_t random_size(size_t min, size_t max)
+{
+    size_t size = min + (bench_rand() % (max - min + 1u));
+
+    return ITS_UTILS_MIN(ITS_UTILS_ALIGN(size, bench.fs_cfg.program_unit),
+                         bench.fs_cfg.max_file_size);
+}
+
+static void error(const char *what, uint32_t idx, psa_status_t status)
+{
+    bench.errors++;
+    fprintf(stderr, "error: %s of file %u after %u power cuts (status %d)\n",
+            what, (unsigned)idx, (unsigned)bench.cuts, (int)status);
+}
+
+static void accumulate_fs_stats(void)
+{
+#if ITS_FLASH_FS_STATS
+    const struct its_flash_fs_stats_t *s =
+        its_flash_fs_get_stats(&bench.fs_ctx);
+#endif
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    const struct its_flash_fs_cache_stats_t *c =
+        its_flash_fs_get_cache_stats(&bench.fs_ctx);
+#endif
+
+#if ITS_FLASH_FS_STATS
+    bench.fs_stats.moved_bytes += s->moved_bytes;
+    bench.fs_stats.metablock_swaps += s->metablock_swaps;
+    bench.fs_stats.compactions += s->compactions;
+#endif
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    bench.cache_stats.hits += c->hits;
+    bench.cache_stats.misses += c->misses;
+    bench.cache_stats.bypasses += c->bypasses;
+    bench.cache_stats.invalidations += c->invalidations;
+#endif
+}
+
+/* Writes a whole file and updates the model */
+static psa_status_t file_write(uint32_t idx, const uint8_t *data, size_t size)
+{
+    struct its_flash_fs_file_info_t info = {
+        .size_max = size,
+        .flags = ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE,
+    };
+    struct bench_file_t *file = &bench.files[idx];
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    psa_status_t status;
+
+    make_fid(idx, fid);
+
+    status = its_flash_fs_file_write(&bench.fs_ctx, fid, &info, size, 0, data);
+    if (status == PSA_SUCCESS) {
+        file->exists = true;
+        file->size = size;
+        (void)memcpy(file->data, data, size);
+        bench.user_bytes += size;
+    } else if (flash_emu_power_lost()) {
+        bench.pending.valid = true;
+        bench.pending.idx = idx;
+        bench.pending.exists = true;
+        bench.pending.size = size;
+        (void)memcpy(bench.pending.data, data, size);
+    }
+
+    return status;
+}
+
+/* Writes part of an existing file and updates the model */
+static psa_status_t file_update(uint32_t idx, size_t offset, const uint8_t *data,
+                                size_t size)
+{
+    struct its_flash_fs_file_info_t info = {0};
+    struct bench_file_t *file = &bench.files[idx];
+    size_t new_size = ITS_UTILS_MAX(file->size, offset + size);
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    psa_status_t status;
+
+    make_fid(idx, fid);
+
+    status = its_flash_fs_file_write(&bench.fs_ctx, fid, &info, size, offset,
+                                     data);
+    if (status == PSA_SUCCESS) {
+        file->size = new_size;
+        (void)memcpy(file->data + offset, data, size);
+        bench.user_bytes += size;
+    } else if (flash_emu_power_lost()) {
+        bench.pending.valid = true;
+        bench.pending.idx = idx;
+        bench.pending.exists = true;
+        bench.pending.size = new_size;
+        (void)memcpy(bench.pending.data, file->data, file->size);
+        (void)memcpy(bench.pending.data + offset, data, size);
+    }
+
+    return status;
+}
+
+/* Deletes a file and updates the model */
+static psa_status_t file_delete(uint32_t idx)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    psa_status_t status;
+
+    make_fid(idx, fid);
+
+    status = its_flash_fs_file_delete(&bench.fs_ctx, fid);
+    if (status == PSA_SUCCESS) {
+        bench.files[idx].exists = false;
+    } else if (flash_emu_power_lost()) {
+        bench.pending.valid = true;
+        bench.pending.idx = idx;
+        bench.pending.exists = false;
+    }
+
+    return status;
+}
+
+/* Reads a whole file and checks it against the model. Returns true if the
+ * content matches the expected existence, size and data.
+ */
+static bool file_matches(uint32_t idx, bool exists, size_t size,
+                         const uint8_t *data)
+{
+    struct its_flash_fs_file_info_t info;
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    psa_status_t status;
+
+    make_fid(idx, fid);
+
+    status = its_flash_fs_file_get_info(&bench.fs_ctx, fid, &info);
+    if (status == PSA_ERROR_DOES_NOT_EXIST) {
+        return !exists;
+    } else if ((status != PSA_SUCCESS) || !exists ||
+               (info.size_current != size)) {
+        return false;
+    }
+
+    status = its_flash_fs_file_read(&bench.fs_ctx, fid, size, 0, bench.buf);
+
+    return (status == PSA_SUCCESS) && (memcmp(bench.buf, data, size) == 0);
+}
+
+static psa_status_t file_check(uint32_t idx)
+{
+    const struct bench_file_t *file = &bench.files[idx];
+
+    if (!file_matches(idx, file->exists, file->size, file->data)) {
+        error("check", idx, PSA_ERROR_DATA_CORRUPT);
+    }
+
+    return PSA_SUCCESS;
+}
+
+/* Picks a file which is neither a table nor in use by a UID */
+static int32_t ps_free_file(void)
+{
+    uint32_t idx;
+
+    for (idx = BENCH_PS_NUM_TABLES; idx < bench.fs_cfg.max_num_files; idx++) {
+        if (!bench.files[idx].exists) {
+            return (int32_t)idx;
+        }
+    }
+
+    return -1;
+}
+
+static psa_status_t ps_write_table(void)
+{
+    uint32_t next = (bench.table_file == BENCH_PS_TABLE_FILE_0) ?
+                    BENCH_PS_TABLE_FILE_1 : BENCH_PS_TABLE_FILE_0;
+    psa_status_t status;
+
+    fill(bench.buf, BENCH_PS_TABLE_SIZE);
+    status = file_write(next, bench.buf, BENCH_PS_TABLE_SIZE);
+    if (status == PSA_SUCCESS) {
+        bench.table_file = next;
+    }
+
+    return status;
+}
+
+/* Replays a PS request the way the PS object layer issues it to the
+ * filesystem: the new object is written to a free file, the object table is
+ * rewritten and the old object file is deleted.
+ */
+static psa_status_t ps_op(enum bench_op_t op, uint32_t uid)
+{
+    int32_t old_idx = bench.uid_file[uid];
+    int32_t new_idx;
+    psa_status_t status;
+    size_t size;
+
+    switch (op) {
+    case BENCH_OP_SET:
+        new_idx = ps_free_file();
+        if (new_idx < 0) {
+            return PSA_ERROR_INSUFFICIENT_STORAGE;
+        }
+        size = random_size(PS_OBJECT_HEADER_SIZE + 1u, PS_MAX_OBJECT_SIZE);
+        fill(bench.buf, size);
+        status = file_write((uint32_t)new_idx, bench.buf, size);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+        bench.uid_file[uid] = new_idx;
+        break;
+
+    case BENCH_OP_GET:
+        if (old_idx < 0) {
+            return PSA_ERROR_DOES_NOT_EXIST;
+        }
+        return file_check((uint32_t)old_idx);
+
+    case BENCH_OP_REMOVE:
+        if (old_idx < 0) {
+            return PSA_ERROR_DOES_NOT_EXIST;
+        }
+        bench.uid_file[uid] = -1;
+        break;
+
+    default:
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    status = ps_write_table();
+    if (status != PSA_SUCCESS) {
+        /* The table still refers to the old object. After a power cut, the
+         * new object file is deleted at the next mount.
+         */
+        if ((op == BENCH_OP_SET) && !flash_emu_power_lost()) {
+            (void)file_delete((uint32_t)bench.uid_file[uid]);
+        }
+        bench.uid_file[uid] = old_idx;
+        return status;
+    }
+
+    if (old_idx >= 0) {
+        /* A failure leaves an orphan file, deleted at the next mount */
+        (void)file_delete((uint32_t)old_idx);
+    }
+
+    return PSA_SUCCESS;
+}
+
+static psa_status_t its_op(enum bench_op_t op, uint32_t uid)
+{
+    const struct bench_file_t *file = &bench.files[uid];
+    size_t offset;
+    size_t size;
+
+    switch (op) {
+    case BENCH_OP_SET:
+        if (bench.update_size != 0) {
+            if (file->exists && (file->size >= bench.update_size)) {
+                /* Rewrite part of the file at a program unit boundary */
+                offset = bench_rand() % (file->size - bench.update_size + 1u);
+                offset -= offset % bench.fs_cfg.program_unit;
+                fill(bench.buf, bench.update_size);
+                return file_update(uid, offset, bench.buf, bench.update_size);
+            }
+            size = bench.fs_cfg.max_file_size;
+        } else {
+            size = random_size(1, bench.fs_cfg.max_file_size);
+        }
+        fill(bench.buf, size);
+        return file_write(uid, bench.buf, size);
+
+    case BENCH_OP_GET:
+        if (!bench.files[uid].exists) {
+            return PSA_ERROR_DOES_NOT_EXIST;
+        }
+        return file_check(uid);
+
+    case BENCH_OP_REMOVE:
+        if (!bench.files[uid].exists) {
+            return PSA_ERROR_DOES_NOT_EXIST;
+        }
+        return file_delete(uid);
+
+    default:
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+}
+
+static psa_status_t mount(bool wipe)
+{
+    uint64_t busy_ns = flash_emu_get_stats()->busy_ns;
+    psa_status_t status;
+
+    if (flash_emu_open(&bench.emu_cfg) != 0) {
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    if (Driver_FLASH_EMU.Initialize(NULL) != ARM_DRIVER_OK) {
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    bench.nand_dev.buf_block_id_0 = ITS_BLOCK_INVALID_ID;
+    bench.nand_dev.buf_block_id_1 = ITS_BLOCK_INVALID_ID;
+
+    status = its_flash_fs_init_ctx(&bench.fs_ctx, &bench.fs_cfg, bench.fs_ops);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    if (wipe) {
+        status = its_flash_fs_wipe_all(&bench.fs_ctx);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+
+    status = its_flash_fs_prepare(&bench.fs_ctx);
+
+    bench.mount_ns += flash_emu_get_stats()->busy_ns - busy_ns;
+
+    return status;
+}
+
+/* Reboots after a power cut and checks the content of every file */
+static psa_status_t reboot(void)
+{
+    struct bench_pending_t *pending = &bench.pending;
+    uint32_t idx;
+    uint32_t uid;
+    psa_status_t status;
+    bool referenced;
+
+    accumulate_fs_stats();
+    flash_emu_close();
+    bench.cuts++;
+
+    status = mount(false);
+    if (status != PSA_SUCCESS) {
+        error("mount", 0, status);
+
+        /* Carry on with an empty filesystem */
+        flash_emu_close();
+        status = mount(true);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        for (idx = 0; idx < bench.fs_cfg.max_num_files; idx++) {
+            bench.files[idx].exists = false;
+        }
+        for (uid = 0; (bench.uid_file != NULL) && (uid < bench.num_uids);
+             uid++) {
+            bench.uid_file[uid] = -1;
+        }
+        pending->valid = false;
+
+        return PSA_SUCCESS;
+    }
+
+    for (idx = 0; idx < bench.fs_cfg.max_num_files; idx++) {
+        struct bench_file_t *file = &bench.files[idx];
+
+        if (pending->valid && (pending->idx == idx) &&
+            file_matches(idx, pending->exists, pending->size,
+                         pending->data)) {
+            /* The interrupted operation has completed */
+            file->exists = pending->exists;
+            file->size = pending->size;
+            (void)memcpy(file->data, pending->data, pending->size);
+            continue;
+        }
+
+        if (!file_matches(idx, file->exists, file->size, file->data)) {
+            error("recovery", idx, PSA_ERROR_DATA_CORRUPT);
+        }
+    }
+
+    pending->valid = false;
+
+    if (bench.profile != BENCH_PROFILE_PS) {
+        return PSA_SUCCESS;
+    }
+
+    /* Delete the object files left behind by an interrupted request */
+    for (idx = BENCH_PS_NUM_TABLES; idx < bench.fs_cfg.max_num_files; idx++) {
+        referenced = false;
+        for (uid = 0; uid < bench.num_uids; uid++) {
+            referenced |= (bench.uid_file[uid] == (int32_t)idx);
+        }
+        if (bench.files[idx].exists && !referenced) {
+            status = file_delete(idx);
+            if (status != PSA_SUCCESS) {
+                return status;
+            }
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+static int run(void)
+{
+    const struct flash_emu_stats_t *emu_stats = flash_emu_get_stats();
+    enum bench_op_t op;
+    uint32_t uid;
+    uint32_t i;
+    uint32_t r;
+    uint32_t set_percent;
+    uint64_t busy_ns;
+    psa_status_t status;
+
+    /* The sets and removes share the requests which are not gets 50:15 */
+    set_percent = ((100u - bench.get_percent) * 50u) / 65u;
+
+    for (i = 0; i < bench.num_ops; i++) {
+        if ((bench.cuts < bench.num_cuts) && !flash_emu_power_lost()) {
+            /* Keep a power cut scheduled */
+            r = bench_rand();
+            flash_emu_set_power_cut(1u + (r % bench.cut_window), bench_rand());
+        }
+
+        r = bench_rand() % 100u;
+        if (bench.update_size != 0) {
+            /* The files are not removed, so that they stay large */
+            op = (r < bench.get_percent) ? BENCH_OP_GET : BENCH_OP_SET;
+        } else {
+            op = (r < set_percent) ? BENCH_OP_SET :
+                 (r < set_percent + bench.get_percent) ? BENCH_OP_GET :
+                                                         BENCH_OP_REMOVE;
+        }
+        uid = bench_rand() % bench.num_uids;
+
+        busy_ns = emu_stats->busy_ns;
+        status = (bench.profile == BENCH_PROFILE_PS) ? ps_op(op, uid) :
+                                                       its_op(op, uid);
+        bench.ops[op].busy_ns += emu_stats->busy_ns - busy_ns;
+        bench.ops[op].count++;
+
+        if (flash_emu_power_lost()) {
+            status = reboot();
+            if (status != PSA_SUCCESS) {
+                return -1;
+            }
+        } else if ((status != PSA_SUCCESS) &&
+                   (status != PSA_ERROR_DOES_NOT_EXIST)) {
+            /* Typically the filesystem being full */
+            bench.ops[op].failed++;
+        }
+
+#if ITS_BACKGROUND_MAINTENANCE
+        if (bench.maintain && !flash_emu_power_lost()) {
+            /* The system is idle until the next request */
+            busy_ns = emu_stats->busy_ns;
+            status = its_flash_fs_maintain(&bench.fs_ctx);
+            bench.maintain_ns += emu_stats->busy_ns - busy_ns;
+
+            if (flash_emu_power_lost()) {
+                status = reboot();
+                if (status != PSA_SUCCESS) {
+                    return -1;
+                }
+            } else if (status != PSA_SUCCESS) {
+                error("maintain", 0, status);
+            }
+        }
+#endif
+    }
+
+    flash_emu_set_power_cut(0, 0);
+
+    /* Final check of the whole content */
+    for (i = 0; i < bench.fs_cfg.max_num_files; i++) {
+        (void)file_check(i);
+    }
+
+    accumulate_fs_stats();
+
+    return 0;
+}
+
+static void report(double wall_s)
+{
+    const struct flash_emu_stats_t *s = flash_emu_get_stats();
+    uint32_t num_ops = 0;
+    uint32_t i;
+
+    printf("%s profile, %s filesystem, %s flash: %u sectors of %u bytes, "
+           "program unit %u bytes\n",
+           (bench.profile == BENCH_PROFILE_PS) ? "PS" : "ITS",
+           ITS_FLASH_FS_LOG ? "log-structured" : "block",
+           bench.nand ? "NAND" : "NOR",
+           (unsigned)bench.emu_cfg.sector_count,
+           (unsigned)bench.emu_cfg.sector_size,
+           (unsigned)bench.emu_cfg.program_unit);
+
+    for (i = 0; i < BENCH_NUM_OPS; i++) {
+        const struct bench_op_stats_t *op = &bench.ops[i];
+
+        num_ops += op->count;
+        printf("  %-6s %8u ops, %6u failed, %10.1f us/op\n", op_names[i],
+               (unsigned)op->count, (unsigned)op->failed,
+               op->count ? (op->busy_ns / 1e3) / op->count : 0.0);
+    }
+
+    printf("  flash busy %.3f s, %.0f ops/s, host time %.3f s\n",
+           s->busy_ns / 1e9, s->busy_ns ? num_ops / (s->busy_ns / 1e9) : 0.0,
+           wall_s);
+    printf("  reads %llu (%llu bytes), programs %llu (%llu bytes), "
+           "erases %llu\n",
+           (unsigned long long)s->reads, (unsigned long long)s->read_bytes,
+           (unsigned long long)s->programs,
+           (unsigned long long)s->program_bytes,
+           (unsigned long long)s->erases);
+    printf("  user bytes %llu, write amplification %.2f, sector erases "
+           "%u..%u\n",
+           (unsigned long long)bench.user_bytes,
+           bench.user_bytes ? (double)s->program_bytes / bench.user_bytes : 0.0,
+           (unsigned)s->min_sector_erases, (unsigned)s->max_sector_erases);
+#if ITS_FLASH_FS_STATS
+    printf("  moved bytes %u, metadata block swaps %u, compactions %u\n",
+           (unsigned)bench.fs_stats.moved_bytes,
+           (unsigned)bench.fs_stats.metablock_swaps,
+           (unsigned)bench.fs_stats.compactions);
+#endif
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    printf("  cache %u bytes: hits %u, misses %u, hit rate %.1f%%, "
+           "bypasses %u, invalidations %u\n",
+           (unsigned)ITS_FLASH_FS_CACHE_SIZE,
+           (unsigned)bench.cache_stats.hits,
+           (unsigned)bench.cache_stats.misses,
+           (bench.cache_stats.hits + bench.cache_stats.misses) ?
+           (100.0 * bench.cache_stats.hits) /
+           (bench.cache_stats.hits + bench.cache_stats.misses) : 0.0,
+           (unsigned)bench.cache_stats.bypasses,
+           (unsigned)bench.cache_stats.invalidations);
+#endif
+    if (bench.maintain) {
+        printf("  background maintenance %.3f s\n", bench.maintain_ns / 1e9);
+    }
+    if (bench.cuts != 0) {
+        printf("  power cuts %u, remount %.1f us average\n",
+               (unsigned)bench.cuts, (bench.mount_ns / 1e3) / bench.cuts);
+    }
+    printf("  program rule violations %u, errors %u\n",
+           (unsigned)s->violations, (unsigned)bench.errors);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -i <file>   Flash image file (default its_bench.img)\n"
+        "  -p its|ps   Request profile (default its)\n"
+        "  -t nor|nand Flash type (default nor)\n"
+        "  -b <n>      Number of filesystem blocks\n"
+        "  -S <bytes>  Sector size, also the filesystem block size\n"
+        "  -u <bytes>  NOR program unit or NAND page size\n"
+        "  -n <ops>    Number of requests (default 10000)\n"
+        "  -g <pct>    Percentage of gets in the requests (default 35)\n"
+        "  -U <bytes>  ITS profile: create the files with the maximum size,\n"
+        "              then set <bytes> at a random offset of them, and do not\n"
+        "              remove them\n"
+        "  -s <seed>   Random seed (default 1)\n"
+        "  -c <cuts>   Number of power cuts, 0 to disable (default 0)\n"
+        "  -w <ops>    Maximum program and erase operations before a power\n"
+        "              cut (default 50)\n"
+        "  -E <us>     Sector erase latency\n"
+        "  -P <ns>     Program unit latency\n"
+        "  -R <ns>     Read latency per byte\n"
+        "  -m          Run the background maintenance after each request\n"
+        "  -d          Sleep for the modelled latencies\n", prog);
+}
+
+static int parse_options(int argc, char *argv[])
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:p:t:b:S:u:n:g:U:s:c:w:E:P:R:mdh")) != -1) {
+        switch (opt) {
+        case 'i':
+            bench.image_path = optarg;
+            break;
+        case 'p':
+            if (strcmp(optarg, "ps") == 0) {
+                bench.profile = BENCH_PROFILE_PS;
+            } else if (strcmp(optarg, "its") != 0) {
+                return -1;
+            }
+            break;
+        case 't':
+            if (strcmp(optarg, "nand") == 0) {
+                bench.nand = true;
+            } else if (strcmp(optarg, "nor") != 0) {
+                return -1;
+            }
+            break;
+        case 'b':
+            bench.num_blocks = strtoul(optarg, NULL, 0);
+            break;
+        case 'S':
+            bench.emu_cfg.sector_size = strtoul(optarg, NULL, 0);
+            break;
+        case 'u':
+            bench.emu_cfg.program_unit = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            bench.num_ops = strtoul(optarg, NULL, 0);
+            break;
+        case 'g':
+            bench.get_percent = strtoul(optarg, NULL, 0);
+            break;
+        case 'U':
+            bench.update_size = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            bench.seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            bench.num_cuts = strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            bench.cut_window = strtoul(optarg, NULL, 0);
+            break;
+        case 'E':
+            bench.emu_cfg.erase_us = strtoul(optarg, NULL, 0);
+            break;
+        case 'P':
+            bench.emu_cfg.program_ns = strtoul(optarg, NULL, 0);
+            break;
+        case 'R':
+            bench.emu_cfg.read_byte_ns = strtoul(optarg, NULL, 0);
+            break;
+        case 'm':
+            bench.maintain = true;
+            break;
+        case 'd':
+            bench.emu_cfg.sleep = true;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    return ((bench.cut_window != 0) && (bench.get_percent <= 100)) ? 0 : -1;
+}
+
+static int setup(void)
+{
+    struct its_flash_fs_config_t *cfg = &bench.fs_cfg;
+    uint32_t i;
+
+    if (bench.emu_cfg.program_unit == 0) {
+        bench.emu_cfg.program_unit = bench.nand ? 512 :
+                                     TFM_HAL_ITS_PROGRAM_UNIT;
+    }
+
+    if (bench.num_blocks == 0) {
+        bench.num_blocks = (bench.profile == BENCH_PROFILE_PS) ? 5 : 4;
+    }
+
+    if (bench.nand) {
+#if ITS_FLASH_FS_LOG
+        fprintf(stderr, "The log-structured filesystem does not support "
+                        "NAND flash\n");
+        return -1;
+#endif
+        /* The NAND driver programs whole blocks */
+        cfg->program_unit = 1;
+        cfg->flash_dev = &bench.nand_dev;
+        bench.fs_ops = &its_flash_fs_ops_nand;
+        bench.nand_dev.driver = &Driver_FLASH_EMU;
+        bench.nand_dev.buf_size = bench.emu_cfg.sector_size;
+        bench.nand_dev.write_buf_0 = calloc(1, bench.nand_dev.buf_size);
+        bench.nand_dev.write_buf_1 = calloc(1, bench.nand_dev.buf_size);
+        if ((bench.nand_dev.write_buf_0 == NULL) ||
+            (bench.nand_dev.write_buf_1 == NULL)) {
+            return -1;
+        }
+    } else {
+        if ((bench.emu_cfg.program_unit > TFM_HAL_ITS_PROGRAM_UNIT) ||
+            !ITS_UTILS_IS_ALIGNED(TFM_HAL_ITS_PROGRAM_UNIT,
+                                  bench.emu_cfg.program_unit)) {
+            fprintf(stderr, "The NOR program unit must divide %u\n",
+                    (unsigned)TFM_HAL_ITS_PROGRAM_UNIT);
+            return -1;
+        }
+        cfg->program_unit = bench.emu_cfg.program_unit;
+        cfg->flash_dev = &Driver_FLASH_EMU;
+        bench.fs_ops = &its_flash_fs_ops_nor;
+    }
+
+    bench.emu_cfg.image_path = bench.image_path;
+    bench.emu_cfg.sector_count = bench.num_blocks;
+    bench.emu_cfg.nand = bench.nand;
+
+    cfg->flash_area_addr = 0;
+    cfg->sector_size = bench.emu_cfg.sector_size;
+    cfg->block_size = bench.emu_cfg.sector_size;
+    cfg->num_blocks = bench.num_blocks;
+    cfg->erase_val = 0xFF;
+
+    if (bench.profile == BENCH_PROFILE_PS) {
+        cfg->max_file_size = ITS_UTILS_ALIGN(PS_MAX_OBJECT_SIZE,
+                                             cfg->program_unit);
+        cfg->max_num_files = PS_MAX_NUM_OBJECTS;
+        bench.num_uids = PS_NUM_ASSETS;
+        bench.uid_file = malloc(bench.num_uids * sizeof(int32_t));
+        if (bench.uid_file == NULL) {
+            return -1;
+        }
+        for (i = 0; i < bench.num_uids; i++) {
+            bench.uid_file[i] = -1;
+        }
+        bench.table_file = BENCH_PS_TABLE_FILE_1;
+    } else {
+        cfg->max_file_size = ITS_UTILS_ALIGN(ITS_MAX_ASSET_SIZE,
+                                             cfg->program_unit);
+        cfg->max_num_files = ITS_NUM_ASSETS;
+        bench.num_uids = ITS_NUM_ASSETS;
+    }
+
+    if (bench.update_size > cfg->max_file_size) {
+        fprintf(stderr, "The update size must not exceed %u bytes\n",
+                (unsigned)cfg->max_file_size);
+        return -1;
+    }
+
+    bench.files = calloc(cfg->max_num_files, sizeof(*bench.files));
+    bench.buf = malloc(cfg->max_file_size);
+    bench.pending.data = malloc(cfg->max_file_size);
+    if ((bench.files == NULL) || (bench.buf == NULL) ||
+        (bench.pending.data == NULL)) {
+        return -1;
+    }
+
+    for (i = 0; i < cfg->max_num_files; i++) {
+        bench.files[i].data = malloc(cfg->max_file_size);
+        if (bench.files[i].data == NULL) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct timespec start, end;
+    psa_status_t status;
+    int ret;
+
+    if ((parse_options(argc, argv) != 0) || (setup() != 0)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    rand_state = (bench.seed != 0) ? bench.seed : 1;
+
+    status = mount(true);
+    if (status != PSA_SUCCESS) {
+        fprintf(stderr, "Cannot create the filesystem (status %d)\n",
+                (int)status);
+        return 1;
+    }
+
+    /* Measure the requests only */
+    flash_emu_reset_stats();
+    bench.mount_ns = 0;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    ret = run();
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+    report((end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+
+    flash_emu_close();
+
+    if ((ret != 0) || (bench.errors != 0) ||
+        (flash_emu_get_stats()->violations != 0)) {
+        return 1;
+    }
+
+    return 0;
+}
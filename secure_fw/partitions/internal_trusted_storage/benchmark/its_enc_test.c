@@ -0,0 +1,560 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host tests of the ITS service with ITS_ENCRYPTION on the file backed flash
+ * emulator. The AEAD of the platform is replaced by a checksum and a
+ * keystream, which handle the buffers as the template implementation does.
+ * The tests check partial reads of the files encrypted in chunks, the reads
+ * of the files encrypted as a whole by the previous versions, and that a set
+ * interrupted by a power cut leaves either the old or the new asset.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "flash_emu.h"
+#include "flash/its_flash.h"
+#include "flash_fs/its_flash_fs.h"
+#include "its_utils.h"
+#include "psa/internal_trusted_storage.h"
+#include "tfm_hal_its.h"
+#include "tfm_hal_its_encryption.h"
+#include "tfm_internal_trusted_storage.h"
+#include "tfm_its_req_mngr.h"
+
+#define TEST_IMAGE_PATH      "its_enc_test.img"
+#define TEST_NUM_BLOCKS      6u
+#define TEST_BLOCK_SIZE      4096u
+
+#define TEST_CLIENT_ID       (-1)
+#define TEST_UID             1u
+#define TEST_NUM_UIDS        4u
+
+/* Number of random requests, of power cuts, and of flash operations among
+ * which the power is cut, which cover a set of the largest asset
+ */
+#define TEST_NUM_OPS         2000u
+#define TEST_NUM_CUTS        200u
+#define TEST_CUT_WINDOW      96u
+
+static const struct flash_emu_config_t emu_cfg = {
+    .image_path = TEST_IMAGE_PATH,
+    .sector_size = TEST_BLOCK_SIZE,
+    .sector_count = TEST_NUM_BLOCKS,
+    .program_unit = TFM_HAL_ITS_PROGRAM_UNIT,
+};
+
+/* Configuration of the ITS filesystem of the service */
+static struct its_flash_fs_config_t fs_cfg = {
+    .flash_dev = &ITS_FLASH_DEV,
+    .sector_size = TEST_BLOCK_SIZE,
+    .block_size = TEST_BLOCK_SIZE,
+    .num_blocks = TEST_NUM_BLOCKS,
+    .program_unit = ITS_FLASH_ALIGNMENT,
+    .max_file_size = ITS_UTILS_ALIGN(ITS_ENC_FILE_SIZE(ITS_MAX_ASSET_SIZE),
+                                     ITS_FLASH_ALIGNMENT),
+    .max_num_files = ITS_NUM_ASSETS + 1,
+    .erase_val = 0xFF,
+};
+
+/* Data of the client, read and written by the service through the request
+ * manager
+ */
+static const uint8_t *client_src;
+static uint8_t client_dst[ITS_MAX_ASSET_SIZE];
+static size_t client_dst_len;
+
+/* Content of each asset */
+static struct {
+    bool exists;
+    size_t size;
+    uint8_t data[ITS_MAX_ASSET_SIZE];
+} assets[TEST_NUM_UIDS];
+
+static uint8_t req_buf[ITS_MAX_ASSET_SIZE];
+static uint32_t nonce_counter;
+static uint32_t rand_state;
+static uint32_t failures;
+
+#define TEST_CHECK(cond, ...)                               \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            failures++;                                     \
+            fprintf(stderr, "%s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            return -1;                                      \
+        }                                                   \
+    } while (0)
+
+#define TEST_CHECK_STATUS(expr, expected)                                  \
+    do {                                                                   \
+        psa_status_t status_ = (expr);                                     \
+        TEST_CHECK(status_ == (expected), "%s returned %d instead of %d",  \
+                   #expr, (int)status_, (int)(expected));                  \
+    } while (0)
+
+size_t its_req_mngr_read(uint8_t *buf, size_t num_bytes)
+{
+    (void)memcpy(buf, client_src, num_bytes);
+    client_src += num_bytes;
+
+    return num_bytes;
+}
+
+void its_req_mngr_write(const uint8_t *buf, size_t num_bytes)
+{
+    (void)memcpy(&client_dst[client_dst_len], buf, num_bytes);
+    client_dst_len += num_bytes;
+}
+
+enum tfm_hal_status_t tfm_hal_its_fs_info(struct tfm_hal_its_fs_info_t *fs_info)
+{
+    fs_info->flash_area_addr = 0;
+    fs_info->flash_area_size = TEST_NUM_BLOCKS * TEST_BLOCK_SIZE;
+    fs_info->sectors_per_block = 1;
+
+    return TFM_HAL_SUCCESS;
+}
+
+static uint32_t fnv(uint32_t h, const uint8_t *buf, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        h = (h ^ buf[i]) * 16777619u;
+    }
+
+    return h;
+}
+
+/* FNV-1a checksum of the key label, the nonce, the additional data and the
+ * ciphertext, in place of the tag of the AEAD
+ */
+static void test_tag(const struct tfm_hal_its_auth_crypt_ctx *ctx,
+                     const uint8_t *ciphertext, size_t size, uint8_t *tag)
+{
+    uint32_t h = 2166136261u;
+    uint32_t i;
+
+    h = fnv(h, ctx->deriv_label, ctx->deriv_label_size);
+    h = fnv(h, ctx->nonce, ctx->nonce_size);
+    h = fnv(h, ctx->aad, ctx->aad_size);
+    h = fnv(h, ciphertext, size);
+
+    for (i = 0; i < TFM_ITS_AUTH_TAG_LENGTH; i++) {
+        h = (h ^ i) * 16777619u;
+        tag[i] = (uint8_t)(h >> 24);
+    }
+}
+
+/* Keystream derived from the key label and the nonce, in place of the cipher */
+static void test_xor(const struct tfm_hal_its_auth_crypt_ctx *ctx,
+                     const uint8_t *in, size_t size, uint8_t *out)
+{
+    uint32_t x = fnv(fnv(2166136261u, ctx->deriv_label, ctx->deriv_label_size),
+                     ctx->nonce, ctx->nonce_size);
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        x = (x * 1103515245u) + 12345u;
+        out[i] = in[i] ^ (uint8_t)(x >> 16);
+    }
+}
+
+enum tfm_hal_status_t tfm_hal_its_aead_generate_nonce(uint8_t *nonce,
+                                                      const size_t nonce_size)
+{
+    nonce_counter++;
+    (void)memset(nonce, 0, nonce_size);
+    (void)memcpy(nonce, &nonce_counter, sizeof(nonce_counter));
+
+    return TFM_HAL_SUCCESS;
+}
+
+/* As psa_aead_encrypt(), the ciphertext buffer receives the tag after the
+ * ciphertext.
+ */
+enum tfm_hal_status_t tfm_hal_its_aead_encrypt(
+                                        struct tfm_hal_its_auth_crypt_ctx *ctx,
+                                        const uint8_t *plaintext,
+                                        const size_t plaintext_size,
+                                        uint8_t *ciphertext,
+                                        const size_t ciphertext_size,
+                                        uint8_t *tag,
+                                        const size_t tag_size)
+{
+    if ((tag_size != TFM_ITS_AUTH_TAG_LENGTH) ||
+        (ciphertext_size < plaintext_size + TFM_ITS_AUTH_TAG_LENGTH)) {
+        return TFM_HAL_ERROR_GENERIC;
+    }
+
+    test_xor(ctx, plaintext, plaintext_size, ciphertext);
+    test_tag(ctx, ciphertext, plaintext_size, ciphertext + plaintext_size);
+    (void)memcpy(tag, ciphertext + plaintext_size, tag_size);
+
+    return TFM_HAL_SUCCESS;
+}
+
+/* As the template implementation, the tag is copied after the ciphertext */
+enum tfm_hal_status_t tfm_hal_its_aead_decrypt(
+                                        struct tfm_hal_its_auth_crypt_ctx *ctx,
+                                        const uint8_t *ciphertext,
+                                        const size_t ciphertext_size,
+                                        uint8_t *tag,
+                                        const size_t tag_size,
+                                        uint8_t *plaintext,
+                                        const size_t plaintext_size)
+{
+    uint8_t expected[TFM_ITS_AUTH_TAG_LENGTH];
+
+    if ((tag_size != TFM_ITS_AUTH_TAG_LENGTH) ||
+        (plaintext_size < ciphertext_size)) {
+        return TFM_HAL_ERROR_INVALID_INPUT;
+    }
+
+    (void)memcpy((uint8_t *)(ciphertext + ciphertext_size), tag, tag_size);
+
+    test_tag(ctx, ciphertext, ciphertext_size, expected);
+    if (memcmp(expected, ciphertext + ciphertext_size, tag_size) != 0) {
+        return TFM_HAL_ERROR_GENERIC;
+    }
+
+    test_xor(ctx, ciphertext, ciphertext_size, plaintext);
+
+    return TFM_HAL_SUCCESS;
+}
+
+static uint32_t test_rand(void)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+/* Starts a test on an empty filesystem */
+static int start(uint32_t seed)
+{
+    rand_state = seed;
+    (void)memset(assets, 0, sizeof(assets));
+
+    (void)remove(TEST_IMAGE_PATH);
+    TEST_CHECK(flash_emu_open(&emu_cfg) == 0, "cannot open the flash");
+    TEST_CHECK_STATUS(tfm_its_init(), PSA_SUCCESS);
+
+    return 0;
+}
+
+static int stop(void)
+{
+    flash_emu_close();
+    TEST_CHECK(flash_emu_get_stats()->violations == 0,
+               "%u operations broke the flash program rules",
+               (unsigned)flash_emu_get_stats()->violations);
+
+    return 0;
+}
+
+/* Restarts the service from the flash, after a power cut */
+static int reboot(void)
+{
+    flash_emu_close();
+    TEST_CHECK(flash_emu_open(&emu_cfg) == 0, "cannot open the flash");
+    TEST_CHECK_STATUS(tfm_its_init(), PSA_SUCCESS);
+
+    return 0;
+}
+
+/* Sets an asset to random data of a random size */
+static psa_status_t random_set(uint32_t idx, size_t *p_size)
+{
+    size_t size = test_rand() % (ITS_MAX_ASSET_SIZE + 1u);
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        req_buf[i] = (uint8_t)test_rand();
+    }
+    *p_size = size;
+
+    client_src = req_buf;
+
+    return tfm_its_set(TEST_CLIENT_ID, TEST_UID + idx, size,
+                       PSA_STORAGE_FLAG_NONE);
+}
+
+/* Checks whether a part of the asset holds the data given */
+static bool part_matches(uint32_t idx, size_t offset, size_t size,
+                         const uint8_t *data)
+{
+    size_t len = 0;
+
+    client_dst_len = 0;
+
+    return (tfm_its_get(TEST_CLIENT_ID, TEST_UID + idx, offset, size,
+                        &len) == PSA_SUCCESS) &&
+           (len == size) && (client_dst_len == size) &&
+           (memcmp(client_dst, data, size) == 0);
+}
+
+/* Checks whether the asset holds the data given */
+static bool asset_matches(uint32_t idx, bool exists, size_t size,
+                          const uint8_t *data)
+{
+    struct psa_storage_info_t info;
+    psa_status_t status;
+
+    status = tfm_its_get_info(TEST_CLIENT_ID, TEST_UID + idx, &info);
+    if (status == PSA_ERROR_DOES_NOT_EXIST) {
+        return !exists;
+    } else if ((status != PSA_SUCCESS) || !exists || (info.size != size) ||
+               (info.capacity != size) ||
+               (info.flags != PSA_STORAGE_FLAG_NONE)) {
+        return false;
+    }
+
+    return part_matches(idx, 0, size, data);
+}
+
+/* Random sets of assets of up to several chunks, each one checked by reads of
+ * random parts of it.
+ */
+static int test_partial_reads(void)
+{
+    uint32_t n;
+    uint32_t idx;
+    size_t size;
+    size_t offset;
+
+    if (start(1) != 0) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_OPS; n++) {
+        idx = test_rand() % TEST_NUM_UIDS;
+
+        if ((test_rand() % 4u) == 0) {
+            TEST_CHECK_STATUS(random_set(idx, &size), PSA_SUCCESS);
+            assets[idx].exists = true;
+            assets[idx].size = size;
+            (void)memcpy(assets[idx].data, req_buf, size);
+            continue;
+        }
+
+        if (!assets[idx].exists) {
+            continue;
+        }
+
+        offset = test_rand() % (assets[idx].size + 1u);
+        size = test_rand() % (assets[idx].size - offset + 1u);
+        TEST_CHECK(part_matches(idx, offset, size, &assets[idx].data[offset]),
+                   "read of %u bytes at %u of asset %u failed",
+                   (unsigned)size, (unsigned)offset, (unsigned)idx);
+    }
+
+    for (idx = 0; idx < TEST_NUM_UIDS; idx++) {
+        TEST_CHECK(asset_matches(idx, assets[idx].exists, assets[idx].size,
+                                 assets[idx].data),
+                   "asset %u does not match", (unsigned)idx);
+    }
+
+    return stop();
+}
+
+/* Writes an asset as the previous versions did, encrypted as a whole with the
+ * nonce and the tag in the metadata, through a second filesystem context. The
+ * ciphertext is changed if requested.
+ */
+static int write_whole_file(uint32_t idx, const uint8_t *data, size_t size,
+                            bool tamper)
+{
+    static struct its_flash_fs_ctx_t fs_ctx;
+    static uint8_t enc[ITS_MAX_ASSET_SIZE + TFM_ITS_AUTH_TAG_LENGTH];
+    struct its_flash_fs_file_info_t finfo = {
+        .flags = ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE,
+        .size_max = size,
+    };
+    struct tfm_hal_its_auth_crypt_ctx ctx = { 0 };
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint8_t aad[ITS_FILE_ID_SIZE + sizeof(uint32_t) + sizeof(size_t)];
+    const int32_t client_id = TEST_CLIENT_ID;
+    const psa_storage_uid_t uid = TEST_UID + idx;
+    const uint32_t flags = PSA_STORAGE_FLAG_NONE;
+
+    (void)memcpy(fid, &client_id, sizeof(client_id));
+    (void)memcpy(fid + sizeof(client_id), &uid, sizeof(uid));
+
+    (void)memcpy(aad, fid, sizeof(fid));
+    (void)memcpy(aad + sizeof(fid), &flags, sizeof(flags));
+    (void)memcpy(aad + sizeof(fid) + sizeof(flags), &size, sizeof(size));
+
+    (void)tfm_hal_its_aead_generate_nonce(finfo.nonce, sizeof(finfo.nonce));
+    ctx.deriv_label = fid;
+    ctx.deriv_label_size = sizeof(fid);
+    ctx.aad = aad;
+    ctx.aad_size = sizeof(aad);
+    ctx.nonce = finfo.nonce;
+    ctx.nonce_size = sizeof(finfo.nonce);
+
+    TEST_CHECK(tfm_hal_its_aead_encrypt(&ctx, data, size, enc, sizeof(enc),
+                                        finfo.tag, sizeof(finfo.tag)) ==
+               TFM_HAL_SUCCESS, "cannot encrypt the file");
+    if (tamper) {
+        enc[test_rand() % size] ^= (uint8_t)(1u << (test_rand() % 8u));
+    }
+
+    TEST_CHECK_STATUS(its_flash_fs_init_ctx(&fs_ctx, &fs_cfg, &ITS_FLASH_OPS),
+                      PSA_SUCCESS);
+    TEST_CHECK_STATUS(its_flash_fs_prepare(&fs_ctx), PSA_SUCCESS);
+    TEST_CHECK_STATUS(its_flash_fs_file_write(&fs_ctx, fid, &finfo, size, 0,
+                                              enc), PSA_SUCCESS);
+
+    return 0;
+}
+
+/* The assets encrypted as a whole by the previous versions are read, in part
+ * or fully, and are encrypted in chunks once they are set again. A change of
+ * their content is detected.
+ */
+static int test_whole_file(void)
+{
+    size_t sizes[TEST_NUM_UIDS] = { 0, 1, ITS_ENCRYPTION_CHUNK_SIZE + 1,
+                                    ITS_MAX_ASSET_SIZE };
+    size_t offset;
+    size_t size;
+    uint32_t idx;
+    uint32_t n;
+    size_t i;
+
+    if (start(2) != 0) {
+        return -1;
+    }
+
+    for (idx = 0; idx < TEST_NUM_UIDS; idx++) {
+        assets[idx].exists = true;
+        assets[idx].size = sizes[idx];
+        for (i = 0; i < sizes[idx]; i++) {
+            assets[idx].data[i] = (uint8_t)test_rand();
+        }
+
+        if (write_whole_file(idx, assets[idx].data, sizes[idx], false) != 0) {
+            return -1;
+        }
+    }
+
+    if (reboot() != 0) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_OPS / 10u; n++) {
+        idx = test_rand() % TEST_NUM_UIDS;
+        offset = test_rand() % (assets[idx].size + 1u);
+        size = test_rand() % (assets[idx].size - offset + 1u);
+        TEST_CHECK(part_matches(idx, offset, size, &assets[idx].data[offset]),
+                   "read of %u bytes at %u of asset %u failed",
+                   (unsigned)size, (unsigned)offset, (unsigned)idx);
+    }
+
+    for (idx = 0; idx < TEST_NUM_UIDS; idx++) {
+        TEST_CHECK(asset_matches(idx, true, assets[idx].size,
+                                 assets[idx].data),
+                   "asset %u does not match", (unsigned)idx);
+    }
+
+    /* A changed bit of the ciphertext is detected */
+    if ((write_whole_file(3, assets[3].data, assets[3].size, true) != 0) ||
+        (reboot() != 0)) {
+        return -1;
+    }
+    TEST_CHECK(!part_matches(3, 0, 1, assets[3].data) && (client_dst_len == 0),
+               "changed asset read");
+
+    /* Set again, it is encrypted in chunks */
+    TEST_CHECK_STATUS(random_set(1, &size), PSA_SUCCESS);
+    TEST_CHECK(asset_matches(1, true, size, req_buf),
+               "asset 1 not read after it was set again");
+
+    return stop();
+}
+
+/* A set of an asset larger than ITS_BUF_SIZE is interrupted by a power cut at
+ * a random point. The asset holds the old or the new data after the reboot.
+ */
+static int test_set_power_cut(void)
+{
+    size_t size;
+    uint32_t n;
+    psa_status_t status;
+
+    if (start(3) != 0) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_CUTS; n++) {
+        flash_emu_set_power_cut(1u + (test_rand() % TEST_CUT_WINDOW),
+                                test_rand());
+
+        status = random_set(0, &size);
+        flash_emu_set_power_cut(0, 0);
+        if (status == PSA_SUCCESS) {
+            assets[0].exists = true;
+            assets[0].size = size;
+            (void)memcpy(assets[0].data, req_buf, size);
+        }
+
+        if (reboot() != 0) {
+            return -1;
+        }
+
+        if (!asset_matches(0, assets[0].exists, assets[0].size,
+                           assets[0].data)) {
+            TEST_CHECK((status != PSA_SUCCESS) &&
+                       asset_matches(0, true, size, req_buf),
+                       "asset partly set after a power cut");
+            assets[0].exists = true;
+            assets[0].size = size;
+            (void)memcpy(assets[0].data, req_buf, size);
+        }
+    }
+
+    return stop();
+}
+
+static const struct {
+    const char *name;
+    int (*run)(void);
+} tests[] = {
+    { "partial_reads", test_partial_reads },
+    { "whole_file", test_whole_file },
+    { "set_power_cut", test_set_power_cut },
+};
+
+int main(int argc, char *argv[])
+{
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if ((argc > 1) && (strcmp(argv[1], tests[i].name) != 0)) {
+            continue;
+        }
+
+        ret = tests[i].run();
+        printf("%s: %s\n", tests[i].name, (ret == 0) ? "PASS" : "FAIL");
+        if (ret != 0) {
+            /* Leave the flash device closed for the next test */
+            flash_emu_close();
+        }
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,826 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host tests of the metadata block filesystem on the file backed flash
+ * emulator. The tests run random file writes and deletes, cut the power at
+ * random points and remount the filesystem from the image file. They check
+ * the content of the files and the state the filesystem keeps in RAM against
+ * a second context mounted from the same flash. The transaction tests stage
+ * random writes and deletes, and check that a commit applies all of them, and
+ * an abort or a power cut during the commit either all of them or none. The
+ * upgrade test mounts a filesystem of the previous version, with power cuts.
+ * With ITS_BACKGROUND_MAINTENANCE, the data of the deleted files is checked to
+ * be erased from the flash.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "flash_emu.h"
+#include "flash/its_flash_nor.h"
+#include "flash_fs/its_flash_fs.h"
+#include "its_utils.h"
+
+#if ITS_BACKGROUND_MAINTENANCE
+#define TEST_IMAGE_PATH      "its_fs_test_maintain.img"
+#else
+#define TEST_IMAGE_PATH      "its_fs_test.img"
+#endif
+#define TEST_NUM_BLOCKS      6u
+#define TEST_BLOCK_SIZE      4096u
+#define TEST_PROGRAM_UNIT    4u
+#define TEST_NUM_FILES       ITS_NUM_ASSETS
+#define TEST_MAX_FILE_SIZE   ITS_UTILS_ALIGN(ITS_MAX_ASSET_SIZE, \
+                                             TEST_PROGRAM_UNIT)
+
+/* Number of power cuts of each test, and of requests run after each one */
+#define TEST_NUM_CUTS        200u
+#define TEST_CUT_WINDOW      40u
+#define TEST_OPS_AFTER_CUT   20u
+
+/* Number of transactions of each transaction test, of requests staged in each
+ * one and largest size of a file staged, so that several fit in the buffer
+ */
+#define TEST_NUM_TXNS        200u
+#define TEST_TXN_MAX_OPS     ITS_UTILS_MIN(4u, ITS_TRANSACTION_MAX_OPS)
+#define TEST_TXN_MAX_SIZE    (ITS_TRANSACTION_BUF_SIZE / TEST_TXN_MAX_OPS)
+
+/* Flag of the user stored with the files staged */
+#define TEST_USER_FLAG       0x1u
+
+struct test_file_t {
+    bool exists;
+    size_t size;
+    uint8_t data[TEST_MAX_FILE_SIZE];
+};
+
+/* A file write or delete interrupted by a power cut */
+struct test_pending_t {
+    bool valid;
+    uint32_t idx;
+    bool exists;
+    size_t size;
+    uint8_t data[TEST_MAX_FILE_SIZE];
+};
+
+static struct flash_emu_config_t emu_cfg = {
+    .image_path = TEST_IMAGE_PATH,
+    .sector_size = TEST_BLOCK_SIZE,
+    .sector_count = TEST_NUM_BLOCKS,
+    .program_unit = TEST_PROGRAM_UNIT,
+};
+
+static struct its_flash_fs_config_t fs_cfg = {
+    .flash_dev = &Driver_FLASH_EMU,
+    .sector_size = TEST_BLOCK_SIZE,
+    .block_size = TEST_BLOCK_SIZE,
+    .num_blocks = TEST_NUM_BLOCKS,
+    .program_unit = TEST_PROGRAM_UNIT,
+    .max_file_size = TEST_MAX_FILE_SIZE,
+    .max_num_files = TEST_NUM_FILES + 1,
+    .erase_val = 0xFF,
+};
+
+static struct its_flash_fs_ctx_t fs_ctx;
+static struct its_flash_fs_ctx_t check_ctx;
+static struct test_file_t files[TEST_NUM_FILES];
+static struct test_pending_t pending;
+static struct test_file_t txn_files[TEST_NUM_FILES];
+static struct its_flash_fs_txn_t txn;
+static uint8_t buf[TEST_MAX_FILE_SIZE];
+static uint32_t rand_state;
+static uint32_t failures;
+
+#define TEST_CHECK(cond, ...)                               \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            failures++;                                     \
+            fprintf(stderr, "%s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            return -1;                                      \
+        }                                                   \
+    } while (0)
+
+static uint32_t test_rand(void)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+static void make_fid(uint32_t idx, uint8_t *fid)
+{
+    (void)memset(fid, 0, ITS_FILE_ID_SIZE);
+    /* An all-zero file ID is not valid */
+    (void)memcpy(fid, &(uint32_t){ idx + 1u }, sizeof(uint32_t));
+}
+
+static psa_status_t mount(struct its_flash_fs_ctx_t *ctx, bool wipe)
+{
+    psa_status_t status;
+
+    status = its_flash_fs_init_ctx(ctx, &fs_cfg, &its_flash_fs_ops_nor);
+    if ((status == PSA_SUCCESS) && wipe) {
+        status = its_flash_fs_wipe_all(ctx);
+    }
+    if (status == PSA_SUCCESS) {
+        status = its_flash_fs_prepare(ctx);
+    }
+
+    return status;
+}
+
+/* Starts a test on an empty filesystem */
+static int start(uint32_t seed)
+{
+    rand_state = seed;
+    (void)memset(files, 0, sizeof(files));
+    pending.valid = false;
+
+    (void)remove(TEST_IMAGE_PATH);
+    TEST_CHECK(flash_emu_open(&emu_cfg) == 0, "cannot open the flash");
+    TEST_CHECK(Driver_FLASH_EMU.Initialize(NULL) == ARM_DRIVER_OK,
+               "cannot initialize the flash");
+    TEST_CHECK(mount(&fs_ctx, true) == PSA_SUCCESS, "cannot create the fs");
+
+    return 0;
+}
+
+static int stop(void)
+{
+    flash_emu_close();
+    TEST_CHECK(flash_emu_get_stats()->violations == 0,
+               "%u operations broke the flash program rules",
+               (unsigned)flash_emu_get_stats()->violations);
+
+    return 0;
+}
+
+static bool file_matches(struct its_flash_fs_ctx_t *ctx, uint32_t idx,
+                         bool exists, size_t size, const uint8_t *data)
+{
+    struct its_flash_fs_file_info_t info;
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    psa_status_t status;
+
+    make_fid(idx, fid);
+
+    status = its_flash_fs_file_get_info(ctx, fid, &info);
+    if (status == PSA_ERROR_DOES_NOT_EXIST) {
+        return !exists;
+    } else if ((status != PSA_SUCCESS) || !exists ||
+               (info.size_current != size)) {
+        return false;
+    }
+
+    status = its_flash_fs_file_read(ctx, fid, size, 0, buf);
+
+    return (status == PSA_SUCCESS) && (memcmp(buf, data, size) == 0);
+}
+
+/* Writes or deletes a random file and updates the model */
+static psa_status_t random_op(void)
+{
+    struct its_flash_fs_file_info_t info = {
+        .flags = ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE,
+    };
+    uint32_t idx = test_rand() % TEST_NUM_FILES;
+    struct test_file_t *file = &files[idx];
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    psa_status_t status;
+    size_t i;
+
+    make_fid(idx, fid);
+
+    pending.idx = idx;
+    if (file->exists && ((test_rand() % 4u) == 0)) {
+        pending.exists = false;
+        status = its_flash_fs_file_delete(&fs_ctx, fid);
+    } else {
+        pending.exists = true;
+        pending.size = ITS_UTILS_ALIGN(
+                           1u + (test_rand() % TEST_MAX_FILE_SIZE),
+                           TEST_PROGRAM_UNIT);
+        pending.size = ITS_UTILS_MIN(pending.size, TEST_MAX_FILE_SIZE);
+        for (i = 0; i < pending.size; i++) {
+            pending.data[i] = (uint8_t)test_rand();
+        }
+        info.size_max = pending.size;
+        status = its_flash_fs_file_write(&fs_ctx, fid, &info, pending.size, 0,
+                                         pending.data);
+    }
+
+    if (status == PSA_SUCCESS) {
+        file->exists = pending.exists;
+        file->size = pending.size;
+        (void)memcpy(file->data, pending.data, pending.size);
+    } else if (flash_emu_power_lost()) {
+        pending.valid = true;
+    }
+
+    return status;
+}
+
+/* Runs random requests until the power is cut */
+static int run_until_cut(void)
+{
+    psa_status_t status;
+
+    flash_emu_set_power_cut(1u + (test_rand() % TEST_CUT_WINDOW), test_rand());
+
+    do {
+        status = random_op();
+        /* The filesystem may be full */
+        TEST_CHECK((status == PSA_SUCCESS) || flash_emu_power_lost() ||
+                   (status == PSA_ERROR_INSUFFICIENT_STORAGE),
+                   "request failed (status %d)", (int)status);
+    } while (!flash_emu_power_lost());
+
+    return 0;
+}
+
+/* Remounts the filesystem from the flash after a power cut */
+static int remount(void)
+{
+    flash_emu_close();
+    TEST_CHECK(flash_emu_open(&emu_cfg) == 0, "cannot open the flash");
+    TEST_CHECK(Driver_FLASH_EMU.Initialize(NULL) == ARM_DRIVER_OK,
+               "cannot initialize the flash");
+    TEST_CHECK(mount(&fs_ctx, false) == PSA_SUCCESS, "remount failed");
+
+    return 0;
+}
+
+/* Reboots after a power cut and checks the content of every file */
+static int reboot(void)
+{
+    struct test_file_t *file;
+    uint32_t idx;
+
+    if (remount() != 0) {
+        return -1;
+    }
+
+    for (idx = 0; idx < TEST_NUM_FILES; idx++) {
+        file = &files[idx];
+
+        if (pending.valid && (pending.idx == idx) &&
+            file_matches(&fs_ctx, idx, pending.exists, pending.size,
+                         pending.data)) {
+            /* The interrupted request has completed */
+            file->exists = pending.exists;
+            file->size = pending.size;
+            (void)memcpy(file->data, pending.data, pending.size);
+            continue;
+        }
+
+        TEST_CHECK(file_matches(&fs_ctx, idx, file->exists, file->size,
+                                file->data),
+                   "file %u lost after a power cut", (unsigned)idx);
+    }
+
+    pending.valid = false;
+
+    return 0;
+}
+
+/* Runs requests without power cut, checking that each of them succeeds */
+static int run_ops(uint32_t num_ops)
+{
+    psa_status_t status;
+
+    while (num_ops-- > 0) {
+        status = random_op();
+        TEST_CHECK((status == PSA_SUCCESS) ||
+                   (status == PSA_ERROR_INSUFFICIENT_STORAGE),
+                   "request failed (status %d)", (int)status);
+    }
+
+    return 0;
+}
+
+/* Mounts a second context from the flash, which builds its state from the
+ * content of the flash only.
+ */
+static int mount_check_ctx(void)
+{
+    TEST_CHECK(mount(&check_ctx, false) == PSA_SUCCESS,
+               "second mount failed");
+    TEST_CHECK(check_ctx.active_metablock == fs_ctx.active_metablock,
+               "second mount selected metadata block %u instead of %u",
+               (unsigned)check_ctx.active_metablock,
+               (unsigned)fs_ctx.active_metablock);
+
+    return 0;
+}
+
+/* The free file entries and the free size of the blocks kept in RAM are
+ * updated by each request. They must stay equal to the ones read from flash
+ * when the filesystem is mounted, including after the recovery from a power
+ * cut.
+ */
+static int test_index_power_cut(void)
+{
+    const struct its_file_index_t *index = &fs_ctx.file_index;
+    const struct its_file_index_t *check = &check_ctx.file_index;
+    uint32_t cut;
+    uint32_t i;
+
+    if (start(1) != 0) {
+        return -1;
+    }
+
+    for (cut = 0; cut < TEST_NUM_CUTS; cut++) {
+        if ((run_until_cut() != 0) || (reboot() != 0) ||
+            (run_ops(TEST_OPS_AFTER_CUT) != 0) || (mount_check_ctx() != 0)) {
+            return -1;
+        }
+
+        TEST_CHECK(index->built, "index not built after power cut %u",
+                   (unsigned)cut);
+        TEST_CHECK(memcmp(index->free_files, check->free_files,
+                          sizeof(index->free_files)) == 0,
+                   "free file entries differ after power cut %u",
+                   (unsigned)cut);
+        for (i = 0; i < ITS_FLASH_FS_NUM_BLOCK_SUMMARIES; i++) {
+            TEST_CHECK(index->block_free[i] == check->block_free[i],
+                       "free size of block %u differs after power cut %u",
+                       (unsigned)i, (unsigned)cut);
+        }
+    }
+
+    return stop();
+}
+
+/* Checks the metadata XOR maintained from the index against a second mount,
+ * which computes it from the metadata read from flash and only selects the
+ * latest metadata block if it matches the XOR stored in its header.
+ */
+static int check_metadata_xor(uint32_t step)
+{
+    const struct its_file_index_t *index = &fs_ctx.file_index;
+    const struct its_file_index_t *check = &check_ctx.file_index;
+    uint32_t i;
+
+    if (mount_check_ctx() != 0) {
+        return -1;
+    }
+
+    TEST_CHECK(fs_ctx.meta_block_header.metadata_xor ==
+               check_ctx.meta_block_header.metadata_xor,
+               "metadata XOR differs at step %u", (unsigned)step);
+    TEST_CHECK(memcmp(index->file_xor, check->file_xor,
+                      sizeof(index->file_xor)) == 0,
+               "file metadata XORs differ at step %u", (unsigned)step);
+    for (i = 0; i < ITS_FLASH_FS_NUM_BLOCK_SUMMARIES; i++) {
+        TEST_CHECK(index->block_xor[i] == check->block_xor[i],
+                   "XOR of block %u differs at step %u", (unsigned)i,
+                   (unsigned)step);
+    }
+
+    return 0;
+}
+
+/* The metadata XOR is updated from the entries written by each request,
+ * instead of being computed from the whole metadata block. It must match the
+ * metadata in flash after every request, and after the recovery from a power
+ * cut.
+ */
+static int test_metadata_xor(void)
+{
+    uint32_t cut;
+    uint32_t op;
+
+    if (start(2) != 0) {
+        return -1;
+    }
+
+    for (cut = 0; cut < TEST_NUM_CUTS; cut++) {
+        if ((run_until_cut() != 0) || (reboot() != 0)) {
+            return -1;
+        }
+
+        for (op = 0; op < TEST_OPS_AFTER_CUT; op++) {
+            if ((run_ops(1) != 0) ||
+                (check_metadata_xor((cut * TEST_OPS_AFTER_CUT) + op) != 0)) {
+                return -1;
+            }
+        }
+    }
+
+    return stop();
+}
+
+/* Checks that the content of every file in the filesystem is the one of the
+ * model given
+ */
+static bool files_match(const struct test_file_t *model)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < TEST_NUM_FILES; idx++) {
+        if (!file_matches(&fs_ctx, idx, model[idx].exists, model[idx].size,
+                          model[idx].data)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Stages a random write or delete in the transaction and updates the model of
+ * the files once the transaction commits
+ */
+static int txn_random_op(void)
+{
+    struct its_flash_fs_file_info_t info = {
+        .flags = ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE |
+                 TEST_USER_FLAG,
+    };
+    uint32_t idx = test_rand() % TEST_NUM_FILES;
+    struct test_file_t *file = &txn_files[idx];
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    size_t size;
+    size_t half;
+    psa_status_t status;
+    size_t i;
+
+    make_fid(idx, fid);
+
+    if (file->exists && ((test_rand() % 3u) == 0)) {
+        status = its_flash_fs_txn_delete(&txn, fid);
+        TEST_CHECK(status == PSA_SUCCESS, "staged delete failed (status %d)",
+                   (int)status);
+        file->exists = false;
+        TEST_CHECK(its_flash_fs_txn_get_info(&txn, fid, &info) ==
+                   PSA_ERROR_DOES_NOT_EXIST,
+                   "file %u still staged after its delete", (unsigned)idx);
+        return 0;
+    }
+
+    size = ITS_UTILS_ALIGN(1u + (test_rand() % TEST_TXN_MAX_SIZE),
+                           TEST_PROGRAM_UNIT);
+    size = ITS_UTILS_MIN(size, TEST_TXN_MAX_SIZE);
+    for (i = 0; i < size; i++) {
+        buf[i] = (uint8_t)test_rand();
+    }
+
+    /* Stage the file in two writes, the second one adding to the first */
+    half = ITS_UTILS_ALIGN(size / 2u, TEST_PROGRAM_UNIT);
+    info.size_max = size;
+    status = its_flash_fs_txn_write(&txn, fid, &info, half, 0, buf);
+    if (status == PSA_ERROR_INSUFFICIENT_MEMORY) {
+        /* The transaction is full, nothing has been staged */
+        return 0;
+    }
+    TEST_CHECK(status == PSA_SUCCESS, "staged write failed (status %d)",
+               (int)status);
+
+    info.flags = 0;
+    status = its_flash_fs_txn_write(&txn, fid, &info, size - half, half,
+                                    &buf[half]);
+    TEST_CHECK(status == PSA_SUCCESS, "staged append failed (status %d)",
+               (int)status);
+
+    file->exists = true;
+    file->size = size;
+    (void)memcpy(file->data, buf, size);
+
+    status = its_flash_fs_txn_get_info(&txn, fid, &info);
+    TEST_CHECK((status == PSA_SUCCESS) && (info.size_current == size) &&
+               (info.size_max == size) &&
+               (info.flags == TEST_USER_FLAG),
+               "wrong information of staged file %u", (unsigned)idx);
+
+    return 0;
+}
+
+/* Begins a transaction and stages random requests in it */
+static int txn_stage(void)
+{
+    uint32_t num_ops = 1u + (test_rand() % TEST_TXN_MAX_OPS);
+
+    (void)memcpy(txn_files, files, sizeof(files));
+    its_flash_fs_txn_begin(&fs_ctx, &txn);
+
+    while (num_ops-- > 0) {
+        if (txn_random_op() != 0) {
+            return -1;
+        }
+    }
+
+    /* Nothing staged is visible before the commit */
+    TEST_CHECK(files_match(files), "staged request visible before the commit");
+
+    return 0;
+}
+
+/* Commits or aborts random transactions, and checks that the filesystem holds
+ * either all of the requests of each one or none of them
+ */
+static int test_txn(void)
+{
+    uint8_t active_metablock;
+    bool commit;
+    uint32_t n;
+    psa_status_t status;
+
+    if (start(3) != 0) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_TXNS; n++) {
+        if (txn_stage() != 0) {
+            return -1;
+        }
+
+        active_metablock = fs_ctx.active_metablock;
+        commit = (test_rand() % 4u) != 0;
+        if (commit) {
+            status = its_flash_fs_txn_commit(&txn);
+        } else {
+            its_flash_fs_txn_abort(&txn);
+            status = PSA_SUCCESS;
+        }
+
+        /* The filesystem may be full, or the files may not fit in the blocks
+         * a commit rewrites
+         */
+        TEST_CHECK((status == PSA_SUCCESS) ||
+                   (status == PSA_ERROR_INSUFFICIENT_STORAGE) ||
+                   (status == PSA_ERROR_NOT_SUPPORTED),
+                   "commit failed (status %d)", (int)status);
+        TEST_CHECK(its_flash_fs_txn_commit(&txn) == PSA_ERROR_BAD_STATE,
+                   "transaction %u not ended", (unsigned)n);
+
+        if (commit && (status == PSA_SUCCESS)) {
+            TEST_CHECK(files_match(txn_files),
+                       "transaction %u not applied", (unsigned)n);
+            if (memcmp(txn_files, files, sizeof(files)) != 0) {
+                /* A single metadata block update applies the transaction */
+                TEST_CHECK(fs_ctx.active_metablock != active_metablock,
+                           "transaction %u applied without a metadata block "
+                           "swap", (unsigned)n);
+            }
+            (void)memcpy(files, txn_files, sizeof(files));
+        } else {
+            TEST_CHECK(files_match(files),
+                       "transaction %u partly applied", (unsigned)n);
+            TEST_CHECK(fs_ctx.active_metablock == active_metablock,
+                       "metadata block swapped by transaction %u",
+                       (unsigned)n);
+        }
+
+        if (mount_check_ctx() != 0) {
+            return -1;
+        }
+    }
+
+    return stop();
+}
+
+/* Cuts the power during the commit of random transactions, and checks that the
+ * filesystem holds either all of the requests of the transaction or none of
+ * them after the reboot
+ */
+static int test_txn_power_cut(void)
+{
+    uint32_t cut;
+    psa_status_t status;
+
+    if (start(4) != 0) {
+        return -1;
+    }
+
+    for (cut = 0; cut < TEST_NUM_CUTS; cut++) {
+        flash_emu_set_power_cut(1u + (test_rand() % TEST_CUT_WINDOW),
+                                test_rand());
+
+        do {
+            if (txn_stage() != 0) {
+                return -1;
+            }
+
+            status = its_flash_fs_txn_commit(&txn);
+            TEST_CHECK((status == PSA_SUCCESS) || flash_emu_power_lost() ||
+                       (status == PSA_ERROR_INSUFFICIENT_STORAGE) ||
+                       (status == PSA_ERROR_NOT_SUPPORTED),
+                       "commit failed (status %d)", (int)status);
+            if ((status == PSA_SUCCESS) && !flash_emu_power_lost()) {
+                (void)memcpy(files, txn_files, sizeof(files));
+            }
+        } while (!flash_emu_power_lost());
+
+        if (remount() != 0) {
+            return -1;
+        }
+
+        if (files_match(txn_files)) {
+            (void)memcpy(files, txn_files, sizeof(files));
+        } else {
+            TEST_CHECK(files_match(files),
+                       "transaction partly applied after power cut %u",
+                       (unsigned)cut);
+        }
+
+        if (mount_check_ctx() != 0) {
+            return -1;
+        }
+    }
+
+    return stop();
+}
+
+/* Sets the version in the header of the active metadata block. Only bits are
+ * cleared, as a NOR flash program can.
+ */
+static int set_fs_version(uint8_t fs_version)
+{
+    const uint32_t offset =
+        offsetof(struct its_metadata_block_header_t, fs_version);
+    const uint32_t addr = (fs_ctx.active_metablock * TEST_BLOCK_SIZE) +
+                          (offset - (offset % TEST_PROGRAM_UNIT));
+    uint8_t unit[TEST_PROGRAM_UNIT];
+
+    TEST_CHECK(Driver_FLASH_EMU.ReadData(addr, unit, sizeof(unit)) ==
+               (int32_t)sizeof(unit), "cannot read the header");
+    unit[offset % TEST_PROGRAM_UNIT] &= fs_version;
+    TEST_CHECK(Driver_FLASH_EMU.ProgramData(addr, unit, sizeof(unit)) ==
+               (int32_t)sizeof(unit), "cannot program the header");
+
+    return 0;
+}
+
+/* A filesystem of the previous version, which has the same layout, is
+ * upgraded when it is mounted and keeps its files, including when the power
+ * is cut during the upgrade.
+ */
+static int test_version_upgrade(void)
+{
+    uint32_t cut;
+
+    if (start(5) != 0) {
+        return -1;
+    }
+
+    for (cut = 0; cut < TEST_NUM_CUTS / 10u; cut++) {
+        if ((run_ops(TEST_OPS_AFTER_CUT) != 0) ||
+            (set_fs_version(ITS_PREVIOUS_SUPPORTED_VERSION) != 0)) {
+            return -1;
+        }
+
+        /* Mount, with the power cut during the upgrade for most of them */
+        flash_emu_close();
+        TEST_CHECK(flash_emu_open(&emu_cfg) == 0, "cannot open the flash");
+        TEST_CHECK(Driver_FLASH_EMU.Initialize(NULL) == ARM_DRIVER_OK,
+                   "cannot initialize the flash");
+        flash_emu_set_power_cut(test_rand() % TEST_CUT_WINDOW, test_rand());
+        (void)mount(&fs_ctx, false);
+        flash_emu_set_power_cut(0, 0);
+
+        if (remount() != 0) {
+            return -1;
+        }
+
+        TEST_CHECK(fs_ctx.meta_block_header.fs_version ==
+                   ITS_SUPPORTED_VERSION, "version %u not upgraded",
+                   (unsigned)fs_ctx.meta_block_header.fs_version);
+        TEST_CHECK(files_match(files), "files lost by the upgrade %u",
+                   (unsigned)cut);
+
+        if (mount_check_ctx() != 0) {
+            return -1;
+        }
+    }
+
+    return stop();
+}
+
+#if ITS_BACKGROUND_MAINTENANCE
+/* Checks that the data given is nowhere in the flash */
+static int check_not_in_flash(const uint8_t *data, size_t size)
+{
+    static uint8_t image[TEST_NUM_BLOCKS * TEST_BLOCK_SIZE];
+    size_t pos;
+
+    TEST_CHECK(Driver_FLASH_EMU.ReadData(0, image, sizeof(image)) ==
+               (int32_t)sizeof(image), "cannot read the flash");
+
+    for (pos = 0; pos + size <= sizeof(image); pos++) {
+        TEST_CHECK(memcmp(&image[pos], data, size) != 0,
+                   "removed data found in flash at 0x%x", (unsigned)pos);
+    }
+
+    return 0;
+}
+
+/* The maintenance leaves the erase of the scratch blocks to later, but the
+ * data of a deleted file must not stay in flash, whether it is deleted on its
+ * own or by a transaction.
+ */
+static int test_delete_erases(void)
+{
+    struct its_flash_fs_file_info_t info = {
+        .flags = ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE,
+    };
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint32_t n;
+    uint32_t idx;
+    size_t size;
+    size_t i;
+    psa_status_t status;
+
+    if ((start(6) != 0) || (run_ops(TEST_OPS_AFTER_CUT) != 0)) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_CUTS / 4u; n++) {
+        idx = test_rand() % TEST_NUM_FILES;
+        make_fid(idx, fid);
+
+        size = ITS_UTILS_MIN(ITS_UTILS_ALIGN(16u + (test_rand() % 64u),
+                                             TEST_PROGRAM_UNIT),
+                             TEST_MAX_FILE_SIZE);
+        for (i = 0; i < size; i++) {
+            buf[i] = (uint8_t)test_rand();
+        }
+        info.size_max = size;
+        status = its_flash_fs_file_write(&fs_ctx, fid, &info, size, 0, buf);
+        if (status == PSA_ERROR_INSUFFICIENT_STORAGE) {
+            continue;
+        }
+        TEST_CHECK(status == PSA_SUCCESS, "write failed (status %d)",
+                   (int)status);
+
+        if ((n % 2u) == 0) {
+            status = its_flash_fs_file_delete(&fs_ctx, fid);
+        } else {
+            its_flash_fs_txn_begin(&fs_ctx, &txn);
+            status = its_flash_fs_txn_delete(&txn, fid);
+            if (status == PSA_SUCCESS) {
+                status = its_flash_fs_txn_commit(&txn);
+            }
+        }
+        TEST_CHECK(status == PSA_SUCCESS, "delete failed (status %d)",
+                   (int)status);
+        files[idx].exists = false;
+
+        if ((check_not_in_flash(buf, size) != 0) ||
+            (run_ops(test_rand() % 4u) != 0)) {
+            return -1;
+        }
+    }
+
+    TEST_CHECK(files_match(files), "files lost by the deletes");
+
+    return stop();
+}
+#endif /* ITS_BACKGROUND_MAINTENANCE */
+
+static const struct {
+    const char *name;
+    int (*run)(void);
+} tests[] = {
+    { "index_power_cut", test_index_power_cut },
+    { "metadata_xor", test_metadata_xor },
+    { "txn", test_txn },
+    { "txn_power_cut", test_txn_power_cut },
+    { "version_upgrade", test_version_upgrade },
+#if ITS_BACKGROUND_MAINTENANCE
+    { "delete_erases", test_delete_erases },
+#endif
+};
+
+int main(int argc, char *argv[])
+{
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if ((argc > 1) && (strcmp(argv[1], tests[i].name) != 0)) {
+            continue;
+        }
+
+        ret = tests[i].run();
+        printf("%s: %s\n", tests[i].name, (ret == 0) ? "PASS" : "FAIL");
+        if (ret != 0) {
+            /* Leave the flash device closed for the next test */
+            flash_emu_close();
+        }
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
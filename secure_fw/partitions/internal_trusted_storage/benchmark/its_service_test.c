@@ -0,0 +1,343 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host tests of the ITS service on the file backed flash emulator. They call
+ * the service as the request manager does, for several clients, and check the
+ * rules the service applies to the transactions.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "flash_emu.h"
+#include "psa/internal_trusted_storage.h"
+#include "tfm_hal_its.h"
+#include "tfm_internal_trusted_storage.h"
+#include "tfm_its_req_mngr.h"
+
+#define TEST_IMAGE_PATH      "its_service_test.img"
+#define TEST_NUM_BLOCKS      6u
+#define TEST_BLOCK_SIZE      4096u
+
+/* Two secure partitions, and a non-secure client */
+#define TEST_CLIENT_A        (0x102)
+#define TEST_CLIENT_B        (0x103)
+#define TEST_CLIENT_NS       (-1)
+
+#define TEST_UID_1           1u
+#define TEST_UID_2           2u
+#define TEST_DATA_SIZE       64u
+
+static const struct flash_emu_config_t emu_cfg = {
+    .image_path = TEST_IMAGE_PATH,
+    .sector_size = TEST_BLOCK_SIZE,
+    .sector_count = TEST_NUM_BLOCKS,
+    .program_unit = TFM_HAL_ITS_PROGRAM_UNIT,
+};
+
+/* Data of the client, read and written by the service through the request
+ * manager
+ */
+static const uint8_t *client_src;
+static uint8_t client_dst[TEST_DATA_SIZE];
+static size_t client_dst_len;
+
+static uint32_t failures;
+
+#define TEST_CHECK(cond, ...)                               \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            failures++;                                     \
+            fprintf(stderr, "%s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            return -1;                                      \
+        }                                                   \
+    } while (0)
+
+#define TEST_CHECK_STATUS(expr, expected)                                  \
+    do {                                                                   \
+        psa_status_t status_ = (expr);                                     \
+        TEST_CHECK(status_ == (expected), "%s returned %d instead of %d",  \
+                   #expr, (int)status_, (int)(expected));                  \
+    } while (0)
+
+size_t its_req_mngr_read(uint8_t *buf, size_t num_bytes)
+{
+    (void)memcpy(buf, client_src, num_bytes);
+    client_src += num_bytes;
+
+    return num_bytes;
+}
+
+void its_req_mngr_write(const uint8_t *buf, size_t num_bytes)
+{
+    (void)memcpy(&client_dst[client_dst_len], buf, num_bytes);
+    client_dst_len += num_bytes;
+}
+
+enum tfm_hal_status_t tfm_hal_its_fs_info(struct tfm_hal_its_fs_info_t *fs_info)
+{
+    fs_info->flash_area_addr = 0;
+    fs_info->flash_area_size = TEST_NUM_BLOCKS * TEST_BLOCK_SIZE;
+    fs_info->sectors_per_block = 1;
+
+    return TFM_HAL_SUCCESS;
+}
+
+/* Data of an asset, which depends on its UID and on a version */
+static void make_data(psa_storage_uid_t uid, uint8_t version, uint8_t *data)
+{
+    size_t i;
+
+    for (i = 0; i < TEST_DATA_SIZE; i++) {
+        data[i] = (uint8_t)((uid * 31u) + (version * 7u) + i);
+    }
+}
+
+static psa_status_t set(int32_t client_id, psa_storage_uid_t uid,
+                        uint8_t version, psa_storage_create_flags_t flags)
+{
+    uint8_t data[TEST_DATA_SIZE];
+
+    make_data(uid, version, data);
+    client_src = data;
+
+    return tfm_its_set(client_id, uid, TEST_DATA_SIZE, flags);
+}
+
+static psa_status_t txn_set(int32_t client_id, psa_storage_uid_t uid,
+                            uint8_t version, psa_storage_create_flags_t flags)
+{
+    uint8_t data[TEST_DATA_SIZE];
+
+    make_data(uid, version, data);
+    client_src = data;
+
+    return tfm_its_txn_set(client_id, uid, TEST_DATA_SIZE, flags);
+}
+
+/* Checks that the asset holds the data of the version given */
+static int check_data(int32_t client_id, psa_storage_uid_t uid,
+                      uint8_t version)
+{
+    uint8_t data[TEST_DATA_SIZE];
+    size_t len = 0;
+
+    client_dst_len = 0;
+    TEST_CHECK_STATUS(tfm_its_get(client_id, uid, 0, TEST_DATA_SIZE, &len),
+                      PSA_SUCCESS);
+
+    make_data(uid, version, data);
+    TEST_CHECK((len == TEST_DATA_SIZE) && (client_dst_len == TEST_DATA_SIZE) &&
+               (memcmp(client_dst, data, TEST_DATA_SIZE) == 0),
+               "asset %u does not hold version %u", (unsigned)uid,
+               (unsigned)version);
+
+    return 0;
+}
+
+/* Starts a test on an empty filesystem */
+static int start(void)
+{
+    (void)remove(TEST_IMAGE_PATH);
+    TEST_CHECK(flash_emu_open(&emu_cfg) == 0, "cannot open the flash");
+    TEST_CHECK_STATUS(tfm_its_init(), PSA_SUCCESS);
+
+    return 0;
+}
+
+static int stop(void)
+{
+    flash_emu_close();
+
+    return 0;
+}
+
+/* A client cannot begin a transaction, nor use one, while another client has
+ * one in progress. The transaction in progress is kept.
+ */
+static int test_txn_owner(void)
+{
+    if (start() != 0) {
+        return -1;
+    }
+
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_A), PSA_SUCCESS);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_A, TEST_UID_1, 1,
+                              PSA_STORAGE_FLAG_NONE), PSA_SUCCESS);
+
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_B), PSA_ERROR_BAD_STATE);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_B, TEST_UID_1, 2,
+                              PSA_STORAGE_FLAG_NONE), PSA_ERROR_BAD_STATE);
+    TEST_CHECK_STATUS(tfm_its_txn_remove(TEST_CLIENT_B, TEST_UID_1),
+                      PSA_ERROR_BAD_STATE);
+    TEST_CHECK_STATUS(tfm_its_txn_abort(TEST_CLIENT_B), PSA_ERROR_BAD_STATE);
+    TEST_CHECK_STATUS(tfm_its_txn_commit(TEST_CLIENT_B), PSA_ERROR_BAD_STATE);
+
+    /* The client owning the transaction may begin it again */
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_A), PSA_SUCCESS);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_A, TEST_UID_2, 1,
+                              PSA_STORAGE_FLAG_NONE), PSA_SUCCESS);
+    TEST_CHECK_STATUS(tfm_its_txn_commit(TEST_CLIENT_A), PSA_SUCCESS);
+    if (check_data(TEST_CLIENT_A, TEST_UID_2, 1) != 0) {
+        return -1;
+    }
+    TEST_CHECK_STATUS(tfm_its_get_info(TEST_CLIENT_A, TEST_UID_1,
+                                       &(struct psa_storage_info_t){ 0 }),
+                      PSA_ERROR_DOES_NOT_EXIST);
+
+    /* Once it is committed, another client may begin one */
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_B), PSA_SUCCESS);
+    TEST_CHECK_STATUS(tfm_its_txn_abort(TEST_CLIENT_B), PSA_SUCCESS);
+
+    return stop();
+}
+
+/* A non-secure client cannot begin a transaction, nor use the one of a secure
+ * partition. The transaction in progress is kept.
+ */
+static int test_txn_non_secure(void)
+{
+    if (start() != 0) {
+        return -1;
+    }
+
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_NS),
+                      PSA_ERROR_NOT_PERMITTED);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_NS, TEST_UID_1, 1,
+                              PSA_STORAGE_FLAG_NONE), PSA_ERROR_NOT_PERMITTED);
+
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_A), PSA_SUCCESS);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_A, TEST_UID_1, 1,
+                              PSA_STORAGE_FLAG_NONE), PSA_SUCCESS);
+
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_NS),
+                      PSA_ERROR_NOT_PERMITTED);
+    TEST_CHECK_STATUS(tfm_its_txn_remove(TEST_CLIENT_NS, TEST_UID_1),
+                      PSA_ERROR_NOT_PERMITTED);
+    TEST_CHECK_STATUS(tfm_its_txn_abort(TEST_CLIENT_NS),
+                      PSA_ERROR_NOT_PERMITTED);
+    TEST_CHECK_STATUS(tfm_its_txn_commit(TEST_CLIENT_NS),
+                      PSA_ERROR_NOT_PERMITTED);
+
+    /* The non-secure client still has the plain API */
+    TEST_CHECK_STATUS(set(TEST_CLIENT_NS, TEST_UID_2, 2,
+                          PSA_STORAGE_FLAG_NONE), PSA_SUCCESS);
+
+    TEST_CHECK_STATUS(tfm_its_txn_commit(TEST_CLIENT_A), PSA_SUCCESS);
+    if ((check_data(TEST_CLIENT_A, TEST_UID_1, 1) != 0) ||
+        (check_data(TEST_CLIENT_NS, TEST_UID_2, 2) != 0)) {
+        return -1;
+    }
+
+    return stop();
+}
+
+/* An asset staged with the write once flag cannot be staged again nor removed
+ * in the same transaction, nor once the transaction has committed.
+ */
+static int test_txn_write_once(void)
+{
+    if (start() != 0) {
+        return -1;
+    }
+
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_A), PSA_SUCCESS);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_A, TEST_UID_1, 1,
+                              PSA_STORAGE_FLAG_WRITE_ONCE), PSA_SUCCESS);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_A, TEST_UID_1, 2,
+                              PSA_STORAGE_FLAG_NONE), PSA_ERROR_NOT_PERMITTED);
+    TEST_CHECK_STATUS(tfm_its_txn_remove(TEST_CLIENT_A, TEST_UID_1),
+                      PSA_ERROR_NOT_PERMITTED);
+    TEST_CHECK_STATUS(tfm_its_txn_commit(TEST_CLIENT_A), PSA_SUCCESS);
+    if (check_data(TEST_CLIENT_A, TEST_UID_1, 1) != 0) {
+        return -1;
+    }
+
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_A), PSA_SUCCESS);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_A, TEST_UID_1, 3,
+                              PSA_STORAGE_FLAG_NONE), PSA_ERROR_NOT_PERMITTED);
+    TEST_CHECK_STATUS(tfm_its_txn_remove(TEST_CLIENT_A, TEST_UID_1),
+                      PSA_ERROR_NOT_PERMITTED);
+    TEST_CHECK_STATUS(tfm_its_txn_abort(TEST_CLIENT_A), PSA_SUCCESS);
+    if (check_data(TEST_CLIENT_A, TEST_UID_1, 1) != 0) {
+        return -1;
+    }
+
+    return stop();
+}
+
+/* An asset created with the write once flag outside of the transaction after
+ * it has been staged makes the commit fail, without applying anything.
+ */
+static int test_txn_write_once_commit(void)
+{
+    if (start() != 0) {
+        return -1;
+    }
+
+    TEST_CHECK_STATUS(tfm_its_txn_begin(TEST_CLIENT_A), PSA_SUCCESS);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_A, TEST_UID_1, 1,
+                              PSA_STORAGE_FLAG_NONE), PSA_SUCCESS);
+    TEST_CHECK_STATUS(txn_set(TEST_CLIENT_A, TEST_UID_2, 1,
+                              PSA_STORAGE_FLAG_NONE), PSA_SUCCESS);
+    TEST_CHECK_STATUS(set(TEST_CLIENT_A, TEST_UID_2, 2,
+                          PSA_STORAGE_FLAG_WRITE_ONCE), PSA_SUCCESS);
+    TEST_CHECK_STATUS(tfm_its_txn_commit(TEST_CLIENT_A),
+                      PSA_ERROR_NOT_PERMITTED);
+
+    if (check_data(TEST_CLIENT_A, TEST_UID_2, 2) != 0) {
+        return -1;
+    }
+    TEST_CHECK_STATUS(tfm_its_get_info(TEST_CLIENT_A, TEST_UID_1,
+                                       &(struct psa_storage_info_t){ 0 }),
+                      PSA_ERROR_DOES_NOT_EXIST);
+
+    /* The failed commit has ended the transaction */
+    TEST_CHECK_STATUS(tfm_its_txn_abort(TEST_CLIENT_A), PSA_ERROR_BAD_STATE);
+
+    return stop();
+}
+
+static const struct {
+    const char *name;
+    int (*run)(void);
+} tests[] = {
+    { "txn_owner", test_txn_owner },
+    { "txn_non_secure", test_txn_non_secure },
+    { "txn_write_once", test_txn_write_once },
+    { "txn_write_once_commit", test_txn_write_once_commit },
+};
+
+int main(int argc, char *argv[])
+{
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if ((argc > 1) && (strcmp(argv[1], tests[i].name) != 0)) {
+            continue;
+        }
+
+        ret = tests[i].run();
+        printf("%s: %s\n", tests[i].name, (ret == 0) ? "PASS" : "FAIL");
+        if (ret != 0) {
+            /* Leave the flash device closed for the next test, and end the
+             * transaction the test may have left in progress
+             */
+            (void)tfm_its_txn_abort(TEST_CLIENT_A);
+            (void)tfm_its_txn_abort(TEST_CLIENT_B);
+            flash_emu_close();
+        }
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -11,6 +11,9 @@
 #include <string.h>
 
 #include "config_tfm.h"
+
+#if !ITS_FLASH_FS_LOG
+
 #include "its_flash_fs.h"
 #include "its_flash_fs_dblock.h"
 #include "its_utils.h"
@@ -135,6 +138,14 @@ static psa_status_t its_flash_fs_validate_config(
         ret = PSA_ERROR_INVALID_ARGUMENT;
     }
 
+#if ITS_FILE_INDEX
+    /* The file index is dimensioned statically */
+    if ((cfg->max_num_files == 0) ||
+        (cfg->max_num_files > ITS_FLASH_FS_MAX_NUM_FILES)) {
+        ret = PSA_ERROR_INVALID_ARGUMENT;
+    }
+#endif
+
     return ret;
 }
 
@@ -161,6 +172,8 @@ psa_status_t its_flash_fs_init_ctx(struct its_flash_fs_ctx_t *fs_ctx,
     fs_ctx->cfg = fs_cfg;
     fs_ctx->ops = fs_ops;
 
+    its_flash_fs_io_init(fs_ctx);
+
     return PSA_SUCCESS;
 }
 
@@ -250,6 +263,11 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
     finfo->size_max = ITS_UTILS_ALIGN(finfo->size_max, fs_ctx->cfg->program_unit);
 #endif
 
+    err = its_flash_fs_mblock_prepare_scratch(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
     /* Check if the file already exists */
     err = its_flash_fs_mblock_get_file_idx_meta(fs_ctx, fid, &old_idx, &file_meta);
     if (err == PSA_SUCCESS) {
@@ -408,6 +426,10 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
         return err;
     }
 
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.user_bytes += data_size;
+#endif
+
     /* Delete the old file in a second block update.
      * Note: A power failure after this point, but before the deletion has
      * completed, will leave the old file in the filesystem, so it is always
@@ -442,6 +464,11 @@ static psa_status_t its_flash_fs_delete_idx(struct its_flash_fs_ctx_t *fs_ctx,
         return PSA_ERROR_DOES_NOT_EXIST;
     }
 
+    err = its_flash_fs_mblock_prepare_scratch(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
     /* Save logical block, data_index and max_size to be used later on */
     del_file_lblock = file_meta.lblock;
     del_file_data_idx = file_meta.data_idx;
@@ -563,7 +590,17 @@ psa_status_t its_flash_fs_file_delete(struct its_flash_fs_ctx_t *fs_ctx,
         return PSA_ERROR_DOES_NOT_EXIST;
     }
 
-    return its_flash_fs_delete_idx(fs_ctx, del_file_idx);
+    err = its_flash_fs_delete_idx(fs_ctx, del_file_idx);
+#if ITS_BACKGROUND_MAINTENANCE
+    /* The data of the file is left in the scratch blocks, which are erased
+     * now rather than by the maintenance, so that it does not stay in flash.
+     */
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_mblock_erase_scratch(fs_ctx);
+    }
+#endif
+
+    return err;
 }
 
 psa_status_t its_flash_fs_file_read(struct its_flash_fs_ctx_t *fs_ctx,
@@ -597,3 +634,737 @@ psa_status_t its_flash_fs_file_read(struct its_flash_fs_ctx_t *fs_ctx,
 
     return PSA_SUCCESS;
 }
+
+#if ITS_BACKGROUND_MAINTENANCE
+psa_status_t its_flash_fs_maintain(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    /* Updates leave the erase of the scratch blocks to this function */
+    return its_flash_fs_mblock_erase_scratch(fs_ctx);
+}
+#endif
+
+#if ITS_TRANSACTION
+/* Logical block of a staged file which does not fit in logical block 0 */
+#define ITS_FLASH_FS_TXN_DBLOCK  ITS_BLOCK_INVALID_ID
+
+static bool its_flash_fs_txn_is_write(const struct its_flash_fs_txn_op_t *op)
+{
+    return !(op->flags & ITS_FLASH_FS_FLAG_DELETE);
+}
+
+static bool its_flash_fs_txn_removes(const struct its_flash_fs_txn_op_t *op,
+                                     uint32_t lblock)
+{
+    return (op->old_idx != ITS_METADATA_INVALID_INDEX) &&
+           (op->old_lblock == lblock);
+}
+
+/* Returns the index of the operation staged for the file, or num_ops */
+static uint32_t its_flash_fs_txn_find(const struct its_flash_fs_txn_t *txn,
+                                      const uint8_t *fid)
+{
+    uint32_t i;
+
+    for (i = 0; i < txn->num_ops; i++) {
+        if (memcmp(txn->ops[i].fid, fid, ITS_FILE_ID_SIZE) == 0) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/* Removes a staged operation. Its data stays in the buffer until the
+ * transaction ends.
+ */
+static void its_flash_fs_txn_drop(struct its_flash_fs_txn_t *txn, uint32_t i)
+{
+    txn->num_ops--;
+    (void)memmove(&txn->ops[i], &txn->ops[i + 1],
+                  (txn->num_ops - i) * sizeof(txn->ops[0]));
+}
+
+/* Size of the files removed from the logical block before the offset */
+static size_t its_flash_fs_txn_removed_before(
+                                          const struct its_flash_fs_txn_t *txn,
+                                          uint32_t lblock,
+                                          size_t data_idx)
+{
+    size_t size = 0;
+    uint32_t i;
+
+    for (i = 0; i < txn->num_ops; i++) {
+        if (its_flash_fs_txn_removes(&txn->ops[i], lblock) &&
+            (txn->ops[i].old_data_idx < data_idx)) {
+            size += txn->ops[i].old_max_size;
+        }
+    }
+
+    return size;
+}
+
+/* First file removed from the logical block at or after the offset */
+static const struct its_flash_fs_txn_op_t *its_flash_fs_txn_next_removed(
+                                          const struct its_flash_fs_txn_t *txn,
+                                          uint32_t lblock,
+                                          size_t data_idx)
+{
+    const struct its_flash_fs_txn_op_t *next = NULL;
+    uint32_t i;
+
+    for (i = 0; i < txn->num_ops; i++) {
+        /* Files without data do not split the data kept in the block */
+        if (its_flash_fs_txn_removes(&txn->ops[i], lblock) &&
+            (txn->ops[i].old_max_size != 0) &&
+            (txn->ops[i].old_data_idx >= data_idx) &&
+            ((next == NULL) ||
+             (txn->ops[i].old_data_idx < next->old_data_idx))) {
+            next = &txn->ops[i];
+        }
+    }
+
+    return next;
+}
+
+/**
+ * \brief Checks that the staged operations can be committed in one metadata
+ *        block update, and places the new files.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in,out] txn     Transaction to commit
+ * \param[out]    dblock  Dedicated logical block rewritten by the update, or
+ *                        logical block 0 if none
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_plan(struct its_flash_fs_ctx_t *fs_ctx,
+                                          struct its_flash_fs_txn_t *txn,
+                                          uint32_t *dblock)
+{
+    struct its_block_meta_t block_meta;
+    struct its_file_meta_t file_meta;
+    struct its_flash_fs_txn_op_t *op;
+    size_t lb0_free;
+    size_t dblock_size = 0;
+    uint32_t num_free = 0;
+    uint32_t num_new = 0;
+    uint32_t i;
+    psa_status_t err;
+
+    *dblock = ITS_LOGICAL_DBLOCK0;
+
+    /* Find the files replaced or deleted. Only logical block 0 and one other
+     * block have scratch space to be rewritten in a single update.
+     */
+    for (i = 0; i < txn->num_ops; i++) {
+        op = &txn->ops[i];
+
+        err = its_flash_fs_mblock_get_file_idx_meta(fs_ctx, op->fid,
+                                                    &op->old_idx, &file_meta);
+        if (err == PSA_ERROR_DOES_NOT_EXIST) {
+            if (!its_flash_fs_txn_is_write(op)) {
+                return PSA_ERROR_DOES_NOT_EXIST;
+            }
+            op->old_idx = ITS_METADATA_INVALID_INDEX;
+            num_new++;
+            continue;
+        } else if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        op->old_lblock = file_meta.lblock;
+        op->old_data_idx = file_meta.data_idx;
+        op->old_max_size = file_meta.max_size;
+
+        /* The entry of a deleted file can be given to a new file */
+        if (!its_flash_fs_txn_is_write(op)) {
+            num_free++;
+        }
+
+        if (file_meta.lblock != ITS_LOGICAL_DBLOCK0) {
+            if ((*dblock != ITS_LOGICAL_DBLOCK0) &&
+                (*dblock != file_meta.lblock)) {
+                return PSA_ERROR_NOT_SUPPORTED;
+            }
+            *dblock = file_meta.lblock;
+        }
+    }
+
+    /* Check that there are enough free file metadata entries */
+    for (i = 0; (i < fs_ctx->cfg->max_num_files) && (num_free < num_new); i++) {
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &file_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if (its_utils_validate_fid(file_meta.id) != PSA_SUCCESS) {
+            num_free++;
+        }
+    }
+
+    if (num_free < num_new) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    /* Place the new files in logical block 0 first, as for a single write,
+     * and the ones which do not fit there in the dedicated block.
+     */
+    err = its_flash_fs_mblock_read_block_metadata(fs_ctx, ITS_LOGICAL_DBLOCK0,
+                                                  &block_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    lb0_free = block_meta.free_size +
+               its_flash_fs_txn_removed_before(txn, ITS_LOGICAL_DBLOCK0,
+                                               SIZE_MAX);
+
+    for (i = 0; i < txn->num_ops; i++) {
+        op = &txn->ops[i];
+        if (!its_flash_fs_txn_is_write(op)) {
+            continue;
+        }
+
+        if (op->size_max <= lb0_free) {
+            op->lblock = ITS_LOGICAL_DBLOCK0;
+            lb0_free -= op->size_max;
+        } else {
+            op->lblock = ITS_FLASH_FS_TXN_DBLOCK;
+            dblock_size += op->size_max;
+        }
+    }
+
+    if (dblock_size == 0) {
+        return PSA_SUCCESS;
+    }
+
+    if (*dblock != ITS_LOGICAL_DBLOCK0) {
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, *dblock,
+                                                      &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if ((block_meta.free_size +
+             its_flash_fs_txn_removed_before(txn, *dblock, SIZE_MAX))
+            < dblock_size) {
+            return PSA_ERROR_INSUFFICIENT_STORAGE;
+        }
+    } else {
+        /* Use the first dedicated block with enough free space */
+        for (i = ITS_LOGICAL_DBLOCK0 + 1;
+             i < its_flash_fs_num_active_dblocks(fs_ctx->cfg); i++) {
+            err = its_flash_fs_mblock_read_block_metadata(fs_ctx, i,
+                                                          &block_meta);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+
+            if (block_meta.free_size >= dblock_size) {
+                *dblock = i;
+                break;
+            }
+        }
+
+        if (*dblock == ITS_LOGICAL_DBLOCK0) {
+            return PSA_ERROR_INSUFFICIENT_STORAGE;
+        }
+    }
+
+    for (i = 0; i < txn->num_ops; i++) {
+        if (its_flash_fs_txn_is_write(&txn->ops[i]) &&
+            (txn->ops[i].lblock == ITS_FLASH_FS_TXN_DBLOCK)) {
+            txn->ops[i].lblock = *dblock;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Rewrites a logical block in its scratch block, without the files
+ *        replaced or deleted and with the new files appended.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in,out] txn         Transaction to commit
+ * \param[in]     lblock      Logical block number
+ * \param[in,out] block_meta  Metadata of the logical block, the free size is
+ *                            updated
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_rewrite_block(
+                                            struct its_flash_fs_ctx_t *fs_ctx,
+                                            struct its_flash_fs_txn_t *txn,
+                                            uint32_t lblock,
+                                            struct its_block_meta_t *block_meta)
+{
+    const struct its_flash_fs_txn_op_t *removed;
+    struct its_flash_fs_txn_op_t *op;
+    uint32_t scratch_id;
+    size_t data_end;
+    size_t dst_offset;
+    size_t src_offset;
+    size_t size;
+    uint32_t i;
+    psa_status_t err;
+
+    scratch_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx, lblock);
+    data_end = fs_ctx->cfg->block_size - block_meta->free_size;
+    src_offset = block_meta->data_start;
+    dst_offset = block_meta->data_start;
+
+    /* Move the data kept between the files removed */
+    do {
+        removed = its_flash_fs_txn_next_removed(txn, lblock, src_offset);
+        size = ((removed != NULL) ? removed->old_data_idx : data_end)
+               - src_offset;
+
+        err = its_flash_fs_block_to_block_move(fs_ctx, scratch_id, dst_offset,
+                                               block_meta->phy_id, src_offset,
+                                               size);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+        dst_offset += size;
+
+        if (removed != NULL) {
+            src_offset = removed->old_data_idx + removed->old_max_size;
+        }
+    } while (removed != NULL);
+
+    /* Append the new files */
+    for (i = 0; i < txn->num_ops; i++) {
+        op = &txn->ops[i];
+        if (!its_flash_fs_txn_is_write(op) || (op->lblock != lblock)) {
+            continue;
+        }
+
+        op->data_idx = dst_offset;
+        if (op->size_current != 0) {
+            err = its_flash_fs_io_write(fs_ctx, scratch_id,
+                                        &txn->buf[op->data_offset], dst_offset,
+                                        ITS_UTILS_ALIGN(op->size_current,
+                                                    fs_ctx->cfg->program_unit));
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+        }
+        dst_offset += op->size_max;
+    }
+
+    block_meta->free_size = fs_ctx->cfg->block_size - dst_offset;
+
+    /* Logical block 0 is flushed with the metadata */
+    if (lblock != ITS_LOGICAL_DBLOCK0) {
+        err = its_flash_fs_io_flush(fs_ctx, scratch_id);
+    }
+
+    return err;
+}
+
+/**
+ * \brief Writes the scratch metadata block for the staged operations and
+ *        swaps it with the active one.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in,out] txn     Transaction to commit
+ * \param[in]     dblock  Dedicated logical block rewritten by the update, or
+ *                        logical block 0 if none
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_apply(struct its_flash_fs_ctx_t *fs_ctx,
+                                           struct its_flash_fs_txn_t *txn,
+                                           uint32_t dblock)
+{
+    struct its_block_meta_t lb0_meta;
+    struct its_block_meta_t block_meta;
+    struct its_file_meta_t file_meta;
+    struct its_flash_fs_txn_op_t *op;
+    uint32_t cur_phys_block;
+    uint32_t next_new = 0;
+    uint32_t idx;
+    uint32_t i;
+    bool lb0_modified = false;
+    psa_status_t err;
+
+    for (i = 0; i < txn->num_ops; i++) {
+        op = &txn->ops[i];
+        if (its_flash_fs_txn_removes(op, ITS_LOGICAL_DBLOCK0) ||
+            (its_flash_fs_txn_is_write(op) &&
+             (op->lblock == ITS_LOGICAL_DBLOCK0))) {
+            lb0_modified = true;
+        }
+    }
+
+    err = its_flash_fs_mblock_read_block_metadata(fs_ctx, ITS_LOGICAL_DBLOCK0,
+                                                  &lb0_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = its_flash_fs_mblock_prepare_scratch(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* The data in logical block 0 is moved to the scratch metadata block in
+     * any case, as for a single write.
+     */
+    if (lb0_modified) {
+        err = its_flash_fs_txn_rewrite_block(fs_ctx, txn, ITS_LOGICAL_DBLOCK0,
+                                             &lb0_meta);
+    } else {
+        err = its_flash_fs_mblock_migrate_lb0_data_to_scratch(fs_ctx);
+    }
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    if (dblock != ITS_LOGICAL_DBLOCK0) {
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, dblock,
+                                                      &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        err = its_flash_fs_txn_rewrite_block(fs_ctx, txn, dblock, &block_meta);
+        if (err != PSA_SUCCESS) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        cur_phys_block = block_meta.phy_id;
+
+        /* Cur scratch block become the active datablock */
+        block_meta.phy_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
+                                                                    dblock);
+
+        /* Swap the scratch data block */
+        its_flash_fs_mblock_set_data_scratch(fs_ctx, cur_phys_block, dblock);
+    }
+
+    err = its_flash_fs_mblock_update_scratch_block_meta_lb0(fs_ctx, dblock,
+                                                            &block_meta,
+                                                            &lb0_meta);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    /* Write every file metadata entry, as most of them may have moved */
+    for (idx = 0; idx < fs_ctx->cfg->max_num_files; idx++) {
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, idx, &file_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        for (i = 0; i < txn->num_ops; i++) {
+            if (txn->ops[i].old_idx == idx) {
+                break;
+            }
+        }
+
+        op = NULL;
+        if (i < txn->num_ops) {
+            /* A replaced file keeps its entry, a deleted one frees it */
+            if (its_flash_fs_txn_is_write(&txn->ops[i])) {
+                op = &txn->ops[i];
+            } else {
+                file_meta = (struct its_file_meta_t){0};
+            }
+        } else if ((its_utils_validate_fid(file_meta.id) == PSA_SUCCESS) &&
+                   ((file_meta.lblock == ITS_LOGICAL_DBLOCK0) ||
+                    (file_meta.lblock == dblock))) {
+            /* A file kept in a rewritten block */
+            file_meta.data_idx -= its_flash_fs_txn_removed_before(
+                                                            txn,
+                                                            file_meta.lblock,
+                                                            file_meta.data_idx);
+        }
+
+        /* Give the free entries to the new files */
+        if ((op == NULL) &&
+            (its_utils_validate_fid(file_meta.id) != PSA_SUCCESS)) {
+            for (; next_new < txn->num_ops; next_new++) {
+                if (its_flash_fs_txn_is_write(&txn->ops[next_new]) &&
+                    (txn->ops[next_new].old_idx ==
+                     ITS_METADATA_INVALID_INDEX)) {
+                    op = &txn->ops[next_new++];
+                    break;
+                }
+            }
+        }
+
+        if (op != NULL) {
+            file_meta = (struct its_file_meta_t){0};
+            memcpy(file_meta.id, op->fid, ITS_FILE_ID_SIZE);
+            file_meta.lblock = op->lblock;
+            file_meta.data_idx = op->data_idx;
+            file_meta.cur_size = op->size_current;
+            file_meta.max_size = op->size_max;
+            file_meta.flags = op->flags;
+#ifdef ITS_ENCRYPTION
+            memcpy(file_meta.nonce, op->nonce, sizeof(op->nonce));
+            memcpy(file_meta.tag, op->tag, sizeof(op->tag));
+#endif
+        }
+
+        err = its_flash_fs_mblock_update_scratch_file_meta(fs_ctx, idx,
+                                                           &file_meta);
+        if (err != PSA_SUCCESS) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+    }
+
+    /* Write metadata header, swap metadata blocks and erase scratch blocks */
+    return its_flash_fs_mblock_meta_update_finalize(fs_ctx);
+}
+
+void its_flash_fs_txn_begin(struct its_flash_fs_ctx_t *fs_ctx,
+                            struct its_flash_fs_txn_t *txn)
+{
+    txn->fs_ctx = fs_ctx;
+    txn->num_ops = 0;
+    txn->buf_used = 0;
+}
+
+psa_status_t its_flash_fs_txn_write(struct its_flash_fs_txn_t *txn,
+                                    const uint8_t *fid,
+                                    struct its_flash_fs_file_info_t *finfo,
+                                    size_t data_size,
+                                    size_t offset,
+                                    const uint8_t *data)
+{
+    struct its_flash_fs_txn_op_t *op;
+    size_t size_current;
+    size_t size_max;
+    uint32_t i;
+
+    if (txn->fs_ctx == NULL) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (finfo == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Do not permit the user to pass filesystem-internal flags */
+    if (finfo->flags & ITS_FLASH_FS_INTERNAL_FLAGS_MASK) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+#if (ITS_FLASH_MAX_ALIGNMENT != 1)
+    /* Check that the offset is aligned with the flash program unit */
+    if (!ITS_UTILS_IS_ALIGNED(offset, txn->fs_ctx->cfg->program_unit)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+#endif
+
+    i = its_flash_fs_txn_find(txn, fid);
+
+    if (finfo->flags & ITS_FLASH_FS_FLAG_TRUNCATE) {
+#if (ITS_FLASH_MAX_ALIGNMENT != 1)
+        /* Set the max_size to be aligned with the flash program unit */
+        finfo->size_max = ITS_UTILS_ALIGN(finfo->size_max,
+                                          txn->fs_ctx->cfg->program_unit);
+#endif
+        if (finfo->size_max > txn->fs_ctx->cfg->max_file_size) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+        size_current = 0;
+        size_max = finfo->size_max;
+    } else if ((i < txn->num_ops) &&
+               its_flash_fs_txn_is_write(&txn->ops[i])) {
+        size_current = txn->ops[i].size_current;
+        size_max = txn->ops[i].size_max;
+    } else {
+        /* Only whole files can be staged */
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* It is not permitted to create gaps in the file */
+    if (offset > size_current) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Check that the new data is contained within the file's max size */
+    if (its_utils_check_contained_in(size_max, offset, data_size)
+        != PSA_SUCCESS) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (finfo->flags & ITS_FLASH_FS_FLAG_TRUNCATE) {
+        if (((i == txn->num_ops) &&
+             (txn->num_ops == ITS_TRANSACTION_MAX_OPS)) ||
+            (size_max > sizeof(txn->buf) - txn->buf_used)) {
+            return PSA_ERROR_INSUFFICIENT_MEMORY;
+        }
+
+        /* The new file replaces anything staged before for it */
+        if (i < txn->num_ops) {
+            its_flash_fs_txn_drop(txn, i);
+        }
+
+        i = txn->num_ops++;
+        op = &txn->ops[i];
+        memcpy(op->fid, fid, ITS_FILE_ID_SIZE);
+        op->flags = finfo->flags;
+        op->size_current = 0;
+        op->size_max = size_max;
+        op->data_offset = txn->buf_used;
+        txn->buf_used += size_max;
+
+        /* Zero the staged data so that the alignment padding is meaningless */
+        (void)memset(&txn->buf[op->data_offset], 0, size_max);
+    }
+
+    op = &txn->ops[i];
+    if (data_size != 0) {
+        memcpy(&txn->buf[op->data_offset + offset], data, data_size);
+    }
+
+    /* Update the file's current size if required */
+    if ((offset + data_size) > op->size_current) {
+        op->size_current = offset + data_size;
+    }
+
+#ifdef ITS_ENCRYPTION
+    memcpy(op->nonce, finfo->nonce, sizeof(finfo->nonce));
+    memcpy(op->tag, finfo->tag, sizeof(finfo->tag));
+#endif
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_txn_delete(struct its_flash_fs_txn_t *txn,
+                                     const uint8_t *fid)
+{
+    struct its_flash_fs_txn_op_t *op;
+    bool staged = false;
+    uint32_t idx;
+    uint32_t i;
+    psa_status_t err;
+
+    if (txn->fs_ctx == NULL) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    i = its_flash_fs_txn_find(txn, fid);
+    if (i < txn->num_ops) {
+        if (!its_flash_fs_txn_is_write(&txn->ops[i])) {
+            return PSA_SUCCESS;
+        }
+
+        /* Discard the staged write */
+        its_flash_fs_txn_drop(txn, i);
+        staged = true;
+    }
+
+    /* Only a file which exists in the filesystem needs to be deleted */
+    err = its_flash_fs_mblock_get_file_idx_meta(txn->fs_ctx, fid, &idx, NULL);
+    if (err != PSA_SUCCESS) {
+        return staged ? PSA_SUCCESS : PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    if (txn->num_ops == ITS_TRANSACTION_MAX_OPS) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    op = &txn->ops[txn->num_ops++];
+    memcpy(op->fid, fid, ITS_FILE_ID_SIZE);
+    op->flags = ITS_FLASH_FS_FLAG_DELETE;
+    op->size_current = 0;
+    op->size_max = 0;
+    op->data_offset = txn->buf_used;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_txn_get_info(const struct its_flash_fs_txn_t *txn,
+                                       const uint8_t *fid,
+                                       struct its_flash_fs_file_info_t *info)
+{
+    const struct its_flash_fs_txn_op_t *op;
+    uint32_t i;
+
+    if (txn->fs_ctx == NULL) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    i = its_flash_fs_txn_find(txn, fid);
+    if ((i == txn->num_ops) || !its_flash_fs_txn_is_write(&txn->ops[i])) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    op = &txn->ops[i];
+    info->size_max = op->size_max;
+    info->size_current = op->size_current;
+    info->flags = op->flags & ITS_FLASH_FS_USER_FLAGS_MASK;
+
+#ifdef ITS_ENCRYPTION
+    memcpy(info->nonce, op->nonce, TFM_ITS_ENC_NONCE_LENGTH);
+    memcpy(info->tag, op->tag, TFM_ITS_AUTH_TAG_LENGTH);
+#endif
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_txn_commit(struct its_flash_fs_txn_t *txn)
+{
+    struct its_flash_fs_ctx_t *fs_ctx = txn->fs_ctx;
+    uint32_t dblock;
+#if ITS_FLASH_FS_STATS || ITS_BACKGROUND_MAINTENANCE
+    uint32_t i;
+#endif
+    psa_status_t err;
+
+    if (fs_ctx == NULL) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    /* The transaction ends whatever the result */
+    txn->fs_ctx = NULL;
+
+    if (txn->num_ops == 0) {
+        return PSA_SUCCESS;
+    }
+
+    err = its_flash_fs_txn_plan(fs_ctx, txn, &dblock);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = its_flash_fs_txn_apply(fs_ctx, txn, dblock);
+
+#if ITS_FLASH_FS_STATS
+    if (err == PSA_SUCCESS) {
+        for (i = 0; i < txn->num_ops; i++) {
+            if (its_flash_fs_txn_is_write(&txn->ops[i])) {
+                fs_ctx->stats.user_bytes += txn->ops[i].size_current;
+            }
+        }
+    }
+#endif
+
+#if ITS_BACKGROUND_MAINTENANCE
+    /* As for a delete out of a transaction, the data of the deleted files is
+     * erased with the scratch blocks now.
+     */
+    for (i = 0; (err == PSA_SUCCESS) && (i < txn->num_ops); i++) {
+        if (!its_flash_fs_txn_is_write(&txn->ops[i])) {
+            err = its_flash_fs_mblock_erase_scratch(fs_ctx);
+            break;
+        }
+    }
+#endif
+
+    return err;
+}
+
+void its_flash_fs_txn_abort(struct its_flash_fs_txn_t *txn)
+{
+    txn->fs_ctx = NULL;
+}
+#endif /* ITS_TRANSACTION */
+
+#endif /* !ITS_FLASH_FS_LOG */
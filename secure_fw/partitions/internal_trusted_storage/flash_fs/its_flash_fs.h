@@ -20,7 +20,12 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "config_tfm.h"
+#if ITS_FLASH_FS_LOG
+#include "its_flash_fs_log.h"
+#else
 #include "its_flash_fs_mblock.h"
+#endif
 #include "psa/error.h"
 
 #ifdef __cplusplus
@@ -42,6 +47,26 @@ extern "C" {
 /* Invalid block index */
 #define ITS_BLOCK_INVALID_ID 0xFFFFFFFFU
 
+#ifdef ITS_ENCRYPTION
+/* Encrypted files are stored as a sequence of chunks. Each chunk holds a nonce,
+ * the ciphertext of up to ITS_ENCRYPTION_CHUNK_SIZE bytes of the file and the
+ * authentication tag, padded to the flash program unit unless it is the last
+ * one. The tag follows the ciphertext, where the platform AEAD may expect it.
+ * A file has at least one chunk, so that an empty file is authenticated.
+ */
+#define ITS_ENC_CHUNK_OVERHEAD  (TFM_ITS_ENC_NONCE_LENGTH + \
+                                 TFM_ITS_AUTH_TAG_LENGTH)
+#define ITS_ENC_CHUNK_STRIDE    ITS_UTILS_ALIGN(ITS_ENC_CHUNK_OVERHEAD + \
+                                                ITS_ENCRYPTION_CHUNK_SIZE, \
+                                                ITS_FLASH_MAX_ALIGNMENT)
+
+/* Size in the filesystem of an encrypted file of the given size */
+#define ITS_ENC_FILE_SIZE(size) \
+    ((((size) / ITS_ENCRYPTION_CHUNK_SIZE) * ITS_ENC_CHUNK_STRIDE) + \
+     ((((size) % ITS_ENCRYPTION_CHUNK_SIZE) != 0 || (size) == 0) ? \
+      (ITS_ENC_CHUNK_OVERHEAD + ((size) % ITS_ENCRYPTION_CHUNK_SIZE)) : 0))
+#endif /* ITS_ENCRYPTION */
+
 /**
  * \struct its_flash_fs_config_t
  *
@@ -180,13 +205,78 @@ struct its_flash_fs_file_info_t {
     size_t size_max;      /*!< The maximum size of the file in bytes. */
     uint32_t flags;       /*!< Flags set when the file was created */
 #ifdef ITS_ENCRYPTION
-    /*!< Additional authenticated data */
-    uint8_t aad[ITS_FILE_ID_SIZE + ITS_DATA_SIZE_FIELD_SIZE + ITS_FLAG_SIZE];
-    uint8_t nonce[TFM_ITS_ENC_NONCE_LENGTH]; /*!< Nonce/IV for encrypted files */
-    uint8_t tag[TFM_ITS_AUTH_TAG_LENGTH];    /*!< Authentication tag */
+    uint8_t nonce[TFM_ITS_ENC_NONCE_LENGTH]; /*!< Nonce binding the chunks of
+                                              *   an encrypted file
+                                              */
+    uint8_t tag[TFM_ITS_AUTH_TAG_LENGTH];    /*!< Authentication tag of a file
+                                              *   encrypted as a whole
+                                              */
+#endif
+};
+
+#if ITS_TRANSACTION
+/*!
+ * \struct its_flash_fs_txn_op_t
+ *
+ * \brief Structure containing a file write or delete staged in a transaction.
+ */
+struct its_flash_fs_txn_op_t {
+    uint8_t fid[ITS_FILE_ID_SIZE]; /*!< ID of the file */
+    uint32_t flags;        /*!< Flags of the new file. Only the
+                            *   filesystem-internal delete flag for a delete.
+                            */
+    size_t size_current;   /*!< Size of the staged data in bytes */
+    size_t size_max;       /*!< Maximum size of the new file in bytes */
+    size_t data_offset;    /*!< Offset of the staged data in the buffer */
+#ifdef ITS_ENCRYPTION
+    uint8_t nonce[TFM_ITS_ENC_NONCE_LENGTH]; /*!< Nonce binding the chunks of
+                                              *   an encrypted file
+                                              */
+    uint8_t tag[TFM_ITS_AUTH_TAG_LENGTH];    /*!< Authentication tag of a file
+                                              *   encrypted as a whole
+                                              */
 #endif
+    /* Set when the transaction is committed */
+    uint32_t old_idx;      /*!< Metadata index of the file replaced or
+                            *   deleted, ITS_METADATA_INVALID_INDEX if none
+                            */
+    uint32_t old_lblock;   /*!< Logical block of the file replaced or deleted */
+    size_t old_data_idx;   /*!< Offset of the file replaced or deleted */
+    size_t old_max_size;   /*!< Maximum size of the file replaced or deleted */
+    uint32_t lblock;       /*!< Logical block of the new file */
+    size_t data_idx;       /*!< Offset of the new file in the logical block */
 };
 
+/*!
+ * \struct its_flash_fs_txn_t
+ *
+ * \brief Structure containing a transaction, which stages file writes and
+ *        deletes in RAM and commits them to a filesystem in a single metadata
+ *        block update.
+ *
+ * \details The user should allocate a variable of this type and start the
+ *          transaction with its_flash_fs_txn_begin(). The contents are internal
+ *          to the filesystem.
+ */
+struct its_flash_fs_txn_t {
+    struct its_flash_fs_ctx_t *fs_ctx; /*!< Filesystem the transaction applies
+                                        *   to, NULL if none is in progress
+                                        */
+    uint32_t num_ops;                  /*!< Number of staged operations */
+    size_t buf_used;                   /*!< Bytes of the buffer in use */
+    struct its_flash_fs_txn_op_t ops[ITS_TRANSACTION_MAX_OPS]; /*!< Staged
+                                                                *   operations
+                                                                */
+#ifdef ITS_ENCRYPTION
+    uint8_t buf[ITS_UTILS_ALIGN(ITS_ENC_FILE_SIZE(ITS_TRANSACTION_BUF_SIZE),
+                                ITS_FLASH_MAX_ALIGNMENT)]; /*!< Staged data */
+#else
+    uint8_t buf[ITS_UTILS_ALIGN(ITS_TRANSACTION_BUF_SIZE,
+                                ITS_FLASH_MAX_ALIGNMENT)]; /*!< Staged data */
+#endif
+};
+#endif /* ITS_TRANSACTION */
+
 /**
  * \brief Initialises the filesystem context. Must be called successfully before
  *        any other filesystem API is called.
@@ -286,6 +376,141 @@ psa_status_t its_flash_fs_file_read(struct its_flash_fs_ctx_t *fs_ctx,
 psa_status_t its_flash_fs_file_delete(struct its_flash_fs_ctx_t *fs_ctx,
                                       const uint8_t *fid);
 
+#if ITS_BACKGROUND_MAINTENANCE
+/**
+ * \brief Performs the flash maintenance which would otherwise be done by the
+ *        next writes of the filesystem, such as erasing the blocks they will
+ *        write to.
+ *
+ * \details It is meant to be called when the system is idle. It returns
+ *          immediately if there is nothing to do.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_maintain(struct its_flash_fs_ctx_t *fs_ctx);
+#endif
+
+#if ITS_FLASH_FS_STATS
+/**
+ * \brief Gets the flash access counters of the filesystem, counted since its
+ *        context was initialized.
+ *
+ * \param[in] fs_ctx  Filesystem context
+ *
+ * \return Returns the counters of the filesystem
+ */
+const struct its_flash_fs_stats_t *its_flash_fs_get_stats(
+                                       const struct its_flash_fs_ctx_t *fs_ctx);
+#endif
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+/**
+ * \brief Gets the counters of the accesses of the filesystem to the flash
+ *        cache, counted since its context was initialized.
+ *
+ * \param[in] fs_ctx  Filesystem context
+ *
+ * \return Returns the counters of the filesystem
+ */
+const struct its_flash_fs_cache_stats_t *its_flash_fs_get_cache_stats(
+                                       const struct its_flash_fs_ctx_t *fs_ctx);
+#endif
+
+#if ITS_TRANSACTION
+/**
+ * \brief Starts a transaction on a filesystem, discarding anything staged in
+ *        the transaction before.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[out]    txn     Transaction to start
+ */
+void its_flash_fs_txn_begin(struct its_flash_fs_ctx_t *fs_ctx,
+                            struct its_flash_fs_txn_t *txn);
+
+/**
+ * \brief Stages data to be written to a file when the transaction commits.
+ *
+ * \details A transaction only stages whole files: the first write of a file
+ *          must carry the ITS_FLASH_FS_FLAG_TRUNCATE flag, and it replaces
+ *          anything staged before for the file. Further writes without the
+ *          flag add data to that staged file, in the same way as
+ *          its_flash_fs_file_write() does for a file in flash.
+ *
+ * \param[in,out] txn        Transaction in progress
+ * \param[in]     fid        File ID
+ * \param[in]     finfo      Pointer to \ref its_flash_fs_file_info_t
+ * \param[in]     data_size  Size of the incoming write data.
+ * \param[in]     offset     Offset in the file to write. Must be less than or
+ *                           equal to the current staged size.
+ * \param[in]     data       Pointer to buffer containing data to be written
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ *
+ * \retval PSA_ERROR_INSUFFICIENT_MEMORY  The transaction cannot stage more
+ *                                        operations or data
+ */
+psa_status_t its_flash_fs_txn_write(struct its_flash_fs_txn_t *txn,
+                                    const uint8_t *fid,
+                                    struct its_flash_fs_file_info_t *finfo,
+                                    size_t data_size,
+                                    size_t offset,
+                                    const uint8_t *data);
+
+/**
+ * \brief Stages the deletion of a file when the transaction commits. A write
+ *        of the file staged before is discarded.
+ *
+ * \param[in,out] txn  Transaction in progress
+ * \param[in]     fid  File ID
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_delete(struct its_flash_fs_txn_t *txn,
+                                     const uint8_t *fid);
+
+/**
+ * \brief Gets the information of a file whose write is staged in the
+ *        transaction.
+ *
+ * \param[in]  txn   Transaction in progress
+ * \param[in]  fid   File ID
+ * \param[out] info  Pointer to the information structure to fill
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ *
+ * \retval PSA_ERROR_DOES_NOT_EXIST  No write of the file is staged
+ */
+psa_status_t its_flash_fs_txn_get_info(const struct its_flash_fs_txn_t *txn,
+                                       const uint8_t *fid,
+                                       struct its_flash_fs_file_info_t *info);
+
+/**
+ * \brief Commits the staged operations with a single metadata block update,
+ *        so that either all of them or none of them are applied after a power
+ *        failure. The transaction is ended whatever the result.
+ *
+ * \details The data block holding the metadata and at most one other data
+ *          block are rewritten by the update. The files replaced or deleted and
+ *          the new files must fit in those blocks, so a transaction can be
+ *          refused with PSA_ERROR_NOT_SUPPORTED when the filesystem has more
+ *          than one dedicated data block.
+ *
+ * \param[in,out] txn  Transaction in progress
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_commit(struct its_flash_fs_txn_t *txn);
+
+/**
+ * \brief Ends a transaction without applying the staged operations.
+ *
+ * \param[in,out] txn  Transaction to end
+ */
+void its_flash_fs_txn_abort(struct its_flash_fs_txn_t *txn);
+#endif /* ITS_TRANSACTION */
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,6 +5,10 @@
  *
  */
 
+#include "config_tfm.h"
+
+#if !ITS_FLASH_FS_LOG
+
 #include "its_flash_fs_dblock.h"
 
 #include "its_flash_fs.h"
@@ -108,7 +112,7 @@ psa_status_t its_flash_fs_dblock_compact_block(
      * block update.
      */
     if ((lblock != ITS_LOGICAL_DBLOCK0) && (flush_data != 0)) {
-        err = fs_ctx->ops->flush(fs_ctx->cfg, scratch_id);
+        err = its_flash_fs_io_flush(fs_ctx, scratch_id);
     }
 
     return err;
@@ -131,7 +135,7 @@ psa_status_t its_flash_fs_dblock_read_file(
 
     pos = (file_meta->data_idx + offset);
 
-    return fs_ctx->ops->read(fs_ctx->cfg, phys_block, buf, pos, size);
+    return its_flash_fs_io_read(fs_ctx, phys_block, buf, pos, size);
 }
 
 psa_status_t its_flash_fs_dblock_write_file(
@@ -164,7 +168,7 @@ psa_status_t its_flash_fs_dblock_write_file(
     }
 
     /* Write the new file data */
-    err = fs_ctx->ops->write(fs_ctx->cfg, scratch_id, data, pos, size);
+    err = its_flash_fs_io_write(fs_ctx, scratch_id, data, pos, size);
     if (err != PSA_SUCCESS) {
         return err;
     }
@@ -187,8 +191,10 @@ psa_status_t its_flash_fs_dblock_write_file(
      * block update.
      */
     if (file_meta->lblock != ITS_LOGICAL_DBLOCK0) {
-        err = fs_ctx->ops->flush(fs_ctx->cfg, scratch_id);
+        err = its_flash_fs_io_flush(fs_ctx, scratch_id);
     }
 
     return err;
 }
+
+#endif /* !ITS_FLASH_FS_LOG */
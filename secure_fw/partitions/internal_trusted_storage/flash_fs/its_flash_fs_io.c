@@ -0,0 +1,343 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "its_flash_fs_io.h"
+
+#include <string.h>
+
+#include "config_tfm.h"
+#include "its_flash_fs.h"
+#include "its_utils.h"
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+#if (ITS_FLASH_FS_CACHE_LINE_SIZE == 0) || \
+    (ITS_FLASH_FS_CACHE_SIZE % ITS_FLASH_FS_CACHE_LINE_SIZE != 0)
+#error "Invalid config: ITS_FLASH_FS_CACHE_SIZE shall be a multiple of ITS_FLASH_FS_CACHE_LINE_SIZE!"
+#endif
+
+/* Number of lines of the cache */
+#define ITS_FLASH_FS_CACHE_NUM_LINES \
+    (ITS_FLASH_FS_CACHE_SIZE / ITS_FLASH_FS_CACHE_LINE_SIZE)
+
+/* Reads larger than this go to flash without being cached, so that reading a
+ * large file or moving a block does not evict the metadata from the cache.
+ */
+#define ITS_FLASH_FS_CACHE_MAX_READ \
+    ITS_UTILS_MAX(ITS_FLASH_FS_CACHE_SIZE / 4, ITS_FLASH_FS_CACHE_LINE_SIZE)
+
+/*!
+ * \struct its_flash_fs_cache_line_t
+ *
+ * \brief Structure containing a line of the flash cache.
+ */
+struct its_flash_fs_cache_line_t {
+    struct its_flash_fs_ctx_t *fs_ctx; /*!< Filesystem of the line, NULL if
+                                        *   the line is free
+                                        */
+    uint32_t block;     /*!< Physical block ID */
+    uint32_t offset;    /*!< Offset of the line in the block */
+    uint32_t size;      /*!< Size of the line, smaller than the line size at
+                         *   the end of the block
+                         */
+    uint32_t last_use;  /*!< Value of the cache clock when last read */
+    uint8_t data[ITS_FLASH_FS_CACHE_LINE_SIZE]; /*!< Flash content */
+};
+
+/* The cache is shared by all the filesystem contexts */
+static struct its_flash_fs_cache_line_t cache_lines[ITS_FLASH_FS_CACHE_NUM_LINES];
+static uint32_t cache_clock;
+#endif /* ITS_FLASH_FS_CACHE_SIZE != 0 */
+
+/**
+ * \brief Reads data from a block in flash.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ * \param[out]    buf     Buffer to store the data read
+ * \param[in]     offset  Offset in the block
+ * \param[in]     size    Number of bytes to read
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_io_read_flash(
+                                            struct its_flash_fs_ctx_t *fs_ctx,
+                                            uint32_t block, uint8_t *buf,
+                                            size_t offset, size_t size)
+{
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.read_bytes += size;
+#endif
+
+    return fs_ctx->ops->read(fs_ctx->cfg, block, buf, offset, size);
+}
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+/**
+ * \brief Drops the lines of a filesystem overlapping a range of a block, or
+ *        all the lines of the filesystem if block is ITS_BLOCK_INVALID_ID.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ * \param[in]     offset  Offset of the range in the block
+ * \param[in]     size    Size of the range
+ */
+static void its_flash_fs_cache_invalidate(struct its_flash_fs_ctx_t *fs_ctx,
+                                          uint32_t block, size_t offset,
+                                          size_t size)
+{
+    struct its_flash_fs_cache_line_t *line;
+    uint32_t i;
+
+    for (i = 0; i < ITS_FLASH_FS_CACHE_NUM_LINES; i++) {
+        line = &cache_lines[i];
+
+        if ((line->fs_ctx != fs_ctx) ||
+            ((block != ITS_BLOCK_INVALID_ID) &&
+             ((line->block != block) ||
+              (line->offset >= offset + size) ||
+              (line->offset + line->size <= offset)))) {
+            continue;
+        }
+
+        line->fs_ctx = NULL;
+        if (block != ITS_BLOCK_INVALID_ID) {
+            fs_ctx->cache_stats.invalidations++;
+        }
+    }
+}
+
+/**
+ * \brief Gets the line of a filesystem caching the given line of a block, and
+ *        reads it from flash if it is not in the cache.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ * \param[in]     offset  Offset of the line in the block, a multiple of the
+ *                        line size
+ * \param[out]    p_line  Set to the line
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_cache_get_line(
+                                    struct its_flash_fs_ctx_t *fs_ctx,
+                                    uint32_t block, uint32_t offset,
+                                    struct its_flash_fs_cache_line_t **p_line)
+{
+    struct its_flash_fs_cache_line_t *line;
+    struct its_flash_fs_cache_line_t *victim = &cache_lines[0];
+    psa_status_t err;
+    uint32_t i;
+
+    for (i = 0; i < ITS_FLASH_FS_CACHE_NUM_LINES; i++) {
+        line = &cache_lines[i];
+
+        if ((line->fs_ctx == fs_ctx) && (line->block == block) &&
+            (line->offset == offset)) {
+            fs_ctx->cache_stats.hits++;
+            line->last_use = ++cache_clock;
+            *p_line = line;
+            return PSA_SUCCESS;
+        }
+
+        /* Replace a free line, or else the least recently used one */
+        if ((victim->fs_ctx != NULL) &&
+            ((line->fs_ctx == NULL) ||
+             ((cache_clock - line->last_use) >
+              (cache_clock - victim->last_use)))) {
+            victim = line;
+        }
+    }
+
+    if (victim->fs_ctx != NULL) {
+        /* The evicted line may belong to another filesystem */
+        victim->fs_ctx->cache_stats.evictions++;
+        victim->fs_ctx = NULL;
+    }
+
+    victim->size = ITS_UTILS_MIN(ITS_FLASH_FS_CACHE_LINE_SIZE,
+                                 fs_ctx->cfg->block_size - offset);
+
+    err = its_flash_fs_io_read_flash(fs_ctx, block, victim->data, offset,
+                                     victim->size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    fs_ctx->cache_stats.misses++;
+    victim->fs_ctx = fs_ctx;
+    victim->block = block;
+    victim->offset = offset;
+    victim->last_use = ++cache_clock;
+    *p_line = victim;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Reads data from a block through the cache.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ * \param[out]    buf     Buffer to store the data read
+ * \param[in]     offset  Offset in the block
+ * \param[in]     size    Number of bytes to read
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_cache_read(struct its_flash_fs_ctx_t *fs_ctx,
+                                            uint32_t block, uint8_t *buf,
+                                            size_t offset, size_t size)
+{
+    struct its_flash_fs_cache_line_t *line;
+    size_t line_offset;
+    size_t len;
+    psa_status_t err;
+
+    while (size > 0) {
+        line_offset = offset - (offset % ITS_FLASH_FS_CACHE_LINE_SIZE);
+
+        err = its_flash_fs_cache_get_line(fs_ctx, block, line_offset, &line);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        len = ITS_UTILS_MIN(size, line->size - (offset - line_offset));
+        (void)memcpy(buf, line->data + (offset - line_offset), len);
+
+        buf += len;
+        offset += len;
+        size -= len;
+    }
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_FLASH_FS_CACHE_SIZE != 0 */
+
+void its_flash_fs_io_init(struct its_flash_fs_ctx_t *fs_ctx)
+{
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    /* The lines left by a previous use of the context may be stale */
+    its_flash_fs_cache_invalidate(fs_ctx, ITS_BLOCK_INVALID_ID, 0, 0);
+#else
+    (void)fs_ctx;
+#endif
+}
+
+psa_status_t its_flash_fs_io_read(struct its_flash_fs_ctx_t *fs_ctx,
+                                  uint32_t block, uint8_t *buf, size_t offset,
+                                  size_t size)
+{
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    if (size > ITS_FLASH_FS_CACHE_MAX_READ) {
+        fs_ctx->cache_stats.bypasses++;
+    } else {
+        return its_flash_fs_cache_read(fs_ctx, block, buf, offset, size);
+    }
+#endif
+
+    return its_flash_fs_io_read_flash(fs_ctx, block, buf, offset, size);
+}
+
+psa_status_t its_flash_fs_io_read_uncached(struct its_flash_fs_ctx_t *fs_ctx,
+                                           uint32_t block, uint8_t *buf,
+                                           size_t offset, size_t size)
+{
+    /* The cache only holds the flash content, so it can be bypassed */
+    return its_flash_fs_io_read_flash(fs_ctx, block, buf, offset, size);
+}
+
+psa_status_t its_flash_fs_io_write(struct its_flash_fs_ctx_t *fs_ctx,
+                                   uint32_t block, const uint8_t *buf,
+                                   size_t offset, size_t size)
+{
+    psa_status_t err;
+
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.prog_bytes += size;
+#endif
+
+    err = fs_ctx->ops->write(fs_ctx->cfg, block, buf, offset, size);
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    /* Whatever the result, as a failed write may have programmed a part of
+     * the range
+     */
+    its_flash_fs_cache_invalidate(fs_ctx, block, offset, size);
+#endif
+
+    return err;
+}
+
+psa_status_t its_flash_fs_io_flush(struct its_flash_fs_ctx_t *fs_ctx,
+                                   uint32_t block)
+{
+    psa_status_t err;
+
+    err = fs_ctx->ops->flush(fs_ctx->cfg, block);
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    /* A flash driver buffering the writes, such as the NAND one, may program
+     * the whole block when it is flushed.
+     */
+    its_flash_fs_cache_invalidate(fs_ctx, block, 0, fs_ctx->cfg->block_size);
+#endif
+
+    return err;
+}
+
+psa_status_t its_flash_fs_io_erase(struct its_flash_fs_ctx_t *fs_ctx,
+                                   uint32_t block)
+{
+    psa_status_t err;
+
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.erases++;
+    if (block < ITS_FLASH_FS_STATS_MAX_BLOCKS) {
+        fs_ctx->stats.block_erases[block]++;
+    }
+#endif
+
+    err = fs_ctx->ops->erase(fs_ctx->cfg, block);
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    its_flash_fs_cache_invalidate(fs_ctx, block, 0, fs_ctx->cfg->block_size);
+#endif
+
+    return err;
+}
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+uint32_t its_flash_fs_io_cache_lines(const struct its_flash_fs_ctx_t *fs_ctx)
+{
+    uint32_t num_lines = 0;
+    uint32_t i;
+
+    for (i = 0; i < ITS_FLASH_FS_CACHE_NUM_LINES; i++) {
+        if (cache_lines[i].fs_ctx == fs_ctx) {
+            num_lines++;
+        }
+    }
+
+    return num_lines;
+}
+#endif /* ITS_FLASH_FS_CACHE_SIZE != 0 */
+
+#if ITS_FLASH_FS_STATS
+const struct its_flash_fs_stats_t *its_flash_fs_get_stats(
+                                        const struct its_flash_fs_ctx_t *fs_ctx)
+{
+    return &fs_ctx->stats;
+}
+#endif /* ITS_FLASH_FS_STATS */
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+const struct its_flash_fs_cache_stats_t *its_flash_fs_get_cache_stats(
+                                        const struct its_flash_fs_ctx_t *fs_ctx)
+{
+    return &fs_ctx->cache_stats;
+}
+#endif /* ITS_FLASH_FS_CACHE_SIZE != 0 */
@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  its_flash_fs_io.h
+ *
+ * \brief Flash operations used by the filesystem implementations. They call
+ *        the flash operations of the filesystem context and, when
+ *        ITS_FLASH_FS_STATS is enabled, count the flash accesses in the
+ *        context.
+ *
+ *        When ITS_FLASH_FS_CACHE_SIZE is not 0, the reads go through a cache
+ *        of lines of flash shared by all the filesystem contexts. The cache
+ *        is write-through: it only ever holds what the flash operations
+ *        returned, and the lines are dropped when their flash content is
+ *        programmed, flushed or erased, so a power failure at any point
+ *        cannot leave data in the cache which is not in flash.
+ */
+
+#ifndef __ITS_FLASH_FS_IO_H__
+#define __ITS_FLASH_FS_IO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config_tfm.h"
+#include "psa/error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct its_flash_fs_ctx_t;
+
+#if ITS_FLASH_FS_STATS
+/*!
+ * \struct its_flash_fs_stats_t
+ *
+ * \brief Structure to count the flash accesses of a filesystem since it was
+ *        initialized.
+ */
+struct its_flash_fs_stats_t {
+    uint32_t read_bytes;      /*!< Bytes read from flash */
+    uint32_t prog_bytes;      /*!< Bytes programmed to flash */
+    uint32_t user_bytes;      /*!< Bytes of file data written by the callers */
+    uint32_t moved_bytes;     /*!< Bytes copied from one block to another */
+    uint32_t erases;          /*!< Blocks erased */
+    uint32_t metablock_swaps; /*!< Metadata block swaps */
+    uint32_t compactions;     /*!< Compactions of the oldest block of the log */
+    /** Erases of each of the first ITS_FLASH_FS_STATS_MAX_BLOCKS blocks */
+    uint32_t block_erases[ITS_FLASH_FS_STATS_MAX_BLOCKS];
+};
+#endif /* ITS_FLASH_FS_STATS */
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+/*!
+ * \struct its_flash_fs_cache_stats_t
+ *
+ * \brief Structure to count the accesses of a filesystem to the flash cache
+ *        since its context was initialized.
+ */
+struct its_flash_fs_cache_stats_t {
+    uint32_t hits;          /*!< Lines read from the cache */
+    uint32_t misses;        /*!< Lines read from flash into the cache */
+    uint32_t bypasses;      /*!< Reads too large to be cached */
+    uint32_t evictions;     /*!< Lines evicted to make room for others */
+    uint32_t invalidations; /*!< Lines dropped as their flash content was
+                             *   programmed or erased
+                             */
+};
+#endif /* ITS_FLASH_FS_CACHE_SIZE != 0 */
+
+/**
+ * \brief Initializes the flash operations of a filesystem context. Must be
+ *        called when the context is initialized, as the flash content may
+ *        have changed since the context was last used.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ */
+void its_flash_fs_io_init(struct its_flash_fs_ctx_t *fs_ctx);
+
+/**
+ * \brief Reads data from a block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ * \param[out]    buf     Buffer to store the data read
+ * \param[in]     offset  Offset in the block
+ * \param[in]     size    Number of bytes to read
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_io_read(struct its_flash_fs_ctx_t *fs_ctx,
+                                  uint32_t block, uint8_t *buf, size_t offset,
+                                  size_t size);
+
+/**
+ * \brief Reads data from a block without caching it, for data which is not
+ *        expected to be read again soon, such as the data moved from one
+ *        block to another.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ * \param[out]    buf     Buffer to store the data read
+ * \param[in]     offset  Offset in the block
+ * \param[in]     size    Number of bytes to read
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_io_read_uncached(struct its_flash_fs_ctx_t *fs_ctx,
+                                           uint32_t block, uint8_t *buf,
+                                           size_t offset, size_t size);
+
+/**
+ * \brief Programs data to a block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ * \param[in]     buf     Data to program
+ * \param[in]     offset  Offset in the block
+ * \param[in]     size    Number of bytes to program
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_io_write(struct its_flash_fs_ctx_t *fs_ctx,
+                                   uint32_t block, const uint8_t *buf,
+                                   size_t offset, size_t size);
+
+/**
+ * \brief Flushes the modifications of a block to flash.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_io_flush(struct its_flash_fs_ctx_t *fs_ctx,
+                                   uint32_t block);
+
+/**
+ * \brief Erases a block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_io_erase(struct its_flash_fs_ctx_t *fs_ctx,
+                                   uint32_t block);
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+/**
+ * \brief Gets the number of lines of the flash cache holding data of a
+ *        filesystem.
+ *
+ * \param[in] fs_ctx  Filesystem context
+ *
+ * \return Returns the number of lines
+ */
+uint32_t its_flash_fs_io_cache_lines(const struct its_flash_fs_ctx_t *fs_ctx);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ITS_FLASH_FS_IO_H__ */
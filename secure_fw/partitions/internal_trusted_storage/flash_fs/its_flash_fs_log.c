@@ -0,0 +1,1637 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "config_tfm.h"
+
+#if ITS_FLASH_FS_LOG
+
+#include "its_flash_fs.h"
+#include "its_utils.h"
+
+#ifndef ITS_MAX_BLOCK_DATA_COPY
+#define ITS_MAX_BLOCK_DATA_COPY 256
+#endif
+
+/* Filesystem-internal flags, which cannot be passed by the caller */
+#define ITS_FLASH_FS_INTERNAL_FLAGS_MASK  (UINT32_MAX - ((1U << 24) - 1))
+
+/* Values identifying the structures of the log in flash */
+#define ITS_FLASH_FS_LOG_BLOCK_MAGIC  0x474F4C49U /* "ILOG" */
+#define ITS_FLASH_FS_LOG_REC_FILE     0x454C4946U /* "FILE" */
+#define ITS_FLASH_FS_LOG_REC_DELTA    0x41544C44U /* "DLTA" */
+#define ITS_FLASH_FS_LOG_REC_DELETE   0x454C4544U /* "DELE" */
+#define ITS_FLASH_FS_LOG_COMMIT       0x54494D43U /* "CMIT" */
+
+/* Structures programmed to flash, padded to the largest program unit */
+union its_flash_fs_log_block_hdr_buf_t {
+    struct its_flash_fs_log_block_hdr_t hdr;
+    uint8_t buf[ITS_UTILS_ALIGN(sizeof(struct its_flash_fs_log_block_hdr_t),
+                                ITS_FLASH_MAX_ALIGNMENT)];
+};
+
+union its_flash_fs_log_rec_hdr_buf_t {
+    struct its_flash_fs_log_rec_hdr_t hdr;
+    uint8_t buf[ITS_UTILS_ALIGN(sizeof(struct its_flash_fs_log_rec_hdr_t),
+                                ITS_FLASH_MAX_ALIGNMENT)];
+};
+
+union its_flash_fs_log_commit_buf_t {
+    uint32_t commit;
+    uint8_t buf[ITS_UTILS_ALIGN(sizeof(uint32_t), ITS_FLASH_MAX_ALIGNMENT)];
+};
+
+static size_t its_flash_fs_log_block_hdr_len(
+                                        const struct its_flash_fs_config_t *cfg)
+{
+    return ITS_UTILS_ALIGN(sizeof(struct its_flash_fs_log_block_hdr_t),
+                           cfg->program_unit);
+}
+
+static size_t its_flash_fs_log_rec_hdr_len(
+                                        const struct its_flash_fs_config_t *cfg)
+{
+    return ITS_UTILS_ALIGN(sizeof(struct its_flash_fs_log_rec_hdr_t),
+                           cfg->program_unit);
+}
+
+static size_t its_flash_fs_log_commit_len(
+                                        const struct its_flash_fs_config_t *cfg)
+{
+    return ITS_UTILS_ALIGN(sizeof(uint32_t), cfg->program_unit);
+}
+
+/**
+ * \brief Gets the size in flash of a record holding the given data size.
+ *
+ * \param[in] cfg   Filesystem config
+ * \param[in] size  Size of the file data in the record
+ *
+ * \return Returns the size of the record in bytes
+ */
+static size_t its_flash_fs_log_rec_len(const struct its_flash_fs_config_t *cfg,
+                                       size_t size)
+{
+    return its_flash_fs_log_rec_hdr_len(cfg)
+           + ITS_UTILS_ALIGN(size, cfg->program_unit)
+           + its_flash_fs_log_commit_len(cfg);
+}
+
+/**
+ * \brief Gets the space in the log which can be reserved by the files.
+ *
+ * \details Compacting the oldest block moves its live records to the head,
+ *          using at most one free block. Records do not span blocks, so each
+ *          block wastes less than a maximum size record at its end. Keeping
+ *          the reserved space below that of num_blocks - 2 blocks filled with
+ *          the worst case waste guarantees that compacting all blocks always
+ *          frees a block. The space of one more maximum size record is kept for
+ *          the new record of a file, written while the old one is still live.
+ *
+ * \param[in] cfg  Filesystem config
+ *
+ * \return Returns the capacity in bytes, 0 if the configuration leaves none
+ */
+static size_t its_flash_fs_log_capacity(const struct its_flash_fs_config_t *cfg)
+{
+    size_t usable = cfg->block_size - its_flash_fs_log_block_hdr_len(cfg);
+    size_t max_rec = its_flash_fs_log_rec_len(cfg, cfg->max_file_size);
+    size_t capacity;
+
+    if ((cfg->num_blocks < 3) || (usable <= max_rec)) {
+        return 0;
+    }
+
+    capacity = (cfg->num_blocks - 2) * (usable - max_rec);
+
+    return (capacity > max_rec) ? (capacity - max_rec) : 0;
+}
+
+/* FNV-1a hash, used to detect records which were not fully programmed */
+static uint32_t its_flash_fs_log_checksum(const uint8_t *data, size_t size)
+{
+    uint32_t hash = 0x811C9DC5U;
+
+    while (size--) {
+        hash ^= *data++;
+        hash *= 0x01000193U;
+    }
+
+    return hash;
+}
+
+static uint32_t its_flash_fs_log_next(const struct its_flash_fs_ctx_t *fs_ctx,
+                                      uint32_t block)
+{
+    return (block + 1) % fs_ctx->cfg->num_blocks;
+}
+
+#if ITS_FILE_INDEX
+/* End of a hash bucket of the file index */
+#define ITS_FLASH_FS_LOG_INDEX_END  UINT16_MAX
+
+static uint32_t its_flash_fs_log_bucket(const struct its_flash_fs_ctx_t *fs_ctx,
+                                        const uint8_t *fid)
+{
+    return its_flash_fs_log_checksum(fid, ITS_FILE_ID_SIZE)
+           % fs_ctx->cfg->max_num_files;
+}
+
+static void its_flash_fs_log_index_link(struct its_flash_fs_ctx_t *fs_ctx,
+                                        uint32_t idx)
+{
+    uint32_t bucket = its_flash_fs_log_bucket(fs_ctx, fs_ctx->files[idx].id);
+
+    fs_ctx->index_next[idx] = fs_ctx->index_head[bucket];
+    fs_ctx->index_head[bucket] = (uint16_t)idx;
+}
+
+static void its_flash_fs_log_index_unlink(struct its_flash_fs_ctx_t *fs_ctx,
+                                          uint32_t idx)
+{
+    uint16_t *link = &fs_ctx->index_head[its_flash_fs_log_bucket(fs_ctx,
+                                                     fs_ctx->files[idx].id)];
+
+    while (*link != idx) {
+        link = &fs_ctx->index_next[*link];
+    }
+
+    *link = fs_ctx->index_next[idx];
+}
+#endif /* ITS_FILE_INDEX */
+
+/* Empties the file table */
+static void its_flash_fs_log_clear_files(struct its_flash_fs_ctx_t *fs_ctx)
+{
+#if ITS_FILE_INDEX
+    uint32_t i;
+
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        fs_ctx->index_head[i] = ITS_FLASH_FS_LOG_INDEX_END;
+    }
+#endif
+
+    fs_ctx->num_files = 0;
+}
+
+static struct its_flash_fs_log_file_t *its_flash_fs_log_find(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              const uint8_t *fid)
+{
+    uint32_t i;
+
+#if ITS_FILE_INDEX
+    /* Only the files of the same hash bucket are compared */
+    for (i = fs_ctx->index_head[its_flash_fs_log_bucket(fs_ctx, fid)];
+         i != ITS_FLASH_FS_LOG_INDEX_END; i = fs_ctx->index_next[i]) {
+#else
+    for (i = 0; i < fs_ctx->num_files; i++) {
+#endif
+        if (memcmp(fs_ctx->files[i].id, fid, ITS_FILE_ID_SIZE) == 0) {
+            return &fs_ctx->files[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Adds a file to the table, which must not be full */
+static struct its_flash_fs_log_file_t *its_flash_fs_log_add(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              const uint8_t *fid)
+{
+    struct its_flash_fs_log_file_t *file = &fs_ctx->files[fs_ctx->num_files];
+
+    memcpy(file->id, fid, ITS_FILE_ID_SIZE);
+    file->num_deltas = 0;
+#if ITS_FILE_INDEX
+    its_flash_fs_log_index_link(fs_ctx, fs_ctx->num_files);
+#endif
+    fs_ctx->num_files++;
+
+    return file;
+}
+
+static void its_flash_fs_log_remove(struct its_flash_fs_ctx_t *fs_ctx,
+                                    struct its_flash_fs_log_file_t *file)
+{
+    uint32_t idx = (uint32_t)(file - fs_ctx->files);
+
+    fs_ctx->num_files--;
+
+#if ITS_FILE_INDEX
+    its_flash_fs_log_index_unlink(fs_ctx, idx);
+#endif
+
+    if (idx != fs_ctx->num_files) {
+        /* The last file takes the place of the removed one */
+#if ITS_FILE_INDEX
+        its_flash_fs_log_index_unlink(fs_ctx, fs_ctx->num_files);
+#endif
+        *file = fs_ctx->files[fs_ctx->num_files];
+#if ITS_FILE_INDEX
+        its_flash_fs_log_index_link(fs_ctx, idx);
+#endif
+    }
+}
+
+/* Gets the space in the log of the delta records of a file */
+static size_t its_flash_fs_log_delta_space(
+                                    const struct its_flash_fs_config_t *cfg,
+                                    const struct its_flash_fs_log_file_t *file)
+{
+    size_t space = 0;
+    uint32_t i;
+
+    for (i = 0; i < file->num_deltas; i++) {
+        space += its_flash_fs_log_rec_len(cfg, file->deltas[i].data_size);
+    }
+
+    return space;
+}
+
+/* Gets the space reserved in the log by a file */
+static size_t its_flash_fs_log_file_space(
+                                    const struct its_flash_fs_config_t *cfg,
+                                    const struct its_flash_fs_log_file_t *file)
+{
+    return its_flash_fs_log_rec_len(cfg, file->max_size)
+           + its_flash_fs_log_delta_space(cfg, file);
+}
+
+static psa_status_t its_flash_fs_log_load(struct its_flash_fs_ctx_t *fs_ctx);
+static psa_status_t its_flash_fs_log_merge(struct its_flash_fs_ctx_t *fs_ctx,
+                                           struct its_flash_fs_log_file_t *file);
+
+static psa_status_t its_flash_fs_log_move(struct its_flash_fs_ctx_t *fs_ctx,
+                                          uint32_t dst_block,
+                                          size_t dst_offset,
+                                          uint32_t src_block,
+                                          size_t src_offset,
+                                          size_t size)
+{
+    psa_status_t err;
+    size_t bytes_to_move;
+    uint8_t data_copy[ITS_MAX_BLOCK_DATA_COPY];
+
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.moved_bytes += size;
+#endif
+
+    while (size > 0) {
+        bytes_to_move = ITS_UTILS_MIN(size, ITS_MAX_BLOCK_DATA_COPY);
+
+        err = its_flash_fs_io_read_uncached(fs_ctx, src_block, data_copy,
+                                            src_offset, bytes_to_move);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        err = its_flash_fs_io_write(fs_ctx, dst_block, data_copy, dst_offset,
+                                    bytes_to_move);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        dst_offset += bytes_to_move;
+        src_offset += bytes_to_move;
+        size -= bytes_to_move;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Reads data of a file from its file record, overlaid with the data of
+ *        its delta records in the order they were written. The bytes after the
+ *        current size of the file are set to the erase value.
+ *
+ * \param[in]  fs_ctx    Filesystem context
+ * \param[in]  file      File to read
+ * \param[in]  offset    Offset of the data in the file
+ * \param[in]  size      Size of the data
+ * \param[in]  uncached  Whether to read around the flash cache
+ * \param[out] data      Buffer to read the data to
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_read_data(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      const struct its_flash_fs_log_file_t *file,
+                                      size_t offset,
+                                      size_t size,
+                                      bool uncached,
+                                      uint8_t *data)
+{
+    psa_status_t (*read)(struct its_flash_fs_ctx_t *, uint32_t, uint8_t *,
+                         size_t, size_t) =
+        uncached ? its_flash_fs_io_read_uncached : its_flash_fs_io_read;
+    size_t hdr_len = its_flash_fs_log_rec_hdr_len(fs_ctx->cfg);
+    const struct its_flash_fs_log_delta_t *delta;
+    size_t start;
+    size_t end;
+    psa_status_t err;
+    uint32_t i;
+
+    end = ITS_UTILS_MIN(offset + size, file->base_size);
+    if (offset < end) {
+        err = read(fs_ctx, file->block, data, file->offset + hdr_len + offset,
+                   end - offset);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    } else {
+        end = offset;
+    }
+
+    /* The file has no gaps, so the bytes after its file record up to its
+     * current size are all held by its delta records.
+     */
+    memset(data + (end - offset), fs_ctx->cfg->erase_val, offset + size - end);
+
+    for (i = 0; i < file->num_deltas; i++) {
+        delta = &file->deltas[i];
+        start = ITS_UTILS_MAX(offset, delta->data_off);
+        end = ITS_UTILS_MIN(offset + size, delta->data_off + delta->data_size);
+        if (start >= end) {
+            continue;
+        }
+
+        err = read(fs_ctx, file->block, data + (start - offset),
+                   delta->offset + hdr_len + (start - delta->data_off),
+                   end - start);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Copies data of a file, with its delta records applied, to the head
+ *        of the log.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     file        File to copy from
+ * \param[in]     dst_offset  Offset in the head block to copy to
+ * \param[in]     offset      Offset of the data in the file
+ * \param[in]     size        Size of the data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_copy_data(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      const struct its_flash_fs_log_file_t *file,
+                                      size_t dst_offset,
+                                      size_t offset,
+                                      size_t size)
+{
+    psa_status_t err;
+    size_t bytes_to_copy;
+    uint8_t data_copy[ITS_MAX_BLOCK_DATA_COPY];
+
+    if (file->num_deltas == 0) {
+        return its_flash_fs_log_move(fs_ctx, fs_ctx->head, dst_offset,
+                                     file->block,
+                                     file->offset
+                                     + its_flash_fs_log_rec_hdr_len(fs_ctx->cfg)
+                                     + offset,
+                                     size);
+    }
+
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.moved_bytes += size;
+#endif
+
+    while (size > 0) {
+        bytes_to_copy = ITS_UTILS_MIN(size, ITS_MAX_BLOCK_DATA_COPY);
+
+        err = its_flash_fs_log_read_data(fs_ctx, file, offset, bytes_to_copy,
+                                         true, data_copy);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        err = its_flash_fs_io_write(fs_ctx, fs_ctx->head, data_copy,
+                                    dst_offset, bytes_to_copy);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        dst_offset += bytes_to_copy;
+        offset += bytes_to_copy;
+        size -= bytes_to_copy;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Reads the sequence number of a block of the log.
+ *
+ * \param[in]  fs_ctx  Filesystem context
+ * \param[in]  block   Physical block ID
+ * \param[out] seq     Sequence number of the block
+ *
+ * \return Returns PSA_SUCCESS if the block has a valid header,
+ *         PSA_ERROR_DOES_NOT_EXIST if not, or another error code as specified
+ *         in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_read_block_seq(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t block,
+                                              uint32_t *seq)
+{
+    union its_flash_fs_log_block_hdr_buf_t hdr_buf;
+    psa_status_t err;
+
+    err = its_flash_fs_io_read(fs_ctx, block, hdr_buf.buf, 0,
+                               sizeof(hdr_buf.hdr));
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* The blocks of the previous versions are read as they are, and replaced
+     * by blocks of the current version as the log is compacted.
+     */
+    if ((hdr_buf.hdr.magic != ITS_FLASH_FS_LOG_BLOCK_MAGIC) ||
+        (hdr_buf.hdr.seq_inv != ~hdr_buf.hdr.seq) ||
+        (hdr_buf.hdr.fs_version < ITS_FLASH_FS_LOG_OLDEST_VERSION) ||
+        (hdr_buf.hdr.fs_version > ITS_FLASH_FS_LOG_VERSION)) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    *seq = hdr_buf.hdr.seq;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Erases a block and makes it the head of the log.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ * \param[in]     seq     Sequence number of the block
+ * \param[in]     erased  Whether the block is known to be erased already
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_open_block(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t block,
+                                              uint32_t seq,
+                                              bool erased)
+{
+    union its_flash_fs_log_block_hdr_buf_t hdr_buf = {0};
+    size_t hdr_len = its_flash_fs_log_block_hdr_len(fs_ctx->cfg);
+    psa_status_t err;
+
+    if (!erased) {
+        err = its_flash_fs_io_erase(fs_ctx, block);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    hdr_buf.hdr.magic = ITS_FLASH_FS_LOG_BLOCK_MAGIC;
+    hdr_buf.hdr.seq = seq;
+    hdr_buf.hdr.seq_inv = ~seq;
+    hdr_buf.hdr.fs_version = ITS_FLASH_FS_LOG_VERSION;
+
+    err = its_flash_fs_io_write(fs_ctx, block, hdr_buf.buf, 0, hdr_len);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = its_flash_fs_io_flush(fs_ctx, block);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    fs_ctx->head = block;
+    fs_ctx->head_seq = seq;
+    fs_ctx->head_off = hdr_len;
+    fs_ctx->next_erased = false;
+
+    return PSA_SUCCESS;
+}
+
+static psa_status_t its_flash_fs_log_open_next(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    psa_status_t err;
+
+    err = its_flash_fs_log_open_block(fs_ctx,
+                                      its_flash_fs_log_next(fs_ctx,
+                                                            fs_ctx->head),
+                                      fs_ctx->head_seq + 1,
+                                      fs_ctx->next_erased);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    fs_ctx->num_used++;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Compacts the oldest block of the log, by copying its live records to
+ *        the head in the order they are stored and erasing it. The delta
+ *        records of a file are merged with its file record instead, so the
+ *        copies never take more space than the live records.
+ *
+ * \note A power failure before the erase leaves records in the oldest block
+ *       which are shadowed by their copies, and no free block. The compaction
+ *       is resumed when the log is loaded.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_compact_tail(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    struct its_flash_fs_log_file_t *file;
+    psa_status_t err;
+    size_t len;
+    uint32_t i;
+
+    for (;;) {
+        /* Find the first live record left in the block */
+        file = NULL;
+        for (i = 0; i < fs_ctx->num_files; i++) {
+            if ((fs_ctx->files[i].block == fs_ctx->tail) &&
+                ((file == NULL) || (fs_ctx->files[i].offset < file->offset))) {
+                file = &fs_ctx->files[i];
+            }
+        }
+
+        if (file == NULL) {
+            break;
+        }
+
+        len = its_flash_fs_log_rec_len(cfg, file->cur_size);
+        if (fs_ctx->head_off + len > cfg->block_size) {
+            if (fs_ctx->num_used == cfg->num_blocks) {
+                /* A previous compaction of the block failed, after using the
+                 * last free block for part of the copies. Nothing else is
+                 * written to the head until the compaction completes, and the
+                 * oldest block has not started to be erased, so the head is
+                 * discarded to restart with a free block.
+                 */
+                err = its_flash_fs_io_erase(fs_ctx, fs_ctx->head);
+                if (err != PSA_SUCCESS) {
+                    return err;
+                }
+
+                return its_flash_fs_log_load(fs_ctx);
+            }
+
+            err = its_flash_fs_log_open_next(fs_ctx);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+        }
+
+        if (file->num_deltas != 0) {
+            err = its_flash_fs_log_merge(fs_ctx, file);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+            continue;
+        }
+
+        /* Records do not hold their location, so they are copied as is */
+        err = its_flash_fs_log_move(fs_ctx, fs_ctx->head, fs_ctx->head_off,
+                                    file->block, file->offset, len);
+        if (err == PSA_SUCCESS) {
+            err = its_flash_fs_io_flush(fs_ctx, fs_ctx->head);
+        }
+        if (err != PSA_SUCCESS) {
+            /* The rest of the head block may be partially programmed */
+            fs_ctx->head_off = cfg->block_size;
+            return err;
+        }
+
+        file->block = fs_ctx->head;
+        file->offset = fs_ctx->head_off;
+        fs_ctx->head_off += len;
+    }
+
+    err = its_flash_fs_io_erase(fs_ctx, fs_ctx->tail);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (its_flash_fs_log_next(fs_ctx, fs_ctx->head) == fs_ctx->tail) {
+        /* The block was the only free one left, it is opened next */
+        fs_ctx->next_erased = true;
+    }
+
+    fs_ctx->tail = its_flash_fs_log_next(fs_ctx, fs_ctx->tail);
+    fs_ctx->num_used--;
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.compactions++;
+#endif
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Makes space for a record of the given size in the head block, by
+ *        opening a free block or compacting the oldest blocks. One free block
+ *        is always kept for the compaction.
+ *
+ * \note The file table is reloaded if an interrupted compaction is restarted,
+ *       so pointers to its entries are not valid after this call.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     len     Size of the record
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_reserve(struct its_flash_fs_ctx_t *fs_ctx,
+                                             size_t len)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    uint32_t compactions = 0;
+    psa_status_t err;
+
+    while (fs_ctx->head_off + len > cfg->block_size) {
+        if (cfg->num_blocks - fs_ctx->num_used >= 2) {
+            err = its_flash_fs_log_open_next(fs_ctx);
+        } else if ((fs_ctx->tail != fs_ctx->head) &&
+                   (compactions < cfg->num_blocks)) {
+            err = its_flash_fs_log_compact_tail(fs_ctx);
+            compactions++;
+        } else {
+            err = PSA_ERROR_INSUFFICIENT_STORAGE;
+        }
+
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Writes a record header at the head of the log.
+ *
+ * \param[in,out] fs_ctx   Filesystem context
+ * \param[in]     hdr_buf  Record header, whose checksum is set by this
+ *                         function
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_write_rec_hdr(
+                                       struct its_flash_fs_ctx_t *fs_ctx,
+                                       union its_flash_fs_log_rec_hdr_buf_t *hdr_buf)
+{
+    hdr_buf->hdr.check = its_flash_fs_log_checksum(hdr_buf->buf,
+                                offsetof(struct its_flash_fs_log_rec_hdr_t,
+                                         check));
+
+    return its_flash_fs_io_write(fs_ctx, fs_ctx->head, hdr_buf->buf,
+                                 fs_ctx->head_off,
+                                 its_flash_fs_log_rec_hdr_len(fs_ctx->cfg));
+}
+
+/**
+ * \brief Writes the data of a file record started at the head of the log. The
+ *        new data is written at the given offset, and the rest of the data is
+ *        copied from the previous records of the file.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     old        Previous records of the file, NULL if none
+ * \param[in]     old_size   Size of the data to keep from the previous records
+ * \param[in]     offset     Offset of the new data in the file
+ * \param[in]     data_size  Size of the new data
+ * \param[in]     data       New data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_write_data(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      const struct its_flash_fs_log_file_t *old,
+                                      size_t old_size,
+                                      size_t offset,
+                                      size_t data_size,
+                                      const uint8_t *data)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    size_t hdr_len = its_flash_fs_log_rec_hdr_len(cfg);
+    size_t data_start = fs_ctx->head_off + hdr_len;
+    size_t end = offset + ITS_UTILS_ALIGN(data_size, cfg->program_unit);
+    psa_status_t err;
+
+    /* Copy the existing data before the new data */
+    if (offset > 0) {
+        err = its_flash_fs_log_copy_data(fs_ctx, old, data_start, 0, offset);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    /* Write the new data */
+    if (data_size != 0) {
+        err = its_flash_fs_io_write(fs_ctx, fs_ctx->head, data,
+                                    data_start + offset, end - offset);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    /* Copy the existing data after the new data */
+    old_size = ITS_UTILS_ALIGN(old_size, cfg->program_unit);
+    if (end < old_size) {
+        err = its_flash_fs_log_copy_data(fs_ctx, old, data_start + end, end,
+                                         old_size - end);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Commits the record started at the head of the log, by programming its
+ *        commit word, and moves the head after it.
+ *
+ * \param[in,out] fs_ctx    Filesystem context
+ * \param[in]     hdr       Header of the record
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_commit_rec(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      const struct its_flash_fs_log_rec_hdr_t *hdr)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    union its_flash_fs_log_commit_buf_t commit_buf = {0};
+    size_t len = its_flash_fs_log_rec_len(cfg, hdr->cur_size);
+    psa_status_t err;
+
+    /* The commit word is bound to the header, so that stale data cannot be
+     * mistaken for it.
+     */
+    commit_buf.commit = ITS_FLASH_FS_LOG_COMMIT ^ hdr->check;
+
+    err = its_flash_fs_io_write(fs_ctx, fs_ctx->head, commit_buf.buf,
+                                fs_ctx->head_off + len
+                                - its_flash_fs_log_commit_len(cfg),
+                                its_flash_fs_log_commit_len(cfg));
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = its_flash_fs_io_flush(fs_ctx, fs_ctx->head);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    fs_ctx->head_off += len;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Writes at the head of the log a file record holding the data of a
+ *        file merged with its delta records, which it replaces. The head block
+ *        must have space for it.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in,out] file    File whose records are merged
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_merge(struct its_flash_fs_ctx_t *fs_ctx,
+                                           struct its_flash_fs_log_file_t *file)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    union its_flash_fs_log_rec_hdr_buf_t hdr_buf = {0};
+    size_t len = its_flash_fs_log_rec_len(cfg, file->cur_size);
+    size_t delta_space = its_flash_fs_log_delta_space(cfg, file);
+    psa_status_t err;
+
+    /* The nonce and tag of the file are the ones of its last record */
+    err = its_flash_fs_io_read(fs_ctx, file->block, hdr_buf.buf,
+                               file->deltas[file->num_deltas - 1].offset,
+                               sizeof(hdr_buf.hdr));
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    hdr_buf.hdr.type = ITS_FLASH_FS_LOG_REC_FILE;
+    hdr_buf.hdr.flags = file->flags;
+    hdr_buf.hdr.cur_size = file->cur_size;
+    hdr_buf.hdr.max_size = file->max_size;
+
+    err = its_flash_fs_log_write_rec_hdr(fs_ctx, &hdr_buf);
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_log_copy_data(fs_ctx, file,
+                                         fs_ctx->head_off
+                                         + its_flash_fs_log_rec_hdr_len(cfg),
+                                         0,
+                                         ITS_UTILS_ALIGN(file->cur_size,
+                                                         cfg->program_unit));
+    }
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_log_commit_rec(fs_ctx, &hdr_buf.hdr);
+    }
+    if (err != PSA_SUCCESS) {
+        /* The rest of the head block may be partially programmed */
+        fs_ctx->head_off = cfg->block_size;
+        return err;
+    }
+
+    file->block = fs_ctx->head;
+    file->offset = fs_ctx->head_off - len;
+    file->base_size = file->cur_size;
+    file->num_deltas = 0;
+    fs_ctx->live_size -= delta_space;
+
+    return PSA_SUCCESS;
+}
+
+static bool its_flash_fs_log_is_erased(const struct its_flash_fs_config_t *cfg,
+                                       const uint8_t *buf, size_t size)
+{
+    while (size--) {
+        if (*buf++ != cfg->erase_val) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Applies a committed record found in the log to the file table.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     hdr     Header of the record
+ * \param[in]     block   Physical block of the record
+ * \param[in]     offset  Offset of the record in the block
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_apply_rec(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      const struct its_flash_fs_log_rec_hdr_t *hdr,
+                                      uint32_t block,
+                                      uint32_t offset)
+{
+    struct its_flash_fs_log_file_t *file = its_flash_fs_log_find(fs_ctx,
+                                                                 hdr->id);
+
+    if (hdr->type == ITS_FLASH_FS_LOG_REC_DELETE) {
+        if (file != NULL) {
+            its_flash_fs_log_remove(fs_ctx, file);
+        }
+        return PSA_SUCCESS;
+    }
+
+    if (hdr->type == ITS_FLASH_FS_LOG_REC_DELTA) {
+        /* A delta record is only written after the file record of its file,
+         * in the same block, and within the file.
+         */
+        if ((file == NULL) || (file->block != block) ||
+            (file->num_deltas == ITS_FLASH_FS_LOG_MAX_DELTAS) ||
+            (hdr->max_size > file->cur_size) ||
+            (hdr->max_size + hdr->cur_size > file->max_size)) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        file->deltas[file->num_deltas].offset = offset;
+        file->deltas[file->num_deltas].data_off = hdr->max_size;
+        file->deltas[file->num_deltas].data_size = hdr->cur_size;
+        file->num_deltas++;
+        file->cur_size = ITS_UTILS_MAX(file->cur_size,
+                                       hdr->max_size + hdr->cur_size);
+        return PSA_SUCCESS;
+    }
+
+    if (file == NULL) {
+        if (fs_ctx->num_files == fs_ctx->cfg->max_num_files) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        file = its_flash_fs_log_add(fs_ctx, hdr->id);
+    }
+
+    file->block = block;
+    file->offset = offset;
+    file->base_size = hdr->cur_size;
+    file->cur_size = hdr->cur_size;
+    file->max_size = hdr->max_size;
+    file->flags = hdr->flags;
+    file->num_deltas = 0;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Checks the fields of a record header read from the log.
+ *
+ * \param[in] cfg  Filesystem config
+ * \param[in] hdr  Header of the record
+ *
+ * \return Returns true if the header is valid
+ */
+static bool its_flash_fs_log_rec_hdr_is_valid(
+                                   const struct its_flash_fs_config_t *cfg,
+                                   const struct its_flash_fs_log_rec_hdr_t *hdr)
+{
+    switch (hdr->type) {
+    case ITS_FLASH_FS_LOG_REC_FILE:
+    case ITS_FLASH_FS_LOG_REC_DELETE:
+        return (hdr->cur_size <= hdr->max_size) &&
+               (hdr->max_size <= cfg->max_file_size);
+    case ITS_FLASH_FS_LOG_REC_DELTA:
+        /* The offset of the data in the file is held in max_size */
+        return (hdr->cur_size <= cfg->max_file_size) &&
+               (hdr->max_size <= cfg->max_file_size - hdr->cur_size);
+    default:
+        return false;
+    }
+}
+
+/**
+ * \brief Applies the records of a block of the log to the file table.
+ *
+ * \details The records are read until the first erased header. A record with
+ *          a corrupted header or without a valid commit word was interrupted
+ *          by a power failure. It is not applied and it closes the block, as
+ *          the rest of the block may have been partially programmed.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     block   Physical block ID
+ * \param[out]    end     Offset where the next record can be written
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_replay_block(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t block,
+                                              uint32_t *end)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    union its_flash_fs_log_rec_hdr_buf_t hdr_buf;
+    union its_flash_fs_log_commit_buf_t commit_buf;
+    size_t hdr_len = its_flash_fs_log_rec_hdr_len(cfg);
+    size_t commit_len = its_flash_fs_log_commit_len(cfg);
+    size_t offset = its_flash_fs_log_block_hdr_len(cfg);
+    size_t len;
+    psa_status_t err;
+
+    while (offset + hdr_len + commit_len <= cfg->block_size) {
+        err = its_flash_fs_io_read(fs_ctx, block, hdr_buf.buf, offset, hdr_len);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if (its_flash_fs_log_is_erased(cfg, hdr_buf.buf, hdr_len)) {
+            break;
+        }
+
+        len = its_flash_fs_log_rec_len(cfg, hdr_buf.hdr.cur_size);
+        if ((hdr_buf.hdr.check != its_flash_fs_log_checksum(hdr_buf.buf,
+                                  offsetof(struct its_flash_fs_log_rec_hdr_t,
+                                           check))) ||
+            !its_flash_fs_log_rec_hdr_is_valid(cfg, &hdr_buf.hdr) ||
+            (offset + len > cfg->block_size)) {
+            offset = cfg->block_size;
+            break;
+        }
+
+        err = its_flash_fs_io_read(fs_ctx, block, commit_buf.buf,
+                                   offset + len - commit_len, sizeof(uint32_t));
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if (commit_buf.commit != (ITS_FLASH_FS_LOG_COMMIT ^ hdr_buf.hdr.check)) {
+            offset = cfg->block_size;
+            break;
+        }
+
+        err = its_flash_fs_log_apply_rec(fs_ctx, &hdr_buf.hdr, block, offset);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        offset += len;
+    }
+
+    *end = offset;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Validates the configuration of the flash filesystem.
+ *
+ * \param[in] cfg  Filesystem config
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_validate_config(
+                                        const struct its_flash_fs_config_t *cfg)
+{
+    /* At least one file of the maximum size must fit in the log, with the
+     * blocks kept free for the compaction.
+     */
+    if (its_flash_fs_log_capacity(cfg) <
+        its_flash_fs_log_rec_len(cfg, cfg->max_file_size)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* The file table is dimensioned statically */
+    if ((cfg->max_num_files == 0) ||
+        (cfg->max_num_files > ITS_FLASH_FS_MAX_NUM_FILES)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_init_ctx(struct its_flash_fs_ctx_t *fs_ctx,
+                                   const struct its_flash_fs_config_t *fs_cfg,
+                                   const struct its_flash_fs_ops_t *fs_ops)
+{
+    psa_status_t err;
+
+    if (!fs_ctx || !fs_cfg || !fs_ops) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Check for valid filesystem configuration */
+    err = its_flash_fs_log_validate_config(fs_cfg);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Zero the context */
+    memset(fs_ctx, 0, sizeof(*fs_ctx));
+
+    /* Associate the filesystem config and operations with the context */
+    fs_ctx->cfg = fs_cfg;
+    fs_ctx->ops = fs_ops;
+
+    its_flash_fs_io_init(fs_ctx);
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Finds the blocks of the log and rebuilds the file table from them.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_load(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    uint32_t block;
+    uint32_t prev;
+    uint32_t seq;
+    uint32_t tail_seq;
+    uint32_t end = 0;
+    uint32_t i;
+    bool found = false;
+    psa_status_t err;
+
+    /* The free blocks may have been left partially programmed or erased */
+    fs_ctx->next_erased = false;
+
+    /* The head is the block opened last */
+    for (block = 0; block < cfg->num_blocks; block++) {
+        err = its_flash_fs_log_read_block_seq(fs_ctx, block, &seq);
+        if (err == PSA_SUCCESS) {
+            if (!found || (seq > fs_ctx->head_seq)) {
+                fs_ctx->head = block;
+                fs_ctx->head_seq = seq;
+                found = true;
+            }
+        } else if (err != PSA_ERROR_DOES_NOT_EXIST) {
+            return err;
+        }
+    }
+
+    if (!found) {
+        /* No valid log in the flash area */
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    /* The blocks are opened in a ring, so the log extends backwards from the
+     * head for as long as the sequence numbers are consecutive.
+     */
+    fs_ctx->tail = fs_ctx->head;
+    fs_ctx->num_used = 1;
+    tail_seq = fs_ctx->head_seq;
+    while (fs_ctx->num_used < cfg->num_blocks) {
+        prev = (fs_ctx->tail + cfg->num_blocks - 1) % cfg->num_blocks;
+
+        err = its_flash_fs_log_read_block_seq(fs_ctx, prev, &seq);
+        if (err == PSA_ERROR_DOES_NOT_EXIST) {
+            break;
+        } else if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if (seq != tail_seq - 1) {
+            break;
+        }
+
+        fs_ctx->tail = prev;
+        fs_ctx->num_used++;
+        tail_seq = seq;
+    }
+
+    /* Rebuild the file table by applying the records from the oldest */
+    its_flash_fs_log_clear_files(fs_ctx);
+    for (i = 0, block = fs_ctx->tail; i < fs_ctx->num_used;
+         i++, block = its_flash_fs_log_next(fs_ctx, block)) {
+        err = its_flash_fs_log_replay_block(fs_ctx, block, &end);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+    fs_ctx->head_off = end;
+
+    fs_ctx->live_size = 0;
+    for (i = 0; i < fs_ctx->num_files; i++) {
+        fs_ctx->live_size += its_flash_fs_log_file_space(cfg,
+                                                         &fs_ctx->files[i]);
+    }
+
+    /* A compaction interrupted by a power failure leaves no free block. It is
+     * completed, or rolled back, before anything else is written to the head.
+     */
+    if (fs_ctx->num_used == cfg->num_blocks) {
+        return its_flash_fs_log_compact_tail(fs_ctx);
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_prepare(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    return its_flash_fs_log_load(fs_ctx);
+}
+
+psa_status_t its_flash_fs_wipe_all(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    psa_status_t err;
+    uint32_t block;
+
+    for (block = 1; block < fs_ctx->cfg->num_blocks; block++) {
+        err = its_flash_fs_io_erase(fs_ctx, block);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    /* Start an empty log in the first block */
+    err = its_flash_fs_log_open_block(fs_ctx, 0, 1, false);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    fs_ctx->tail = 0;
+    fs_ctx->num_used = 1;
+    fs_ctx->live_size = 0;
+    its_flash_fs_log_clear_files(fs_ctx);
+    fs_ctx->next_erased = true;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_file_get_info(struct its_flash_fs_ctx_t *fs_ctx,
+                                        const uint8_t *fid,
+                                        struct its_flash_fs_file_info_t *info)
+{
+    const struct its_flash_fs_log_file_t *file;
+#ifdef ITS_ENCRYPTION
+    union its_flash_fs_log_rec_hdr_buf_t hdr_buf;
+    psa_status_t err;
+#endif
+
+    file = its_flash_fs_log_find(fs_ctx, fid);
+    if (file == NULL) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    info->size_max = file->max_size;
+    info->size_current = file->cur_size;
+    info->flags = file->flags & ITS_FLASH_FS_USER_FLAGS_MASK;
+
+#ifdef ITS_ENCRYPTION
+    /* The nonce and tag of the file are the ones of its last record */
+    err = its_flash_fs_io_read(fs_ctx, file->block, hdr_buf.buf,
+                               (file->num_deltas != 0) ?
+                               file->deltas[file->num_deltas - 1].offset :
+                               file->offset,
+                               sizeof(hdr_buf.hdr));
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    memcpy(info->nonce, hdr_buf.hdr.nonce, TFM_ITS_ENC_NONCE_LENGTH);
+    memcpy(info->tag, hdr_buf.hdr.tag, TFM_ITS_AUTH_TAG_LENGTH);
+#endif
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Checks whether a write to an existing file can be appended as a delta
+ *        record holding only the new data. The file record of the file must be
+ *        in the head block, so that all the records of a file are compacted
+ *        together, and the delta record must be smaller than a new file
+ *        record, fit in the head block and in the capacity of the log.
+ *
+ * \param[in] fs_ctx     Filesystem context
+ * \param[in] file       File written
+ * \param[in] cur_size   Size of the file after the write
+ * \param[in] data_size  Size of the new data
+ *
+ * \return Returns true if a delta record can be written
+ */
+static bool its_flash_fs_log_delta_fits(
+                                   const struct its_flash_fs_ctx_t *fs_ctx,
+                                   const struct its_flash_fs_log_file_t *file,
+                                   size_t cur_size,
+                                   size_t data_size)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    size_t len = its_flash_fs_log_rec_len(cfg, data_size);
+
+    return (file->num_deltas < ITS_FLASH_FS_LOG_MAX_DELTAS) &&
+           (file->block == fs_ctx->head) &&
+           (len < its_flash_fs_log_rec_len(cfg, cur_size)) &&
+           (fs_ctx->head_off + len <= cfg->block_size) &&
+           (fs_ctx->live_size + len <= its_flash_fs_log_capacity(cfg));
+}
+
+/**
+ * \brief Appends a delta record holding the new data of a write to an existing
+ *        file, which its_flash_fs_log_delta_fits() accepted.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in,out] file       File written
+ * \param[in,out] hdr_buf    Header of the file record the write would append,
+ *                           turned into the header of the delta record
+ * \param[in]     offset     Offset of the new data in the file
+ * \param[in]     data_size  Size of the new data
+ * \param[in]     data       New data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_log_write_delta(
+                                  struct its_flash_fs_ctx_t *fs_ctx,
+                                  struct its_flash_fs_log_file_t *file,
+                                  union its_flash_fs_log_rec_hdr_buf_t *hdr_buf,
+                                  size_t offset,
+                                  size_t data_size,
+                                  const uint8_t *data)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    struct its_flash_fs_log_delta_t *delta;
+    uint32_t cur_size = hdr_buf->hdr.cur_size;
+    size_t len = its_flash_fs_log_rec_len(cfg, data_size);
+    psa_status_t err;
+
+    /* The offset of the data in the file is held in max_size */
+    hdr_buf->hdr.type = ITS_FLASH_FS_LOG_REC_DELTA;
+    hdr_buf->hdr.cur_size = data_size;
+    hdr_buf->hdr.max_size = offset;
+
+    err = its_flash_fs_log_write_rec_hdr(fs_ctx, hdr_buf);
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_io_write(fs_ctx, fs_ctx->head, data,
+                                    fs_ctx->head_off
+                                    + its_flash_fs_log_rec_hdr_len(cfg),
+                                    ITS_UTILS_ALIGN(data_size,
+                                                    cfg->program_unit));
+    }
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_log_commit_rec(fs_ctx, &hdr_buf->hdr);
+    }
+    if (err != PSA_SUCCESS) {
+        /* The rest of the head block may be partially programmed */
+        fs_ctx->head_off = cfg->block_size;
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    delta = &file->deltas[file->num_deltas++];
+    delta->offset = fs_ctx->head_off - len;
+    delta->data_off = offset;
+    delta->data_size = data_size;
+    file->cur_size = cur_size;
+    fs_ctx->live_size += len;
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.user_bytes += data_size;
+#endif
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
+                                     const uint8_t *fid,
+                                     struct its_flash_fs_file_info_t *finfo,
+                                     size_t data_size,
+                                     size_t offset,
+                                     const uint8_t *data)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    union its_flash_fs_log_rec_hdr_buf_t hdr_buf = {0};
+    struct its_flash_fs_log_file_t *file;
+    size_t old_size = 0;
+    size_t live_size;
+    size_t len;
+    bool update = false;
+    psa_status_t err;
+
+    if (finfo == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Do not permit the user to pass filesystem-internal flags */
+    if (finfo->flags & ITS_FLASH_FS_INTERNAL_FLAGS_MASK) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+#if (ITS_FLASH_MAX_ALIGNMENT != 1)
+    /* Set the max_size to be aligned with the flash program unit */
+    finfo->size_max = ITS_UTILS_ALIGN(finfo->size_max, cfg->program_unit);
+#endif
+
+    hdr_buf.hdr.type = ITS_FLASH_FS_LOG_REC_FILE;
+    memcpy(hdr_buf.hdr.id, fid, ITS_FILE_ID_SIZE);
+
+    /* Check if the file already exists */
+    file = its_flash_fs_log_find(fs_ctx, fid);
+    if ((file != NULL) && !(finfo->flags & ITS_FLASH_FS_FLAG_TRUNCATE)) {
+        /* Write to the existing file. Its data is copied to the new record,
+         * with the new data written over it, unless only the new data is
+         * appended in a delta record.
+         */
+        hdr_buf.hdr.flags = file->flags;
+        hdr_buf.hdr.cur_size = file->cur_size;
+        hdr_buf.hdr.max_size = file->max_size;
+        old_size = file->cur_size;
+        update = true;
+    } else {
+        /* The create flag must be supplied to create a new file */
+        if ((file == NULL) && !(finfo->flags & ITS_FLASH_FS_FLAG_CREATE)) {
+            return PSA_ERROR_DOES_NOT_EXIST;
+        }
+
+        /* Check that the file's maximum size is valid */
+        if (finfo->size_max > cfg->max_file_size) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        if ((file == NULL) && (fs_ctx->num_files == cfg->max_num_files)) {
+            return PSA_ERROR_INSUFFICIENT_STORAGE;
+        }
+
+        hdr_buf.hdr.flags = finfo->flags & ITS_FLASH_FS_USER_FLAGS_MASK;
+        hdr_buf.hdr.cur_size = 0;
+        hdr_buf.hdr.max_size = finfo->size_max;
+    }
+
+    if (data_size != 0) {
+#if (ITS_FLASH_MAX_ALIGNMENT != 1)
+        /* Check that the offset is aligned with the flash program unit */
+        if (!ITS_UTILS_IS_ALIGNED(offset, cfg->program_unit)) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+#endif
+
+        /* It is not permitted to create gaps in the file */
+        if (offset > hdr_buf.hdr.cur_size) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        /* Check that the new data is contained within the file's max size */
+        if (its_utils_check_contained_in(hdr_buf.hdr.max_size, offset,
+                                         ITS_UTILS_ALIGN(data_size,
+                                                         cfg->program_unit))
+            != PSA_SUCCESS) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        /* Update the file's current size if required */
+        if ((offset + data_size) > hdr_buf.hdr.cur_size) {
+            hdr_buf.hdr.cur_size = offset + data_size;
+        }
+    } else {
+        /* Only the existing data, if any, is written */
+        offset = 0;
+    }
+
+#ifdef ITS_ENCRYPTION
+    memcpy(hdr_buf.hdr.nonce, finfo->nonce, sizeof(finfo->nonce));
+    memcpy(hdr_buf.hdr.tag, finfo->tag, sizeof(finfo->tag));
+#endif
+
+    if (update && (data_size != 0) &&
+        its_flash_fs_log_delta_fits(fs_ctx, file, hdr_buf.hdr.cur_size,
+                                    data_size)) {
+        return its_flash_fs_log_write_delta(fs_ctx, file, &hdr_buf, offset,
+                                            data_size, data);
+    }
+
+    /* The space of the file is reserved for its maximum size, so that writes
+     * to an existing file do not run out of space. Its delta records are
+     * replaced by the new file record.
+     */
+    live_size = fs_ctx->live_size + its_flash_fs_log_rec_len(cfg,
+                                                      hdr_buf.hdr.max_size);
+    if (file != NULL) {
+        live_size -= its_flash_fs_log_file_space(cfg, file);
+    }
+    if (live_size > its_flash_fs_log_capacity(cfg)) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    len = its_flash_fs_log_rec_len(cfg, hdr_buf.hdr.cur_size);
+    err = its_flash_fs_log_reserve(fs_ctx, len);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Making space can move the existing record and reload the file table */
+    file = its_flash_fs_log_find(fs_ctx, fid);
+
+    err = its_flash_fs_log_write_rec_hdr(fs_ctx, &hdr_buf);
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_log_write_data(fs_ctx, file, old_size, offset,
+                                          data_size, data);
+    }
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_log_commit_rec(fs_ctx, &hdr_buf.hdr);
+    }
+    if (err != PSA_SUCCESS) {
+        /* The rest of the head block may be partially programmed */
+        fs_ctx->head_off = fs_ctx->cfg->block_size;
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    /* Making space can also merge the delta records of the file */
+    live_size = fs_ctx->live_size + its_flash_fs_log_rec_len(cfg,
+                                                      hdr_buf.hdr.max_size);
+    if (file == NULL) {
+        file = its_flash_fs_log_add(fs_ctx, fid);
+    } else {
+        live_size -= its_flash_fs_log_file_space(cfg, file);
+    }
+
+    file->block = fs_ctx->head;
+    file->offset = fs_ctx->head_off - len;
+    file->base_size = hdr_buf.hdr.cur_size;
+    file->cur_size = hdr_buf.hdr.cur_size;
+    file->max_size = hdr_buf.hdr.max_size;
+    file->flags = hdr_buf.hdr.flags;
+    file->num_deltas = 0;
+    fs_ctx->live_size = live_size;
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.user_bytes += data_size;
+#endif
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_file_delete(struct its_flash_fs_ctx_t *fs_ctx,
+                                      const uint8_t *fid)
+{
+    union its_flash_fs_log_rec_hdr_buf_t hdr_buf = {0};
+    struct its_flash_fs_log_file_t *file;
+    psa_status_t err;
+
+    file = its_flash_fs_log_find(fs_ctx, fid);
+    if (file == NULL) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    err = its_flash_fs_log_reserve(fs_ctx,
+                                   its_flash_fs_log_rec_len(fs_ctx->cfg, 0));
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Making space can reload the file table */
+    file = its_flash_fs_log_find(fs_ctx, fid);
+
+    hdr_buf.hdr.type = ITS_FLASH_FS_LOG_REC_DELETE;
+    memcpy(hdr_buf.hdr.id, fid, ITS_FILE_ID_SIZE);
+
+    err = its_flash_fs_log_write_rec_hdr(fs_ctx, &hdr_buf);
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_log_commit_rec(fs_ctx, &hdr_buf.hdr);
+    }
+    if (err != PSA_SUCCESS) {
+        /* The rest of the head block may be partially programmed */
+        fs_ctx->head_off = fs_ctx->cfg->block_size;
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    fs_ctx->live_size -= its_flash_fs_log_file_space(fs_ctx->cfg, file);
+    its_flash_fs_log_remove(fs_ctx, file);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_file_read(struct its_flash_fs_ctx_t *fs_ctx,
+                                    const uint8_t *fid,
+                                    size_t size,
+                                    size_t offset,
+                                    uint8_t *data)
+{
+    const struct its_flash_fs_log_file_t *file;
+    psa_status_t err;
+
+    file = its_flash_fs_log_find(fs_ctx, fid);
+    if (file == NULL) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    /* Boundary check the incoming request */
+    err = its_utils_check_contained_in(file->cur_size, offset, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = its_flash_fs_log_read_data(fs_ctx, file, offset, size, false, data);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+#if ITS_BACKGROUND_MAINTENANCE
+psa_status_t its_flash_fs_maintain(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    const struct its_flash_fs_config_t *cfg = fs_ctx->cfg;
+    size_t live_len = 0;
+    psa_status_t err;
+    uint32_t i;
+
+    /* When only the block kept for the compaction is free, the next write
+     * which does not fit in the head compacts the oldest block. Once a write
+     * of the largest file would not fit, that is done now if the live records
+     * of the oldest block fit in the head, so that a block is freed without
+     * opening a new one.
+     */
+    if ((cfg->num_blocks - fs_ctx->num_used < 2) &&
+        (fs_ctx->tail != fs_ctx->head) &&
+        (fs_ctx->head_off + its_flash_fs_log_rec_len(cfg, cfg->max_file_size) >
+         cfg->block_size)) {
+        for (i = 0; i < fs_ctx->num_files; i++) {
+            if (fs_ctx->files[i].block == fs_ctx->tail) {
+                live_len += its_flash_fs_log_rec_len(cfg,
+                                                     fs_ctx->files[i].cur_size);
+            }
+        }
+
+        if (fs_ctx->head_off + live_len <= cfg->block_size) {
+            err = its_flash_fs_log_compact_tail(fs_ctx);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+        }
+    }
+
+    /* Erase the block opened next, so that opening it does not */
+    if (!fs_ctx->next_erased && (fs_ctx->num_used < cfg->num_blocks)) {
+        err = its_flash_fs_io_erase(fs_ctx,
+                                    its_flash_fs_log_next(fs_ctx,
+                                                          fs_ctx->head));
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        fs_ctx->next_erased = true;
+    }
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_BACKGROUND_MAINTENANCE */
+
+#endif /* ITS_FLASH_FS_LOG */
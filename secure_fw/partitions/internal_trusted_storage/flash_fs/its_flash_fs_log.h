@@ -0,0 +1,212 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  its_flash_fs_log.h
+ *
+ * \brief Log-structured implementation of the ITS flash filesystem, selected
+ *        with ITS_FLASH_FS_LOG in place of the metadata block implementation.
+ *
+ *        The blocks of the flash area are used as a circular log. Each file
+ *        write appends a record holding the file metadata and the whole file
+ *        data to the head block, and each delete appends a deletion record.
+ *        A small write to a file whose record is in the head block appends a
+ *        delta record holding only the new data instead, up to
+ *        ITS_FLASH_FS_LOG_MAX_DELTAS per file. The location of the records of
+ *        each file is kept in RAM. When the log runs out of free blocks, the
+ *        oldest block is compacted by copying its live records to the head,
+ *        merging the delta records of a file into a single file record, and
+ *        erasing it, so a small update only programs the data it changes
+ *        instead of copying whole data blocks.
+ */
+
+#ifndef __ITS_FLASH_FS_LOG_H__
+#define __ITS_FLASH_FS_LOG_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config_tfm.h"
+#include "flash/its_flash.h"
+#include "its_flash_fs.h"
+#include "its_flash_fs_io.h"
+#include "its_utils.h"
+#include "psa/error.h"
+
+#ifdef TFM_PARTITION_PROTECTED_STORAGE
+#include "ps_object_defs.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if ITS_TRANSACTION
+#error "ITS_TRANSACTION is not supported by the log-structured filesystem"
+#endif
+
+#if (TFM_HAL_ITS_PROGRAM_UNIT > 16) && !ITS_RAM_FS
+#error "The log-structured filesystem does not support NAND flash for ITS"
+#endif
+
+#if defined(TFM_PARTITION_PROTECTED_STORAGE) && \
+    (TFM_HAL_PS_PROGRAM_UNIT > 16) && !PS_RAM_FS
+#error "The log-structured filesystem does not support NAND flash for PS"
+#endif
+
+/*!
+ * \def ITS_FLASH_FS_LOG_VERSION
+ *
+ * \brief Defines the version of the log-structured filesystem layout.
+ */
+#define ITS_FLASH_FS_LOG_VERSION  0x03
+
+/*!
+ * \def ITS_FLASH_FS_LOG_OLDEST_VERSION
+ *
+ * \brief Defines the oldest version of the layout whose blocks are still read.
+ *        The blocks of versions 1 and 2 have the layout of the current version
+ *        without delta records. With ITS_ENCRYPTION, the files of version 1
+ *        are all encrypted as a whole, while the later versions may also hold
+ *        files encrypted in chunks.
+ */
+#define ITS_FLASH_FS_LOG_OLDEST_VERSION  0x01
+
+/*!
+ * \def ITS_FLASH_FS_MAX_NUM_FILES
+ *
+ * \brief Defines the largest number of files of all the filesystem contexts.
+ *        It dimensions statically the file table of each context.
+ */
+#ifdef TFM_PARTITION_PROTECTED_STORAGE
+#define ITS_FLASH_FS_MAX_NUM_FILES  ITS_UTILS_MAX(ITS_NUM_ASSETS + 1, \
+                                                  PS_MAX_NUM_OBJECTS)
+#else
+#define ITS_FLASH_FS_MAX_NUM_FILES  (ITS_NUM_ASSETS + 1)
+#endif
+
+/*!
+ * \def ITS_FLASH_FS_LOG_DELTA_SLOTS
+ *
+ * \brief Defines the number of delta records kept in RAM for each file, at
+ *        least one so that the table can be dimensioned when they are disabled.
+ */
+#define ITS_FLASH_FS_LOG_DELTA_SLOTS  ITS_UTILS_MAX(ITS_FLASH_FS_LOG_MAX_DELTAS, 1)
+
+/*!
+ * \struct its_flash_fs_log_block_hdr_t
+ *
+ * \brief Structure programmed at the start of each block of the log when it
+ *        becomes the head.
+ *
+ * \note This structure is programmed to flash, padded to a multiple of the
+ *       flash program unit.
+ */
+struct its_flash_fs_log_block_hdr_t {
+    uint32_t magic;     /*!< Identifies a block of the log */
+    uint32_t seq;       /*!< Sequence number, incremented for each block */
+    uint32_t seq_inv;   /*!< Bitwise inverse of the sequence number */
+    uint8_t fs_version; /*!< Filesystem version */
+    uint8_t reserved[3];
+};
+
+/*!
+ * \struct its_flash_fs_log_rec_hdr_t
+ *
+ * \brief Structure programmed at the start of each record of the log. The file
+ *        data follows it, then a commit word which is programmed last.
+ *
+ * \note This structure is programmed to flash, padded to a multiple of the
+ *       flash program unit.
+ */
+struct its_flash_fs_log_rec_hdr_t {
+    uint32_t type;                 /*!< File, delta or deletion record */
+    uint32_t flags;                /*!< Flags set when the file was created */
+    uint32_t cur_size;             /*!< Size of the file data in the record */
+    uint32_t max_size;             /*!< Maximum size of the file, or for a
+                                    *   delta record, offset of its data in
+                                    *   the file
+                                    */
+    uint8_t id[ITS_FILE_ID_SIZE];  /*!< ID of the file */
+#ifdef ITS_ENCRYPTION
+    uint8_t nonce[TFM_ITS_ENC_NONCE_LENGTH]; /*!< Nonce of the file */
+    uint8_t tag[TFM_ITS_AUTH_TAG_LENGTH];    /*!< Authentication tag */
+#endif
+    uint32_t check;                /*!< Checksum of the fields above */
+};
+
+/*!
+ * \struct its_flash_fs_log_delta_t
+ *
+ * \brief Structure to store in RAM the location of a delta record of a file,
+ *        which is in the block of the file record.
+ */
+struct its_flash_fs_log_delta_t {
+    uint32_t offset;     /*!< Offset of the record in the block */
+    uint32_t data_off;   /*!< Offset of its data in the file */
+    uint32_t data_size;  /*!< Size of its data */
+};
+
+/*!
+ * \struct its_flash_fs_log_file_t
+ *
+ * \brief Structure to store in RAM the location and metadata of the last file
+ *        record of a file, and of the delta records written after it.
+ */
+struct its_flash_fs_log_file_t {
+    uint8_t id[ITS_FILE_ID_SIZE];  /*!< ID of the file */
+    uint32_t block;                /*!< Physical block of the record */
+    uint32_t offset;               /*!< Offset of the record in the block */
+    uint32_t base_size;            /*!< Size of the data in the record */
+    uint32_t cur_size;             /*!< Current size of the file */
+    uint32_t max_size;             /*!< Maximum size of the file */
+    uint32_t flags;                /*!< Flags set when the file was created */
+    uint32_t num_deltas;           /*!< Number of delta records */
+    /** Delta records, in the order they were written */
+    struct its_flash_fs_log_delta_t deltas[ITS_FLASH_FS_LOG_DELTA_SLOTS];
+};
+
+/**
+ * \struct its_flash_fs_ctx_t
+ *
+ * \brief Structure to store the ITS flash file system context.
+ */
+struct its_flash_fs_ctx_t {
+    const struct its_flash_fs_config_t *cfg; /**< Filesystem configuration */
+    const struct its_flash_fs_ops_t *ops;    /**< Filesystem flash operations */
+    uint32_t tail;       /**< Oldest block of the log */
+    uint32_t head;       /**< Block the records are appended to */
+    uint32_t head_seq;   /**< Sequence number of the head block */
+    uint32_t head_off;   /**< Offset of the next record in the head block */
+    uint32_t num_used;   /**< Number of blocks from the tail to the head */
+    bool next_erased;    /**< Whether the block after the head is known to be
+                          *   erased
+                          */
+    size_t live_size;    /**< Space reserved in the log by the files */
+    uint32_t num_files;  /**< Number of files */
+    /** Records of each file */
+    struct its_flash_fs_log_file_t files[ITS_FLASH_FS_MAX_NUM_FILES];
+#if ITS_FILE_INDEX
+    /** First file of each hash bucket of the file IDs */
+    uint16_t index_head[ITS_FLASH_FS_MAX_NUM_FILES];
+    /** Next file of the same hash bucket as each file */
+    uint16_t index_next[ITS_FLASH_FS_MAX_NUM_FILES];
+#endif
+#if ITS_FLASH_FS_STATS
+    struct its_flash_fs_stats_t stats; /**< Flash access counters */
+#endif
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    struct its_flash_fs_cache_stats_t cache_stats; /**< Flash cache counters */
+#endif
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ITS_FLASH_FS_LOG_H__ */
@@ -8,6 +8,9 @@
 #include <string.h>
 
 #include "config_tfm.h"
+
+#if !ITS_FLASH_FS_LOG
+
 #include "its_flash_fs_mblock.h"
 #include "psa/storage_common.h"
 #include "coverity_check.h"
@@ -148,6 +151,10 @@ static void its_mblock_swap_metablocks(struct its_flash_fs_ctx_t *fs_ctx)
     tmp_block = fs_ctx->scratch_metablock;
     fs_ctx->scratch_metablock = fs_ctx->active_metablock;
     fs_ctx->active_metablock = tmp_block;
+
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.metablock_swaps++;
+#endif
 }
 
 /**
@@ -402,10 +409,10 @@ static psa_status_t its_mblock_calculate_metadata_xor(
 
     /* Calculate the XOR value based on the block metadata. */
     for (i = 0; i < its_num_active_dblocks(fs_ctx); i++) {
-        err = fs_ctx->ops->read(fs_ctx->cfg, block_id,
-                                metadata,
-                                its_mblock_block_meta_offset(i),
-                                ITS_BLOCK_METADATA_SIZE);
+        err = its_flash_fs_io_read(fs_ctx, block_id,
+                                   metadata,
+                                   its_mblock_block_meta_offset(i),
+                                   ITS_BLOCK_METADATA_SIZE);
         if (err != PSA_SUCCESS) {
             return err;
         }
@@ -418,10 +425,10 @@ static psa_status_t its_mblock_calculate_metadata_xor(
 
     /* Calculate the XOR value based on the file metadata. */
     for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
-        err = fs_ctx->ops->read(fs_ctx->cfg, block_id,
-                                metadata,
-                                its_mblock_file_meta_offset(fs_ctx, i),
-                                ITS_FILE_METADATA_SIZE);
+        err = its_flash_fs_io_read(fs_ctx, block_id,
+                                   metadata,
+                                   its_mblock_file_meta_offset(fs_ctx, i),
+                                   ITS_FILE_METADATA_SIZE);
         if (err != PSA_SUCCESS) {
             return err;
         }
@@ -465,6 +472,285 @@ static psa_status_t its_mblock_validate_metadata_xor(
 }
 #endif /* ITS_VALIDATE_METADATA_FROM_FLASH */
 
+#if ITS_FILE_INDEX
+/* Marks a file metadata entry which is not indexed, or the end of a bucket */
+#define ITS_FILE_INDEX_NONE       ITS_METADATA_INVALID_INDEX
+/* Marks a file metadata entry which is not written in the scratch block */
+#define ITS_FILE_INDEX_UNCHANGED  (ITS_METADATA_INVALID_INDEX - 1)
+/* Marks a block metadata entry which is not written in the scratch block */
+#define ITS_BLOCK_SUMMARY_UNCHANGED  SIZE_MAX
+
+/**
+ * \brief Gets the number of logical blocks whose free size is kept in the file
+ *        index.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Number of logical blocks
+ */
+static uint32_t its_file_index_num_blocks(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    return ITS_UTILS_MIN(its_num_active_dblocks(fs_ctx),
+                         ITS_FLASH_FS_NUM_BLOCK_SUMMARIES);
+}
+
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+/**
+ * \brief Calculates the XOR of a metadata entry.
+ *
+ * \param[in] entry  Metadata entry
+ * \param[in] size   Size of the entry
+ *
+ * \return XOR of all the bytes of the entry
+ */
+static uint8_t its_file_index_entry_xor(const void *entry, size_t size)
+{
+    const uint8_t *p_entry = (const uint8_t *)entry;
+    uint8_t xor_value = 0;
+
+    while (size-- > 0) {
+        xor_value ^= *p_entry++;
+    }
+
+    return xor_value;
+}
+#endif
+
+/**
+ * \brief Gets the file index bucket of a file ID.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     fid     File ID
+ *
+ * \return Bucket of the file ID, or ITS_FILE_INDEX_NONE if the file ID is not
+ *         valid, as free entries are not indexed
+ */
+static uint16_t its_file_index_bucket(struct its_flash_fs_ctx_t *fs_ctx,
+                                      const uint8_t *fid)
+{
+    /* FNV-1a hash of the file ID */
+    uint32_t hash = 2166136261U;
+    uint32_t i;
+
+    if (its_utils_validate_fid(fid) != PSA_SUCCESS) {
+        return ITS_FILE_INDEX_NONE;
+    }
+
+    for (i = 0; i < ITS_FILE_ID_SIZE; i++) {
+        hash = (hash ^ fid[i]) * 16777619U;
+    }
+
+    return (uint16_t)(hash % fs_ctx->cfg->max_num_files);
+}
+
+/**
+ * \brief Moves a file metadata entry to another bucket of the file index.
+ *
+ * \param[in,out] index   File index
+ * \param[in]     idx     File metadata entry index
+ * \param[in]     bucket  New bucket, or ITS_FILE_INDEX_NONE to remove the entry
+ */
+static void its_file_index_move(struct its_file_index_t *index, uint32_t idx,
+                                uint16_t bucket)
+{
+    uint16_t *link;
+
+    if (index->bucket[idx] != ITS_FILE_INDEX_NONE) {
+        /* Unlink the entry from its current bucket */
+        link = &index->head[index->bucket[idx]];
+        while (*link != idx) {
+            link = &index->next[*link];
+        }
+        *link = index->next[idx];
+    }
+
+    index->bucket[idx] = bucket;
+    if (bucket != ITS_FILE_INDEX_NONE) {
+        index->next[idx] = index->head[bucket];
+        index->head[bucket] = (uint16_t)idx;
+        index->free_files[idx / 32] &= ~(1UL << (idx % 32));
+    } else {
+        index->free_files[idx / 32] |= (1UL << (idx % 32));
+    }
+}
+
+/**
+ * \brief Empties the file index.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ */
+static void its_file_index_reset(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    uint32_t i;
+
+    (void)memset(index->free_files, 0, sizeof(index->free_files));
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        index->head[i] = ITS_FILE_INDEX_NONE;
+        index->bucket[i] = ITS_FILE_INDEX_NONE;
+        index->pending[i] = ITS_FILE_INDEX_UNCHANGED;
+        index->free_files[i / 32] |= (1UL << (i % 32));
+    }
+
+    for (i = 0; i < ITS_FLASH_FS_NUM_BLOCK_SUMMARIES; i++) {
+        index->block_free[i] = 0;
+        index->block_pending[i] = ITS_BLOCK_SUMMARY_UNCHANGED;
+    }
+
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+    (void)memset(index->file_xor, 0, sizeof(index->file_xor));
+    (void)memset(index->block_xor, 0, sizeof(index->block_xor));
+#endif
+    index->built = false;
+}
+
+/**
+ * \brief Builds the file index from the file metadata table stored in the
+ *        active metadata block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_file_index_build(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    psa_status_t err;
+    uint32_t i;
+    struct its_file_meta_t tmp_metadata;
+    struct its_block_meta_t block_meta;
+
+    its_file_index_reset(fs_ctx);
+
+    for (i = 0; i < its_file_index_num_blocks(fs_ctx); i++) {
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, i, &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        fs_ctx->file_index.block_free[i] = block_meta.free_size;
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+        fs_ctx->file_index.block_xor[i] =
+            its_file_index_entry_xor(&block_meta, ITS_BLOCK_METADATA_SIZE);
+#endif
+    }
+
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &tmp_metadata);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        its_file_index_move(&fs_ctx->file_index, i,
+                            its_file_index_bucket(fs_ctx, tmp_metadata.id));
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+        fs_ctx->file_index.file_xor[i] =
+            its_file_index_entry_xor(&tmp_metadata, ITS_FILE_METADATA_SIZE);
+#endif
+    }
+
+    fs_ctx->file_index.built = true;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Applies to the file index the file metadata entries written in the
+ *        scratch metadata block, once it has become the active one.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ */
+static void its_file_index_commit(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    uint32_t i;
+
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        if (index->pending[i] != ITS_FILE_INDEX_UNCHANGED) {
+            /* An entry whose file ID changes within the same bucket does not
+             * need to be relinked, as the IDs are compared on lookup.
+             */
+            if (index->pending[i] != index->bucket[i]) {
+                its_file_index_move(index, i, index->pending[i]);
+            }
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+            index->file_xor[i] = index->file_pending_xor[i];
+#endif
+            index->pending[i] = ITS_FILE_INDEX_UNCHANGED;
+        }
+    }
+
+    for (i = 0; i < ITS_FLASH_FS_NUM_BLOCK_SUMMARIES; i++) {
+        if (index->block_pending[i] != ITS_BLOCK_SUMMARY_UNCHANGED) {
+            index->block_free[i] = index->block_pending[i];
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+            index->block_xor[i] = index->block_pending_xor[i];
+#endif
+            index->block_pending[i] = ITS_BLOCK_SUMMARY_UNCHANGED;
+        }
+    }
+}
+
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+/**
+ * \brief Calculates the XOR on the whole metadata in a metadata block from the
+ *        XOR of each entry kept in the file index. Only the block metadata of
+ *        the logical blocks which are not summarised in the index are read
+ *        from flash.
+ *
+ * \details For the scratch metadata block, the entries written by the update
+ *          in progress are taken into account. For the active metadata block,
+ *          no update must be in progress.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     block_id   Metadata block ID
+ * \param[out]    xor_value  XOR value based on all the metadata in the block
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_file_index_metadata_xor(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t block_id,
+                                              uint8_t *xor_value)
+{
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    struct its_block_meta_t block_meta;
+    psa_status_t err;
+    uint8_t xor_value_temp = 0;
+    uint32_t i;
+
+    /* Entries which are not written in the scratch metadata block have been
+     * copied from the active one.
+     */
+    for (i = 0; i < its_file_index_num_blocks(fs_ctx); i++) {
+        xor_value_temp ^=
+            (index->block_pending[i] != ITS_BLOCK_SUMMARY_UNCHANGED) ?
+            index->block_pending_xor[i] : index->block_xor[i];
+    }
+
+    for (; i < its_num_active_dblocks(fs_ctx); i++) {
+        err = its_flash_fs_io_read(fs_ctx, block_id,
+                                   (uint8_t *)&block_meta,
+                                   its_mblock_block_meta_offset(i),
+                                   ITS_BLOCK_METADATA_SIZE);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        xor_value_temp ^= its_file_index_entry_xor(&block_meta,
+                                                   ITS_BLOCK_METADATA_SIZE);
+    }
+
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        xor_value_temp ^= (index->pending[i] != ITS_FILE_INDEX_UNCHANGED) ?
+                          index->file_pending_xor[i] : index->file_xor[i];
+    }
+
+    *xor_value = xor_value_temp;
+    return PSA_SUCCESS;
+}
+#endif /* ITS_VALIDATE_METADATA_FROM_FLASH */
+#endif /* ITS_FILE_INDEX */
+
 /**
  * \brief Gets a free file metadata table entry.
  *
@@ -477,6 +763,31 @@ static psa_status_t its_mblock_validate_metadata_xor(
 static uint32_t its_get_free_file_index(struct its_flash_fs_ctx_t *fs_ctx,
                                         bool use_spare)
 {
+#if ITS_FILE_INDEX
+    uint32_t i;
+    uint32_t word;
+
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i += 32) {
+        word = fs_ctx->file_index.free_files[i / 32];
+
+        if (!use_spare && (word != 0)) {
+            /* Keep the first free file index as a spare */
+            word &= word - 1;
+            use_spare = true;
+        }
+
+        if (word != 0) {
+            /* Found, the lowest bit set is the first free entry */
+            while ((word & 1UL) == 0) {
+                word >>= 1;
+                i++;
+            }
+            return i;
+        }
+    }
+
+    return ITS_METADATA_INVALID_INDEX;
+#else
     psa_status_t err;
     uint32_t i;
     struct its_file_meta_t tmp_metadata;
@@ -504,6 +815,7 @@ static uint32_t its_get_free_file_index(struct its_flash_fs_ctx_t *fs_ctx,
     }
 
     return ITS_METADATA_INVALID_INDEX;
+#endif /* ITS_FILE_INDEX */
 }
 
 /**
@@ -523,7 +835,7 @@ static psa_status_t its_mblock_erase_scratch_blocks(
      * and power-failure-safe operation, it is necessary that
      * metadata scratch block is erased before data block.
      */
-    err = fs_ctx->ops->erase(fs_ctx->cfg, fs_ctx->scratch_metablock);
+    err = its_flash_fs_io_erase(fs_ctx, fs_ctx->scratch_metablock);
     if (err != PSA_SUCCESS) {
         return err;
     }
@@ -537,7 +849,11 @@ static psa_status_t its_mblock_erase_scratch_blocks(
         scratch_datablock =
             its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
                                                     (ITS_LOGICAL_DBLOCK0 + 1));
-        err = fs_ctx->ops->erase(fs_ctx->cfg, scratch_datablock);
+        err = its_flash_fs_io_erase(fs_ctx, scratch_datablock);
+    }
+
+    if (err == PSA_SUCCESS) {
+        fs_ctx->scratch_erased = true;
     }
 
     return err;
@@ -559,25 +875,52 @@ static psa_status_t its_mblock_update_scratch_block_meta(
                                       const struct its_block_meta_t *block_meta)
 {
     size_t pos;
+#if ITS_FILE_INDEX
+    psa_status_t err;
+#endif
 
     /* Calculate the position */
     pos = its_mblock_block_meta_offset(lblock);
-    return fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
-                              (const uint8_t *)block_meta, pos,
-                              ITS_BLOCK_METADATA_SIZE);
+#if ITS_FILE_INDEX
+    err = its_flash_fs_io_write(fs_ctx, fs_ctx->scratch_metablock,
+                                (const uint8_t *)block_meta, pos,
+                                ITS_BLOCK_METADATA_SIZE);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Summarised when the scratch metadata block becomes the active one */
+    if (lblock < ITS_FLASH_FS_NUM_BLOCK_SUMMARIES) {
+        fs_ctx->file_index.block_pending[lblock] = block_meta->free_size;
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+        fs_ctx->file_index.block_pending_xor[lblock] =
+            its_file_index_entry_xor(block_meta, ITS_BLOCK_METADATA_SIZE);
+#endif
+    }
+
+    return PSA_SUCCESS;
+#else
+    return its_flash_fs_io_write(fs_ctx, fs_ctx->scratch_metablock,
+                                 (const uint8_t *)block_meta, pos,
+                                 ITS_BLOCK_METADATA_SIZE);
+#endif
 }
 
 /**
  * \brief Copies rest of the block metadata.
  *
- * \param[in,out] fs_ctx  Filesystem context
- * \param[in]     lblock  Logical block number to skip
+ * \param[in,out] fs_ctx    Filesystem context
+ * \param[in]     lblock    Logical block number to skip
+ * \param[in]     lb0_meta  Block metadata to write for logical block 0 when
+ *                          \a lblock is not 0, or NULL to copy it from the
+ *                          active metadata block
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
 static psa_status_t its_mblock_copy_remaining_block_meta(
-                                              struct its_flash_fs_ctx_t *fs_ctx,
-                                              uint32_t lblock)
+                                     struct its_flash_fs_ctx_t *fs_ctx,
+                                     uint32_t lblock,
+                                     const struct its_block_meta_t *lb0_meta)
 {
     struct its_block_meta_t block_meta;
     psa_status_t err;
@@ -585,6 +928,16 @@ static psa_status_t its_mblock_copy_remaining_block_meta(
     size_t pos;
     uint32_t scratch_block;
     size_t size;
+#if ITS_FILE_INDEX
+    uint32_t i;
+
+    /* The copied entries are not modified by the update */
+    for (i = ITS_LOGICAL_DBLOCK0 + 1; i < ITS_FLASH_FS_NUM_BLOCK_SUMMARIES; i++) {
+        if (i != lblock) {
+            fs_ctx->file_index.block_pending[i] = ITS_BLOCK_SUMMARY_UNCHANGED;
+        }
+    }
+#endif
 
     scratch_block = fs_ctx->scratch_metablock;
     meta_block = fs_ctx->active_metablock;
@@ -598,11 +951,15 @@ static psa_status_t its_mblock_copy_remaining_block_meta(
          * the physical block ID has been updated while processing the file
          * data.
          */
-        err = its_flash_fs_mblock_read_block_metadata(fs_ctx,
-                                                      ITS_LOGICAL_DBLOCK0,
-                                                      &block_meta);
-        if (err != PSA_SUCCESS) {
-            return PSA_ERROR_GENERIC_ERROR;
+        if (lb0_meta != NULL) {
+            block_meta = *lb0_meta;
+        } else {
+            err = its_flash_fs_mblock_read_block_metadata(fs_ctx,
+                                                          ITS_LOGICAL_DBLOCK0,
+                                                          &block_meta);
+            if (err != PSA_SUCCESS) {
+                return PSA_ERROR_GENERIC_ERROR;
+            }
         }
 
         /* Update physical ID for logical block 0 to match with the
@@ -685,11 +1042,14 @@ __attribute__((always_inline))
 static inline psa_status_t its_mblock_validate_fs_version(uint8_t fs_version,
                                                           bool *backward_comp)
 {
-    /* Looks for exact version number and the backward compatible version. */
+    /* Looks for exact version number and the backward compatible versions.
+     * The previous version has the same layout as the supported one.
+     */
     if (fs_version == ITS_BACKWARD_SUPPORTED_VERSION) {
         *backward_comp = true;
         return PSA_SUCCESS;
-    } else if (fs_version == ITS_SUPPORTED_VERSION) {
+    } else if ((fs_version == ITS_SUPPORTED_VERSION) ||
+               (fs_version == ITS_PREVIOUS_SUPPORTED_VERSION)) {
         *backward_comp = false;
         return PSA_SUCCESS;
     } else {
@@ -698,21 +1058,19 @@ static inline psa_status_t its_mblock_validate_fs_version(uint8_t fs_version,
 }
 
 /**
- * \brief Validates header metadata in order to guarantee that a corruption or
- *        malicious change in stored metadata doesn't result in an invalid
- *        access and the header version is correct.
+ * \brief Validates the fields of the metadata block header which can be
+ *        checked without reading the rest of the block, in order to guarantee
+ *        that the header version is correct and that the swap count can be
+ *        used to find the latest metadata block.
  *
  * \param[in,out] fs_ctx  Filesystem context
  * \param[in]     h_meta  Pointer to metadata block header
  *
- * \param[in] block_id    Metadata block ID
- *
  * \return Returns error code as specified in \ref psa_status_t
  */
 static psa_status_t its_mblock_validate_header_meta(
                                struct its_flash_fs_ctx_t *fs_ctx,
-                               const struct its_metadata_block_header_t *h_meta,
-                               uint32_t block_id)
+                               const struct its_metadata_block_header_t *h_meta)
 {
     psa_status_t err;
     bool backward_compatible = false;
@@ -730,12 +1088,6 @@ static psa_status_t its_mblock_validate_header_meta(
         TFM_COVERITY_BLOCK_END(MISRA_C_2023_Rule_11_3)
     } else {
         err = its_mblock_validate_swap_count(fs_ctx, h_meta->active_swap_count);
-        if (err != PSA_SUCCESS) {
-            return err;
-        }
-#if ITS_VALIDATE_METADATA_FROM_FLASH
-        err = its_mblock_validate_metadata_xor(fs_ctx, h_meta, block_id);
-#endif
     }
     return err;
 }
@@ -762,10 +1114,19 @@ static psa_status_t its_mblock_write_scratch_meta_header(
         fs_ctx->meta_block_header.active_swap_count++;
     }
 #if ITS_VALIDATE_METADATA_FROM_FLASH
-    /* Calculate metadata XOR value. */
-    err = its_mblock_calculate_metadata_xor(fs_ctx,
+#if ITS_FILE_INDEX
+    if (fs_ctx->file_index.built) {
+        /* Calculate metadata XOR value from the entries kept in the index */
+        err = its_file_index_metadata_xor(fs_ctx, fs_ctx->scratch_metablock,
+                                       &fs_ctx->meta_block_header.metadata_xor);
+    } else
+#endif
+    {
+        /* Calculate metadata XOR value. */
+        err = its_mblock_calculate_metadata_xor(fs_ctx,
                                        fs_ctx->scratch_metablock,
                                        &fs_ctx->meta_block_header.metadata_xor);
+    }
     if (err != PSA_SUCCESS) {
         return err;
     }
@@ -774,14 +1135,14 @@ static psa_status_t its_mblock_write_scratch_meta_header(
 #endif
 
     /* Write the metadata block header */
-    return fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
-                              (uint8_t *)(&fs_ctx->meta_block_header), 0,
-                              ITS_BLOCK_META_HEADER_SIZE);
+    return its_flash_fs_io_write(fs_ctx, fs_ctx->scratch_metablock,
+                                 (uint8_t *)(&fs_ctx->meta_block_header), 0,
+                                 ITS_BLOCK_META_HEADER_SIZE);
 }
 
 /**
  * \brief Upgrade the meta header to ITS_SUPPORTED_VERSION if it is
- *        ITS_BACKWARD_SUPPORTED_VERSION.
+ *        ITS_BACKWARD_SUPPORTED_VERSION or ITS_PREVIOUS_SUPPORTED_VERSION.
  *
  * \param[in,out] fs_ctx  Filesystem context
  *
@@ -793,36 +1154,60 @@ static psa_status_t its_mblock_upgrade_meta_header(
     bool backward_compatible = false;
     psa_status_t err;
     size_t number;
+    size_t header_size;
     struct its_metadata_block_header_comp_t *meta_block_header_comp;
     struct its_block_meta_t block_meta_0;
 
+    if (fs_ctx->meta_block_header.fs_version == ITS_SUPPORTED_VERSION) {
+        return PSA_SUCCESS;
+    }
+
     err = its_mblock_validate_fs_version(fs_ctx->meta_block_header.fs_version,
                                          &backward_compatible);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-    if (!backward_compatible) {
-        return PSA_SUCCESS;
+    err = its_flash_fs_mblock_prepare_scratch(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (backward_compatible) {
+        header_size = sizeof(struct its_metadata_block_header_comp_t);
+        err = its_flash_fs_mblock_read_block_metadata_comp(fs_ctx,
+                                                           ITS_LOGICAL_DBLOCK0,
+                                                           &block_meta_0);
+    } else {
+        header_size = ITS_BLOCK_META_HEADER_SIZE;
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx,
+                                                      ITS_LOGICAL_DBLOCK0,
+                                                      &block_meta_0);
+    }
+    if (err != PSA_SUCCESS) {
+        return err;
     }
 
-    err = its_flash_fs_mblock_read_block_metadata_comp(fs_ctx,
-                                                       ITS_LOGICAL_DBLOCK0,
-                                                       &block_meta_0);
+    /* The data of logical block 0 is stored in the metadata block, so its
+     * physical ID becomes the one of the scratch metadata block.
+     */
+    block_meta_0.phy_id = fs_ctx->scratch_metablock;
+    err = its_mblock_update_scratch_block_meta(fs_ctx, ITS_LOGICAL_DBLOCK0,
+                                               &block_meta_0);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-    /* Copy the entire metadata and the file data in active_metablock to
+    /* Copy the rest of the metadata and the file data in active_metablock to
      * scratch_metablock. Only the meta_block_header needs to be updated.
      */
-    number = fs_ctx->cfg->block_size - block_meta_0.free_size -
-                            sizeof(struct its_metadata_block_header_comp_t);
+    number = fs_ctx->cfg->block_size - block_meta_0.free_size - header_size -
+             ITS_BLOCK_METADATA_SIZE;
     err = its_flash_fs_block_to_block_move(fs_ctx,
                     fs_ctx->scratch_metablock,
-                    its_mblock_block_meta_offset(ITS_LOGICAL_DBLOCK0),
+                    its_mblock_block_meta_offset(ITS_LOGICAL_DBLOCK0 + 1),
                     fs_ctx->active_metablock,
-                    sizeof(struct its_metadata_block_header_comp_t),
+                    header_size + ITS_BLOCK_METADATA_SIZE,
                     number);
     if (err != PSA_SUCCESS) {
         return err;
@@ -832,39 +1217,18 @@ static psa_status_t its_mblock_upgrade_meta_header(
      * scratch_dblock field share the same position as in the
      * ITS_BACKWARD_SUPPORTED_VERSION. So, no need to update it.
      */
-    TFM_COVERITY_DEVIATE_BLOCK(MISRA_C_2023_Rule_11_3, "Intentional pointer cast");
-    meta_block_header_comp =
-        (struct its_metadata_block_header_comp_t *)&fs_ctx->meta_block_header;
-    TFM_COVERITY_BLOCK_END(MISRA_C_2023_Rule_11_3)
-    fs_ctx->meta_block_header.active_swap_count =
-             meta_block_header_comp->active_swap_count;
+    if (backward_compatible) {
+        TFM_COVERITY_DEVIATE_BLOCK(MISRA_C_2023_Rule_11_3, "Intentional pointer cast");
+        meta_block_header_comp =
+            (struct its_metadata_block_header_comp_t *)&fs_ctx->meta_block_header;
+        TFM_COVERITY_BLOCK_END(MISRA_C_2023_Rule_11_3)
+        fs_ctx->meta_block_header.active_swap_count =
+                 meta_block_header_comp->active_swap_count;
+    }
     fs_ctx->meta_block_header.fs_version = ITS_SUPPORTED_VERSION;
     return its_flash_fs_mblock_meta_update_finalize(fs_ctx);
 }
 
-/**
- * \brief Reads the active metadata block header into its_system_ctx.
- *
- * \param[in,out] fs_ctx  Filesystem context
- *
- * \return Returns error code as specified in \ref psa_status_t
- */
-static psa_status_t its_mblock_read_meta_header(
-                                              struct its_flash_fs_ctx_t *fs_ctx)
-{
-    psa_status_t err;
-
-    err = fs_ctx->ops->read(fs_ctx->cfg, fs_ctx->active_metablock,
-                            (uint8_t *)&fs_ctx->meta_block_header, 0,
-                            ITS_BLOCK_META_HEADER_SIZE);
-    if (err != PSA_SUCCESS) {
-        return err;
-    }
-
-    return its_mblock_validate_header_meta(fs_ctx, &fs_ctx->meta_block_header,
-                                           fs_ctx->active_metablock);
-}
-
 /**
  * \brief Reserves space for an file.
  *
@@ -887,6 +1251,13 @@ static psa_status_t its_mblock_reserve_file(struct its_flash_fs_ctx_t *fs_ctx,
     uint32_t i;
 
     for (i = 0; i < its_num_active_dblocks(fs_ctx); i++) {
+#if ITS_FILE_INDEX
+        /* Skip the blocks known to be too full without reading them */
+        if ((i < ITS_FLASH_FS_NUM_BLOCK_SUMMARIES) &&
+            (fs_ctx->file_index.block_free[i] < size)) {
+            continue;
+        }
+#endif
         err = its_flash_fs_mblock_read_block_metadata(fs_ctx, i, block_meta);
         if (err != PSA_SUCCESS) {
             return PSA_ERROR_GENERIC_ERROR;
@@ -912,9 +1283,80 @@ static psa_status_t its_mblock_reserve_file(struct its_flash_fs_ctx_t *fs_ctx,
     return PSA_ERROR_INSUFFICIENT_STORAGE;
 }
 
+/**
+ * \brief Makes a metadata block the active one and checks its metadata
+ *        against the XOR stored in its header.
+ *
+ * \details With the file index, the XOR is calculated from the entries read to
+ *          build the index, so that the metadata is read only once. If an entry
+ *          fails validation, the whole metadata is checked against the XOR to
+ *          tell a corrupted block from a block whose content is not valid. In
+ *          the second case the index is left unbuilt, so that building it
+ *          again fails. The index is emptied first, so that nothing is kept
+ *          from a block which failed to load before.
+ *
+ * \param[in,out] fs_ctx    Filesystem context
+ * \param[in]     h_meta    Pointer to the header of the metadata block
+ * \param[in]     block_id  Metadata block ID
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_mblock_load_metablock(
+                               struct its_flash_fs_ctx_t *fs_ctx,
+                               const struct its_metadata_block_header_t *h_meta,
+                               uint32_t block_id)
+{
+    bool backward_compatible = false;
+#if ITS_FILE_INDEX && ITS_VALIDATE_METADATA_FROM_FLASH
+    psa_status_t err;
+    uint8_t xor_value;
+#endif
+
+#if ITS_FILE_INDEX
+    /* The index is built when the block is validated, or once it is
+     * upgraded.
+     */
+    its_file_index_reset(fs_ctx);
+#endif
+
+    fs_ctx->meta_block_header = *h_meta;
+    fs_ctx->active_metablock = block_id;
+    fs_ctx->scratch_metablock = ITS_OTHER_META_BLOCK(block_id);
+
+    /* The header of the backward supported version has no metadata XOR. The
+     * index is built once the block is upgraded.
+     */
+    (void)its_mblock_validate_fs_version(h_meta->fs_version,
+                                         &backward_compatible);
+    if (backward_compatible) {
+        return PSA_SUCCESS;
+    }
+
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+#if ITS_FILE_INDEX
+    err = its_file_index_build(fs_ctx);
+    if (err == PSA_SUCCESS) {
+        err = its_file_index_metadata_xor(fs_ctx, block_id, &xor_value);
+        if ((err == PSA_SUCCESS) && (xor_value != h_meta->metadata_xor)) {
+            err = PSA_ERROR_STORAGE_FAILURE;
+        }
+        return err;
+    }
+#endif
+    return its_mblock_validate_metadata_xor(fs_ctx, h_meta, block_id);
+#else
+    return PSA_SUCCESS;
+#endif
+}
+
 /**
  * \brief Validates and find the valid-active metablock
  *
+ * \details The latest metadata block is found from the headers of both blocks.
+ *          Only its metadata is read and checked, unless it turns out to be
+ *          corrupted, for instance by a power failure during an update, in
+ *          which case the other block is checked and used.
+ *
  * \param[in,out] fs_ctx  Filesystem context
  *
  * \return Returns value as specified in \ref psa_status_t
@@ -934,21 +1376,21 @@ static psa_status_t its_init_get_active_metablock(
      * attempt to validate the metadata header, otherwise assume that the block
      * update was incomplete
      */
-    err = fs_ctx->ops->read(fs_ctx->cfg, ITS_METADATA_BLOCK0,
-                            (uint8_t *)&h_meta0, 0, ITS_BLOCK_META_HEADER_SIZE);
+    err = its_flash_fs_io_read(fs_ctx, ITS_METADATA_BLOCK0,
+                               (uint8_t *)&h_meta0, 0,
+                               ITS_BLOCK_META_HEADER_SIZE);
     if (err == PSA_SUCCESS) {
-        if (its_mblock_validate_header_meta(fs_ctx, &h_meta0,
-                                        ITS_METADATA_BLOCK0) == PSA_SUCCESS) {
+        if (its_mblock_validate_header_meta(fs_ctx, &h_meta0) == PSA_SUCCESS) {
             num_valid_meta_blocks++;
             cur_meta_block = ITS_METADATA_BLOCK0;
         }
     }
 
-    err = fs_ctx->ops->read(fs_ctx->cfg, ITS_METADATA_BLOCK1,
-                            (uint8_t *)&h_meta1, 0, ITS_BLOCK_META_HEADER_SIZE);
+    err = its_flash_fs_io_read(fs_ctx, ITS_METADATA_BLOCK1,
+                               (uint8_t *)&h_meta1, 0,
+                               ITS_BLOCK_META_HEADER_SIZE);
     if (err == PSA_SUCCESS) {
-        if (its_mblock_validate_header_meta(fs_ctx, &h_meta1,
-                                        ITS_METADATA_BLOCK1) == PSA_SUCCESS) {
+        if (its_mblock_validate_header_meta(fs_ctx, &h_meta1) == PSA_SUCCESS) {
             num_valid_meta_blocks++;
             cur_meta_block = ITS_METADATA_BLOCK1;
         }
@@ -965,8 +1407,19 @@ static psa_status_t its_init_get_active_metablock(
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    fs_ctx->active_metablock = cur_meta_block;
-    fs_ctx->scratch_metablock = ITS_OTHER_META_BLOCK(cur_meta_block);
+    err = its_mblock_load_metablock(fs_ctx,
+              (cur_meta_block == ITS_METADATA_BLOCK0) ? &h_meta0 : &h_meta1,
+              cur_meta_block);
+    if ((err != PSA_SUCCESS) && (num_valid_meta_blocks > 1)) {
+        /* The latest metadata block is corrupted, fall back to the other one */
+        cur_meta_block = ITS_OTHER_META_BLOCK(cur_meta_block);
+        err = its_mblock_load_metablock(fs_ctx,
+                  (cur_meta_block == ITS_METADATA_BLOCK0) ? &h_meta0 : &h_meta1,
+                  cur_meta_block);
+    }
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
 
     return PSA_SUCCESS;
 }
@@ -979,6 +1432,15 @@ psa_status_t its_flash_fs_mblock_cp_file_meta(struct its_flash_fs_ctx_t *fs_ctx,
     size_t pos_start = its_mblock_file_meta_offset(fs_ctx, idx_start);
     size_t pos_end = its_mblock_file_meta_offset(fs_ctx, idx_end);
 
+#if ITS_FILE_INDEX
+    uint32_t i;
+
+    /* The copied entries are not modified by the update */
+    for (i = idx_start; i < idx_end; i++) {
+        fs_ctx->file_index.pending[i] = ITS_FILE_INDEX_UNCHANGED;
+    }
+#endif
+
     /* Copy all data between the two positions from the scratch metadata block
      * to the active metadata block.
      */
@@ -1007,8 +1469,20 @@ psa_status_t its_flash_fs_mblock_get_file_idx_meta(struct its_flash_fs_ctx_t *fs
     psa_status_t err;
     uint32_t i;
     struct its_file_meta_t tmp_metadata;
+#if ITS_FILE_INDEX
+    uint16_t bucket = its_file_index_bucket(fs_ctx, fid);
+
+    if (bucket == ITS_FILE_INDEX_NONE) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
 
+    /* Only the entries in the bucket of the file ID can match it */
+    for (i = fs_ctx->file_index.head[bucket];
+         i != ITS_FILE_INDEX_NONE;
+         i = fs_ctx->file_index.next[i]) {
+#else
     for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+#endif
         err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &tmp_metadata);
         if (err != PSA_SUCCESS) {
             return PSA_ERROR_GENERIC_ERROR;
@@ -1063,26 +1537,32 @@ psa_status_t its_flash_fs_mblock_init(struct its_flash_fs_ctx_t *fs_ctx)
         return err;
     }
 
+    /* The scratch blocks are not erased at this point, but before the first
+     * update, to keep the mount time short.
+     */
+    fs_ctx->scratch_erased = false;
+
     err = its_init_get_active_metablock(fs_ctx);
     if (err != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    err = its_mblock_read_meta_header(fs_ctx);
+    /* Upgrade the metadata header if required. */
+    err = its_mblock_upgrade_meta_header(fs_ctx);
+#if ITS_FILE_INDEX
     if (err != PSA_SUCCESS) {
-        return PSA_ERROR_GENERIC_ERROR;
+        return err;
     }
 
-    /* Erase the other scratch metadata block. It can be used in the later
-     * step.
-     */
-    err = its_mblock_erase_scratch_blocks(fs_ctx);
-    if (err != PSA_SUCCESS) {
-        return PSA_ERROR_GENERIC_ERROR;
+    if (!fs_ctx->file_index.built) {
+        err = its_file_index_build(fs_ctx);
+        if (err != PSA_SUCCESS) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
     }
+#endif
 
-    /* Upgrade the metadata header if required. */
-    return its_mblock_upgrade_meta_header(fs_ctx);
+    return err;
 }
 
 psa_status_t its_flash_fs_mblock_meta_update_finalize(
@@ -1097,18 +1577,56 @@ psa_status_t its_flash_fs_mblock_meta_update_finalize(
     }
 
     /* Commit metadata block modifications to flash */
-    err = fs_ctx->ops->flush(fs_ctx->cfg, fs_ctx->scratch_metablock);
+    err = its_flash_fs_io_flush(fs_ctx, fs_ctx->scratch_metablock);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
     /* Update the running context */
     its_mblock_swap_metablocks(fs_ctx);
+#if ITS_FILE_INDEX
+    its_file_index_commit(fs_ctx);
+#endif
 
+#if ITS_BACKGROUND_MAINTENANCE
+    /* The scratch blocks are erased by the background maintenance, or before
+     * the next update if it has not run.
+     */
+    return PSA_SUCCESS;
+#else
     /* Erase meta block and current scratch block */
+    return its_mblock_erase_scratch_blocks(fs_ctx);
+#endif
+}
+
+psa_status_t its_flash_fs_mblock_erase_scratch(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    if (fs_ctx->scratch_erased) {
+        return PSA_SUCCESS;
+    }
+
     return its_mblock_erase_scratch_blocks(fs_ctx);
 }
 
+psa_status_t its_flash_fs_mblock_prepare_scratch(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    psa_status_t err;
+
+    err = its_flash_fs_mblock_erase_scratch(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* The update writes to the scratch blocks from now on. If it does not
+     * complete, they are erased again before the next update.
+     */
+    fs_ctx->scratch_erased = false;
+
+    return PSA_SUCCESS;
+}
+
 psa_status_t its_flash_fs_mblock_migrate_lb0_data_to_scratch(
                                               struct its_flash_fs_ctx_t *fs_ctx)
 {
@@ -1141,9 +1659,9 @@ psa_status_t its_flash_fs_mblock_read_file_meta(
     size_t offset;
 
     offset = its_mblock_file_meta_offset(fs_ctx, idx);
-    err = fs_ctx->ops->read(fs_ctx->cfg, fs_ctx->active_metablock,
-                            (uint8_t *)file_meta, offset,
-                            ITS_FILE_METADATA_SIZE);
+    err = its_flash_fs_io_read(fs_ctx, fs_ctx->active_metablock,
+                               (uint8_t *)file_meta, offset,
+                               ITS_FILE_METADATA_SIZE);
 
 #if ITS_VALIDATE_METADATA_FROM_FLASH
     if (err == PSA_SUCCESS) {
@@ -1163,9 +1681,9 @@ psa_status_t its_flash_fs_mblock_read_block_metadata(
     size_t pos;
 
     pos = its_mblock_block_meta_offset(lblock);
-    err = fs_ctx->ops->read(fs_ctx->cfg, fs_ctx->active_metablock,
-                            (uint8_t *)block_meta, pos,
-                            ITS_BLOCK_METADATA_SIZE);
+    err = its_flash_fs_io_read(fs_ctx, fs_ctx->active_metablock,
+                               (uint8_t *)block_meta, pos,
+                               ITS_BLOCK_METADATA_SIZE);
 
 #if ITS_VALIDATE_METADATA_FROM_FLASH
     if (err == PSA_SUCCESS) {
@@ -1187,9 +1705,9 @@ psa_status_t its_flash_fs_mblock_read_block_metadata_comp(
     pos = sizeof(struct its_metadata_block_header_comp_t) +
                                              (lblock * ITS_BLOCK_METADATA_SIZE);
 
-    err = fs_ctx->ops->read(fs_ctx->cfg, fs_ctx->active_metablock,
-                            (uint8_t *)block_meta, pos,
-                            ITS_BLOCK_METADATA_SIZE);
+    err = its_flash_fs_io_read(fs_ctx, fs_ctx->active_metablock,
+                               (uint8_t *)block_meta, pos,
+                               ITS_BLOCK_METADATA_SIZE);
 
 #if ITS_VALIDATE_METADATA_FROM_FLASH
     if (err == PSA_SUCCESS) {
@@ -1241,13 +1759,21 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
         metablock_to_erase_first = fs_ctx->scratch_metablock;
     }
 
-    err = fs_ctx->ops->erase(fs_ctx->cfg, metablock_to_erase_first);
+#if ITS_FILE_INDEX
+    /* Entries are indexed as they are written, as all of them are */
+    its_file_index_reset(fs_ctx);
+    fs_ctx->file_index.built = true;
+#endif
+    /* The scratch data block is not erased below */
+    fs_ctx->scratch_erased = false;
+
+    err = its_flash_fs_io_erase(fs_ctx, metablock_to_erase_first);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-    err = fs_ctx->ops->erase(fs_ctx->cfg,
-                             ITS_OTHER_META_BLOCK(metablock_to_erase_first));
+    err = its_flash_fs_io_erase(fs_ctx,
+                                ITS_OTHER_META_BLOCK(metablock_to_erase_first));
     if (err != PSA_SUCCESS) {
         return err;
     }
@@ -1286,8 +1812,8 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
         /* If a flash error is detected, the code erases the rest
          * of the blocks anyway to remove all data stored in them.
          */
-        err |= fs_ctx->ops->erase(fs_ctx->cfg,
-                                  i + its_init_dblock_start(fs_ctx));
+        err |= its_flash_fs_io_erase(fs_ctx,
+                                     i + its_init_dblock_start(fs_ctx));
     }
 
     /* If an error is detected while erasing the flash, then return a
@@ -1324,13 +1850,16 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
     }
 
     /* Commit metadata block modifications to flash */
-    err = fs_ctx->ops->flush(fs_ctx->cfg, fs_ctx->scratch_metablock);
+    err = its_flash_fs_io_flush(fs_ctx, fs_ctx->scratch_metablock);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
     /* Swap active and scratch metablocks */
     its_mblock_swap_metablocks(fs_ctx);
+#if ITS_FILE_INDEX
+    its_file_index_commit(fs_ctx);
+#endif
 
     return PSA_SUCCESS;
 }
@@ -1363,7 +1892,30 @@ psa_status_t its_flash_fs_mblock_update_scratch_block_meta(
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    return its_mblock_copy_remaining_block_meta(fs_ctx, lblock);
+    return its_mblock_copy_remaining_block_meta(fs_ctx, lblock, NULL);
+}
+
+psa_status_t its_flash_fs_mblock_update_scratch_block_meta_lb0(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      uint32_t lblock,
+                                      struct its_block_meta_t *block_meta,
+                                      const struct its_block_meta_t *lb0_meta)
+{
+    struct its_block_meta_t lb0_scratch_meta;
+    psa_status_t err;
+
+    if (lblock == ITS_LOGICAL_DBLOCK0) {
+        lb0_scratch_meta = *lb0_meta;
+        return its_flash_fs_mblock_update_scratch_block_meta(fs_ctx, lblock,
+                                                             &lb0_scratch_meta);
+    }
+
+    err = its_mblock_update_scratch_block_meta(fs_ctx, lblock, block_meta);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return its_mblock_copy_remaining_block_meta(fs_ctx, lblock, lb0_meta);
 }
 
 psa_status_t its_flash_fs_mblock_update_scratch_file_meta(
@@ -1372,12 +1924,34 @@ psa_status_t its_flash_fs_mblock_update_scratch_file_meta(
                                         const struct its_file_meta_t *file_meta)
 {
     size_t pos;
+#if ITS_FILE_INDEX
+    psa_status_t err;
+#endif
 
     /* Calculate the position */
     pos = its_mblock_file_meta_offset(fs_ctx, idx);
-    return fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
-                              (const uint8_t *)file_meta, pos,
-                              ITS_FILE_METADATA_SIZE);
+#if ITS_FILE_INDEX
+    err = its_flash_fs_io_write(fs_ctx, fs_ctx->scratch_metablock,
+                                (const uint8_t *)file_meta, pos,
+                                ITS_FILE_METADATA_SIZE);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Indexed when the scratch metadata block becomes the active one */
+    fs_ctx->file_index.pending[idx] = its_file_index_bucket(fs_ctx,
+                                                            file_meta->id);
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+    fs_ctx->file_index.file_pending_xor[idx] =
+        its_file_index_entry_xor(file_meta, ITS_FILE_METADATA_SIZE);
+#endif
+
+    return PSA_SUCCESS;
+#else
+    return its_flash_fs_io_write(fs_ctx, fs_ctx->scratch_metablock,
+                                 (const uint8_t *)file_meta, pos,
+                                 ITS_FILE_METADATA_SIZE);
+#endif
 }
 
 psa_status_t its_flash_fs_block_to_block_move(struct its_flash_fs_ctx_t *fs_ctx,
@@ -1391,6 +1965,10 @@ psa_status_t its_flash_fs_block_to_block_move(struct its_flash_fs_ctx_t *fs_ctx,
     size_t bytes_to_move;
     uint8_t dst_block_data_copy[ITS_MAX_BLOCK_DATA_COPY];
 
+#if ITS_FLASH_FS_STATS
+    fs_ctx->stats.moved_bytes += size;
+#endif
+
     while (size > 0) {
         /* Calculates the number of bytes to move */
         bytes_to_move = ITS_UTILS_MIN(size, ITS_MAX_BLOCK_DATA_COPY);
@@ -1398,15 +1976,16 @@ psa_status_t its_flash_fs_block_to_block_move(struct its_flash_fs_ctx_t *fs_ctx,
         /* Reads data from source block and store it in the in-memory copy of
          * destination content.
          */
-        status = fs_ctx->ops->read(fs_ctx->cfg, src_block, dst_block_data_copy,
-                                   src_offset, bytes_to_move);
+        status = its_flash_fs_io_read_uncached(fs_ctx, src_block,
+                                               dst_block_data_copy,
+                                               src_offset, bytes_to_move);
         if (status != PSA_SUCCESS) {
             return status;
         }
 
         /* Writes in flash the in-memory block content after modification */
-        status = fs_ctx->ops->write(fs_ctx->cfg, dst_block, dst_block_data_copy,
-                                    dst_offset, bytes_to_move);
+        status = its_flash_fs_io_write(fs_ctx, dst_block, dst_block_data_copy,
+                                       dst_offset, bytes_to_move);
         if (status != PSA_SUCCESS) {
             return status;
         }
@@ -1421,3 +2000,5 @@ psa_status_t its_flash_fs_block_to_block_move(struct its_flash_fs_ctx_t *fs_ctx,
 
     return PSA_SUCCESS;
 }
+
+#endif /* !ITS_FLASH_FS_LOG */
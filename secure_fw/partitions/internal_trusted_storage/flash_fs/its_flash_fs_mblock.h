@@ -12,11 +12,17 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "config_tfm.h"
 #include "flash/its_flash.h"
 #include "its_flash_fs.h"
+#include "its_flash_fs_io.h"
 #include "its_utils.h"
 #include "psa/error.h"
 
+#if ITS_FILE_INDEX && defined(TFM_PARTITION_PROTECTED_STORAGE)
+#include "ps_object_defs.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -26,7 +32,17 @@ extern "C" {
  *
  * \brief Defines the supported version.
  */
-#define ITS_SUPPORTED_VERSION  0x02
+#define ITS_SUPPORTED_VERSION  0x03
+
+/*!
+ * \def ITS_PREVIOUS_SUPPORTED_VERSION
+ *
+ * \brief Defines the previous version, which is upgraded when the filesystem
+ *        is mounted. Its layout is the one of the supported version. With
+ *        ITS_ENCRYPTION, its files are all encrypted as a whole, while the
+ *        supported version may also hold files encrypted in chunks.
+ */
+#define ITS_PREVIOUS_SUPPORTED_VERSION  0x02
 
 /*!
  * \def ITS_BACKWARD_SUPPORTED_VERSION
@@ -179,6 +195,78 @@ struct its_file_meta_t {
 };
 #undef _T3
 
+#if ITS_FILE_INDEX
+/*!
+ * \def ITS_FLASH_FS_MAX_NUM_FILES
+ *
+ * \brief Defines the largest number of files of all the filesystem contexts.
+ *        It dimensions statically the file index of each context.
+ */
+#ifdef TFM_PARTITION_PROTECTED_STORAGE
+#define ITS_FLASH_FS_MAX_NUM_FILES  ITS_UTILS_MAX(ITS_NUM_ASSETS + 1, \
+                                                  PS_MAX_NUM_OBJECTS)
+#else
+#define ITS_FLASH_FS_MAX_NUM_FILES  (ITS_NUM_ASSETS + 1)
+#endif
+
+/*!
+ * \def ITS_FLASH_FS_NUM_BLOCK_SUMMARIES
+ *
+ * \brief Defines the number of logical data blocks, starting from logical
+ *        block 0, whose free size is kept in the file index. The free size of
+ *        the other data blocks is read from flash when reserving a file.
+ */
+#ifndef ITS_FLASH_FS_NUM_BLOCK_SUMMARIES
+#define ITS_FLASH_FS_NUM_BLOCK_SUMMARIES  8
+#endif
+
+/*!
+ * \struct its_file_index_t
+ *
+ * \brief In-RAM index of the metadata stored in the active metadata block.
+ *        The used file metadata entries are chained in buckets selected by a
+ *        hash of their file ID, so that looking up a file only reads from flash
+ *        the entries of one bucket. The free file metadata entries and the free
+ *        size of the data blocks are tracked as well, so that reserving a file
+ *        does not scan the metadata tables in flash.
+ */
+struct its_file_index_t {
+    uint16_t head[ITS_FLASH_FS_MAX_NUM_FILES];    /*!< First entry of each
+                                                   *   bucket
+                                                   */
+    uint16_t next[ITS_FLASH_FS_MAX_NUM_FILES];    /*!< Next entry in the same
+                                                   *   bucket
+                                                   */
+    uint16_t bucket[ITS_FLASH_FS_MAX_NUM_FILES];  /*!< Bucket of each entry */
+    uint16_t pending[ITS_FLASH_FS_MAX_NUM_FILES]; /*!< Bucket of each entry
+                                                   *   written in the scratch
+                                                   *   metadata block
+                                                   */
+    /*! Bitmap of the free entries */
+    uint32_t free_files[(ITS_FLASH_FS_MAX_NUM_FILES + 31) / 32];
+    /*! Free size of the first logical blocks */
+    size_t block_free[ITS_FLASH_FS_NUM_BLOCK_SUMMARIES];
+    /*! Free size of the first logical blocks written in the scratch metadata
+     *  block
+     */
+    size_t block_pending[ITS_FLASH_FS_NUM_BLOCK_SUMMARIES];
+#if ITS_VALIDATE_METADATA_FROM_FLASH
+    /*! XOR of each file metadata entry */
+    uint8_t file_xor[ITS_FLASH_FS_MAX_NUM_FILES];
+    /*! XOR of each file metadata entry written in the scratch metadata block */
+    uint8_t file_pending_xor[ITS_FLASH_FS_MAX_NUM_FILES];
+    /*! XOR of the metadata of the first logical blocks */
+    uint8_t block_xor[ITS_FLASH_FS_NUM_BLOCK_SUMMARIES];
+    /*! XOR of the metadata of the first logical blocks written in the scratch
+     *  metadata block
+     */
+    uint8_t block_pending_xor[ITS_FLASH_FS_NUM_BLOCK_SUMMARIES];
+#endif
+    /*! Whether the index describes the whole active metadata block */
+    bool built;
+};
+#endif /* ITS_FILE_INDEX */
+
 /**
  * \struct its_flash_fs_ctx_t
  *
@@ -192,6 +280,18 @@ struct its_flash_fs_ctx_t {
                                                            */
     uint32_t active_metablock;  /**< Active metadata block */
     uint32_t scratch_metablock; /**< Scratch metadata block */
+    bool scratch_erased;        /**< Whether the scratch blocks are erased */
+#if ITS_FILE_INDEX
+    struct its_file_index_t file_index; /**< File index of the active metadata
+                                         *   block
+                                         */
+#endif
+#if ITS_FLASH_FS_STATS
+    struct its_flash_fs_stats_t stats;  /**< Flash access counters */
+#endif
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    struct its_flash_fs_cache_stats_t cache_stats; /**< Flash cache counters */
+#endif
 };
 
 /**
@@ -203,6 +303,29 @@ struct its_flash_fs_ctx_t {
  */
 psa_status_t its_flash_fs_mblock_init(struct its_flash_fs_ctx_t *fs_ctx);
 
+/**
+ * \brief Erases the scratch blocks, unless they are known to be erased.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_mblock_erase_scratch(
+                                             struct its_flash_fs_ctx_t *fs_ctx);
+
+/**
+ * \brief Prepares the scratch blocks for an update. They are erased if this has
+ *        not been done since the last update or the filesystem was mounted.
+ *
+ * \details It must be called before an update writes to the scratch blocks.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_mblock_prepare_scratch(
+                                             struct its_flash_fs_ctx_t *fs_ctx);
+
 /**
  * \brief Copies the file metadata entries between two indexes from the active
  *        metadata block to the scratch metadata block.
@@ -390,6 +513,26 @@ psa_status_t its_flash_fs_mblock_update_scratch_block_meta(
                                            uint32_t lblock,
                                            struct its_block_meta_t *block_meta);
 
+/**
+ * \brief Puts the metadata of a logical block and of logical block 0 in
+ *        scratch metadata block, for an update which modifies the data of both
+ *        blocks.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     lblock      Logical block number
+ * \param[in]     block_meta  Pointer to block's metadata
+ * \param[in]     lb0_meta    Pointer to logical block 0's metadata. The
+ *                            physical ID of the scratch metadata block is
+ *                            written in place of its physical ID.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_mblock_update_scratch_block_meta_lb0(
+                                     struct its_flash_fs_ctx_t *fs_ctx,
+                                     uint32_t lblock,
+                                     struct its_block_meta_t *block_meta,
+                                     const struct its_block_meta_t *lb0_meta);
+
 /**
  * \brief Writes a file metadata entry into scratch metadata block.
  *
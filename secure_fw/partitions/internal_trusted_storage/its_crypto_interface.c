@@ -16,19 +16,35 @@
 #include "tfm_internal_trusted_storage.h"
 #include "tfm_its_defs.h"
 
+/* The additional data consist of the file id, the flags, the data size of the
+ * file, the index of the chunk and the nonce of the file.
+ */
+#define ITS_ENC_AAD_SIZE (ITS_FILE_ID_SIZE + ITS_FLAG_SIZE + \
+                          ITS_DATA_SIZE_FIELD_SIZE + sizeof(uint32_t) + \
+                          TFM_ITS_ENC_NONCE_LENGTH)
+
+/* The additional data of a file encrypted as a whole consist of the file id,
+ * the flags and the data size of the file.
+ */
+#define ITS_ENC_FILE_AAD_SIZE (ITS_FILE_ID_SIZE + ITS_FLAG_SIZE + \
+                               sizeof(size_t))
+
 /**
  * \brief Fills the AEAD additional data used for the encryption/decryption
  *
  * \details The additional data is not encrypted but its integrity is checked.
- *          For the ITS encryption we use the file id, the file flags and the
- *          data size of the file as additional data.
+ *          For the ITS encryption we use the file id, the file flags, the
+ *          data size of the file, the index of the chunk and the nonce of the
+ *          file as additional data, so that a chunk can neither be moved nor
+ *          mixed with chunks of another file or version of the file.
  *
  * \param[out]  aad       Additional authenticated data
  * \param[in]   aad_size  Additional authenticated data size in bytes
  * \param[in]   fid       Identifier of the file
  * \param[in]   fid_size  Identifier of the file size in bytes
- * \param[in]   flags     Flags of the file
+ * \param[in]   finfo     Information of the file
  * \param[in]   data_size Data size in bytes
+ * \param[in]   chunk_idx Index of the chunk
  *
  * \retval PSA_SUCCESS                On success
  * \retval PSA_ERROR_INVALID_ARGUMENT When the additional data buffer does not
@@ -36,35 +52,37 @@
  *                                    buffers are NULL
  *
  */
-static psa_status_t tfm_its_fill_enc_add(uint8_t *aad,
-                                         const size_t aad_size,
-                                         const uint8_t *fid,
-                                         const size_t fid_size,
-                                         const uint32_t flags,
-                                         const size_t data_size)
+static psa_status_t tfm_its_fill_enc_add(
+                                    uint8_t *aad,
+                                    const size_t aad_size,
+                                    const uint8_t *fid,
+                                    const size_t fid_size,
+                                    const struct its_flash_fs_file_info_t *finfo,
+                                    const size_t data_size,
+                                    const uint32_t chunk_idx)
 
 {
     /* Only the user flags are populated in the function which
      * gets the file info from ITS (see its_flash_fs_file_get_info).
      * We use the same flags for conformity.
      */
-    const uint32_t user_flags = flags & ITS_FLASH_FS_USER_FLAGS_MASK;
+    const uint32_t user_flags = finfo->flags & ITS_FLASH_FS_USER_FLAGS_MASK;
+    const uint32_t size_field = (uint32_t)data_size;
 
-    /* The additional data consist of the file id, the flags and the
-     * data size of the file.
-     */
-    const size_t aad_expected_size =
-      ITS_FILE_ID_SIZE + sizeof(user_flags) + sizeof(data_size);
-
-    if ((aad_size != aad_expected_size) || (aad == NULL) || (fid == NULL)) {
+    if ((aad_size != ITS_ENC_AAD_SIZE) || (aad == NULL) || (fid == NULL) ||
+        (fid_size != ITS_FILE_ID_SIZE)) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
     memcpy(aad, fid, fid_size);
-    memcpy(aad + fid_size, &user_flags, sizeof(user_flags));
-    memcpy(aad + fid_size + sizeof(user_flags),
-               &data_size,
-               sizeof(data_size));
+    aad += fid_size;
+    memcpy(aad, &user_flags, sizeof(user_flags));
+    aad += sizeof(user_flags);
+    memcpy(aad, &size_field, sizeof(size_field));
+    aad += sizeof(size_field);
+    memcpy(aad, &chunk_idx, sizeof(chunk_idx));
+    aad += sizeof(chunk_idx);
+    memcpy(aad, finfo->nonce, sizeof(finfo->nonce));
 
     return PSA_SUCCESS;
 }
@@ -81,82 +99,170 @@ static psa_status_t tfm_hal_to_psa_error(enum tfm_hal_status_t tfm_hal_err)
     }
 }
 
-psa_status_t tfm_its_crypt_file(struct its_flash_fs_file_info_t *finfo,
-                                uint8_t *fid,
-                                const size_t fid_size,
-                                const uint8_t *input,
-                                const size_t input_size,
-                                uint8_t *output,
-                                const size_t output_size,
-                                const bool is_encrypt)
+psa_status_t tfm_its_crypt_file_init(struct its_flash_fs_file_info_t *finfo)
 {
-    struct tfm_hal_its_auth_crypt_ctx aead_ctx = {0};
-    enum tfm_hal_status_t err;
-    size_t file_size;
-
     if (finfo == NULL) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    /* The file size is not known yet when encrypting */
-    if (is_encrypt) {
-        file_size = input_size;
-    } else {
-        file_size = finfo->size_current;
-    }
+    return tfm_hal_to_psa_error(
+        tfm_hal_its_aead_generate_nonce(finfo->nonce, sizeof(finfo->nonce)));
+}
 
-    err =  tfm_its_fill_enc_add(finfo->aad,
-                                sizeof(finfo->aad),
-                                fid,
-                                fid_size,
-                                finfo->flags,
-                                file_size);
-    if (err != TFM_HAL_SUCCESS) {
-        return tfm_hal_to_psa_error(err);
+psa_status_t tfm_its_crypt_chunk(const struct its_flash_fs_file_info_t *finfo,
+                                 uint8_t *fid,
+                                 const size_t fid_size,
+                                 const size_t data_size,
+                                 const uint32_t chunk_idx,
+                                 const uint8_t *input,
+                                 const size_t input_size,
+                                 uint8_t *output,
+                                 const size_t output_size,
+                                 const bool is_encrypt)
+{
+    struct tfm_hal_its_auth_crypt_ctx aead_ctx = {0};
+    uint8_t aad[ITS_ENC_AAD_SIZE];
+    uint8_t nonce[TFM_ITS_ENC_NONCE_LENGTH];
+    uint8_t tag[TFM_ITS_AUTH_TAG_LENGTH];
+    size_t ciphertext_size = 0;
+    psa_status_t status;
+    enum tfm_hal_status_t err;
+
+    if ((finfo == NULL) || (input == NULL) || (output == NULL)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
     }
 
+    /* The encrypted chunk is made of the nonce, the ciphertext and the tag */
     if (is_encrypt) {
-        err = tfm_hal_its_aead_generate_nonce(finfo->nonce,
-                                              sizeof(finfo->nonce));
+        if ((input_size > ITS_ENCRYPTION_CHUNK_SIZE) ||
+            (output_size < ITS_ENC_CHUNK_OVERHEAD + input_size)) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
 
+        err = tfm_hal_its_aead_generate_nonce(nonce, sizeof(nonce));
         if (err != TFM_HAL_SUCCESS) {
             return tfm_hal_to_psa_error(err);
         }
+    } else {
+        if ((input_size < ITS_ENC_CHUNK_OVERHEAD) ||
+            (input_size - ITS_ENC_CHUNK_OVERHEAD > ITS_ENCRYPTION_CHUNK_SIZE) ||
+            (output_size < input_size - ITS_ENC_CHUNK_OVERHEAD)) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        ciphertext_size = input_size - ITS_ENC_CHUNK_OVERHEAD;
+        memcpy(nonce, input, sizeof(nonce));
+        memcpy(tag, input + sizeof(nonce) + ciphertext_size, sizeof(tag));
+    }
+
+    status = tfm_its_fill_enc_add(aad,
+                                  sizeof(aad),
+                                  fid,
+                                  fid_size,
+                                  finfo,
+                                  data_size,
+                                  chunk_idx);
+    if (status != PSA_SUCCESS) {
+        return status;
     }
 
     /* Set all required parameters for the aead operation context */
-    aead_ctx.nonce = finfo->nonce;
-    aead_ctx.nonce_size = sizeof(finfo->nonce);
+    aead_ctx.nonce = nonce;
+    aead_ctx.nonce_size = sizeof(nonce);
     aead_ctx.deriv_label = fid;
     aead_ctx.deriv_label_size = fid_size;
-    aead_ctx.aad = finfo->aad;
-    aead_ctx.aad_size = sizeof(finfo->aad);
-
+    aead_ctx.aad = aad;
+    aead_ctx.aad_size = sizeof(aad);
 
     if (is_encrypt) {
+        /* The platform may write the tag after the ciphertext as well */
         err = tfm_hal_its_aead_encrypt(&aead_ctx,
                                        input,
                                        input_size,
-                                       output,
-                                       output_size,
-                                       finfo->tag,
-                                       sizeof(finfo->tag));
+                                       output + sizeof(nonce),
+                                       input_size + sizeof(tag),
+                                       tag,
+                                       sizeof(tag));
+        if (err == TFM_HAL_SUCCESS) {
+            memcpy(output, nonce, sizeof(nonce));
+            memcpy(output + sizeof(nonce) + input_size, tag, sizeof(tag));
+        }
     } else {
+        /* The platform may copy the tag after the ciphertext, where it is
+         * already.
+         */
         err = tfm_hal_its_aead_decrypt(&aead_ctx,
-                                       input,
-                                       input_size,
-                                       finfo->tag,
-                                       sizeof(finfo->tag),
+                                       input + sizeof(nonce),
+                                       ciphertext_size,
+                                       tag,
+                                       sizeof(tag),
                                        output,
                                        output_size);
     }
 
-    if (err != TFM_HAL_SUCCESS) {
-        return tfm_hal_to_psa_error(err);
+    return tfm_hal_to_psa_error(err);
+}
+
+psa_status_t tfm_its_decrypt_file(const struct its_flash_fs_file_info_t *finfo,
+                                  uint8_t *fid,
+                                  const size_t fid_size,
+                                  uint8_t *buf,
+                                  const size_t data_size)
+{
+    struct tfm_hal_its_auth_crypt_ctx aead_ctx = {0};
+    uint8_t aad[ITS_ENC_FILE_AAD_SIZE];
+    uint8_t nonce[TFM_ITS_ENC_NONCE_LENGTH];
+    uint8_t tag[TFM_ITS_AUTH_TAG_LENGTH];
+    uint32_t user_flags;
+
+    if ((finfo == NULL) || (fid == NULL) || (fid_size != ITS_FILE_ID_SIZE) ||
+        (buf == NULL)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    if (is_encrypt) {
-        finfo->size_max = input_size;
+    /* Only the user flags are authenticated, as for the chunks */
+    user_flags = finfo->flags & ITS_FLASH_FS_USER_FLAGS_MASK;
+
+    memcpy(aad, fid, fid_size);
+    memcpy(aad + fid_size, &user_flags, sizeof(user_flags));
+    memcpy(aad + fid_size + sizeof(user_flags), &data_size, sizeof(data_size));
+    memcpy(nonce, finfo->nonce, sizeof(nonce));
+    memcpy(tag, finfo->tag, sizeof(tag));
+
+    aead_ctx.nonce = nonce;
+    aead_ctx.nonce_size = sizeof(nonce);
+    aead_ctx.deriv_label = fid;
+    aead_ctx.deriv_label_size = fid_size;
+    aead_ctx.aad = aad;
+    aead_ctx.aad_size = sizeof(aad);
+
+    /* The file is decrypted in place. The platform may copy the tag after the
+     * ciphertext, the caller provides room for it.
+     */
+    return tfm_hal_to_psa_error(tfm_hal_its_aead_decrypt(&aead_ctx,
+                                                         buf,
+                                                         data_size,
+                                                         tag,
+                                                         sizeof(tag),
+                                                         buf,
+                                                         data_size));
+}
+
+psa_status_t tfm_its_crypt_data_size(size_t file_size, size_t *data_size)
+{
+    const size_t last_size = file_size % ITS_ENC_CHUNK_STRIDE;
+
+    /* Only the last chunk may be partial, and a file has at least one chunk */
+    if ((file_size == 0) ||
+        ((last_size != 0) &&
+         ((last_size < ITS_ENC_CHUNK_OVERHEAD) ||
+          (last_size > ITS_ENC_CHUNK_OVERHEAD + ITS_ENCRYPTION_CHUNK_SIZE)))) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    *data_size = (file_size / ITS_ENC_CHUNK_STRIDE) * ITS_ENCRYPTION_CHUNK_SIZE;
+    if (last_size != 0) {
+        *data_size += last_size - ITS_ENC_CHUNK_OVERHEAD;
     }
 
     return PSA_SUCCESS;
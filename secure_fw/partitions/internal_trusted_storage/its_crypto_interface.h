@@ -16,27 +16,77 @@
 #include "tfm_its_defs.h"
 
 /**
- * \brief Perform encryption/decryption of the buffer using the
+ * \brief Generate the nonce of a new version of a file. It is authenticated
+ *        with each chunk of the file, so that chunks of different versions of
+ *        the file cannot be mixed.
+ *
+ * \param[out]  finfo         Pointer to \ref its_flash_fs_file_info_t
+ *
+ * \return PSA_SUCCESS on successful operation or a valid PSA error code
+ */
+psa_status_t tfm_its_crypt_file_init(struct its_flash_fs_file_info_t *finfo);
+
+/**
+ * \brief Perform encryption/decryption of a chunk of a file using the
  *        tfm_hal_its APIs
  *
+ * \details The encrypted chunk is made of the nonce, the ciphertext and the
+ *          authentication tag, see \ref ITS_ENC_CHUNK_OVERHEAD.
+ *
  * \param[in]   finfo         Pointer to \ref its_flash_fs_file_info_t
  * \param[in]   fid           File identifier
  * \param[in]   fid_size      File identifier size in bytes
- * \param[in]   input         Input buffer
+ * \param[in]   data_size     Size of the file data in bytes
+ * \param[in]   chunk_idx     Index of the chunk in the file
+ * \param[in]   input         Input buffer, the plaintext or the encrypted chunk
  * \param[in]   input_size    Input size in bytes
- * \param[out]  output        Output buffer
+ * \param[out]  output        Output buffer, the encrypted chunk or the
+ *                            plaintext
  * \param[in]   output_size   Output size in bytes
  * \param[in]   is_encrypt    Set the operation type (encryption/decryption)
  *
  * \return PSA_SUCCESS on successful operation or a valid PSA error code
  *
  */
-psa_status_t tfm_its_crypt_file(struct its_flash_fs_file_info_t *finfo,
-                                uint8_t *fid,
-                                const size_t fid_size,
-                                const uint8_t *input,
-                                const size_t input_size,
-                                uint8_t *output,
-                                const size_t output_size,
-                                const bool is_encrypt);
+psa_status_t tfm_its_crypt_chunk(const struct its_flash_fs_file_info_t *finfo,
+                                 uint8_t *fid,
+                                 const size_t fid_size,
+                                 const size_t data_size,
+                                 const uint32_t chunk_idx,
+                                 const uint8_t *input,
+                                 const size_t input_size,
+                                 uint8_t *output,
+                                 const size_t output_size,
+                                 const bool is_encrypt);
 
+/**
+ * \brief Decrypt a file encrypted as a whole, with the nonce and the
+ *        authentication tag kept in its metadata. Files were encrypted so
+ *        before they were encrypted in chunks.
+ *
+ * \param[in]     finfo      Pointer to \ref its_flash_fs_file_info_t
+ * \param[in]     fid        File identifier
+ * \param[in]     fid_size   File identifier size in bytes
+ * \param[in,out] buf        The ciphertext, decrypted in place. It must have
+ *                           room for the tag after the ciphertext.
+ * \param[in]     data_size  Size of the file data in bytes
+ *
+ * \return PSA_SUCCESS on successful operation or a valid PSA error code
+ */
+psa_status_t tfm_its_decrypt_file(const struct its_flash_fs_file_info_t *finfo,
+                                  uint8_t *fid,
+                                  const size_t fid_size,
+                                  uint8_t *buf,
+                                  const size_t data_size);
+
+/**
+ * \brief Get the size of the data of an encrypted file from its size in the
+ *        filesystem.
+ *
+ * \param[in]   file_size     Size of the file in the filesystem in bytes
+ * \param[out]  data_size     Size of the file data in bytes
+ *
+ * \retval PSA_SUCCESS             On success
+ * \retval PSA_ERROR_DATA_CORRUPT  The size is not the size of an encrypted file
+ */
+psa_status_t tfm_its_crypt_data_size(size_t file_size, size_t *data_size);
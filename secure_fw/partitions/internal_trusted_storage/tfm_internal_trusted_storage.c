@@ -43,12 +43,17 @@ static struct its_flash_fs_file_info_t g_file_info;
  * Note: size must be aligned to the max flash program unit to meet the
  * alignment requirement of the filesystem.
  */
-#ifndef ITS_ENCRYPTION
-static uint8_t __ALIGNED(4) asset_data[ITS_UTILS_ALIGN(ITS_BUF_SIZE,
+#if defined(ITS_ENCRYPTION) && !defined(TFM_PARTITION_PROTECTED_STORAGE)
+/* Only the plaintext of one chunk is buffered when encryption is enabled */
+static uint8_t __ALIGNED(4) asset_data[ITS_ENCRYPTION_CHUNK_SIZE];
+#elif defined(ITS_ENCRYPTION)
+static uint8_t __ALIGNED(4) asset_data[ITS_UTILS_ALIGN(
+                                          ITS_UTILS_MAX(ITS_BUF_SIZE,
+                                                 ITS_ENCRYPTION_CHUNK_SIZE),
                                           ITS_FLASH_MAX_ALIGNMENT)];
 #else
-static uint8_t __ALIGNED(4) asset_data[ITS_UTILS_ALIGN(ITS_MAX_ASSET_SIZE,
-                                              ITS_FLASH_MAX_ALIGNMENT)];
+static uint8_t __ALIGNED(4) asset_data[ITS_UTILS_ALIGN(ITS_BUF_SIZE,
+                                          ITS_FLASH_MAX_ALIGNMENT)];
 #endif
 
 #ifdef TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
@@ -56,7 +61,12 @@ static struct its_flash_fs_ctx_t fs_ctx_its;
 static struct its_flash_fs_config_t fs_cfg_its = {
     .flash_dev = &ITS_FLASH_DEV,
     .program_unit = ITS_FLASH_ALIGNMENT,
+#ifdef ITS_ENCRYPTION
+    .max_file_size = ITS_UTILS_ALIGN(ITS_ENC_FILE_SIZE(ITS_MAX_ASSET_SIZE),
+                                     ITS_FLASH_ALIGNMENT),
+#else
     .max_file_size = ITS_UTILS_ALIGN(ITS_MAX_ASSET_SIZE, ITS_FLASH_ALIGNMENT),
+#endif
     .max_num_files = ITS_NUM_ASSETS + 1, /* Extra file for atomic replacement */
 };
 #endif /* TFM_PARTITION_INTERNAL_TRUSTED_STORAGE */
@@ -86,58 +96,94 @@ static struct its_flash_fs_ctx_t *get_fs_ctx(int32_t client_id)
 #endif
 }
 
+#if ITS_TRANSACTION && defined(TFM_PARTITION_INTERNAL_TRUSTED_STORAGE)
+/* Transaction of the service. A single one is held, for the client which
+ * started it, until it is committed or aborted.
+ */
+static struct its_flash_fs_txn_t g_txn;
+static int32_t g_txn_client_id;
+
+/* Set while tfm_its_set() stages the file in the transaction */
+static bool g_txn_staging;
+#endif
+
 #ifdef ITS_ENCRYPTION
-/* Buffer to store the encrypted asset data and the authentication tag before it
- * is stored in the filesystem.
+#if (PSA_FRAMEWORK_HAS_MM_IOVEC == 1) && \
+    defined(TFM_PARTITION_INTERNAL_TRUSTED_STORAGE)
+#error "ITS_ENCRYPTION is not supported with PSA_FRAMEWORK_HAS_MM_IOVEC"
+#endif
+
+/* Set in the flags of the files encrypted in chunks. The files written before
+ * are encrypted as a whole, with the tag in their metadata. The flag is stored
+ * and authenticated with the flags of the caller, but not returned to it.
  */
-static uint8_t __ALIGNED(4) enc_asset_data[ITS_UTILS_ALIGN(ITS_MAX_ASSET_SIZE +
-                                           TFM_ITS_AUTH_TAG_LENGTH,
-                                           ITS_FLASH_MAX_ALIGNMENT)];
+#define ITS_FLAG_ENC_CHUNKS (1UL << 15)
 
-static psa_status_t buffer_size_check(int32_t client_id, size_t buffer_size)
+/* Buffer to store the encrypted chunks of an asset, each one with its nonce
+ * and authentication tag. It holds the largest asset, so that a set writes the
+ * file in one operation of the filesystem and stays atomic. It also has room
+ * for the tag after the data of a file encrypted as a whole.
+ */
+static uint8_t __ALIGNED(4) enc_asset_data[ITS_UTILS_ALIGN(
+                                     ITS_ENC_FILE_SIZE(ITS_MAX_ASSET_SIZE),
+                                     ITS_FLASH_MAX_ALIGNMENT)];
+
+static bool is_encrypted(int32_t client_id)
 {
 /* With protected storage no encryption is used */
 #ifdef TFM_PARTITION_PROTECTED_STORAGE
-    if (client_id != TFM_SP_PS) {
+    return client_id != TFM_SP_PS;
 #else
-    {
+    (void)client_id;
+    return true;
 #endif /* TFM_PARTITION_PROTECTED_STORAGE */
-        /* When encryption is enabled the whole file needs to fit in the
-         * global buffer.
-         */
-        if (buffer_size > ITS_MAX_ASSET_SIZE) {
-            return PSA_ERROR_INVALID_ARGUMENT;
-        }
+}
+
+static psa_status_t buffer_size_check(int32_t client_id, size_t buffer_size)
+{
+    /* The size of an encrypted file in the filesystem is only bounded for
+     * assets of up to the maximum asset size.
+     */
+    if (is_encrypted(client_id) && (buffer_size > ITS_MAX_ASSET_SIZE)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
     }
     return PSA_SUCCESS;
 }
 
-static psa_status_t tfm_its_crypt_data(
-    uint8_t **input,
-    size_t input_size,
-    size_t offset)
+/**
+ * \brief Reads a part of a file encrypted as a whole. The whole file is read
+ *        and decrypted, then the requested part is written to the caller.
+ */
+static psa_status_t tfm_its_get_encrypted_file(int32_t client_id,
+                                               size_t data_offset,
+                                               size_t data_size,
+                                               size_t *p_data_length)
 {
     psa_status_t status;
+    const size_t asset_size = g_file_info.size_current;
 
-    if (offset != 0) {
-        /* If the data will be encrypted the whole file needs to be written */
-        return PSA_ERROR_INVALID_ARGUMENT;
+    if (asset_size > ITS_MAX_ASSET_SIZE) {
+        *p_data_length = 0;
+        return PSA_ERROR_DATA_CORRUPT;
     }
 
-    status = tfm_its_crypt_file(&g_file_info,
-                                g_fid,
-                                sizeof(g_fid),
-                                *input,
-                                input_size,
-                                enc_asset_data,
-                                sizeof(enc_asset_data),
-                                true);
-    if (status != PSA_SUCCESS) {
-        return status;
+    status = its_flash_fs_file_read(get_fs_ctx(client_id), g_fid, asset_size,
+                                    0, enc_asset_data);
+    if (status == PSA_SUCCESS) {
+        status = tfm_its_decrypt_file(&g_file_info, g_fid, sizeof(g_fid),
+                                      enc_asset_data, asset_size);
     }
 
-    *input = enc_asset_data;
-    return PSA_SUCCESS;
+    if (status == PSA_SUCCESS) {
+        its_req_mngr_write(enc_asset_data + data_offset, data_size);
+    } else {
+        *p_data_length = 0;
+    }
+
+    /* Do not leave the plaintext of the asset in the buffer */
+    (void)memset(enc_asset_data, 0, asset_size);
+
+    return status;
 }
 
 static psa_status_t tfm_its_get_encrypted(int32_t client_id,
@@ -146,43 +192,72 @@ static psa_status_t tfm_its_get_encrypted(int32_t client_id,
                          size_t *p_data_length)
 {
     psa_status_t status;
+    const size_t asset_size = g_file_info.size_current;
+    uint32_t chunk_idx = data_offset / ITS_ENCRYPTION_CHUNK_SIZE;
+    size_t chunk_offset = data_offset % ITS_ENCRYPTION_CHUNK_SIZE;
+    size_t num_chunks;
+    size_t chunk_size;
+    size_t read_size;
+    size_t i;
 
-    if (g_file_info.size_max > sizeof(enc_asset_data)) {
-            return PSA_ERROR_BUFFER_TOO_SMALL;
+    if (data_size == 0) {
+        return PSA_SUCCESS;
     }
 
-    /* When encryption is enabled we need to read the whole file */
+    if ((g_file_info.flags & ITS_FLAG_ENC_CHUNKS) == 0) {
+        return tfm_its_get_encrypted_file(client_id, data_offset, data_size,
+                                          p_data_length);
+    }
+
+    /* Read the chunks covering the requested data from the filesystem, up to
+     * the end of the last one or of the file.
+     */
+    num_chunks = (chunk_offset + data_size + ITS_ENCRYPTION_CHUNK_SIZE - 1) /
+                 ITS_ENCRYPTION_CHUNK_SIZE;
+    read_size = ITS_ENC_FILE_SIZE(ITS_UTILS_MIN(asset_size,
+                                  (chunk_idx + num_chunks) *
+                                  ITS_ENCRYPTION_CHUNK_SIZE)) -
+                chunk_idx * ITS_ENC_CHUNK_STRIDE;
+
     status = its_flash_fs_file_read(get_fs_ctx(client_id),
                                     g_fid,
-                                    g_file_info.size_current,
-                                    0,
+                                    read_size,
+                                    chunk_idx * ITS_ENC_CHUNK_STRIDE,
                                     enc_asset_data);
     if (status != PSA_SUCCESS) {
         *p_data_length = 0;
         return status;
     }
 
-    status = tfm_its_crypt_file(&g_file_info,
-                                g_fid,
-                                sizeof(g_fid),
-                                enc_asset_data,
-                                g_file_info.size_current,
-                                asset_data,
-                                sizeof(asset_data),
-                                false);
-    if (status != PSA_SUCCESS) {
-        *p_data_length = 0;
-        return status;
-    }
+    /* Decrypt them one by one and write the requested part to the caller */
+    for (i = 0; i < num_chunks; i++) {
+        chunk_size = ITS_UTILS_MIN(asset_size -
+                                   chunk_idx * ITS_ENCRYPTION_CHUNK_SIZE,
+                                   ITS_ENCRYPTION_CHUNK_SIZE);
+
+        status = tfm_its_crypt_chunk(&g_file_info,
+                                     g_fid,
+                                     sizeof(g_fid),
+                                     asset_size,
+                                     chunk_idx,
+                                     enc_asset_data + i * ITS_ENC_CHUNK_STRIDE,
+                                     ITS_ENC_CHUNK_OVERHEAD + chunk_size,
+                                     asset_data,
+                                     sizeof(asset_data),
+                                     false);
+        if (status != PSA_SUCCESS) {
+            *p_data_length = 0;
+            return status;
+        }
 
-    #if (PSA_FRAMEWORK_HAS_MM_IOVEC == 1) /* PSA_FRAMEWORK_HAS_MM_IOVEC */
-    memcpy(its_req_mngr_get_vec_base(), asset_data + data_offset, data_size);
-    #else
-    /* Write asset data to the caller in one go as due to buffer check before
-     * it is ensured that all data fit into asset_data
-     */
-    its_req_mngr_write(asset_data + data_offset, data_size);
-    #endif /* PSA_FRAMEWORK_HAS_MM_IOVEC */
+        /* Write asset data to the caller */
+        chunk_size = ITS_UTILS_MIN(chunk_size - chunk_offset, data_size);
+        its_req_mngr_write(asset_data + chunk_offset, chunk_size);
+
+        data_size -= chunk_size;
+        chunk_offset = 0;
+        chunk_idx++;
+    }
 
     return PSA_SUCCESS;
 }
@@ -387,6 +462,28 @@ static psa_status_t get_file_info(psa_storage_uid_t uid, int32_t client_id)
                                       &g_file_info);
 }
 
+/**
+ * \brief Reads the file info of an asset, with the size of the file replaced
+ *        by the size of the asset data.
+ */
+static psa_status_t get_asset_info(psa_storage_uid_t uid, int32_t client_id)
+{
+    psa_status_t status;
+
+    status = get_file_info(uid, client_id);
+
+#if defined ITS_ENCRYPTION && defined TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
+    /* A file encrypted as a whole has the size of its data */
+    if ((status == PSA_SUCCESS) && is_encrypted(client_id) &&
+        ((g_file_info.flags & ITS_FLAG_ENC_CHUNKS) != 0)) {
+        status = tfm_its_crypt_data_size(g_file_info.size_current,
+                                         &g_file_info.size_current);
+    }
+#endif
+
+    return status;
+}
+
 
 static psa_status_t tfm_its_write_data_to_fs(const int32_t client_id,
                                      const uint8_t *fid,
@@ -395,45 +492,21 @@ static psa_status_t tfm_its_write_data_to_fs(const int32_t client_id,
                                      uint8_t *data)
 {
     psa_status_t status;
-    uint8_t *buffer_ptr = data;
-    struct its_flash_fs_ctx_t *fs_ctx = get_fs_ctx(client_id);
 
-#ifdef ITS_ENCRYPTION /* ITS_ENCRYPTION */
-
-#ifdef TFM_PARTITION_PROTECTED_STORAGE
-    if (client_id == TFM_SP_PS) {
-        status = PSA_SUCCESS;
-    } else {
-        status = tfm_its_crypt_data(&buffer_ptr, data_size, offset);
+#if ITS_TRANSACTION && defined(TFM_PARTITION_INTERNAL_TRUSTED_STORAGE)
+    if (g_txn_staging) {
+        return its_flash_fs_txn_write(&g_txn, fid, &g_file_info, data_size,
+                                      offset, data);
     }
-#else
-    status = tfm_its_crypt_data(&buffer_ptr, data_size, offset);
 #endif
 
-    if (status != PSA_SUCCESS) {
-        return status;
-    }
-
-    if (buffer_ptr == enc_asset_data) {
-        /*
-         * Zero the tail of enc_asset_data, the tag is preserved in the file
-         * info.
-         */
-        (void)memset(
-            enc_asset_data + data_size,
-            0,
-            ITS_UTILS_ALIGN(data_size, fs_ctx->cfg->program_unit) - data_size);
-    }
-
-#endif /* ITS_ENCRYPTION */
-
     status = its_flash_fs_file_write(
-        fs_ctx,
+        get_fs_ctx(client_id),
         fid,
         &g_file_info,
         data_size,
         offset,
-        buffer_ptr);
+        data);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -464,6 +537,83 @@ static void zeroize_excess_asset_data(
 }
 #endif
 
+#if defined ITS_ENCRYPTION && defined TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
+static psa_status_t tfm_its_set_encrypted(int32_t client_id,
+                                          size_t data_length)
+{
+    psa_status_t status;
+    const size_t asset_size = data_length;
+    const size_t file_size = ITS_ENC_FILE_SIZE(asset_size);
+    size_t chunk_size;
+    size_t offset = 0;
+    uint32_t chunk_idx = 0;
+
+    g_file_info.flags |= ITS_FLAG_ENC_CHUNKS;
+    (void)memset(g_file_info.tag, 0, sizeof(g_file_info.tag));
+
+    status = tfm_its_crypt_file_init(&g_file_info);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    g_file_info.size_max = file_size;
+
+    /* Iteratively read the data from the caller and encrypt it chunk by chunk
+     * into the buffer, which holds the whole file.
+     */
+    do {
+        chunk_size = ITS_UTILS_MIN(data_length, ITS_ENCRYPTION_CHUNK_SIZE);
+
+        /* Read asset data from the caller */
+        (void)its_req_mngr_read(asset_data, chunk_size);
+
+        status = tfm_its_crypt_chunk(&g_file_info,
+                                     g_fid,
+                                     sizeof(g_fid),
+                                     asset_size,
+                                     chunk_idx,
+                                     asset_data,
+                                     chunk_size,
+                                     enc_asset_data + offset,
+                                     sizeof(enc_asset_data) - offset,
+                                     true);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        data_length -= chunk_size;
+        chunk_idx++;
+
+        if (data_length > 0) {
+            /* Zero the padding of a full chunk up to the next one */
+            (void)memset(enc_asset_data + offset + ITS_ENC_CHUNK_OVERHEAD +
+                         chunk_size,
+                         0,
+                         ITS_ENC_CHUNK_STRIDE - ITS_ENC_CHUNK_OVERHEAD -
+                         chunk_size);
+            offset += ITS_ENC_CHUNK_STRIDE;
+        }
+    } while (data_length > 0);
+
+    /* Zero the tail of the last chunk, the filesystem may align up the size
+     * written to the flash program unit.
+     */
+    (void)memset(enc_asset_data + file_size,
+                 0,
+                 ITS_UTILS_ALIGN(file_size, ITS_FLASH_MAX_ALIGNMENT) -
+                 file_size);
+
+    /* The whole file is written in one operation, so that the asset is
+     * replaced atomically.
+     */
+    return tfm_its_write_data_to_fs(client_id,
+                                    g_fid,
+                                    file_size,
+                                    0,
+                                    enc_asset_data);
+}
+#endif /* ITS_ENCRYPTION && TFM_PARTITION_INTERNAL_TRUSTED_STORAGE */
+
 psa_status_t tfm_its_set(int32_t client_id,
                          psa_storage_uid_t uid,
                          size_t data_length,
@@ -629,6 +779,12 @@ psa_status_t tfm_its_set(int32_t client_id,
 #endif /* ITS_FLASH_MAX_ALIGNMENT */
 
 #else
+#ifdef ITS_ENCRYPTION
+    if (is_encrypted(client_id)) {
+        return tfm_its_set_encrypted(client_id, data_length);
+    }
+#endif /* ITS_ENCRYPTION */
+
     offset = 0;
 
     /* Iteratively read data from the caller and write it to the filesystem, in
@@ -748,15 +904,8 @@ psa_status_t tfm_its_get(int32_t client_id,
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-#if defined ITS_ENCRYPTION && defined TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
-    status = buffer_size_check(client_id, data_offset + data_size);
-    if (status != PSA_SUCCESS) {
-        return status;
-    }
-#endif /* ITS_ENCRYPTION && TFM_PARTITION_INTERNAL_TRUSTED_STORAGE */
-
     /* Read file info */
-    status = get_file_info(uid, client_id);
+    status = get_asset_info(uid, client_id);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -796,7 +945,7 @@ psa_status_t tfm_its_get_info(int32_t client_id, psa_storage_uid_t uid,
     psa_status_t status;
 
     /* Validate and read file info */
-    status = get_file_info(uid, client_id);
+    status = get_asset_info(uid, client_id);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -804,7 +953,11 @@ psa_status_t tfm_its_get_info(int32_t client_id, psa_storage_uid_t uid,
     /* Copy file info to the PSA info struct */
     p_info->capacity = g_file_info.size_current;
     p_info->size = g_file_info.size_current;
+#if defined ITS_ENCRYPTION && defined TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
+    p_info->flags = g_file_info.flags & ~ITS_FLAG_ENC_CHUNKS;
+#else
     p_info->flags = g_file_info.flags;
+#endif
 
     return PSA_SUCCESS;
 }
@@ -838,3 +991,221 @@ psa_status_t tfm_its_remove(int32_t client_id, psa_storage_uid_t uid)
     /* Delete old file from the persistent area */
     return its_flash_fs_file_delete(get_fs_ctx(client_id), g_fid);
 }
+
+#if ITS_TRANSACTION && defined(TFM_PARTITION_INTERNAL_TRUSTED_STORAGE)
+static psa_status_t check_txn_client(int32_t client_id)
+{
+    if (client_id < 0) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    if ((g_txn.fs_ctx == NULL) || (g_txn_client_id != client_id)) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/* Checks that no write of the file in g_fid with the write once flag is
+ * staged in the transaction.
+ */
+static psa_status_t check_txn_write_once(void)
+{
+    struct its_flash_fs_file_info_t info;
+
+    if ((its_flash_fs_txn_get_info(&g_txn, g_fid, &info) == PSA_SUCCESS) &&
+        (info.flags & PSA_STORAGE_FLAG_WRITE_ONCE)) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_txn_begin(int32_t client_id)
+{
+    /* A non-secure client could keep the single transaction of the service
+     * open forever, so transactions are only given to secure partitions
+     */
+    if (client_id < 0) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    /* The transaction of another client must not be discarded */
+    if ((g_txn.fs_ctx != NULL) && (g_txn_client_id != client_id)) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    its_flash_fs_txn_begin(get_fs_ctx(client_id), &g_txn);
+    g_txn_client_id = client_id;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_txn_set(int32_t client_id,
+                             psa_storage_uid_t uid,
+                             size_t data_length,
+                             psa_storage_create_flags_t create_flags)
+{
+    psa_status_t status;
+
+    status = check_txn_client(client_id);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* A write once file may have been staged earlier in the transaction */
+    status = get_file_info(uid, client_id);
+    if ((status != PSA_SUCCESS) && (status != PSA_ERROR_DOES_NOT_EXIST)) {
+        return status;
+    }
+
+    status = check_txn_write_once();
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* Same checks and data path as a set, the file is written to the
+     * transaction instead of the filesystem.
+     */
+    g_txn_staging = true;
+    status = tfm_its_set(client_id, uid, data_length, create_flags);
+    g_txn_staging = false;
+
+    return status;
+}
+
+psa_status_t tfm_its_txn_remove(int32_t client_id, psa_storage_uid_t uid)
+{
+    psa_status_t status;
+
+    status = check_txn_client(client_id);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* The file may only exist in the transaction */
+    status = get_file_info(uid, client_id);
+    if (status == PSA_SUCCESS) {
+        /* If the object exists and has the write once flag set, then it
+         * cannot be deleted.
+         */
+        if (g_file_info.flags & PSA_STORAGE_FLAG_WRITE_ONCE) {
+            return PSA_ERROR_NOT_PERMITTED;
+        }
+    } else if (status != PSA_ERROR_DOES_NOT_EXIST) {
+        return status;
+    }
+
+    status = check_txn_write_once();
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    return its_flash_fs_txn_delete(&g_txn, g_fid);
+}
+
+psa_status_t tfm_its_txn_commit(int32_t client_id)
+{
+    psa_status_t status;
+    uint32_t i;
+
+    status = check_txn_client(client_id);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* The client may have created write once objects outside of the
+     * transaction since they were staged. Within the transaction, a write
+     * once object cannot be staged again nor removed once it is staged.
+     */
+    for (i = 0; i < g_txn.num_ops; i++) {
+        status = its_flash_fs_file_get_info(g_txn.fs_ctx, g_txn.ops[i].fid,
+                                            &g_file_info);
+        if ((status == PSA_SUCCESS) &&
+            (g_file_info.flags & PSA_STORAGE_FLAG_WRITE_ONCE)) {
+            its_flash_fs_txn_abort(&g_txn);
+            return PSA_ERROR_NOT_PERMITTED;
+        }
+    }
+
+    return its_flash_fs_txn_commit(&g_txn);
+}
+
+psa_status_t tfm_its_txn_abort(int32_t client_id)
+{
+    psa_status_t status;
+
+    status = check_txn_client(client_id);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    its_flash_fs_txn_abort(&g_txn);
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_TRANSACTION && TFM_PARTITION_INTERNAL_TRUSTED_STORAGE */
+
+#if ITS_FLASH_FS_STATS
+psa_status_t tfm_its_get_fs_stats(int32_t client_id,
+                                  struct tfm_its_stats_t *stats,
+                                  const uint32_t **block_erases)
+{
+    struct its_flash_fs_ctx_t *fs_ctx = get_fs_ctx(client_id);
+    const struct its_flash_fs_stats_t *fs_stats;
+
+    fs_stats = its_flash_fs_get_stats(fs_ctx);
+
+    stats->num_blocks = fs_ctx->cfg->num_blocks;
+    stats->num_counted_blocks = ITS_UTILS_MIN(fs_ctx->cfg->num_blocks,
+                                              ITS_FLASH_FS_STATS_MAX_BLOCKS);
+    stats->read_bytes = fs_stats->read_bytes;
+    stats->prog_bytes = fs_stats->prog_bytes;
+    stats->user_bytes = fs_stats->user_bytes;
+    stats->moved_bytes = fs_stats->moved_bytes;
+    stats->erases = fs_stats->erases;
+    stats->metablock_swaps = fs_stats->metablock_swaps;
+    stats->compactions = fs_stats->compactions;
+    *block_erases = fs_stats->block_erases;
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_FLASH_FS_STATS */
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+psa_status_t tfm_its_get_fs_cache_stats(int32_t client_id,
+                                        struct tfm_its_cache_stats_t *stats)
+{
+    struct its_flash_fs_ctx_t *fs_ctx = get_fs_ctx(client_id);
+    const struct its_flash_fs_cache_stats_t *cache_stats;
+
+    cache_stats = its_flash_fs_get_cache_stats(fs_ctx);
+
+    stats->capacity = ITS_FLASH_FS_CACHE_SIZE;
+    stats->line_size = ITS_FLASH_FS_CACHE_LINE_SIZE;
+    stats->num_lines = its_flash_fs_io_cache_lines(fs_ctx);
+    stats->hits = cache_stats->hits;
+    stats->misses = cache_stats->misses;
+    stats->bypasses = cache_stats->bypasses;
+    stats->evictions = cache_stats->evictions;
+    stats->invalidations = cache_stats->invalidations;
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_FLASH_FS_CACHE_SIZE != 0 */
+
+#if ITS_BACKGROUND_MAINTENANCE && defined(TFM_PARTITION_INTERNAL_TRUSTED_STORAGE)
+psa_status_t tfm_its_maintain_fs(void)
+{
+    psa_status_t status;
+
+    status = its_flash_fs_maintain(&fs_ctx_its);
+#ifdef TFM_PARTITION_PROTECTED_STORAGE
+    if (status == PSA_SUCCESS) {
+        status = its_flash_fs_maintain(&fs_ctx_ps);
+    }
+#endif
+
+    return status;
+}
+#endif /* ITS_BACKGROUND_MAINTENANCE && TFM_PARTITION_INTERNAL_TRUSTED_STORAGE */
@@ -17,6 +17,7 @@
 
 #include "flash_fs/its_flash_fs.h"
 #include "its_utils.h"
+#include "tfm_its_api.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -163,6 +164,108 @@ psa_status_t tfm_its_get_info(int32_t client_id, psa_storage_uid_t uid,
  */
 psa_status_t tfm_its_remove(int32_t client_id, psa_storage_uid_t uid);
 
+#if ITS_TRANSACTION
+/**
+ * \brief Starts a transaction for the client. Any transaction of the client in
+ *        progress is discarded, as the service holds a single one.
+ *
+ * \param[in] client_id  Identifier of the client
+ *
+ * \return A status indicating the success/failure of the operation.
+ *         PSA_ERROR_NOT_PERMITTED is returned to a non-secure client, and
+ *         PSA_ERROR_BAD_STATE if another client has a transaction in progress.
+ */
+psa_status_t tfm_its_txn_begin(int32_t client_id);
+
+/**
+ * \brief Stages a set of a uid/value pair in the transaction of the client.
+ *
+ * \param[in] client_id     Identifier of the asset's owner (client)
+ * \param[in] uid           The identifier for the data
+ * \param[in] data_length   The size in bytes of the data in `p_data`
+ * \param[in] create_flags  The flags that the data will be stored with
+ *
+ * \return A status indicating the success/failure of the operation, as for
+ *         \ref tfm_its_set. PSA_ERROR_BAD_STATE is returned if the client has
+ *         no transaction in progress.
+ */
+psa_status_t tfm_its_txn_set(int32_t client_id,
+                             psa_storage_uid_t uid,
+                             size_t data_length,
+                             psa_storage_create_flags_t create_flags);
+
+/**
+ * \brief Stages a removal of a uid in the transaction of the client.
+ *
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ * \param[in] uid        The `uid` value
+ *
+ * \return A status indicating the success/failure of the operation, as for
+ *         \ref tfm_its_remove. PSA_ERROR_BAD_STATE is returned if the client
+ *         has no transaction in progress.
+ */
+psa_status_t tfm_its_txn_remove(int32_t client_id, psa_storage_uid_t uid);
+
+/**
+ * \brief Commits the transaction of the client with a single filesystem
+ *        update, and ends it.
+ *
+ * \param[in] client_id  Identifier of the client
+ *
+ * \return A status indicating the success/failure of the operation
+ */
+psa_status_t tfm_its_txn_commit(int32_t client_id);
+
+/**
+ * \brief Ends the transaction of the client without committing it.
+ *
+ * \param[in] client_id  Identifier of the client
+ *
+ * \return A status indicating the success/failure of the operation
+ */
+psa_status_t tfm_its_txn_abort(int32_t client_id);
+#endif /* ITS_TRANSACTION */
+
+#if ITS_FLASH_FS_STATS
+/**
+ * \brief Gets the flash access counters of the filesystem used by the client.
+ *
+ * \param[in]  client_id     Identifier of the client
+ * \param[out] stats         Counters of the filesystem
+ * \param[out] block_erases  Set to the erase counters of the first
+ *                           stats->num_counted_blocks blocks
+ *
+ * \return A status indicating the success/failure of the operation
+ */
+psa_status_t tfm_its_get_fs_stats(int32_t client_id,
+                                  struct tfm_its_stats_t *stats,
+                                  const uint32_t **block_erases);
+#endif /* ITS_FLASH_FS_STATS */
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+/**
+ * \brief Gets the counters of the flash cache for the filesystem used by the
+ *        client.
+ *
+ * \param[in]  client_id  Identifier of the client
+ * \param[out] stats      Counters of the cache
+ *
+ * \return A status indicating the success/failure of the operation
+ */
+psa_status_t tfm_its_get_fs_cache_stats(int32_t client_id,
+                                        struct tfm_its_cache_stats_t *stats);
+#endif /* ITS_FLASH_FS_CACHE_SIZE != 0 */
+
+#if ITS_BACKGROUND_MAINTENANCE
+/**
+ * \brief Performs the background maintenance of the filesystems of the
+ *        service.
+ *
+ * \return A status indicating the success/failure of the operation
+ */
+psa_status_t tfm_its_maintain_fs(void);
+#endif /* ITS_BACKGROUND_MAINTENANCE */
+
 #ifdef __cplusplus
 }
 #endif
@@ -58,7 +58,15 @@ static psa_status_t tfm_its_set_req(const psa_msg_t *msg)
 #else
     handle = msg->handle;
 #endif
-    status = tfm_its_set(msg->client_id, uid, data_length, create_flags);
+#if ITS_TRANSACTION
+    if (msg->type == TFM_ITS_TXN_SET) {
+        status = tfm_its_txn_set(msg->client_id, uid, data_length,
+                                 create_flags);
+    } else
+#endif
+    {
+        status = tfm_its_set(msg->client_id, uid, data_length, create_flags);
+    }
 
 #if PSA_FRAMEWORK_HAS_MM_IOVEC == 1
     if (data_length > 0) {
@@ -153,9 +161,81 @@ static psa_status_t tfm_its_remove_req(const psa_msg_t *msg)
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
+#if ITS_TRANSACTION
+    if (msg->type == TFM_ITS_TXN_REMOVE) {
+        return tfm_its_txn_remove(msg->client_id, uid);
+    }
+#endif
+
     return tfm_its_remove(msg->client_id, uid);
 }
 
+#if ITS_FLASH_FS_STATS
+static psa_status_t tfm_its_get_stats_req(const psa_msg_t *msg)
+{
+    struct tfm_its_stats_t stats;
+    const uint32_t *block_erases;
+    size_t erases_size;
+    psa_status_t status;
+
+    /* The counters reveal the accesses made for all the clients, so they are
+     * only given to secure partitions
+     */
+    if (msg->client_id < 0) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    if (msg->out_size[0] != sizeof(stats)) {
+        /* The output argument size is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    status = tfm_its_get_fs_stats(msg->client_id, &stats, &block_erases);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    psa_write(msg->handle, 0, &stats, sizeof(stats));
+
+    erases_size = ITS_UTILS_MIN(msg->out_size[1],
+                                stats.num_counted_blocks * sizeof(uint32_t));
+    if (erases_size > 0) {
+        psa_write(msg->handle, 1, block_erases, erases_size);
+    }
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_FLASH_FS_STATS */
+
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+static psa_status_t tfm_its_get_cache_stats_req(const psa_msg_t *msg)
+{
+    struct tfm_its_cache_stats_t stats;
+    psa_status_t status;
+
+    /* The counters reveal the reads made for all the clients, so they are
+     * only given to secure partitions
+     */
+    if (msg->client_id < 0) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    if (msg->out_size[0] != sizeof(stats)) {
+        /* The output argument size is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    status = tfm_its_get_fs_cache_stats(msg->client_id, &stats);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    psa_write(msg->handle, 0, &stats, sizeof(stats));
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_FLASH_FS_CACHE_SIZE != 0 */
+
 psa_status_t tfm_its_entry(void)
 {
     return tfm_its_init();
@@ -172,6 +252,30 @@ psa_status_t tfm_internal_trusted_storage_service_sfn(const psa_msg_t *msg)
         return tfm_its_get_info_req(msg);
     case TFM_ITS_REMOVE:
         return tfm_its_remove_req(msg);
+#if ITS_TRANSACTION
+    case TFM_ITS_TXN_BEGIN:
+        return tfm_its_txn_begin(msg->client_id);
+    case TFM_ITS_TXN_SET:
+        return tfm_its_set_req(msg);
+    case TFM_ITS_TXN_REMOVE:
+        return tfm_its_remove_req(msg);
+    case TFM_ITS_TXN_COMMIT:
+        return tfm_its_txn_commit(msg->client_id);
+    case TFM_ITS_TXN_ABORT:
+        return tfm_its_txn_abort(msg->client_id);
+#endif
+#if ITS_FLASH_FS_STATS
+    case TFM_ITS_GET_STATS:
+        return tfm_its_get_stats_req(msg);
+#endif
+#if ITS_BACKGROUND_MAINTENANCE
+    case TFM_ITS_MAINTAIN:
+        return tfm_its_maintain_fs();
+#endif
+#if ITS_FLASH_FS_CACHE_SIZE != 0
+    case TFM_ITS_GET_CACHE_STATS:
+        return tfm_its_get_cache_stats_req(msg);
+#endif
     default:
         return PSA_ERROR_NOT_SUPPORTED;
     }
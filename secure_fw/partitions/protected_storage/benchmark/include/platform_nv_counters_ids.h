@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  platform_nv_counters_ids.h
+ *
+ * \brief NV counters of the host benchmark. Only the PS counters are
+ *        declared, ps_rollback_test provides them in RAM.
+ */
+
+#ifndef __PLATFORM_NV_COUNTERS_IDS_H__
+#define __PLATFORM_NV_COUNTERS_IDS_H__
+
+enum tfm_nv_counter_t {
+    PLAT_NV_COUNTER_PS_0 = 0,  /* Used by PS service */
+    PLAT_NV_COUNTER_PS_1,      /* Used by PS service */
+    PLAT_NV_COUNTER_PS_2,      /* Used by PS service */
+    PLAT_NV_COUNTER_MAX,
+};
+
+#endif /* __PLATFORM_NV_COUNTERS_IDS_H__ */
@@ -0,0 +1,169 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  crypto.h
+ *
+ * \brief PSA Crypto API of the host benchmarks, limited to what the PS crypto
+ *        interface uses. The values are the ones of the PSA Crypto API, the
+ *        functions are implemented by the benchmark.
+ */
+
+#ifndef __PSA_CRYPTO_H__
+#define __PSA_CRYPTO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "psa/error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint16_t psa_key_type_t;
+typedef uint32_t psa_algorithm_t;
+typedef uint32_t psa_key_id_t;
+typedef uint32_t psa_key_usage_t;
+typedef uint16_t psa_key_derivation_step_t;
+
+#define PSA_KEY_ID_NULL                   ((psa_key_id_t)0)
+
+#define PSA_KEY_TYPE_AES                  ((psa_key_type_t)0x2400)
+
+#define PSA_KEY_USAGE_ENCRYPT             ((psa_key_usage_t)0x00000100)
+#define PSA_KEY_USAGE_DECRYPT             ((psa_key_usage_t)0x00000200)
+
+#define PSA_ALG_CATEGORY_MASK             ((psa_algorithm_t)0x7f000000)
+#define PSA_ALG_CATEGORY_AEAD             ((psa_algorithm_t)0x05000000)
+#define PSA_ALG_HASH_MASK                 ((psa_algorithm_t)0x000000ff)
+#define PSA_ALG_SHA_256                   ((psa_algorithm_t)0x02000009)
+#define PSA_ALG_CCM                       ((psa_algorithm_t)0x05500100)
+#define PSA_ALG_GCM                       ((psa_algorithm_t)0x05500200)
+#define PSA_ALG_HKDF_BASE                 ((psa_algorithm_t)0x08000100)
+
+#define PSA_ALG_AEAD_TAG_LENGTH_MASK            ((psa_algorithm_t)0x003f0000)
+#define PSA_AEAD_TAG_LENGTH_OFFSET              16
+#define PSA_ALG_AEAD_AT_LEAST_THIS_LENGTH_FLAG  ((psa_algorithm_t)0x00008000)
+
+#define PSA_ALG_IS_AEAD(alg) \
+    (((alg) & PSA_ALG_CATEGORY_MASK) == PSA_ALG_CATEGORY_AEAD)
+
+#define PSA_ALG_AEAD_WITH_SHORTENED_TAG(aead_alg, tag_length)   \
+    (((aead_alg) & ~(PSA_ALG_AEAD_TAG_LENGTH_MASK |             \
+                     PSA_ALG_AEAD_AT_LEAST_THIS_LENGTH_FLAG)) | \
+     ((tag_length) << PSA_AEAD_TAG_LENGTH_OFFSET &              \
+        PSA_ALG_AEAD_TAG_LENGTH_MASK))
+
+#define PSA_ALG_HKDF(hash_alg) \
+    (PSA_ALG_HKDF_BASE | ((hash_alg) & PSA_ALG_HASH_MASK))
+
+/* Only the AES block cipher is used */
+#define PSA_BLOCK_CIPHER_BLOCK_LENGTH(type) \
+    (((type) == PSA_KEY_TYPE_AES) ? 16u : 0u)
+
+#define PSA_BYTES_TO_BITS(bytes) ((bytes) * 8u)
+
+#define PSA_KEY_DERIVATION_INPUT_SECRET   ((psa_key_derivation_step_t)0x0101)
+#define PSA_KEY_DERIVATION_INPUT_INFO     ((psa_key_derivation_step_t)0x0203)
+
+typedef struct {
+    psa_key_type_t type;
+    size_t bits;
+    psa_key_usage_t usage;
+    psa_algorithm_t alg;
+} psa_key_attributes_t;
+
+#define PSA_KEY_ATTRIBUTES_INIT {0, 0, 0, 0}
+
+/* Maximum length of the info input of a key derivation */
+#define PSA_KEY_DERIVATION_MAX_INFO_LEN 32
+
+typedef struct {
+    psa_algorithm_t alg;
+    psa_key_id_t secret;
+    uint8_t info[PSA_KEY_DERIVATION_MAX_INFO_LEN];
+    size_t info_len;
+} psa_key_derivation_operation_t;
+
+#define PSA_KEY_DERIVATION_OPERATION_INIT {0, PSA_KEY_ID_NULL, {0}, 0}
+
+static inline void psa_set_key_type(psa_key_attributes_t *attributes,
+                                    psa_key_type_t type)
+{
+    attributes->type = type;
+}
+
+static inline void psa_set_key_bits(psa_key_attributes_t *attributes,
+                                    size_t bits)
+{
+    attributes->bits = bits;
+}
+
+static inline void psa_set_key_usage_flags(psa_key_attributes_t *attributes,
+                                           psa_key_usage_t usage)
+{
+    attributes->usage = usage;
+}
+
+static inline void psa_set_key_algorithm(psa_key_attributes_t *attributes,
+                                         psa_algorithm_t alg)
+{
+    attributes->alg = alg;
+}
+
+psa_status_t psa_destroy_key(psa_key_id_t key);
+
+psa_status_t psa_hash_compute(psa_algorithm_t alg,
+                              const uint8_t *input, size_t input_length,
+                              uint8_t *hash, size_t hash_size,
+                              size_t *hash_length);
+
+psa_status_t psa_aead_encrypt(psa_key_id_t key, psa_algorithm_t alg,
+                              const uint8_t *nonce, size_t nonce_length,
+                              const uint8_t *additional_data,
+                              size_t additional_data_length,
+                              const uint8_t *plaintext,
+                              size_t plaintext_length,
+                              uint8_t *ciphertext, size_t ciphertext_size,
+                              size_t *ciphertext_length);
+
+psa_status_t psa_aead_decrypt(psa_key_id_t key, psa_algorithm_t alg,
+                              const uint8_t *nonce, size_t nonce_length,
+                              const uint8_t *additional_data,
+                              size_t additional_data_length,
+                              const uint8_t *ciphertext,
+                              size_t ciphertext_length,
+                              uint8_t *plaintext, size_t plaintext_size,
+                              size_t *plaintext_length);
+
+psa_status_t psa_key_derivation_setup(psa_key_derivation_operation_t *operation,
+                                      psa_algorithm_t alg);
+
+psa_status_t psa_key_derivation_input_key(
+                                    psa_key_derivation_operation_t *operation,
+                                    psa_key_derivation_step_t step,
+                                    psa_key_id_t key);
+
+psa_status_t psa_key_derivation_input_bytes(
+                                    psa_key_derivation_operation_t *operation,
+                                    psa_key_derivation_step_t step,
+                                    const uint8_t *data,
+                                    size_t data_length);
+
+psa_status_t psa_key_derivation_output_key(
+                                    const psa_key_attributes_t *attributes,
+                                    psa_key_derivation_operation_t *operation,
+                                    psa_key_id_t *key);
+
+psa_status_t psa_key_derivation_abort(psa_key_derivation_operation_t *operation);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PSA_CRYPTO_H__ */
@@ -0,0 +1,21 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  tfm_crypto_defs.h
+ *
+ * \brief Crypto service definitions of the host benchmarks, limited to the
+ *        builtin key identifiers used by the PS crypto interface.
+ */
+
+#ifndef __TFM_CRYPTO_DEFS_H__
+#define __TFM_CRYPTO_DEFS_H__
+
+#include "psa/crypto.h"
+#include "crypto_keys/tfm_builtin_key_ids.h"
+
+#endif /* __TFM_CRYPTO_DEFS_H__ */
@@ -0,0 +1,328 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "ps_bench_stubs.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config_tfm.h"
+#include "psa/internal_trusted_storage.h"
+#include "crypto/ps_crypto_interface.h"
+#include "tfm_ps_req_mngr.h"
+
+/* RAM storage of the PS files */
+static struct {
+    uint8_t *data;
+    size_t size;
+} files[BENCH_NUM_FILES];
+
+uint64_t bench_bytes_read;
+
+uint64_t bench_crypto_bytes;
+
+const uint8_t *bench_req_in;
+uint8_t *bench_req_out;
+
+uint32_t bench_fail_set;
+uint32_t bench_fail_encrypt;
+psa_storage_uid_t bench_fail_get_uid;
+
+const uint8_t *bench_encrypt_out;
+size_t bench_encrypt_out_size;
+
+void (*bench_iv_used)(const uint8_t *iv);
+
+/* Gets the index in files of the PS file of the given UID. Returns false if
+ * there is no such file.
+ */
+static bool bench_file_idx(psa_storage_uid_t uid, uint32_t *p_idx)
+{
+    const uint32_t fid = (uint32_t)uid;
+    const uint64_t seg = uid >> 32;
+
+    if (fid == 0 || fid > BENCH_NUM_FIDS || seg > PS_OBJECT_MAX_SEGMENTS) {
+        return false;
+    }
+
+    *p_idx = ((uint32_t)seg * BENCH_NUM_FIDS) + (fid - 1);
+
+    return true;
+}
+
+/* Counts down to the failure of an operation. Returns true if this operation
+ * fails.
+ */
+static bool bench_fails_now(uint32_t *p_count)
+{
+    if (*p_count == 0) {
+        return false;
+    }
+
+    return --(*p_count) == 0;
+}
+
+psa_status_t psa_its_set(psa_storage_uid_t uid, size_t data_length,
+                         const void *p_data, psa_storage_create_flags_t flags)
+{
+    uint8_t *data;
+    uint32_t i;
+
+    (void)flags;
+
+    if (!bench_file_idx(uid, &i)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (bench_fails_now(&bench_fail_set)) {
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    data = realloc(files[i].data, data_length + 1);
+    if (data == NULL) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    (void)memcpy(data, p_data, data_length);
+    files[i].data = data;
+    files[i].size = data_length;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_its_get(psa_storage_uid_t uid, size_t data_offset,
+                         size_t data_size, void *p_data,
+                         size_t *p_data_length)
+{
+    uint32_t i;
+
+    if (!bench_file_idx(uid, &i) || files[i].size == 0) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    if (uid == bench_fail_get_uid) {
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    if (data_offset > files[i].size) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (data_size > files[i].size - data_offset) {
+        data_size = files[i].size - data_offset;
+    }
+
+    (void)memcpy(p_data, files[i].data + data_offset, data_size);
+    *p_data_length = data_size;
+    bench_bytes_read += data_size;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_its_remove(psa_storage_uid_t uid)
+{
+    uint32_t i;
+
+    if (!bench_file_idx(uid, &i) || files[i].size == 0) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    files[i].size = 0;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_req_mngr_read_asset_data(uint8_t *out_data, uint32_t size)
+{
+    (void)memcpy(out_data, bench_req_in, size);
+    bench_req_in += size;
+
+    return PSA_SUCCESS;
+}
+
+void ps_req_mngr_write_asset_data(const uint8_t *in_data, uint32_t size)
+{
+    (void)memcpy(bench_req_out, in_data, size);
+    bench_req_out += size;
+}
+
+/* FNV-1a checksum of the IV, the associated data and the data, in place of
+ * the MAC of the target
+ */
+static void bench_tag(const union ps_crypto_t *crypto, const uint8_t *add,
+                      size_t add_len, const uint8_t *in, size_t in_len,
+                      uint8_t *tag)
+{
+    uint32_t h = 2166136261u;
+    size_t i;
+
+    bench_crypto_bytes += add_len + in_len;
+
+    for (i = 0; i < PS_IV_LEN_BYTES; i++) {
+        h = (h ^ crypto->ref.iv[i]) * 16777619u;
+    }
+    for (i = 0; i < add_len; i++) {
+        h = (h ^ add[i]) * 16777619u;
+    }
+    for (i = 0; i < in_len; i++) {
+        h = (h ^ in[i]) * 16777619u;
+    }
+
+    for (i = 0; i < PS_TAG_LEN_BYTES; i++) {
+        h = (h ^ (uint32_t)i) * 16777619u;
+        tag[i] = (uint8_t)(h >> 24);
+    }
+}
+
+/* Keystream derived from the IV, in place of the cipher of the target */
+static void bench_xor(const union ps_crypto_t *crypto, const uint8_t *in,
+                      size_t len, uint8_t *out)
+{
+    uint32_t x;
+    size_t i;
+
+    (void)memcpy(&x, crypto->ref.iv, sizeof(x));
+
+    for (i = 0; i < len; i++) {
+        x = (x * 1103515245u) + 12345u;
+        out[i] = in[i] ^ (uint8_t)(x >> 16);
+    }
+}
+
+void ps_crypto_clear_keys(void)
+{
+    /* No key is derived */
+}
+
+uint32_t ps_crypto_to_blocks(size_t in_len)
+{
+    return (uint32_t)((in_len + 15) / 16);
+}
+
+psa_status_t ps_crypto_encrypt_and_tag(union ps_crypto_t *crypto,
+                                       const uint8_t *add,
+                                       size_t add_len,
+                                       const uint8_t *in,
+                                       size_t in_len,
+                                       uint8_t *out,
+                                       size_t out_size,
+                                       size_t *out_len)
+{
+    bench_encrypt_out = out;
+    bench_encrypt_out_size = out_size;
+
+    if (out_size < in_len + PS_TAG_LEN_BYTES) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    if (bench_fails_now(&bench_fail_encrypt)) {
+        return PSA_ERROR_HARDWARE_FAILURE;
+    }
+
+    if (bench_iv_used != NULL) {
+        bench_iv_used(crypto->ref.iv);
+    }
+
+    bench_xor(crypto, in, in_len, out);
+    bench_tag(crypto, add, add_len, out, in_len, crypto->ref.tag);
+    (void)memcpy(out + in_len, crypto->ref.tag, PS_TAG_LEN_BYTES);
+    *out_len = in_len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_auth_and_decrypt(const union ps_crypto_t *crypto,
+                                        const uint8_t *add,
+                                        size_t add_len,
+                                        uint8_t *in,
+                                        size_t in_len,
+                                        uint8_t *out,
+                                        size_t out_size,
+                                        size_t *out_len)
+{
+    uint8_t tag[PS_TAG_LEN_BYTES];
+
+    if (out_size < in_len) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    bench_tag(crypto, add, add_len, in, in_len, tag);
+    if (memcmp(tag, crypto->ref.tag, PS_TAG_LEN_BYTES) != 0) {
+        return PSA_ERROR_INVALID_SIGNATURE;
+    }
+
+    bench_xor(crypto, in, in_len, out);
+    *out_len = in_len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_generate_auth_tag(union ps_crypto_t *crypto,
+                                         const uint8_t *add,
+                                         uint32_t add_len)
+{
+    if (bench_iv_used != NULL) {
+        bench_iv_used(crypto->ref.iv);
+    }
+
+    bench_tag(crypto, add, add_len, NULL, 0, crypto->ref.tag);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
+                                    const uint8_t *add,
+                                    uint32_t add_len)
+{
+    uint8_t tag[PS_TAG_LEN_BYTES];
+
+    bench_tag(crypto, add, add_len, NULL, 0, tag);
+
+    return (memcmp(tag, crypto->ref.tag, PS_TAG_LEN_BYTES) == 0) ?
+           PSA_SUCCESS : PSA_ERROR_INVALID_SIGNATURE;
+}
+
+uint8_t *bench_file_data(psa_storage_uid_t uid, size_t *p_size)
+{
+    uint32_t i;
+
+    if (!bench_file_idx(uid, &i) || files[i].size == 0) {
+        return NULL;
+    }
+
+    *p_size = files[i].size;
+
+    return files[i].data;
+}
+
+psa_storage_uid_t bench_file_uid(uint32_t idx)
+{
+    return ((psa_storage_uid_t)(idx / BENCH_NUM_FIDS) << 32) |
+           (psa_storage_uid_t)((idx % BENCH_NUM_FIDS) + 1);
+}
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+void bench_free_files(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < BENCH_NUM_FILES; i++) {
+        free(files[i].data);
+        files[i].data = NULL;
+        files[i].size = 0;
+    }
+}
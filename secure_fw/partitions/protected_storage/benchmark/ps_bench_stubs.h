@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Environment of the host benchmarks of the PS object system. The PS files
+ * are stored in RAM instead of ITS, the request manager copies the data from
+ * and to the buffers of the benchmark, and the PS crypto interface is
+ * replaced by a cheap checksum and keystream, keeping its IVs. The number of
+ * bytes read from the files and the number of bytes going through the AEAD are
+ * counted, as the cost of the operations on the target. The tests can make a
+ * file write or an encryption fail, change the content of the files, and see
+ * the IVs used.
+ */
+
+#ifndef __PS_BENCH_STUBS_H__
+#define __PS_BENCH_STUBS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ps_object_defs.h"
+
+/* File IDs of the PS files: the object tables and the objects */
+#define BENCH_NUM_FIDS         PS_MAX_NUM_OBJECTS
+
+/* PS files: the file of each File ID and, with PS_STREAM_WINDOW_SIZE, its
+ * segment files
+ */
+#define BENCH_NUM_FILES        (BENCH_NUM_FIDS * (PS_OBJECT_MAX_SEGMENTS + 1))
+
+/* Number of bytes read from the files */
+extern uint64_t bench_bytes_read;
+
+/* Number of bytes authenticated, encrypted or decrypted */
+extern uint64_t bench_crypto_bytes;
+
+/* Client buffers of the request being served */
+extern const uint8_t *bench_req_in;
+extern uint8_t *bench_req_out;
+
+/* Number of file writes, and of encryptions, before the one which fails. 0 if
+ * none fails.
+ */
+extern uint32_t bench_fail_set;
+extern uint32_t bench_fail_encrypt;
+
+/* File ID whose reads fail with a storage failure, 0 if none */
+extern psa_storage_uid_t bench_fail_get_uid;
+
+/* Output buffer given to the last encryption, and its size */
+extern const uint8_t *bench_encrypt_out;
+extern size_t bench_encrypt_out_size;
+
+/* Called with the IV of each encryption and tag generation, if set */
+extern void (*bench_iv_used)(const uint8_t *iv);
+
+/* Gets the content of a PS file, NULL if it does not exist */
+uint8_t *bench_file_data(psa_storage_uid_t uid, size_t *p_size);
+
+/* Gets the UID of the PS file of the given index, below BENCH_NUM_FILES */
+psa_storage_uid_t bench_file_uid(uint32_t idx);
+
+/* Gets the monotonic time in nanoseconds */
+uint64_t bench_now_ns(void);
+
+/* Frees the RAM storage of the PS files */
+void bench_free_files(void);
+
+#endif /* __PS_BENCH_STUBS_H__ */
@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host benchmark of the PS object cache. It stores PS_NUM_ASSETS objects
+ * through the PS object system and reads them with a skewed access pattern:
+ * most reads go to a few hot objects, and some of the reads are replaced by
+ * writes of a hot object. The objects are stored in RAM instead of ITS, and
+ * the PS crypto interface is replaced by a cheap checksum and keystream, so
+ * the number of bytes read from ITS and the number of bytes going through the
+ * AEAD per read are reported, as the cost of a read on the target, with the
+ * CPU time of the reads on the host and the counters of the cache.
+ */
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "ps_bench_stubs.h"
+#include "ps_object_cache.h"
+#include "ps_object_system.h"
+
+/* Size of the objects */
+#define BENCH_OBJ_SIZE         256
+
+/* Number of hot objects, and percentage of the reads going to them */
+#define BENCH_NUM_HOT          4
+#define BENCH_HOT_PERCENT      90
+
+static void fail(const char *what, psa_status_t err)
+{
+    fprintf(stderr, "%s failed: %d\n", what, (int)err);
+    exit(1);
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-n reads] [-w writes_per_1000] [-s seed] [-H]\n"
+           "  -n  number of reads (default 100000)\n"
+           "  -w  writes of a hot object per 1000 reads (default 1)\n"
+           "  -s  seed of the access pattern (default 1)\n"
+           "  -H  print the header of the results\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t data[BENCH_OBJ_SIZE];
+    static uint8_t out[BENCH_OBJ_SIZE];
+#if PS_OBJECT_CACHE_SIZE != 0
+    struct tfm_ps_cache_stats_t stats;
+#endif
+    uint32_t num_reads = 100000;
+    uint32_t writes = 1;
+    uint32_t seed = 1;
+    uint32_t num_objects = PS_NUM_ASSETS;
+    uint32_t hits = 0;
+    uint32_t i;
+    uint32_t n;
+    uint64_t t0;
+    uint64_t read_ns = 0;
+    uint64_t read_bytes = 0;
+    uint64_t read_crypto_bytes = 0;
+    size_t data_length;
+    psa_status_t err;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:w:s:Hh")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_reads = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            writes = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'H':
+            printf("%8s %8s %8s %10s %10s %10s %8s\n",
+                   "assets", "cache_B", "obj_B", "read_ns", "its_B/rd",
+                   "crypto_B", "hit_%");
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if (num_reads == 0) {
+        num_reads = 1;
+    }
+
+    srand(seed);
+
+    err = ps_system_prepare();
+    if (err != PSA_SUCCESS) {
+        err = ps_system_wipe_all();
+    }
+    if (err != PSA_SUCCESS) {
+        fail("prepare", err);
+    }
+
+    for (i = 0; i < num_objects; i++) {
+        (void)memset(data, (int)i, sizeof(data));
+        bench_req_in = data;
+        err = ps_object_create(i + 1, -1, PSA_STORAGE_FLAG_NONE,
+                               sizeof(data));
+        if (err != PSA_SUCCESS) {
+            fail("create", err);
+        }
+    }
+
+    for (n = 0; n < num_reads; n++) {
+        i = ((uint32_t)rand() % 100 < BENCH_HOT_PERCENT) ?
+            (uint32_t)rand() % BENCH_NUM_HOT :
+            (uint32_t)rand() % num_objects;
+
+        if ((uint32_t)rand() % 1000 < writes) {
+            (void)memset(data, (int)(i + n), 16);
+            bench_req_in = data;
+            err = ps_object_write(i + 1, -1, 0, 16);
+            if (err != PSA_SUCCESS) {
+                fail("write", err);
+            }
+        }
+
+        bench_bytes_read = 0;
+        bench_crypto_bytes = 0;
+        bench_req_out = out;
+        t0 = bench_now_ns();
+        err = ps_object_read(i + 1, -1, 0, sizeof(out), &data_length);
+        read_ns += bench_now_ns() - t0;
+        if (err != PSA_SUCCESS || data_length != sizeof(out)) {
+            fail("read", err);
+        }
+        read_bytes += bench_bytes_read;
+        read_crypto_bytes += bench_crypto_bytes;
+        hits += (bench_bytes_read == 0) ? 1 : 0;
+    }
+
+#if PS_OBJECT_CACHE_SIZE != 0
+    ps_object_cache_get_stats(&stats);
+    if (stats.hits != hits) {
+        fail("cache counters", PSA_ERROR_GENERIC_ERROR);
+    }
+#endif
+
+    printf("%8u %8u %8u %10llu %10llu %10llu %8.1f\n",
+           num_objects, (unsigned)PS_OBJECT_CACHE_SIZE, BENCH_OBJ_SIZE,
+           (unsigned long long)(read_ns / num_reads),
+           (unsigned long long)(read_bytes / num_reads),
+           (unsigned long long)(read_crypto_bytes / num_reads),
+           (100.0 * hits) / num_reads);
+
+    bench_free_files();
+
+    return 0;
+}
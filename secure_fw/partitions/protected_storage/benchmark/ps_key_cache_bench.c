@@ -0,0 +1,633 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host benchmark of the storage key cache of the PS crypto interface. It
+ * drives the real PS crypto interface with the sequences of AEAD operations
+ * of PS requests, and implements the PSA Crypto functions it calls: the keys
+ * are derived with HKDF-SHA-256 from a fixed HUK into a key store of
+ * PS_CRYPTO_KEY_CACHE_SIZE slots, at least one, and the AEAD is a keystream
+ * with an HMAC-SHA-256 tag. The number of key derivations per request is
+ * reported, as the saving on the target, with the CPU time of the requests on
+ * the host.
+ *
+ * The benchmark fails if a key is used after it is destroyed, if more keys
+ * than the cache size are resident after a request, or if keys are left
+ * resident after a key switch.
+ */
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config_tfm.h"
+#include "crypto/ps_crypto_interface.h"
+#include "tfm_crypto_defs.h"
+#include "psa/crypto.h"
+
+#define SHA256_LEN          32
+#define SHA256_BLOCK_LEN    64
+
+#define BENCH_KEY_LEN       16
+
+/* The key store of the Crypto service, of one slot if no key is cached */
+#if PS_CRYPTO_KEY_CACHE_SIZE > 0
+#define BENCH_KEY_SLOTS     PS_CRYPTO_KEY_CACHE_SIZE
+#else
+#define BENCH_KEY_SLOTS     1
+#endif
+
+/* Size of the objects, and of the object table authenticated with them */
+#define BENCH_OBJ_SIZE      256
+#define BENCH_TABLE_SIZE    128
+
+/* UID of the label of the object table key */
+#define BENCH_TABLE_UID     0
+
+static const uint8_t bench_huk[SHA256_LEN] = {
+    0x9a, 0x13, 0x52, 0x07, 0xe1, 0x4c, 0x88, 0x30,
+    0x5d, 0xb6, 0x21, 0xf4, 0x6a, 0x0f, 0xc3, 0x97,
+    0x41, 0x2e, 0x7b, 0xd8, 0x15, 0xa9, 0x66, 0xcc,
+    0x03, 0x5f, 0xe0, 0x74, 0xbb, 0x28, 0x91, 0x4d,
+};
+
+static struct {
+    bool used;
+    uint8_t key[BENCH_KEY_LEN];
+} key_slots[BENCH_KEY_SLOTS];
+
+static uint32_t num_derivations;
+static uint32_t num_live_keys;
+static uint32_t num_bad_handles;
+
+static void fail(const char *what, psa_status_t err)
+{
+    fprintf(stderr, "%s failed: %d\n", what, (int)err);
+    exit(1);
+}
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+/* SHA-256 of FIPS 180-4 */
+struct sha256_ctx {
+    uint32_t h[8];
+    uint8_t block[SHA256_BLOCK_LEN];
+    size_t block_len;
+    uint64_t total_len;
+};
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(struct sha256_ctx *ctx, const uint8_t *p)
+{
+    uint32_t w[64];
+    uint32_t s[8];
+    uint32_t t1;
+    uint32_t t2;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)p[4 * i] << 24) | ((uint32_t)p[4 * i + 1] << 16) |
+               ((uint32_t)p[4 * i + 2] << 8) | (uint32_t)p[4 * i + 3];
+    }
+    for (; i < 64; i++) {
+        w[i] = w[i - 16] + w[i - 7] +
+               (ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+               (ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10));
+    }
+
+    (void)memcpy(s, ctx->h, sizeof(s));
+    for (i = 0; i < 64; i++) {
+        t1 = s[7] + (ROR32(s[4], 6) ^ ROR32(s[4], 11) ^ ROR32(s[4], 25)) +
+             ((s[4] & s[5]) ^ (~s[4] & s[6])) + sha256_k[i] + w[i];
+        t2 = (ROR32(s[0], 2) ^ ROR32(s[0], 13) ^ ROR32(s[0], 22)) +
+             ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+        (void)memmove(&s[1], &s[0], 7 * sizeof(s[0]));
+        s[4] += t1;
+        s[0] = t1 + t2;
+    }
+    for (i = 0; i < 8; i++) {
+        ctx->h[i] += s[i];
+    }
+}
+
+static void sha256_init(struct sha256_ctx *ctx)
+{
+    static const uint32_t h0[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    (void)memcpy(ctx->h, h0, sizeof(h0));
+    ctx->block_len = 0;
+    ctx->total_len = 0;
+}
+
+static void sha256_update(struct sha256_ctx *ctx, const uint8_t *in,
+                          size_t len)
+{
+    size_t n;
+
+    ctx->total_len += len;
+    while (len > 0) {
+        n = SHA256_BLOCK_LEN - ctx->block_len;
+        if (n > len) {
+            n = len;
+        }
+        (void)memcpy(ctx->block + ctx->block_len, in, n);
+        ctx->block_len += n;
+        in += n;
+        len -= n;
+        if (ctx->block_len == SHA256_BLOCK_LEN) {
+            sha256_block(ctx, ctx->block);
+            ctx->block_len = 0;
+        }
+    }
+}
+
+static void sha256_finish(struct sha256_ctx *ctx, uint8_t *out)
+{
+    uint64_t bits = ctx->total_len * 8;
+    uint8_t pad = 0x80;
+    uint8_t len[8];
+    int i;
+
+    sha256_update(ctx, &pad, 1);
+    pad = 0;
+    while (ctx->block_len != SHA256_BLOCK_LEN - sizeof(len)) {
+        sha256_update(ctx, &pad, 1);
+    }
+    for (i = 0; i < 8; i++) {
+        len[i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    sha256_update(ctx, len, sizeof(len));
+
+    for (i = 0; i < 8; i++) {
+        out[4 * i] = (uint8_t)(ctx->h[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(ctx->h[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(ctx->h[i] >> 8);
+        out[4 * i + 3] = (uint8_t)ctx->h[i];
+    }
+}
+
+/* HMAC-SHA-256 of up to three parts of the message */
+static void hmac_sha256(const uint8_t *key, size_t key_len,
+                        const uint8_t *m1, size_t m1_len,
+                        const uint8_t *m2, size_t m2_len,
+                        const uint8_t *m3, size_t m3_len,
+                        uint8_t *mac)
+{
+    struct sha256_ctx ctx;
+    uint8_t pad[SHA256_BLOCK_LEN];
+    uint8_t inner[SHA256_LEN];
+    size_t i;
+
+    (void)memset(pad, 0x36, sizeof(pad));
+    for (i = 0; i < key_len; i++) {
+        pad[i] ^= key[i];
+    }
+    sha256_init(&ctx);
+    sha256_update(&ctx, pad, sizeof(pad));
+    sha256_update(&ctx, m1, m1_len);
+    sha256_update(&ctx, m2, m2_len);
+    sha256_update(&ctx, m3, m3_len);
+    sha256_finish(&ctx, inner);
+
+    for (i = 0; i < sizeof(pad); i++) {
+        pad[i] ^= 0x36 ^ 0x5c;
+    }
+    sha256_init(&ctx);
+    sha256_update(&ctx, pad, sizeof(pad));
+    sha256_update(&ctx, inner, sizeof(inner));
+    sha256_finish(&ctx, mac);
+}
+
+static const uint8_t *bench_get_key(psa_key_id_t key)
+{
+    if (key == PSA_KEY_ID_NULL || key > BENCH_KEY_SLOTS ||
+        !key_slots[key - 1].used) {
+        num_bad_handles++;
+        return NULL;
+    }
+
+    return key_slots[key - 1].key;
+}
+
+psa_status_t psa_destroy_key(psa_key_id_t key)
+{
+    if (bench_get_key(key) == NULL) {
+        return PSA_ERROR_INVALID_HANDLE;
+    }
+
+    (void)memset(key_slots[key - 1].key, 0, BENCH_KEY_LEN);
+    key_slots[key - 1].used = false;
+    num_live_keys--;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_hash_compute(psa_algorithm_t alg,
+                              const uint8_t *input, size_t input_length,
+                              uint8_t *hash, size_t hash_size,
+                              size_t *hash_length)
+{
+    struct sha256_ctx ctx;
+
+    if (alg != PSA_ALG_SHA_256 || hash_size < SHA256_LEN) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, input, input_length);
+    sha256_finish(&ctx, hash);
+    *hash_length = SHA256_LEN;
+
+    return PSA_SUCCESS;
+}
+
+/* Keystream of the key and the nonce, and tag over the nonce, the associated
+ * data and the ciphertext
+ */
+static void bench_aead(const uint8_t *key, const uint8_t *nonce,
+                       size_t nonce_length, const uint8_t *add,
+                       size_t add_len, const uint8_t *in, uint8_t *out,
+                       size_t len, const uint8_t *ciphertext, uint8_t *tag)
+{
+    uint8_t mac[SHA256_LEN];
+    uint32_t x;
+    size_t i;
+
+    (void)memcpy(&x, key, sizeof(x));
+    x ^= nonce[0];
+    for (i = 0; i < len; i++) {
+        x = (x * 1103515245u) + 12345u;
+        out[i] = in[i] ^ (uint8_t)(x >> 16);
+    }
+
+    hmac_sha256(key, BENCH_KEY_LEN, nonce, nonce_length, add, add_len,
+                (ciphertext != NULL) ? ciphertext : out, len, mac);
+    (void)memcpy(tag, mac, PS_TAG_LEN_BYTES);
+}
+
+psa_status_t psa_aead_encrypt(psa_key_id_t key, psa_algorithm_t alg,
+                              const uint8_t *nonce, size_t nonce_length,
+                              const uint8_t *additional_data,
+                              size_t additional_data_length,
+                              const uint8_t *plaintext,
+                              size_t plaintext_length,
+                              uint8_t *ciphertext, size_t ciphertext_size,
+                              size_t *ciphertext_length)
+{
+    const uint8_t *k = bench_get_key(key);
+
+    (void)alg;
+
+    if (k == NULL) {
+        return PSA_ERROR_INVALID_HANDLE;
+    }
+    if (ciphertext_size < plaintext_length + PS_TAG_LEN_BYTES) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    bench_aead(k, nonce, nonce_length, additional_data,
+               additional_data_length, plaintext, ciphertext,
+               plaintext_length, NULL, ciphertext + plaintext_length);
+    *ciphertext_length = plaintext_length + PS_TAG_LEN_BYTES;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_aead_decrypt(psa_key_id_t key, psa_algorithm_t alg,
+                              const uint8_t *nonce, size_t nonce_length,
+                              const uint8_t *additional_data,
+                              size_t additional_data_length,
+                              const uint8_t *ciphertext,
+                              size_t ciphertext_length,
+                              uint8_t *plaintext, size_t plaintext_size,
+                              size_t *plaintext_length)
+{
+    const uint8_t *k = bench_get_key(key);
+    uint8_t tag[PS_TAG_LEN_BYTES];
+    size_t len;
+
+    (void)alg;
+
+    if (k == NULL) {
+        return PSA_ERROR_INVALID_HANDLE;
+    }
+    if (ciphertext_length < PS_TAG_LEN_BYTES) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+    len = ciphertext_length - PS_TAG_LEN_BYTES;
+    if (plaintext_size < len) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    bench_aead(k, nonce, nonce_length, additional_data,
+               additional_data_length, ciphertext, plaintext, len, ciphertext,
+               tag);
+    if (memcmp(tag, ciphertext + len, PS_TAG_LEN_BYTES) != 0) {
+        return PSA_ERROR_INVALID_SIGNATURE;
+    }
+    *plaintext_length = len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_key_derivation_setup(psa_key_derivation_operation_t *operation,
+                                      psa_algorithm_t alg)
+{
+    if (alg != PSA_ALG_HKDF(PSA_ALG_SHA_256)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+    operation->alg = alg;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_key_derivation_input_key(
+                                    psa_key_derivation_operation_t *operation,
+                                    psa_key_derivation_step_t step,
+                                    psa_key_id_t key)
+{
+    if (step != PSA_KEY_DERIVATION_INPUT_SECRET ||
+        key != TFM_BUILTIN_KEY_ID_HUK) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+    operation->secret = key;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_key_derivation_input_bytes(
+                                    psa_key_derivation_operation_t *operation,
+                                    psa_key_derivation_step_t step,
+                                    const uint8_t *data,
+                                    size_t data_length)
+{
+    if (step != PSA_KEY_DERIVATION_INPUT_INFO ||
+        data_length > sizeof(operation->info)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+    (void)memcpy(operation->info, data, data_length);
+    operation->info_len = data_length;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_key_derivation_output_key(
+                                    const psa_key_attributes_t *attributes,
+                                    psa_key_derivation_operation_t *operation,
+                                    psa_key_id_t *key)
+{
+    static const uint8_t salt[SHA256_LEN];
+    static const uint8_t counter = 1;
+    uint8_t prk[SHA256_LEN];
+    uint8_t okm[SHA256_LEN];
+    uint32_t idx;
+
+    if (operation->secret != TFM_BUILTIN_KEY_ID_HUK ||
+        attributes->bits != PSA_BYTES_TO_BITS(BENCH_KEY_LEN)) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    for (idx = 0; idx < BENCH_KEY_SLOTS; idx++) {
+        if (!key_slots[idx].used) {
+            break;
+        }
+    }
+    if (idx == BENCH_KEY_SLOTS) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    /* HKDF extract and the first block of HKDF expand */
+    hmac_sha256(salt, sizeof(salt), bench_huk, sizeof(bench_huk),
+                NULL, 0, NULL, 0, prk);
+    hmac_sha256(prk, sizeof(prk), operation->info, operation->info_len,
+                &counter, 1, NULL, 0, okm);
+
+    (void)memcpy(key_slots[idx].key, okm, BENCH_KEY_LEN);
+    key_slots[idx].used = true;
+    num_live_keys++;
+    num_derivations++;
+    *key = idx + 1;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_key_derivation_abort(psa_key_derivation_operation_t *operation)
+{
+    (void)memset(operation, 0, sizeof(*operation));
+
+    return PSA_SUCCESS;
+}
+
+static union ps_crypto_t obj_crypto[PS_NUM_ASSETS];
+static union ps_crypto_t table_crypto;
+static uint8_t obj_data[PS_NUM_ASSETS][BENCH_OBJ_SIZE + PS_TAG_LEN_BYTES];
+static uint8_t table_data[BENCH_TABLE_SIZE];
+
+static void bench_check_keys(void)
+{
+    if (num_bad_handles != 0) {
+        fail("key handles", PSA_ERROR_INVALID_HANDLE);
+    }
+    if (num_live_keys > PS_CRYPTO_KEY_CACHE_SIZE) {
+        fail("resident keys", PSA_ERROR_INSUFFICIENT_MEMORY);
+    }
+}
+
+/* A write of an object: the object is encrypted and the object table, which
+ * holds the tag of the object, is authenticated
+ */
+static void bench_set(uint32_t i)
+{
+    static uint8_t in[BENCH_OBJ_SIZE];
+    size_t out_len;
+    psa_status_t err;
+
+    (void)memset(in, (int)i, sizeof(in));
+
+    err = ps_crypto_get_iv(&obj_crypto[i]);
+    if (err == PSA_SUCCESS) {
+        err = ps_crypto_encrypt_and_tag(&obj_crypto[i], NULL, 0, in,
+                                        sizeof(in), obj_data[i],
+                                        sizeof(obj_data[i]), &out_len);
+    }
+    if (err != PSA_SUCCESS) {
+        fail("encrypt", err);
+    }
+
+    (void)memcpy(table_data, obj_crypto[i].ref.tag, PS_TAG_LEN_BYTES);
+    err = ps_crypto_get_iv(&table_crypto);
+    if (err == PSA_SUCCESS) {
+        err = ps_crypto_generate_auth_tag(&table_crypto, table_data,
+                                          sizeof(table_data));
+    }
+    if (err != PSA_SUCCESS) {
+        fail("table tag", err);
+    }
+}
+
+/* A read of an object, decrypted and authenticated */
+static void bench_get(uint32_t i)
+{
+    static uint8_t out[BENCH_OBJ_SIZE];
+    size_t out_len;
+    psa_status_t err;
+
+    err = ps_crypto_auth_and_decrypt(&obj_crypto[i], NULL, 0, obj_data[i],
+                                     BENCH_OBJ_SIZE, out, sizeof(out),
+                                     &out_len);
+    if (err != PSA_SUCCESS || out_len != BENCH_OBJ_SIZE ||
+        out[0] != (uint8_t)i) {
+        fail("decrypt", err);
+    }
+}
+
+/* Switch of the storage key, as done by PS when PS_AES_KEY_USAGE_LIMIT is
+ * reached
+ */
+static void bench_switch_key(uint32_t num_objects)
+{
+    uint32_t i;
+
+    ps_crypto_clear_keys();
+    if (num_live_keys != 0) {
+        fail("key switch", PSA_ERROR_GENERIC_ERROR);
+    }
+
+    table_crypto.ref.key_gen_nr++;
+    for (i = 0; i < num_objects; i++) {
+        obj_crypto[i].ref.key_gen_nr = table_crypto.ref.key_gen_nr;
+        bench_set(i);
+    }
+    bench_check_keys();
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-n requests] [-o objects] [-H]\n"
+           "  -n  number of requests of each workload (default 20000)\n"
+           "  -o  number of objects of the round robin workloads (default 4)\n"
+           "  -H  print the header of the results\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *const workloads[] = {
+        "get_same", "set_same", "get_rr", "set_rr",
+    };
+    uint32_t num_reqs = 20000;
+    uint32_t num_objects = 4;
+    uint32_t w;
+    uint32_t i;
+    uint32_t n;
+    uint64_t t0;
+    uint64_t ns;
+    uint32_t derivations;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:o:Hh")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_reqs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            num_objects = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'H':
+            printf("%8s %8s %8s %10s %10s\n",
+                   "cache", "workload", "objects", "req_ns", "derive/req");
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if (num_reqs == 0) {
+        num_reqs = 1;
+    }
+    if (num_objects == 0 || num_objects > PS_NUM_ASSETS) {
+        num_objects = PS_NUM_ASSETS;
+    }
+
+    if (ps_crypto_init() != PSA_SUCCESS) {
+        fail("init", PSA_ERROR_GENERIC_ERROR);
+    }
+
+    table_crypto.ref.uid = BENCH_TABLE_UID;
+    table_crypto.ref.client_id = 0;
+    for (i = 0; i < num_objects; i++) {
+        obj_crypto[i].ref.uid = i + 1;
+        obj_crypto[i].ref.client_id = -1;
+        bench_set(i);
+    }
+    bench_check_keys();
+
+    for (w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+        num_derivations = 0;
+        t0 = bench_now_ns();
+        for (n = 0; n < num_reqs; n++) {
+            i = (w < 2) ? 0 : n % num_objects;
+            if ((w & 1) == 0) {
+                bench_get(i);
+            } else {
+                bench_set(i);
+            }
+            bench_check_keys();
+        }
+        ns = bench_now_ns() - t0;
+        derivations = num_derivations;
+
+        printf("%8u %8s %8u %10llu %10.2f\n",
+               (unsigned)PS_CRYPTO_KEY_CACHE_SIZE, workloads[w],
+               (w < 2) ? 1u : num_objects,
+               (unsigned long long)(ns / num_reqs),
+               (double)derivations / num_reqs);
+
+        /* The objects are still readable with the keys of a new generation */
+        bench_switch_key(num_objects);
+        for (i = 0; i < num_objects; i++) {
+            bench_get(i);
+        }
+        bench_check_keys();
+    }
+
+    ps_crypto_clear_keys();
+    if (num_live_keys != 0) {
+        fail("clear keys", PSA_ERROR_GENERIC_ERROR);
+    }
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host benchmark of small requests to the PS object system. It stores a few
+ * small objects through the PS object system, with a PS_MAX_ASSET_SIZE much
+ * bigger than the objects, and reports the CPU time on the host of the
+ * get_info, read, write, create and delete requests of a few bytes, which
+ * includes the erasure of the object buffer at the end of each request.
+ */
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "ps_bench_stubs.h"
+#include "ps_object_system.h"
+
+/* Number of objects, and size of the objects and of the requests */
+#define BENCH_NUM_OBJECTS      8
+#define BENCH_OBJ_SIZE         64
+#define BENCH_REQ_SIZE         16
+
+enum bench_op_t {
+    BENCH_OP_GET_INFO = 0,
+    BENCH_OP_READ,
+    BENCH_OP_WRITE,
+    BENCH_OP_CREATE,
+    BENCH_OP_DELETE,
+    BENCH_NUM_OPS
+};
+
+static const char *const bench_op_name[BENCH_NUM_OPS] = {
+    "get_info", "read", "write", "create", "delete",
+};
+
+static void fail(const char *what, psa_status_t err)
+{
+    fprintf(stderr, "%s failed: %d\n", what, (int)err);
+    exit(1);
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-n requests] [-H]\n"
+           "  -n  number of requests of each type (default 100000)\n"
+           "  -H  print the header of the results\n", prog);
+}
+
+static void bench_create(uint32_t i)
+{
+    static uint8_t data[BENCH_OBJ_SIZE];
+    psa_status_t err;
+
+    (void)memset(data, (int)i, sizeof(data));
+    bench_req_in = data;
+    err = ps_object_create(i + 1, -1, PSA_STORAGE_FLAG_NONE, sizeof(data));
+    if (err != PSA_SUCCESS) {
+        fail("create", err);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t data[BENCH_REQ_SIZE];
+    static uint8_t out[BENCH_REQ_SIZE];
+    struct psa_storage_info_t info;
+    uint64_t op_ns[BENCH_NUM_OPS] = {0};
+    uint32_t num_reqs = 100000;
+    uint32_t i;
+    uint32_t n;
+    uint32_t op;
+    uint64_t t0;
+    size_t data_length;
+    psa_status_t err = PSA_SUCCESS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:Hh")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_reqs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'H':
+            printf("%8s %8s %8s %10s %10s %10s %10s %10s\n",
+                   "max_B", "chunk_B", "obj_B", "get_info", "read",
+                   "write", "create", "delete");
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if (num_reqs == 0) {
+        num_reqs = 1;
+    }
+
+    err = ps_system_prepare();
+    if (err != PSA_SUCCESS) {
+        err = ps_system_wipe_all();
+    }
+    if (err != PSA_SUCCESS) {
+        fail("prepare", err);
+    }
+
+    for (i = 0; i < BENCH_NUM_OBJECTS; i++) {
+        bench_create(i);
+    }
+
+    for (n = 0; n < num_reqs; n++) {
+        i = n % BENCH_NUM_OBJECTS;
+
+        for (op = 0; op < BENCH_NUM_OPS; op++) {
+            (void)memset(data, (int)(n + op), sizeof(data));
+            bench_req_in = data;
+            bench_req_out = out;
+
+            t0 = bench_now_ns();
+            switch (op) {
+            case BENCH_OP_GET_INFO:
+                err = ps_object_get_info(i + 1, -1, &info);
+                break;
+            case BENCH_OP_READ:
+                err = ps_object_read(i + 1, -1, 0, sizeof(out),
+                                     &data_length);
+                break;
+            case BENCH_OP_WRITE:
+                err = ps_object_write(i + 1, -1, 0, sizeof(data));
+                break;
+            case BENCH_OP_CREATE:
+                err = ps_object_create(i + 1, -1, PSA_STORAGE_FLAG_NONE,
+                                       sizeof(data));
+                break;
+            case BENCH_OP_DELETE:
+                err = ps_object_delete(i + 1, -1);
+                break;
+            default:
+                break;
+            }
+            op_ns[op] += bench_now_ns() - t0;
+
+            if (err != PSA_SUCCESS) {
+                fail(bench_op_name[op], err);
+            }
+        }
+
+        /* Put the object back for the next round */
+        bench_create(i);
+    }
+
+    printf("%8u %8u %8u", (unsigned)PS_MAX_ASSET_SIZE,
+           (unsigned)PS_ENCRYPTION_CHUNK_SIZE, BENCH_OBJ_SIZE);
+    for (op = 0; op < BENCH_NUM_OPS; op++) {
+        printf(" %10llu", (unsigned long long)(op_ns[op] / num_reqs));
+    }
+    printf("\n");
+
+    bench_free_files();
+
+    return 0;
+}
@@ -0,0 +1,556 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host tests of the PS object system with the PS encryption. The tests run
+ * random creates, partial writes, partial reads and deletes of a few objects
+ * and check them against a model, while making file writes and encryptions
+ * fail and changing the content of the files. They check as well that the
+ * plaintext of an object is not left in the chunk buffer of the encryption
+ * when a write fails, and, with PS_STREAM_WINDOW_SIZE, that a segment file of
+ * another version of an object is not accepted.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "psa/internal_trusted_storage.h"
+#include "ps_bench_stubs.h"
+#include "ps_object_system.h"
+
+#define TEST_NUM_OBJECTS     6u
+#define TEST_CLIENT_ID       (-1)
+
+/* Number of random requests of each test, and of changes of the files */
+#define TEST_NUM_OPS         20000u
+#define TEST_NUM_TAMPERS     500u
+
+struct test_object_t {
+    bool exists;
+    uint32_t max_size;
+    uint32_t size;
+    uint8_t data[PS_MAX_ASSET_SIZE];
+};
+
+static struct test_object_t objects[TEST_NUM_OBJECTS];
+static uint8_t req_buf[PS_MAX_ASSET_SIZE];
+static uint8_t out_buf[PS_MAX_ASSET_SIZE];
+static uint32_t rand_state;
+static uint32_t failures;
+
+#define TEST_CHECK(cond, ...)                               \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            failures++;                                     \
+            fprintf(stderr, "%s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            return -1;                                      \
+        }                                                   \
+    } while (0)
+
+static uint32_t test_rand(void)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+/* Starts a test on an empty PS area */
+static int start(uint32_t seed)
+{
+    rand_state = seed;
+    (void)memset(objects, 0, sizeof(objects));
+    bench_fail_set = 0;
+    bench_fail_encrypt = 0;
+
+    bench_free_files();
+    TEST_CHECK(ps_system_wipe_all() == PSA_SUCCESS, "cannot wipe PS");
+    TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "cannot prepare PS");
+
+    return 0;
+}
+
+static int stop(void)
+{
+    bench_free_files();
+
+    return 0;
+}
+
+/* Checks whether the object in PS holds the content given */
+static bool object_matches(uint32_t idx, const struct test_object_t *obj)
+{
+    struct psa_storage_info_t info;
+    size_t data_length = 0;
+    psa_status_t err;
+
+    err = ps_object_get_info(idx + 1, TEST_CLIENT_ID, &info);
+    if (err == PSA_ERROR_DOES_NOT_EXIST) {
+        return !obj->exists;
+    } else if ((err != PSA_SUCCESS) || !obj->exists ||
+               (info.size != obj->size) || (info.capacity != obj->max_size)) {
+        return false;
+    }
+
+    bench_req_out = out_buf;
+    err = ps_object_read(idx + 1, TEST_CLIENT_ID, 0, obj->size, &data_length);
+
+    return (err == PSA_SUCCESS) && (data_length == obj->size) &&
+           (memcmp(out_buf, obj->data, obj->size) == 0);
+}
+
+/* Arms the failure of a file write or of an encryption for the next
+ * request, for a part of the requests
+ */
+static void arm_failure(void)
+{
+    switch (test_rand() % 8u) {
+    case 0:
+        bench_fail_set = 1u + (test_rand() % 3u);
+        break;
+    case 1:
+        bench_fail_encrypt = 1u + (test_rand() % 4u);
+        break;
+    default:
+        break;
+    }
+}
+
+static bool failure_armed(void)
+{
+    return (bench_fail_set != 0) || (bench_fail_encrypt != 0);
+}
+
+static void disarm_failure(void)
+{
+    bench_fail_set = 0;
+    bench_fail_encrypt = 0;
+}
+
+/* Runs a random request and updates the model */
+static int random_op(void)
+{
+    uint32_t idx = test_rand() % TEST_NUM_OBJECTS;
+    struct test_object_t *obj = &objects[idx];
+    struct test_object_t next = *obj;
+    size_t data_length = 0;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t i;
+    bool armed;
+    psa_status_t err;
+
+    switch (test_rand() % 4u) {
+    case 0:
+        /* Create, or replace, the object */
+        size = 1u + (test_rand() % PS_MAX_ASSET_SIZE);
+        for (i = 0; i < size; i++) {
+            req_buf[i] = (uint8_t)test_rand();
+        }
+        next.exists = true;
+        next.max_size = size;
+        next.size = size;
+        (void)memcpy(next.data, req_buf, size);
+
+        arm_failure();
+        armed = failure_armed();
+        bench_req_in = req_buf;
+        err = ps_object_create(idx + 1, TEST_CLIENT_ID, PSA_STORAGE_FLAG_NONE,
+                               size);
+        break;
+    case 1:
+        /* Write a part of the object, possibly extending it */
+        if (!obj->exists) {
+            return 0;
+        }
+        offset = test_rand() % (obj->size + 1u);
+        size = test_rand() % (obj->max_size - offset + 1u);
+        for (i = 0; i < size; i++) {
+            req_buf[i] = (uint8_t)test_rand();
+        }
+        (void)memcpy(&next.data[offset], req_buf, size);
+        if (offset + size > next.size) {
+            next.size = offset + size;
+        }
+
+        arm_failure();
+        armed = failure_armed();
+        bench_req_in = req_buf;
+        err = ps_object_write(idx + 1, TEST_CLIENT_ID, offset, size);
+        break;
+    case 2:
+        /* Read a part of the object */
+        if (!obj->exists) {
+            return 0;
+        }
+        offset = test_rand() % (obj->size + 1u);
+        size = test_rand() % (obj->size - offset + 1u);
+        bench_req_out = out_buf;
+        err = ps_object_read(idx + 1, TEST_CLIENT_ID, offset, size,
+                             &data_length);
+        TEST_CHECK((err == PSA_SUCCESS) && (data_length == size) &&
+                   (memcmp(out_buf, &obj->data[offset], size) == 0),
+                   "read of object %u failed (status %d)", (unsigned)idx,
+                   (int)err);
+        return 0;
+    default:
+        if (!obj->exists) {
+            return 0;
+        }
+        next.exists = false;
+
+        arm_failure();
+        armed = failure_armed();
+        err = ps_object_delete(idx + 1, TEST_CLIENT_ID);
+        break;
+    }
+
+    /* The failure may not have been reached by the request */
+    disarm_failure();
+
+    if (err == PSA_SUCCESS) {
+        *obj = next;
+    } else {
+        TEST_CHECK(armed, "request on object %u failed (status %d)",
+                   (unsigned)idx, (int)err);
+
+        /* A failed request is not applied, or applied as a whole */
+        if (!object_matches(idx, obj)) {
+            TEST_CHECK(object_matches(idx, &next),
+                       "failed request partly applied to object %u",
+                       (unsigned)idx);
+            *obj = next;
+        }
+    }
+
+    return 0;
+}
+
+/* Checks every object against the model, after a boot */
+static int reboot(void)
+{
+    uint32_t idx;
+
+    TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "cannot prepare PS");
+
+    for (idx = 0; idx < TEST_NUM_OBJECTS; idx++) {
+        TEST_CHECK(object_matches(idx, &objects[idx]),
+                   "object %u does not match the model after a boot",
+                   (unsigned)idx);
+    }
+
+    return 0;
+}
+
+/* Random requests, some of them failing on a file write or an encryption. A
+ * failed request must leave the object unchanged or fully updated.
+ */
+static int test_random_ops(void)
+{
+    uint32_t n;
+
+    if (start(1) != 0) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_OPS; n++) {
+        if (random_op() != 0) {
+            return -1;
+        }
+
+        if (((n % 1000u) == 999u) && (reboot() != 0)) {
+            return -1;
+        }
+    }
+
+    return stop();
+}
+
+/* Reads every object after a change of the files. Each object is either read
+ * correctly or not at all, which is counted as a detection of the change.
+ */
+static int check_objects(uint32_t *p_num_detected)
+{
+    uint32_t idx;
+    struct psa_storage_info_t info;
+    size_t data_length;
+    psa_status_t err;
+
+    for (idx = 0; idx < TEST_NUM_OBJECTS; idx++) {
+        if (!objects[idx].exists) {
+            continue;
+        }
+
+        if (ps_object_get_info(idx + 1, TEST_CLIENT_ID, &info) !=
+            PSA_SUCCESS) {
+            (*p_num_detected)++;
+            continue;
+        }
+
+        bench_req_out = out_buf;
+        data_length = 0;
+        err = ps_object_read(idx + 1, TEST_CLIENT_ID, 0,
+                             objects[idx].size, &data_length);
+        if (err != PSA_SUCCESS) {
+            (*p_num_detected)++;
+            continue;
+        }
+
+        TEST_CHECK((info.size == objects[idx].size) &&
+                   (data_length == objects[idx].size) &&
+                   (memcmp(out_buf, objects[idx].data,
+                           objects[idx].size) == 0),
+                   "object %u read with changed content", (unsigned)idx);
+    }
+
+    return 0;
+}
+
+/* Changes a byte of a random file. The object system must not return data
+ * which is not the one of the model, only fail the request.
+ */
+static int test_tamper(void)
+{
+    uint32_t num_detected = 0;
+    uint32_t n;
+    uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint8_t mask;
+
+    if (start(2) != 0) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_OPS / 10u; n++) {
+        if (random_op() != 0) {
+            return -1;
+        }
+    }
+
+    for (n = 0; n < TEST_NUM_TAMPERS; n++) {
+        data = bench_file_data(bench_file_uid(test_rand() % BENCH_NUM_FILES),
+                               &size);
+        if (data == NULL) {
+            continue;
+        }
+
+        pos = test_rand() % size;
+        mask = (uint8_t)(1u << (test_rand() % 8u));
+        data[pos] ^= mask;
+
+        if (check_objects(&num_detected) != 0) {
+            return -1;
+        }
+
+        data[pos] ^= mask;
+    }
+
+    TEST_CHECK(num_detected > 0, "no change of the files detected");
+
+    return stop();
+}
+
+#if PS_OBJECT_STREAM
+/* Copies of the segment files, saved before some requests */
+static uint8_t *saved_data[BENCH_NUM_FILES];
+static size_t saved_size[BENCH_NUM_FILES];
+
+static void free_saved(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < BENCH_NUM_FILES; i++) {
+        free(saved_data[i]);
+        saved_data[i] = NULL;
+        saved_size[i] = 0;
+    }
+}
+
+static int save_segments(void)
+{
+    const uint8_t *data;
+    size_t size;
+    uint32_t i;
+
+    free_saved();
+
+    /* The segment files follow the files of the File IDs */
+    for (i = BENCH_NUM_FIDS; i < BENCH_NUM_FILES; i++) {
+        data = bench_file_data(bench_file_uid(i), &size);
+        if (data == NULL) {
+            continue;
+        }
+
+        saved_data[i] = malloc(size);
+        TEST_CHECK(saved_data[i] != NULL, "out of memory");
+        (void)memcpy(saved_data[i], data, size);
+        saved_size[i] = size;
+    }
+
+    return 0;
+}
+
+/* Puts back, one at a time, the segment files saved before some requests
+ * which have since been replaced by the ones of another version of an object
+ * stored with the same File ID. The object system must not return data which
+ * is not the one of the model, only fail the request.
+ */
+static int test_replay(void)
+{
+    uint32_t num_detected = 0;
+    uint32_t num_replayed = 0;
+    uint32_t n;
+    uint32_t i;
+    psa_storage_uid_t uid;
+    const uint8_t *data;
+    uint8_t *current;
+    size_t size;
+
+    if (start(4) != 0) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_OPS / 10u; n++) {
+        if (((n % 20u) == 0u) && (save_segments() != 0)) {
+            return -1;
+        }
+
+        if (random_op() != 0) {
+            return -1;
+        }
+
+        if ((n % 20u) != 19u) {
+            continue;
+        }
+
+        for (i = BENCH_NUM_FIDS; i < BENCH_NUM_FILES; i++) {
+            uid = bench_file_uid(i);
+            data = bench_file_data(uid, &size);
+            if ((data == NULL) || (saved_data[i] == NULL) ||
+                ((size == saved_size[i]) &&
+                 (memcmp(data, saved_data[i], size) == 0))) {
+                continue;
+            }
+
+            current = malloc(size);
+            TEST_CHECK(current != NULL, "out of memory");
+            (void)memcpy(current, data, size);
+
+            (void)psa_its_set(uid, saved_size[i], saved_data[i],
+                              PSA_STORAGE_FLAG_NONE);
+            num_replayed++;
+
+            if (check_objects(&num_detected) != 0) {
+                free(current);
+                return -1;
+            }
+
+            (void)psa_its_set(uid, size, current, PSA_STORAGE_FLAG_NONE);
+            free(current);
+        }
+    }
+
+    free_saved();
+
+    TEST_CHECK(num_replayed > 0, "no segment file replayed");
+    TEST_CHECK(num_detected > 0, "no replay of the segment files detected");
+
+    return stop();
+}
+#endif /* PS_OBJECT_STREAM */
+
+#if PS_OBJECT_CHUNKS
+/* Checks that the buffer given to the last encryption, which is the chunk
+ * buffer, holds no data
+ */
+static int check_chunk_buf_wiped(void)
+{
+    size_t i;
+
+    TEST_CHECK(bench_encrypt_out_size ==
+               PS_ENCRYPTION_CHUNK_SIZE + PS_TAG_LEN_BYTES,
+               "last encryption not to the chunk buffer");
+
+    for (i = 0; i < bench_encrypt_out_size; i++) {
+        TEST_CHECK(bench_encrypt_out[i] == 0,
+                   "chunk buffer not wiped at byte %u", (unsigned)i);
+    }
+
+    return 0;
+}
+
+/* A write to the middle of a chunk decrypts the old chunk in the chunk buffer.
+ * The plaintext must not be left there when the write fails.
+ */
+static int test_chunk_buf_wipe(void)
+{
+    const uint32_t size = 2u * PS_ENCRYPTION_CHUNK_SIZE;
+    uint32_t i;
+
+    if (start(3) != 0) {
+        return -1;
+    }
+
+    for (i = 0; i < size; i++) {
+        req_buf[i] = (uint8_t)(0xA5u ^ i);
+    }
+    bench_req_in = req_buf;
+    TEST_CHECK(ps_object_create(1, TEST_CLIENT_ID, PSA_STORAGE_FLAG_NONE,
+                                size) == PSA_SUCCESS, "create failed");
+
+    /* The encryption of the merged chunk fails */
+    bench_fail_encrypt = 1;
+    bench_req_in = req_buf;
+    TEST_CHECK(ps_object_write(1, TEST_CLIENT_ID, 1, 1) != PSA_SUCCESS,
+               "write succeeded despite the encryption failure");
+    disarm_failure();
+    if (check_chunk_buf_wiped() != 0) {
+        return -1;
+    }
+
+    return stop();
+}
+#endif /* PS_OBJECT_CHUNKS */
+
+static const struct {
+    const char *name;
+    int (*run)(void);
+} tests[] = {
+    { "random_ops", test_random_ops },
+    { "tamper", test_tamper },
+#if PS_OBJECT_CHUNKS
+    { "chunk_buf_wipe", test_chunk_buf_wipe },
+#endif
+#if PS_OBJECT_STREAM
+    { "replay", test_replay },
+#endif
+};
+
+int main(int argc, char *argv[])
+{
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if ((argc > 1) && (strcmp(argv[1], tests[i].name) != 0)) {
+            continue;
+        }
+
+        ret = tests[i].run();
+        printf("%s: %s\n", tests[i].name, (ret == 0) ? "PASS" : "FAIL");
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,419 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host tests of the PS rollback protection with PS_NV_COUNTER_BATCH_SIZE. The
+ * PS files are saved after each commit of the object table, and restored later
+ * with the current NV counters. A saved PS area must be accepted at boot if and
+ * only if its last commit belongs to the current batch of commits, and no IV
+ * may be issued twice across the rollbacks.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "nv_counters/ps_nv_counters.h"
+#include "psa/internal_trusted_storage.h"
+#include "ps_bench_stubs.h"
+#include "ps_object_system.h"
+
+#define TEST_CLIENT_ID       (-1)
+#define TEST_UID             1u
+#define TEST_BATCH_SIZE      PS_NV_COUNTER_BATCH_SIZE
+
+/* Number of commits of the random test */
+#define TEST_NUM_COMMITS     (4u * TEST_BATCH_SIZE + 8u)
+
+/* Number of IVs which can be recorded by a test */
+#define TEST_MAX_IVS         4096u
+
+/* Copy of the PS files after a commit, and the state the commit left */
+struct test_snapshot_t {
+    uint8_t *data[BENCH_NUM_FILES];
+    size_t size[BENCH_NUM_FILES];
+    uint32_t batch;   /* Batch of commits of the commit */
+    uint32_t value;   /* Value of the object written by the commit */
+};
+
+static uint32_t nv_counters[3];
+static struct test_snapshot_t snapshots[TEST_NUM_COMMITS];
+
+/* Number of batches since the start of the test, and number of commits left
+ * in the current one. The first commit after a boot starts a new batch.
+ */
+static uint32_t num_batches;
+static uint32_t batch_left;
+static uint32_t nvc_1_start;
+
+/* IVs used by the encryptions and tag generations since the start of a test */
+static uint8_t ivs[TEST_MAX_IVS][PS_IV_LEN_BYTES];
+static uint32_t num_ivs;
+
+static uint32_t rand_state;
+static uint32_t failures;
+
+#define TEST_CHECK(cond, ...)                               \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            failures++;                                     \
+            fprintf(stderr, "%s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            return -1;                                      \
+        }                                                   \
+    } while (0)
+
+psa_status_t ps_read_nv_counter(enum tfm_nv_counter_t counter_id,
+                                uint32_t *val)
+{
+    *val = nv_counters[counter_id - TFM_PS_NV_COUNTER_1];
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_increment_nv_counter(enum tfm_nv_counter_t counter_id)
+{
+    nv_counters[counter_id - TFM_PS_NV_COUNTER_1]++;
+
+    return PSA_SUCCESS;
+}
+
+static uint32_t test_rand(void)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+static void record_iv(const uint8_t *iv)
+{
+    if (num_ivs < TEST_MAX_IVS) {
+        (void)memcpy(ivs[num_ivs], iv, PS_IV_LEN_BYTES);
+    }
+    num_ivs++;
+}
+
+static int compare_ivs(const void *a, const void *b)
+{
+    return memcmp(a, b, PS_IV_LEN_BYTES);
+}
+
+static void free_snapshots(void)
+{
+    uint32_t n;
+    uint32_t i;
+
+    for (n = 0; n < TEST_NUM_COMMITS; n++) {
+        for (i = 0; i < BENCH_NUM_FILES; i++) {
+            free(snapshots[n].data[i]);
+            snapshots[n].data[i] = NULL;
+            snapshots[n].size[i] = 0;
+        }
+    }
+}
+
+static int save(uint32_t n, uint32_t value)
+{
+    const uint8_t *data;
+    size_t size;
+    uint32_t i;
+
+    for (i = 0; i < BENCH_NUM_FILES; i++) {
+        data = bench_file_data(bench_file_uid(i), &size);
+        if (data == NULL) {
+            continue;
+        }
+
+        snapshots[n].data[i] = malloc(size);
+        TEST_CHECK(snapshots[n].data[i] != NULL, "out of memory");
+        (void)memcpy(snapshots[n].data[i], data, size);
+        snapshots[n].size[i] = size;
+    }
+
+    snapshots[n].batch = num_batches - 1;
+    snapshots[n].value = value;
+
+    return 0;
+}
+
+/* Restores the PS files saved after a commit, keeping the NV counters */
+static void restore(uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < BENCH_NUM_FILES; i++) {
+        if (snapshots[n].data[i] != NULL) {
+            (void)psa_its_set(bench_file_uid(i), snapshots[n].size[i],
+                              snapshots[n].data[i], PSA_STORAGE_FLAG_NONE);
+        } else {
+            (void)psa_its_remove(bench_file_uid(i));
+        }
+    }
+}
+
+static bool read_value(uint32_t *p_value)
+{
+    size_t data_length = 0;
+
+    bench_req_out = (uint8_t *)p_value;
+
+    return (ps_object_read(TEST_UID, TEST_CLIENT_ID, 0, sizeof(*p_value),
+                           &data_length) == PSA_SUCCESS) &&
+           (data_length == sizeof(*p_value));
+}
+
+/* Boots on the PS files saved after a commit. Returns true if they are
+ * accepted, with the object written by the commit.
+ */
+static bool boot_accepts(uint32_t n)
+{
+    uint32_t value = 0;
+
+    restore(n);
+    batch_left = 0;
+
+    return (ps_system_prepare() == PSA_SUCCESS) && read_value(&value) &&
+           (value == snapshots[n].value);
+}
+
+/* Starts a test with an object created and a boot */
+static int start(uint32_t seed)
+{
+    uint32_t value = 0;
+
+    rand_state = seed;
+    (void)memset(nv_counters, 0, sizeof(nv_counters));
+    num_batches = 0;
+    batch_left = 0;
+    num_ivs = 0;
+    bench_iv_used = record_iv;
+
+    free_snapshots();
+    bench_free_files();
+    TEST_CHECK(ps_system_wipe_all() == PSA_SUCCESS, "cannot wipe PS");
+    TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "cannot prepare PS");
+
+    bench_req_in = (const uint8_t *)&value;
+    TEST_CHECK(ps_object_create(TEST_UID, TEST_CLIENT_ID,
+                                PSA_STORAGE_FLAG_NONE, sizeof(value)) ==
+               PSA_SUCCESS, "cannot create the object");
+    TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "cannot boot");
+    nvc_1_start = nv_counters[0];
+
+    return 0;
+}
+
+static int stop(void)
+{
+    bench_iv_used = NULL;
+    free_snapshots();
+    bench_free_files();
+
+    return 0;
+}
+
+/* Writes the object, which commits the object table, and saves the PS files */
+static int commit(uint32_t n)
+{
+    uint32_t value = n + 1u;
+
+    bench_req_in = (const uint8_t *)&value;
+    TEST_CHECK(ps_object_write(TEST_UID, TEST_CLIENT_ID, 0, sizeof(value)) ==
+               PSA_SUCCESS, "write %u failed", (unsigned)n);
+
+    if (batch_left == 0) {
+        num_batches++;
+        batch_left = TEST_BATCH_SIZE;
+    }
+    batch_left--;
+
+    /* NVC 1 is incremented once per batch, NVC 2 and 3 follow it */
+    TEST_CHECK((nv_counters[0] - nvc_1_start == num_batches) &&
+               (nv_counters[1] == nv_counters[0]) &&
+               (nv_counters[2] == nv_counters[0]),
+               "NV counters %u %u %u after %u batches",
+               (unsigned)nv_counters[0], (unsigned)nv_counters[1],
+               (unsigned)nv_counters[2], (unsigned)num_batches);
+
+    return save(n, value);
+}
+
+static int commit_range(uint32_t first, uint32_t last)
+{
+    uint32_t n;
+
+    for (n = first; n <= last; n++) {
+        if (commit(n) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* The commits 0 to N - 1 are the first batch, N starts the second one and
+ * N + batch size the third one. The last commit of a batch is rejected once
+ * the next batch has started, the commits of the current batch are accepted.
+ */
+static int test_batch_boundary(void)
+{
+    const uint32_t n = TEST_BATCH_SIZE;
+
+    if ((start(1) != 0) || (commit_range(0, n) != 0)) {
+        return -1;
+    }
+
+    TEST_CHECK(!boot_accepts(n - 1), "commit N - 1 accepted in batch of N");
+    TEST_CHECK(boot_accepts(n), "commit N rejected");
+
+    if ((start(1) != 0) || (commit_range(0, n + TEST_BATCH_SIZE) != 0)) {
+        return -1;
+    }
+
+    TEST_CHECK(!boot_accepts(n), "commit N accepted in batch of N + batch");
+    TEST_CHECK(!boot_accepts(n + TEST_BATCH_SIZE - 1),
+               "last commit of the batch of N accepted in the next batch");
+    TEST_CHECK(boot_accepts(n + TEST_BATCH_SIZE), "commit N + batch rejected");
+
+    return stop();
+}
+
+/* Random commits with boots. At each boot, every saved PS area is accepted
+ * if and only if it belongs to the current batch.
+ */
+static int test_batch_sweep(void)
+{
+    uint32_t num_rejected_boundary = 0;
+    uint32_t n;
+    uint32_t j;
+    uint32_t batch;
+    bool accepted;
+
+    if (start(2) != 0) {
+        return -1;
+    }
+
+    for (n = 0; n < TEST_NUM_COMMITS; n++) {
+        if (commit(n) != 0) {
+            return -1;
+        }
+
+        if (((test_rand() % TEST_BATCH_SIZE) != 0) &&
+            (n != TEST_NUM_COMMITS - 1u)) {
+            continue;
+        }
+
+        batch = snapshots[n].batch;
+        for (j = 0; j <= n; j++) {
+            accepted = boot_accepts(j);
+            TEST_CHECK(accepted == (snapshots[j].batch == batch),
+                       "commit %u of batch %u %s in batch %u", (unsigned)j,
+                       (unsigned)snapshots[j].batch,
+                       accepted ? "accepted" : "rejected", (unsigned)batch);
+
+            if ((j + 1u <= n) && (snapshots[j + 1u].batch == batch) &&
+                (snapshots[j].batch != batch)) {
+                num_rejected_boundary++;
+            }
+        }
+
+        /* Go on from the latest commit, the next one starts a new batch */
+        TEST_CHECK(boot_accepts(n), "latest commit %u rejected", (unsigned)n);
+    }
+
+    TEST_CHECK(num_rejected_boundary > 0, "no batch boundary checked");
+
+    return stop();
+}
+
+/* A power failure after the increment of NVC 1 by the first commit of a
+ * batch. The PS area of the previous commit is accepted through NVC 3, the
+ * ones of older batches are still rejected.
+ */
+static int test_nvc_1_increment(void)
+{
+    const uint32_t n = 2u * TEST_BATCH_SIZE;
+
+    if ((start(3) != 0) || (commit_range(0, n) != 0)) {
+        return -1;
+    }
+
+    nv_counters[0]++;
+
+    TEST_CHECK(!boot_accepts(n - TEST_BATCH_SIZE),
+               "commit of the previous batch accepted through NVC 3");
+    TEST_CHECK(boot_accepts(n), "latest commit rejected through NVC 3");
+
+    return stop();
+}
+
+/* Rolls back all the commits of the current batch but the first one, then
+ * commits again, a few times. The IVs of the commits after a rollback must
+ * differ from the ones of the commits rolled back, which were restored with
+ * the PS area of the first commit.
+ */
+static int test_iv_reuse(void)
+{
+    uint32_t first;
+    uint32_t i;
+
+    if ((start(4) != 0) || (commit_range(0, TEST_BATCH_SIZE - 1u) != 0)) {
+        return -1;
+    }
+
+    for (first = 0; first < 3u * TEST_BATCH_SIZE; first += TEST_BATCH_SIZE) {
+        TEST_CHECK(boot_accepts(first), "commit %u rejected in its batch",
+                   (unsigned)first);
+        if (commit_range(first + TEST_BATCH_SIZE,
+                         first + (2u * TEST_BATCH_SIZE) - 1u) != 0) {
+            return -1;
+        }
+    }
+
+    TEST_CHECK(num_ivs <= TEST_MAX_IVS, "%u IVs used", (unsigned)num_ivs);
+
+    qsort(ivs, num_ivs, PS_IV_LEN_BYTES, compare_ivs);
+    for (i = 1; i < num_ivs; i++) {
+        TEST_CHECK(memcmp(ivs[i - 1u], ivs[i], PS_IV_LEN_BYTES) != 0,
+                   "IV used twice out of %u", (unsigned)num_ivs);
+    }
+
+    return stop();
+}
+
+static const struct {
+    const char *name;
+    int (*run)(void);
+} tests[] = {
+    { "batch_boundary", test_batch_boundary },
+    { "batch_sweep", test_batch_sweep },
+    { "nvc_1_increment", test_nvc_1_increment },
+    { "iv_reuse", test_iv_reuse },
+};
+
+int main(int argc, char *argv[])
+{
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if ((argc > 1) && (strcmp(argv[1], tests[i].name) != 0)) {
+            continue;
+        }
+
+        ret = tests[i].run();
+        printf("%s: %s\n", tests[i].name, (ret == 0) ? "PASS" : "FAIL");
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
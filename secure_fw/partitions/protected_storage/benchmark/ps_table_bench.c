@@ -0,0 +1,398 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host benchmark of the PS object table. It fills the object table with
+ * PS_NUM_ASSETS objects and measures the CPU time of the object table
+ * operations, and the amount of data written per update. The object table and
+ * its journal are saved in and loaded from RAM instead of ITS, and the PS
+ * rollback protection is not part of the benchmark, so that only the cost of
+ * the table itself is measured. With PS_ENCRYPTION, the PS crypto interface is
+ * replaced by a cheap checksum, and the number of bytes authenticated or
+ * hashed per update is reported, as the cost of the crypto on the target.
+ */
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config_tfm.h"
+#include "psa/internal_trusted_storage.h"
+#include "ps_object_table.h"
+#ifdef PS_ENCRYPTION
+#include "crypto/ps_crypto_interface.h"
+#endif
+
+/* File IDs of the PS files, the object files are not stored */
+#define BENCH_NUM_FILES        PS_MAX_NUM_OBJECTS
+
+/* Size of the object data buffer used to load an object table */
+#define BENCH_OBJ_DATA_SIZE    PS_MAX_ASSET_SIZE
+
+/* RAM storage of the object table and journal files */
+static struct {
+    uint8_t *data;
+    size_t size;
+} files[BENCH_NUM_FILES];
+
+/* Number of bytes written in the files */
+static uint64_t bytes_written;
+
+static uint8_t obj_data[BENCH_OBJ_DATA_SIZE];
+
+#ifdef PS_ENCRYPTION
+/* Number of bytes authenticated or hashed */
+static uint64_t crypto_bytes;
+
+/* Last IV */
+static uint32_t iv_counter;
+#endif
+
+static psa_storage_uid_t *uids;
+static int32_t *client_ids;
+
+psa_status_t psa_its_set(psa_storage_uid_t uid, size_t data_length,
+                         const void *p_data, psa_storage_create_flags_t flags)
+{
+    uint8_t *data;
+
+    (void)flags;
+
+    if (uid == 0 || uid > BENCH_NUM_FILES ||
+        data_length > PS_MAX_ASSET_SIZE) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    data = realloc(files[uid - 1].data, data_length);
+    if (data == NULL) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    (void)memcpy(data, p_data, data_length);
+    files[uid - 1].data = data;
+    files[uid - 1].size = data_length;
+    bytes_written += data_length;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_its_get(psa_storage_uid_t uid, size_t data_offset,
+                         size_t data_size, void *p_data,
+                         size_t *p_data_length)
+{
+    if (uid == 0 || uid > BENCH_NUM_FILES || files[uid - 1].size == 0) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    if (data_offset > files[uid - 1].size) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (data_size > files[uid - 1].size - data_offset) {
+        data_size = files[uid - 1].size - data_offset;
+    }
+
+    (void)memcpy(p_data, files[uid - 1].data + data_offset, data_size);
+    *p_data_length = data_size;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_its_remove(psa_storage_uid_t uid)
+{
+    if (uid == 0 || uid > BENCH_NUM_FILES || files[uid - 1].size == 0) {
+        /* The object files are not stored */
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    files[uid - 1].size = 0;
+
+    return PSA_SUCCESS;
+}
+
+#ifdef PS_ENCRYPTION
+/* FNV-1a checksum of the data, in place of the MAC and hash of the target */
+static void bench_checksum(const uint8_t *in, size_t in_len, uint8_t *out,
+                           size_t out_len)
+{
+    uint32_t h = 2166136261u;
+    size_t i;
+
+    crypto_bytes += in_len;
+
+    for (i = 0; i < in_len; i++) {
+        h = (h ^ in[i]) * 16777619u;
+    }
+
+    for (i = 0; i < out_len; i++) {
+        h = (h ^ (uint32_t)i) * 16777619u;
+        out[i] = (uint8_t)(h >> 24);
+    }
+}
+
+void ps_crypto_set_iv(const union ps_crypto_t *crypto)
+{
+    (void)memcpy(&iv_counter, crypto->ref.iv, sizeof(iv_counter));
+}
+
+psa_status_t ps_crypto_get_iv(union ps_crypto_t *crypto)
+{
+    iv_counter++;
+    (void)memset(crypto->ref.iv, 0, PS_IV_LEN_BYTES);
+    (void)memcpy(crypto->ref.iv, &iv_counter, sizeof(iv_counter));
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_generate_auth_tag(union ps_crypto_t *crypto,
+                                         const uint8_t *add,
+                                         uint32_t add_len)
+{
+    bench_checksum(add, add_len, crypto->ref.tag, PS_TAG_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
+                                    const uint8_t *add,
+                                    uint32_t add_len)
+{
+    uint8_t tag[PS_TAG_LEN_BYTES];
+
+    bench_checksum(add, add_len, tag, PS_TAG_LEN_BYTES);
+
+    return (memcmp(tag, crypto->ref.tag, PS_TAG_LEN_BYTES) == 0) ?
+           PSA_SUCCESS : PSA_ERROR_INVALID_SIGNATURE;
+}
+
+psa_status_t ps_crypto_hash(const uint8_t *in, size_t in_len, uint8_t *hash)
+{
+    bench_checksum(in, in_len, hash, PS_HASH_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
+#endif /* PS_ENCRYPTION */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static void fail(const char *what, psa_status_t err)
+{
+    fprintf(stderr, "%s failed: %d\n", what, (int)err);
+    exit(1);
+}
+
+static psa_status_t set_object(psa_storage_uid_t uid, int32_t client_id,
+                               uint32_t fid_num)
+{
+    struct ps_obj_table_info_t info = { 0 };
+    psa_status_t err;
+#ifdef PS_ENCRYPTION
+    uint8_t tag[PS_TAG_LEN_BYTES] = { 0 };
+
+    info.tag = tag;
+#endif
+
+    err = ps_object_table_get_free_fid(fid_num, &info.fid);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return ps_object_table_set_obj_tbl_info(uid, client_id, &info);
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-r rounds] [-s seed] [-H]\n"
+           "  -r  rounds of lookups over all the objects (default 100)\n"
+           "  -s  seed of the UIDs (default 1)\n"
+           "  -H  print the header of the results\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+    struct ps_obj_table_info_t info;
+    uint32_t rounds = 100;
+    uint32_t seed = 1;
+    uint32_t num_assets = PS_NUM_ASSETS;
+    uint32_t i;
+    uint32_t r;
+    uint32_t fid;
+    uint64_t t0;
+    uint64_t hit_ns;
+    uint64_t miss_ns;
+    uint64_t free_ns;
+    uint64_t update_ns;
+    uint64_t update_bytes;
+    uint64_t update_crypto_bytes = 0;
+    uint64_t init_ns;
+    psa_status_t err;
+    int opt;
+#ifdef PS_ENCRYPTION
+    uint8_t tag[PS_TAG_LEN_BYTES];
+
+    info.tag = tag;
+#endif
+
+    while ((opt = getopt(argc, argv, "r:s:Hh")) != -1) {
+        switch (opt) {
+        case 'r':
+            rounds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'H':
+            printf("%8s %6s %8s %6s %12s %12s %12s %12s %12s %12s %12s\n",
+                   "assets", "index", "journal", "merkle", "hit_ns", "miss_ns",
+                   "free_fid_ns", "update_ns", "update_B", "crypto_B",
+                   "init_us");
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if (rounds == 0) {
+        rounds = 1;
+    }
+
+    uids = calloc(num_assets, sizeof(*uids));
+    client_ids = calloc(num_assets, sizeof(*client_ids));
+    if (uids == NULL || client_ids == NULL) {
+        return 1;
+    }
+
+    srand(seed);
+    for (i = 0; i < num_assets; i++) {
+        /* Random UIDs, spread over a few clients, including NS ones */
+        uids[i] = ((psa_storage_uid_t)(uint32_t)rand() << 32) |
+                  (uint32_t)rand() | 1u;
+        client_ids[i] = (int32_t)(i % 4) - 2;
+    }
+
+    err = ps_object_table_create();
+    if (err != PSA_SUCCESS) {
+        fail("create", err);
+    }
+
+    /* Keep a free entry for the updates, as the PS object system does */
+    for (i = 0; i < num_assets; i++) {
+        err = set_object(uids[i], client_ids[i], 2);
+        if (err != PSA_SUCCESS) {
+            fail("set", err);
+        }
+    }
+
+    /* Lookup of existing objects */
+    t0 = now_ns();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < num_assets; i++) {
+            err = ps_object_table_get_obj_tbl_info(uids[i], client_ids[i],
+                                                   &info);
+            if (err != PSA_SUCCESS) {
+                fail("get", err);
+            }
+        }
+    }
+    hit_ns = (now_ns() - t0) / ((uint64_t)rounds * num_assets);
+
+    /* Lookup of objects which do not exist */
+    t0 = now_ns();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < num_assets; i++) {
+            err = ps_object_table_obj_exist(uids[i] ^ 2u, client_ids[i]);
+            if (err != PSA_ERROR_DOES_NOT_EXIST) {
+                fail("exist", err);
+            }
+        }
+    }
+    miss_ns = (now_ns() - t0) / ((uint64_t)rounds * num_assets);
+
+    /* Allocation of a file ID for a new version of an object */
+    t0 = now_ns();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < num_assets; i++) {
+            err = ps_object_table_get_free_fid(1, &fid);
+            if (err != PSA_SUCCESS) {
+                fail("get_free_fid", err);
+            }
+        }
+    }
+    free_ns = (now_ns() - t0) / ((uint64_t)rounds * num_assets);
+
+    /* Update of each object, which includes saving the table in RAM */
+    bytes_written = 0;
+#ifdef PS_ENCRYPTION
+    crypto_bytes = 0;
+#endif
+    t0 = now_ns();
+    for (i = 0; i < num_assets; i++) {
+        err = set_object(uids[i], client_ids[i], 1);
+        if (err != PSA_SUCCESS) {
+            fail("update", err);
+        }
+        (void)ps_object_table_delete_old_table();
+    }
+    update_ns = (now_ns() - t0) / num_assets;
+    update_bytes = bytes_written / num_assets;
+#ifdef PS_ENCRYPTION
+    update_crypto_bytes = crypto_bytes / num_assets;
+#endif
+
+    /* Load of the table, as at boot */
+    t0 = now_ns();
+    err = ps_object_table_init(obj_data);
+    if (err != PSA_SUCCESS) {
+        fail("init", err);
+    }
+    init_ns = now_ns() - t0;
+
+    /* Check the table content after the load */
+    for (i = 0; i < num_assets; i++) {
+        err = ps_object_table_obj_exist(uids[i], client_ids[i]);
+        if (err != PSA_SUCCESS) {
+            fail("check", err);
+        }
+        err = ps_object_table_delete_object(uids[i], client_ids[i]);
+        if (err != PSA_SUCCESS) {
+            fail("remove", err);
+        }
+        if (ps_object_table_obj_exist(uids[i], client_ids[i]) !=
+            PSA_ERROR_DOES_NOT_EXIST) {
+            fail("check removed", PSA_ERROR_GENERIC_ERROR);
+        }
+    }
+
+    printf("%8u %6s %8u %6u %12llu %12llu %12llu %12llu %12llu %12llu "
+           "%12.1f\n",
+           num_assets, PS_OBJ_TABLE_INDEX ? "hash" : "linear",
+           (unsigned)PS_OBJ_TABLE_JOURNAL_SIZE,
+           (unsigned)PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES,
+           (unsigned long long)hit_ns, (unsigned long long)miss_ns,
+           (unsigned long long)free_ns, (unsigned long long)update_ns,
+           (unsigned long long)update_bytes,
+           (unsigned long long)update_crypto_bytes, (double)init_ns / 1000.0);
+
+    free(uids);
+    free(client_ids);
+    for (i = 0; i < BENCH_NUM_FILES; i++) {
+        free(files[i].data);
+    }
+
+    return 0;
+}
@@ -0,0 +1,453 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host tests of the upgrade of the PS object table from the object system
+ * version 1, whose entries have no object information. The PS area is written
+ * by the current object system, and its object table is then rewritten in the
+ * layout of version 1, as the tables of version 1 are written. The objects
+ * must be read in full at the next boot, with their object information read
+ * from the object headers, and the table must be saved in the current
+ * version. The tests are built with the PS encryption, without rollback
+ * protection, object table journal or hash tree, and the object table layouts
+ * below must follow the ones of ps_object_table.c for this configuration.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "crypto/ps_crypto_interface.h"
+#include "psa/internal_trusted_storage.h"
+#include "ps_bench_stubs.h"
+#include "ps_object_system.h"
+
+#define TEST_NUM_OBJECTS     6u
+#define TEST_CLIENT_ID       (-1)
+
+/* File IDs of the two object tables */
+#define TEST_TABLE_FID(idx)  ((idx) + 1u)
+
+#define TEST_VERSION_1       0x01u
+#define TEST_VERSION         0x02u
+
+#define TEST_OBJ_TABLE_ENTRIES (PS_NUM_ASSETS + 1)
+
+/* Object table of the current version */
+struct test_entry_t {
+    uint8_t tag[PS_TAG_LEN_BYTES];
+    psa_storage_uid_t uid;
+    int32_t client_id;
+    struct ps_object_info_t info;
+};
+
+struct test_table_t {
+    union ps_crypto_t crypto;
+    uint8_t version;
+    uint8_t swap_count;
+    struct test_entry_t obj_db[TEST_OBJ_TABLE_ENTRIES];
+};
+
+/* Object table of version 1 */
+struct test_entry_v1_t {
+    uint8_t tag[PS_TAG_LEN_BYTES];
+    psa_storage_uid_t uid;
+    int32_t client_id;
+};
+
+struct test_table_v1_t {
+    union ps_crypto_t crypto;
+    uint8_t version;
+    uint8_t swap_count;
+    struct test_entry_v1_t obj_db[TEST_OBJ_TABLE_ENTRIES];
+};
+
+struct test_object_t {
+    uint32_t size;
+    uint8_t data[PS_MAX_ASSET_SIZE];
+};
+
+static struct test_object_t objects[TEST_NUM_OBJECTS];
+static struct test_table_t table;
+static struct test_table_v1_t table_v1;
+static uint8_t out_buf[PS_MAX_ASSET_SIZE];
+static uint32_t rand_state;
+static uint32_t failures;
+
+#define TEST_CHECK(cond, ...)                               \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            failures++;                                     \
+            fprintf(stderr, "%s:%d: ", __func__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            return -1;                                      \
+        }                                                   \
+    } while (0)
+
+static uint32_t test_rand(void)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+/* Gets the File ID of the only object table file, 0 if there is not one */
+static uint32_t table_fid(void)
+{
+    size_t size;
+    bool table_0 = (bench_file_data(TEST_TABLE_FID(0), &size) != NULL);
+    bool table_1 = (bench_file_data(TEST_TABLE_FID(1), &size) != NULL);
+
+    if (table_0 == table_1) {
+        return 0;
+    }
+
+    return table_0 ? TEST_TABLE_FID(0) : TEST_TABLE_FID(1);
+}
+
+/* Starts a test with objects of random sizes written by the current object
+ * system
+ */
+static int start(uint32_t seed)
+{
+    uint32_t idx;
+    uint32_t i;
+
+    rand_state = seed;
+    bench_fail_set = 0;
+    bench_fail_encrypt = 0;
+    bench_fail_get_uid = 0;
+
+    bench_free_files();
+    TEST_CHECK(ps_system_wipe_all() == PSA_SUCCESS, "cannot wipe PS");
+    TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "cannot prepare PS");
+
+    for (idx = 0; idx < TEST_NUM_OBJECTS; idx++) {
+        objects[idx].size = 1u + (test_rand() % PS_MAX_ASSET_SIZE);
+        for (i = 0; i < objects[idx].size; i++) {
+            objects[idx].data[i] = (uint8_t)test_rand();
+        }
+
+        bench_req_in = objects[idx].data;
+        TEST_CHECK(ps_object_create(idx + 1, TEST_CLIENT_ID,
+                                    PSA_STORAGE_FLAG_NONE,
+                                    objects[idx].size) == PSA_SUCCESS,
+                   "cannot create object %u", (unsigned)idx);
+    }
+
+    /* Only the active table is left after a boot */
+    TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "cannot boot");
+
+    return 0;
+}
+
+static int stop(void)
+{
+    bench_free_files();
+
+    return 0;
+}
+
+/* Rewrites the object table in the layout of version 1 */
+static int downgrade_table(void)
+{
+    uint32_t fid = table_fid();
+    psa_storage_uid_t uid;
+    size_t data_length = 0;
+    uint32_t idx;
+
+    TEST_CHECK(fid != 0, "not a single object table file");
+    TEST_CHECK(psa_its_get(fid, 0, sizeof(table), &table, &data_length) ==
+               PSA_SUCCESS && data_length == sizeof(table),
+               "object table of %u bytes instead of %u", (unsigned)data_length,
+               (unsigned)sizeof(table));
+    TEST_CHECK(table.version == TEST_VERSION, "object table of version %u",
+               (unsigned)table.version);
+
+    (void)memset(&table_v1, 0, sizeof(table_v1));
+    table_v1.crypto = table.crypto;
+    table_v1.version = TEST_VERSION_1;
+    table_v1.swap_count = table.swap_count;
+
+    for (idx = 0; idx < TEST_OBJ_TABLE_ENTRIES; idx++) {
+        (void)memcpy(table_v1.obj_db[idx].tag, table.obj_db[idx].tag,
+                     PS_TAG_LEN_BYTES);
+        table_v1.obj_db[idx].uid = table.obj_db[idx].uid;
+        table_v1.obj_db[idx].client_id = table.obj_db[idx].client_id;
+    }
+
+    /* The whole table of version 1 is authenticated. The key label fields
+     * of the crypto metadata are the ones of the current table.
+     */
+    TEST_CHECK(ps_crypto_get_iv(&table_v1.crypto) == PSA_SUCCESS, "no IV");
+    TEST_CHECK(ps_crypto_generate_auth_tag(&table_v1.crypto,
+                                           (const uint8_t *)&table_v1 +
+                                           sizeof(union ps_crypto_t),
+                                           sizeof(table_v1) -
+                                           sizeof(union ps_crypto_t)) ==
+               PSA_SUCCESS, "cannot authenticate the table of version 1");
+
+    TEST_CHECK(psa_its_set(fid, sizeof(table_v1), &table_v1,
+                           PSA_STORAGE_FLAG_NONE) == PSA_SUCCESS,
+               "cannot write the table of version 1");
+
+    /* Check that the current table has the layout above */
+    for (uid = 1; uid <= TEST_NUM_OBJECTS; uid++) {
+        for (idx = 0; idx < TEST_OBJ_TABLE_ENTRIES; idx++) {
+            if (table.obj_db[idx].uid == uid) {
+                break;
+            }
+        }
+        TEST_CHECK(idx < TEST_OBJ_TABLE_ENTRIES &&
+                   table.obj_db[idx].info.current_size ==
+                   objects[uid - 1].size,
+                   "object %u not in the table", (unsigned)(uid - 1));
+    }
+
+    return 0;
+}
+
+/* Checks whether the object in PS holds the content of the model, with the
+ * object information of the object table
+ */
+static bool object_matches(uint32_t idx)
+{
+    const struct test_object_t *obj = &objects[idx];
+    struct psa_storage_info_t info;
+    size_t data_length = 0;
+
+    if ((ps_object_get_info(idx + 1, TEST_CLIENT_ID, &info) != PSA_SUCCESS) ||
+        (info.size != obj->size) || (info.capacity != obj->size) ||
+        (info.flags != PSA_STORAGE_FLAG_NONE)) {
+        return false;
+    }
+
+    bench_req_out = out_buf;
+
+    return (ps_object_read(idx + 1, TEST_CLIENT_ID, 0, obj->size,
+                           &data_length) == PSA_SUCCESS) &&
+           (data_length == obj->size) &&
+           (memcmp(out_buf, obj->data, obj->size) == 0);
+}
+
+/* Checks that the object table is the only table, in the current version */
+static int check_table(void)
+{
+    uint32_t fid = table_fid();
+    size_t data_length = 0;
+
+    TEST_CHECK(fid != 0, "not a single object table file");
+    TEST_CHECK(psa_its_get(fid, 0, sizeof(table), &table, &data_length) ==
+               PSA_SUCCESS && data_length == sizeof(table) &&
+               table.version == TEST_VERSION,
+               "object table not upgraded");
+
+    return 0;
+}
+
+/* Boots on a PS area with an object table of version 1. The objects are kept,
+ * and the table is saved in the current version.
+ */
+static int test_upgrade(void)
+{
+    uint32_t idx;
+    uint32_t boot;
+
+    if ((start(1) != 0) || (downgrade_table() != 0)) {
+        return -1;
+    }
+
+    for (boot = 0; boot < 2; boot++) {
+        TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "boot %u failed",
+                   (unsigned)boot);
+        if (check_table() != 0) {
+            return -1;
+        }
+
+        for (idx = 0; idx < TEST_NUM_OBJECTS; idx++) {
+            TEST_CHECK(object_matches(idx), "object %u lost at boot %u",
+                       (unsigned)idx, (unsigned)boot);
+        }
+    }
+
+    return stop();
+}
+
+/* The upgraded table cannot be written. The table of version 1 is kept, and
+ * the upgrade is done again at the next boot.
+ */
+static int test_upgrade_failure(void)
+{
+    uint32_t idx;
+
+    if ((start(2) != 0) || (downgrade_table() != 0)) {
+        return -1;
+    }
+
+    bench_fail_set = 1;
+    TEST_CHECK(ps_system_prepare() != PSA_SUCCESS,
+               "boot succeeded without saving the upgraded table");
+    bench_fail_set = 0;
+
+    TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "boot failed");
+    if (check_table() != 0) {
+        return -1;
+    }
+
+    for (idx = 0; idx < TEST_NUM_OBJECTS; idx++) {
+        TEST_CHECK(object_matches(idx), "object %u lost", (unsigned)idx);
+    }
+
+    return stop();
+}
+
+/* An object cannot be read at the upgrade. It is removed from the table, the
+ * other objects are kept.
+ */
+static int test_upgrade_corrupt_object(void)
+{
+    const uint32_t bad = TEST_NUM_OBJECTS / 2u;
+    struct psa_storage_info_t info;
+    uint32_t idx;
+    uint8_t *data;
+    size_t size;
+
+    if ((start(3) != 0) || (downgrade_table() != 0)) {
+        return -1;
+    }
+
+    for (idx = 0; idx < TEST_OBJ_TABLE_ENTRIES; idx++) {
+        if (table_v1.obj_db[idx].uid == bad + 1u) {
+            break;
+        }
+    }
+
+    /* The objects are stored after the two table files */
+    data = bench_file_data(TEST_TABLE_FID(2) + idx, &size);
+    TEST_CHECK(data != NULL, "no file for object %u", (unsigned)bad);
+    data[size - 1u] ^= 0x01u;
+
+    TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "boot failed");
+    if (check_table() != 0) {
+        return -1;
+    }
+
+    for (idx = 0; idx < TEST_NUM_OBJECTS; idx++) {
+        if (idx == bad) {
+            TEST_CHECK(ps_object_get_info(idx + 1, TEST_CLIENT_ID, &info) ==
+                       PSA_ERROR_DOES_NOT_EXIST,
+                       "corrupted object %u kept", (unsigned)idx);
+        } else {
+            TEST_CHECK(object_matches(idx), "object %u lost", (unsigned)idx);
+        }
+    }
+
+    /* The object can be created again */
+    bench_req_in = objects[bad].data;
+    TEST_CHECK(ps_object_create(bad + 1u, TEST_CLIENT_ID, PSA_STORAGE_FLAG_NONE,
+                                objects[bad].size) == PSA_SUCCESS,
+               "cannot create object %u again", (unsigned)bad);
+    TEST_CHECK(object_matches(bad), "object %u not created", (unsigned)bad);
+
+    return stop();
+}
+
+/* An object cannot be read at the upgrade because of a storage failure. The
+ * boot fails without saving the upgraded table, and the object is kept by the
+ * upgrade at the next boot.
+ */
+static int test_upgrade_storage_failure(void)
+{
+    const uint32_t bad = TEST_NUM_OBJECTS / 2u;
+    uint32_t idx;
+    uint8_t *data;
+    size_t size;
+
+    if ((start(5) != 0) || (downgrade_table() != 0)) {
+        return -1;
+    }
+
+    for (idx = 0; idx < TEST_OBJ_TABLE_ENTRIES; idx++) {
+        if (table_v1.obj_db[idx].uid == bad + 1u) {
+            break;
+        }
+    }
+
+    /* The objects are stored after the two table files */
+    bench_fail_get_uid = TEST_TABLE_FID(2) + idx;
+    TEST_CHECK(ps_system_prepare() != PSA_SUCCESS,
+               "boot succeeded without reading object %u", (unsigned)bad);
+    bench_fail_get_uid = 0;
+
+    data = bench_file_data(table_fid(), &size);
+    TEST_CHECK((data != NULL) && (size == sizeof(table_v1)) &&
+               (memcmp(data, &table_v1, size) == 0),
+               "table of version 1 changed by the failed upgrade");
+
+    TEST_CHECK(ps_system_prepare() == PSA_SUCCESS, "boot failed");
+    if (check_table() != 0) {
+        return -1;
+    }
+
+    for (idx = 0; idx < TEST_NUM_OBJECTS; idx++) {
+        TEST_CHECK(object_matches(idx), "object %u lost", (unsigned)idx);
+    }
+
+    return stop();
+}
+
+/* A table of version 1 which does not authenticate is not upgraded */
+static int test_upgrade_corrupt_table(void)
+{
+    uint8_t *data;
+    size_t size;
+
+    if ((start(4) != 0) || (downgrade_table() != 0)) {
+        return -1;
+    }
+
+    data = bench_file_data(table_fid(), &size);
+    data[size - 1u] ^= 0x01u;
+
+    TEST_CHECK(ps_system_prepare() != PSA_SUCCESS,
+               "corrupted table of version 1 accepted");
+
+    return stop();
+}
+
+static const struct {
+    const char *name;
+    int (*run)(void);
+} tests[] = {
+    { "upgrade", test_upgrade },
+    { "upgrade_failure", test_upgrade_failure },
+    { "upgrade_corrupt_object", test_upgrade_corrupt_object },
+    { "upgrade_storage_failure", test_upgrade_storage_failure },
+    { "upgrade_corrupt_table", test_upgrade_corrupt_table },
+};
+
+int main(int argc, char *argv[])
+{
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if ((argc > 1) && (strcmp(argv[1], tests[i].name) != 0)) {
+            continue;
+        }
+
+        ret = tests[i].run();
+        printf("%s: %s\n", tests[i].name, (ret == 0) ? "PASS" : "FAIL");
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -24,6 +24,34 @@
 #error "Invalid config: NOT PS_ROLLBACK_PROTECTION and PS_ENCRYPTION and PSA_ALG_GCM or PSA_ALG_CCM!"
 #endif
 
+#if PS_NV_COUNTER_BATCH_SIZE == 0
+#error "Invalid config: PS_NV_COUNTER_BATCH_SIZE shall be at least 1!"
+#endif
+
+#if PS_ROLLBACK_PROTECTION && (PS_NV_COUNTER_BATCH_SIZE > 1) && \
+    (PS_OBJ_TABLE_JOURNAL_SIZE == 0)
+#error "Invalid config: PS_NV_COUNTER_BATCH_SIZE > 1 and PS_ROLLBACK_PROTECTION and NOT PS_OBJ_TABLE_JOURNAL_SIZE!"
+#endif
+
+#if (PS_ENCRYPTION_CHUNK_SIZE != 0) && (PS_AES_KEY_USAGE_LIMIT != 0)
+#error "Invalid config: PS_ENCRYPTION_CHUNK_SIZE and PS_AES_KEY_USAGE_LIMIT!"
+#endif
+
+#if (PS_STREAM_WINDOW_SIZE != 0) && \
+    ((!defined(PS_ENCRYPTION)) || (PS_ENCRYPTION_CHUNK_SIZE == 0))
+#error "Invalid config: PS_STREAM_WINDOW_SIZE and NOT PS_ENCRYPTION_CHUNK_SIZE!"
+#endif
+
+#if (PS_STREAM_WINDOW_SIZE != 0) && (PS_ENCRYPTION_CHUNK_SIZE != 0) && \
+    (PS_STREAM_WINDOW_SIZE % PS_ENCRYPTION_CHUNK_SIZE != 0)
+#error "Invalid config: PS_STREAM_WINDOW_SIZE shall be a multiple of PS_ENCRYPTION_CHUNK_SIZE!"
+#endif
+
+#if (PS_STREAM_WINDOW_SIZE != 0) && \
+    (PS_OBJECT_CACHE_SIZE > PS_STREAM_WINDOW_SIZE)
+#error "Invalid config: PS_OBJECT_CACHE_SIZE shall not be larger than PS_STREAM_WINDOW_SIZE!"
+#endif
+
 /*
  * ITS_VALIDATE_METADATA_FROM_FLASH shall be enabled when PS_VALIDATE_METADATA_FROM_FLASH is
  * enabled
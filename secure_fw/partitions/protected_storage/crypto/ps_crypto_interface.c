@@ -31,6 +31,9 @@
 #define PS_CRYPTO_ALG \
     PSA_ALG_AEAD_WITH_SHORTENED_TAG(PS_CRYPTO_AEAD_ALG, PS_TAG_LEN_BYTES)
 
+/* The PSA hash algorithm used by this implementation */
+#define PS_CRYPTO_HASH_ALG PSA_ALG_SHA_256
+
 /* Length of the label used to derive a crypto key */
 #if PS_AES_KEY_USAGE_LIMIT == 0
 #define LABEL_LEN (sizeof(int32_t) + sizeof(psa_storage_uid_t))
@@ -47,7 +50,22 @@
  */
 typedef char PS_ERROR_NOT_AEAD_ALG[(PSA_ALG_IS_AEAD(PS_CRYPTO_ALG)) ? 1 : -1];
 
-static uint8_t ps_crypto_iv_buf[PS_IV_LEN_BYTES];
+#if PS_CRYPTO_KEY_CACHE_SIZE > 0
+/*
+ * Keys derived for the most recently used labels, most recent first. They are
+ * kept as volatile keys in the Crypto service so that consecutive operations
+ * on the same object, or on the object table, don't derive the key again.
+ * The evicted keys are destroyed, and all the keys are destroyed when the
+ * storage key is switched.
+ */
+struct ps_crypto_key_cache_entry_t {
+    uint8_t label[LABEL_LEN]; /*!< Label the key has been derived from */
+    psa_key_id_t key;         /*!< Key handle, PSA_KEY_ID_NULL if unused */
+};
+
+static struct ps_crypto_key_cache_entry_t
+                                ps_crypto_key_cache[PS_CRYPTO_KEY_CACHE_SIZE];
+#endif /* PS_CRYPTO_KEY_CACHE_SIZE > 0 */
 
 static void fill_key_label(const union ps_crypto_t *crypto,
                            uint8_t *label)
@@ -126,6 +144,95 @@ err_release_op:
     return PSA_ERROR_GENERIC_ERROR;
 }
 
+/**
+ * \brief Gets the storage key associated to a key label, deriving it if it is
+ *        not resident already.
+ *
+ * \param[out] ps_key  Handle of the key
+ * \param[in]  label   Key label, of LABEL_LEN bytes
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+static psa_status_t ps_crypto_get_key(psa_key_id_t *ps_key,
+                                      const uint8_t *label)
+{
+#if PS_CRYPTO_KEY_CACHE_SIZE > 0
+    psa_status_t status;
+    struct ps_crypto_key_cache_entry_t entry;
+    uint32_t idx;
+
+    for (idx = 0; idx < PS_CRYPTO_KEY_CACHE_SIZE - 1; idx++) {
+        if ((ps_crypto_key_cache[idx].key == PSA_KEY_ID_NULL) ||
+            (memcmp(ps_crypto_key_cache[idx].label, label, LABEL_LEN) == 0)) {
+            break;
+        }
+    }
+
+    if ((ps_crypto_key_cache[idx].key == PSA_KEY_ID_NULL) ||
+        (memcmp(ps_crypto_key_cache[idx].label, label, LABEL_LEN) != 0)) {
+        /* Miss: evict the least recently used key first, so that its key
+         * slot in the Crypto service is free for the derived key.
+         */
+        if (ps_crypto_key_cache[idx].key != PSA_KEY_ID_NULL) {
+            (void)psa_destroy_key(ps_crypto_key_cache[idx].key);
+            ps_crypto_key_cache[idx].key = PSA_KEY_ID_NULL;
+        }
+
+        status = ps_crypto_setkey(&entry.key, label, LABEL_LEN);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+        (void)memcpy(entry.label, label, LABEL_LEN);
+    } else {
+        entry = ps_crypto_key_cache[idx];
+    }
+
+    /* Move the entry to the front of the cache */
+    for (; idx > 0; idx--) {
+        ps_crypto_key_cache[idx] = ps_crypto_key_cache[idx - 1];
+    }
+    ps_crypto_key_cache[0] = entry;
+
+    *ps_key = entry.key;
+
+    return PSA_SUCCESS;
+#else
+    return ps_crypto_setkey(ps_key, label, LABEL_LEN);
+#endif /* PS_CRYPTO_KEY_CACHE_SIZE > 0 */
+}
+
+/**
+ * \brief Releases a key obtained from \ref ps_crypto_get_key.
+ *
+ * \param[in] ps_key  Handle of the key
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+static psa_status_t ps_crypto_put_key(psa_key_id_t ps_key)
+{
+#if PS_CRYPTO_KEY_CACHE_SIZE > 0
+    /* The key stays resident in the cache */
+    (void)ps_key;
+    return PSA_SUCCESS;
+#else
+    return psa_destroy_key(ps_key);
+#endif
+}
+
+void ps_crypto_clear_keys(void)
+{
+#if PS_CRYPTO_KEY_CACHE_SIZE > 0
+    uint32_t idx;
+
+    for (idx = 0; idx < PS_CRYPTO_KEY_CACHE_SIZE; idx++) {
+        if (ps_crypto_key_cache[idx].key != PSA_KEY_ID_NULL) {
+            (void)psa_destroy_key(ps_crypto_key_cache[idx].key);
+            ps_crypto_key_cache[idx].key = PSA_KEY_ID_NULL;
+        }
+    }
+#endif /* PS_CRYPTO_KEY_CACHE_SIZE > 0 */
+}
+
 psa_status_t ps_crypto_init(void)
 {
     /* For GCM and CCM it is essential that nonce doesn't get repeated. If there
@@ -151,62 +258,17 @@ uint32_t ps_crypto_to_blocks(size_t in_len)
                 / PSA_BLOCK_CIPHER_BLOCK_LENGTH(PSA_KEY_TYPE_AES);
 }
 
-void ps_crypto_set_iv(const union ps_crypto_t *crypto)
-{
-    (void)memcpy(ps_crypto_iv_buf, crypto->ref.iv, PS_IV_LEN_BYTES);
-}
-
-psa_status_t ps_crypto_get_iv(union ps_crypto_t *crypto)
+psa_status_t ps_crypto_hash(const uint8_t *in, size_t in_len, uint8_t *hash)
 {
-    /* IV characteristic is algorithm dependent.
-     * For GCM it is essential that it doesn't get repeated.
-     * A simple increment will suffice.
-     * FIXME:
-     * Since IV is predictable in this case,
-     * If there is no rollback protection, an attacker could
-     * try to rollback the storage and encrypt another plaintext
-     * block with same IV/Key pair; this breaks GCM usage rules.
-     * One potential fix would be to generate IV through RNG
-     */
-
-    /* Logic:
-     * IV is a 12 byte value. Read the old value and increment it by 1.
-     * since there is no standard C support for 12 byte integer mathematics,
-     * the increment need to performed manually. Increment the lower 8byte
-     * as uint64_t value and then if the new value is 0, increment the upper
-     * 4 bytes as uint32_t
-     * Endian order doesn't really matter as objective is not to perform
-     * machine accurate increment operation but to generate a non-repetitive
-     * iv value.
-     */
+    psa_status_t status;
+    size_t out_len;
 
-    uint64_t iv_l;
-    uint32_t iv_h;
-
-    (void)memcpy(&iv_l, ps_crypto_iv_buf, sizeof(iv_l));
-    (void)memcpy(&iv_h, (ps_crypto_iv_buf+sizeof(iv_l)), sizeof(iv_h));
-    iv_l++;
-    /* If overflow, increment the MSBs */
-    if (iv_l == 0) {
-        iv_h++;
-
-        /* If overflow, return error. Different IV should be used. */
-        if (iv_h == 0) {
-            /* Reset iv_l and iv_h to the value before increasement. Otherwise,
-             * iv_l will start from '1' the next time this function is called.
-             */
-            iv_l--;
-            iv_h--;
-            return PSA_ERROR_GENERIC_ERROR;
-        }
+    status = psa_hash_compute(PS_CRYPTO_HASH_ALG, in, in_len,
+                              hash, PS_HASH_LEN_BYTES, &out_len);
+    if (status != PSA_SUCCESS || out_len != PS_HASH_LEN_BYTES) {
+        return PSA_ERROR_GENERIC_ERROR;
     }
 
-    /* Update the local buffer */
-    (void)memcpy(ps_crypto_iv_buf, &iv_l, sizeof(iv_l));
-    (void)memcpy((ps_crypto_iv_buf + sizeof(iv_l)), &iv_h, sizeof(iv_h));
-    /* Update the caller buffer */
-    (void)memcpy(crypto->ref.iv, ps_crypto_iv_buf, PS_IV_LEN_BYTES);
-
     return PSA_SUCCESS;
 }
 
@@ -225,7 +287,7 @@ psa_status_t ps_crypto_encrypt_and_tag(union ps_crypto_t *crypto,
 
     fill_key_label(crypto, label);
 
-    status = ps_crypto_setkey(&ps_key, label, sizeof(label));
+    status = ps_crypto_get_key(&ps_key, label);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -236,7 +298,7 @@ psa_status_t ps_crypto_encrypt_and_tag(union ps_crypto_t *crypto,
                               in, in_len,
                               out, out_size, out_len);
     if (status != PSA_SUCCESS) {
-        (void)psa_destroy_key(ps_key);
+        (void)ps_crypto_put_key(ps_key);
         return PSA_ERROR_GENERIC_ERROR;
     }
 
@@ -244,8 +306,8 @@ psa_status_t ps_crypto_encrypt_and_tag(union ps_crypto_t *crypto,
     *out_len -= PS_TAG_LEN_BYTES;
     (void)memcpy(crypto->ref.tag, (out + *out_len), PS_TAG_LEN_BYTES);
 
-    /* Destroy the transient key */
-    status = psa_destroy_key(ps_key);
+    /* Release the storage key */
+    status = ps_crypto_put_key(ps_key);
     if (status != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
@@ -272,7 +334,7 @@ psa_status_t ps_crypto_auth_and_decrypt(const union ps_crypto_t *crypto,
     (void)memcpy((in + in_len), crypto->ref.tag, PS_TAG_LEN_BYTES);
     in_len += PS_TAG_LEN_BYTES;
 
-    status = ps_crypto_setkey(&ps_key, label, sizeof(label));
+    status = ps_crypto_get_key(&ps_key, label);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -283,12 +345,14 @@ psa_status_t ps_crypto_auth_and_decrypt(const union ps_crypto_t *crypto,
                               in, in_len,
                               out, out_size, out_len);
     if (status != PSA_SUCCESS) {
-        (void)psa_destroy_key(ps_key);
-        return PSA_ERROR_INVALID_SIGNATURE;
+        (void)ps_crypto_put_key(ps_key);
+        /* Only a tag mismatch means that the data is not authentic */
+        return (status == PSA_ERROR_INVALID_SIGNATURE) ?
+               status : PSA_ERROR_GENERIC_ERROR;
     }
 
-    /* Destroy the transient key */
-    status = psa_destroy_key(ps_key);
+    /* Release the storage key */
+    status = ps_crypto_put_key(ps_key);
     if (status != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
@@ -307,7 +371,7 @@ psa_status_t ps_crypto_generate_auth_tag(union ps_crypto_t *crypto,
 
     fill_key_label(crypto, label);
 
-    status = ps_crypto_setkey(&ps_key, label, sizeof(label));
+    status = ps_crypto_get_key(&ps_key, label);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -318,12 +382,12 @@ psa_status_t ps_crypto_generate_auth_tag(union ps_crypto_t *crypto,
                               0, 0,
                               crypto->ref.tag, PS_TAG_LEN_BYTES, &out_len);
     if (status != PSA_SUCCESS || out_len != PS_TAG_LEN_BYTES) {
-        (void)psa_destroy_key(ps_key);
+        (void)ps_crypto_put_key(ps_key);
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    /* Destroy the transient key */
-    status = psa_destroy_key(ps_key);
+    /* Release the storage key */
+    status = ps_crypto_put_key(ps_key);
     if (status != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
@@ -342,7 +406,7 @@ psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
 
     fill_key_label(crypto, label);
 
-    status = ps_crypto_setkey(&ps_key, label, sizeof(label));
+    status = ps_crypto_get_key(&ps_key, label);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -353,12 +417,15 @@ psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
                               crypto->ref.tag, PS_TAG_LEN_BYTES,
                               0, 0, &out_len);
     if (status != PSA_SUCCESS || out_len != 0) {
-        (void)psa_destroy_key(ps_key);
-        return PSA_ERROR_INVALID_SIGNATURE;
+        (void)ps_crypto_put_key(ps_key);
+        /* Only a tag mismatch means that the data is not authentic */
+        return (status == PSA_SUCCESS ||
+                status == PSA_ERROR_INVALID_SIGNATURE) ?
+               PSA_ERROR_INVALID_SIGNATURE : PSA_ERROR_GENERIC_ERROR;
     }
 
-    /* Destroy the transient key */
-    status = psa_destroy_key(ps_key);
+    /* Release the storage key */
+    status = ps_crypto_put_key(ps_key);
     if (status != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
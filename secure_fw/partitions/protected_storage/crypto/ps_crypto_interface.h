@@ -21,6 +21,7 @@ extern "C" {
 
 #define PS_TAG_LEN_BYTES  16
 #define PS_IV_LEN_BYTES   12
+#define PS_HASH_LEN_BYTES 32
 
 /* Union containing crypto policy implementations. The ref member provides the
  * reference implementation. Further members can be added to the union to
@@ -45,6 +46,13 @@ union ps_crypto_t {
  */
 psa_status_t ps_crypto_init(void);
 
+/**
+ * \brief Destroys the storage keys kept resident in the Crypto service, see
+ *        PS_CRYPTO_KEY_CACHE_SIZE. The keys are derived again when they are
+ *        used next.
+ */
+void ps_crypto_clear_keys(void);
+
 /**
  * \brief Convert lengths to block count
  *
@@ -133,6 +141,19 @@ psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
  */
 void ps_crypto_set_iv(const union ps_crypto_t *crypto);
 
+/**
+ * \brief Binds the IVs issued from now on to a value of PS NV counter 1.
+ *
+ * \details With PS_NV_COUNTER_BATCH_SIZE above 1, the IV restored at boot can
+ *          be rolled back with the commits of the current batch, so the IVs
+ *          are made of a value of PS NV counter 1 which no IV has been bound
+ *          to before, and of a count of the IVs issued with it. No IV is
+ *          issued before the first call. Otherwise, this has no effect.
+ *
+ * \param[in] nvc_1  Value of PS NV counter 1 just incremented
+ */
+void ps_crypto_bind_iv(uint32_t nvc_1);
+
 /**
  * \brief Gets a new IV value into the crypto union.
  *
@@ -142,6 +163,18 @@ void ps_crypto_set_iv(const union ps_crypto_t *crypto);
  */
 psa_status_t ps_crypto_get_iv(union ps_crypto_t *crypto);
 
+/**
+ * \brief Computes the hash of given data.
+ *
+ * \param[in]  in      Pointer to the data to hash
+ * \param[in]  in_len  Length of the data to hash
+ * \param[out] hash    Pointer to the buffer to store the hash, of
+ *                     PS_HASH_LEN_BYTES bytes
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+psa_status_t ps_crypto_hash(const uint8_t *in, size_t in_len, uint8_t *hash);
+
 #ifdef PS_SUPPORT_FORMAT_TRANSITION
 /**
  * \brief Authenticate old format data against the tag.
@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "ps_crypto_interface.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "config_tfm.h"
+
+#if PS_ROLLBACK_PROTECTION && (PS_NV_COUNTER_BATCH_SIZE > 1)
+/* The IV of the latest commit of the object table can be rolled back within a
+ * batch of commits, so the IVs are bound to a value of PS NV counter 1 instead
+ * of following the IV restored at boot.
+ */
+#define PS_CRYPTO_IV_NVC_BOUND 1
+#else
+#define PS_CRYPTO_IV_NVC_BOUND 0
+#endif
+
+static uint8_t ps_crypto_iv_buf[PS_IV_LEN_BYTES];
+
+#if PS_CRYPTO_IV_NVC_BOUND
+/* Set once the IVs are bound to a value of PS NV counter 1 */
+static bool ps_crypto_iv_bound;
+#endif
+
+void ps_crypto_set_iv(const union ps_crypto_t *crypto)
+{
+#if PS_CRYPTO_IV_NVC_BOUND
+    /* The IVs only depend on the value of PS NV counter 1 they are bound to */
+    (void)crypto;
+#else
+    (void)memcpy(ps_crypto_iv_buf, crypto->ref.iv, PS_IV_LEN_BYTES);
+#endif
+}
+
+void ps_crypto_bind_iv(uint32_t nvc_1)
+{
+#if PS_CRYPTO_IV_NVC_BOUND
+    const uint64_t iv_l = 0;
+
+    (void)memcpy(ps_crypto_iv_buf, &iv_l, sizeof(iv_l));
+    (void)memcpy((ps_crypto_iv_buf + sizeof(iv_l)), &nvc_1, sizeof(nvc_1));
+    ps_crypto_iv_bound = true;
+#else
+    (void)nvc_1;
+#endif
+}
+
+psa_status_t ps_crypto_get_iv(union ps_crypto_t *crypto)
+{
+    /* IV characteristic is algorithm dependent.
+     * For GCM it is essential that it doesn't get repeated.
+     * A simple increment will suffice.
+     * FIXME:
+     * Since IV is predictable in this case,
+     * If there is no rollback protection, an attacker could
+     * try to rollback the storage and encrypt another plaintext
+     * block with same IV/Key pair; this breaks GCM usage rules.
+     * One potential fix would be to generate IV through RNG
+     */
+
+    /* Logic:
+     * IV is a 12 byte value. Read the old value and increment it by 1.
+     * since there is no standard C support for 12 byte integer mathematics,
+     * the increment need to performed manually. Increment the lower 8byte
+     * as uint64_t value and then if the new value is 0, increment the upper
+     * 4 bytes as uint32_t
+     * Endian order doesn't really matter as objective is not to perform
+     * machine accurate increment operation but to generate a non-repetitive
+     * iv value.
+     * When the IVs are bound to a value of PS NV counter 1, the upper 4 bytes
+     * hold that value, and only the lower 8 bytes are incremented.
+     */
+
+    uint64_t iv_l;
+    uint32_t iv_h;
+
+#if PS_CRYPTO_IV_NVC_BOUND
+    if (!ps_crypto_iv_bound) {
+        return PSA_ERROR_BAD_STATE;
+    }
+#endif
+
+    (void)memcpy(&iv_l, ps_crypto_iv_buf, sizeof(iv_l));
+    (void)memcpy(&iv_h, (ps_crypto_iv_buf+sizeof(iv_l)), sizeof(iv_h));
+    iv_l++;
+    /* If overflow, increment the MSBs */
+    if (iv_l == 0) {
+#if PS_CRYPTO_IV_NVC_BOUND
+        /* The MSBs are the value of PS NV counter 1 */
+        return PSA_ERROR_GENERIC_ERROR;
+#else
+        iv_h++;
+
+        /* If overflow, return error. Different IV should be used. */
+        if (iv_h == 0) {
+            /* Reset iv_l and iv_h to the value before increasement. Otherwise,
+             * iv_l will start from '1' the next time this function is called.
+             */
+            iv_l--;
+            iv_h--;
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+#endif
+    }
+
+    /* Update the local buffer */
+    (void)memcpy(ps_crypto_iv_buf, &iv_l, sizeof(iv_l));
+    (void)memcpy((ps_crypto_iv_buf + sizeof(iv_l)), &iv_h, sizeof(iv_h));
+    /* Update the caller buffer */
+    (void)memcpy(crypto->ref.iv, ps_crypto_iv_buf, PS_IV_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
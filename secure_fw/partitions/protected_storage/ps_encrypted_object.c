@@ -17,6 +17,44 @@
 #include "ps_object_defs.h"
 #include "ps_utils.h"
 
+#define PS_OBJECT_START_POSITION  0
+
+#if PS_OBJECT_CHUNKS
+/* Size (in bytes) of the object header that gets stored with the object data:
+ * the IV of the header, including any padding, the object information and the
+ * File ID.
+ */
+#define STORED_HEADER_DATA_SIZE (offsetof(struct ps_object_t, window) \
+                                 - offsetof(struct ps_object_t, header.crypto.ref.iv))
+
+/* Size of the header data authenticated by the tag stored in the object
+ * table.
+ */
+#define PS_HEADER_AUTH_SIZE (sizeof(struct ps_obj_header_t) \
+                             - offsetof(struct ps_obj_header_t, info))
+
+/* Size (in bytes) of the crypto metadata stored before the encrypted chunks
+ * of each window of object data, including any padding.
+ */
+#define STORED_WINDOW_DATA_SIZE (offsetof(struct ps_object_t, data) \
+                                 - offsetof(struct ps_object_t, window))
+
+/* Size of the crypto metadata of a window authenticated by its tag */
+#define PS_WINDOW_AUTH_SIZE (sizeof(struct ps_obj_window_t) \
+                             - offsetof(struct ps_obj_window_t, header_iv))
+
+/* Buffer of an encrypted chunk, with room for the tag appended to the
+ * ciphertext by the crypto layer.
+ */
+static uint8_t ps_chunk_buf[PS_ENCRYPTION_CHUNK_SIZE + PS_TAG_LEN_BYTES];
+
+/* IV of the header of the version of the object being written. It is drawn
+ * when the first window of object data is written, as the windows are bound
+ * to it, and only put in the header when the header is written, as the
+ * windows of the old version are bound to the IV of the old header.
+ */
+static uint8_t ps_header_iv[PS_IV_LEN_BYTES];
+#else
 /* Size (in bytes) of the additional data that gets stored with the object data, including any padding */
 #define STORED_HEADER_DATA_SIZE (offsetof(struct ps_object_t, header.info) \
                                  - offsetof(struct ps_object_t, header.crypto.ref.iv))
@@ -25,8 +63,6 @@
 #define PS_ENCRYPT_SIZE(plaintext_size) \
     ((plaintext_size) + offsetof(struct ps_object_t, data) - offsetof(struct ps_object_t, header.info))
 
-#define PS_OBJECT_START_POSITION  0
-
 /* Buffer to store the maximum encrypted object */
 /* FIXME: Do partial encrypt/decrypt to reduce the size of internal buffer */
 #define PS_MAX_ENCRYPTED_OBJ_SIZE PS_ENCRYPT_SIZE(PS_MAX_OBJECT_DATA_SIZE)
@@ -35,7 +71,669 @@
  * being appended to the ciphertext by the crypto layer.
  */
 #define PS_CRYPTO_BUF_LEN (PS_MAX_ENCRYPTED_OBJ_SIZE + PS_TAG_LEN_BYTES)
+#endif /* PS_OBJECT_CHUNKS */
+
+#if PS_OBJECT_CHUNKS
+/**
+ * \brief Gets the size of a chunk of object data.
+ *
+ * \param[in] data_size  Size of the object data
+ * \param[in] idx        Index of the chunk
+ *
+ * \return Returns the size of the chunk in bytes
+ */
+static uint32_t ps_chunk_size(uint32_t data_size, uint32_t idx)
+{
+    return PS_UTILS_MIN(PS_ENCRYPTION_CHUNK_SIZE,
+                        data_size - (idx * PS_ENCRYPTION_CHUNK_SIZE));
+}
+
+/**
+ * \brief Gets the location of a window of object data in the persistent area,
+ *        where its crypto metadata is stored, followed by its encrypted
+ *        chunks.
+ *
+ * \details The last window of object data is stored after the object header,
+ *          in the file of the object. With PS_STREAM_WINDOW_SIZE, each other
+ *          window is stored in a segment file of the object.
+ *
+ * \param[in]  fid       File ID of the object
+ * \param[in]  max_size  Maximum size of the object data
+ * \param[in]  win       Index of the window
+ * \param[out] p_uid     Pointer to store the UID of the file holding the window
+ * \param[out] p_offset  Pointer to store the offset of the window in the file
+ */
+static void ps_window_location(uint32_t fid, uint32_t max_size, uint32_t win,
+                               psa_storage_uid_t *p_uid, size_t *p_offset)
+{
+#if PS_OBJECT_STREAM
+    if (win < PS_OBJECT_LAST_WINDOW(max_size)) {
+        *p_uid = PS_OBJECT_SEGMENT_UID(fid, win);
+        *p_offset = 0;
+        return;
+    }
+#else
+    (void)max_size;
+    (void)win;
+#endif
+
+    *p_uid = fid;
+    *p_offset = STORED_HEADER_DATA_SIZE;
+}
+
+/**
+ * \brief Gets the location of a chunk of object data in the persistent area,
+ *        in the window of object data holding it.
+ *
+ * \param[in]  fid       File ID of the object
+ * \param[in]  max_size  Maximum size of the object data
+ * \param[in]  idx       Index of the chunk
+ * \param[out] p_uid     Pointer to store the UID of the file holding the chunk
+ * \param[out] p_offset  Pointer to store the offset of the chunk in the file
+ */
+static void ps_chunk_location(uint32_t fid, uint32_t max_size, uint32_t idx,
+                              psa_storage_uid_t *p_uid, size_t *p_offset)
+{
+    const uint32_t chunk_start = idx * PS_ENCRYPTION_CHUNK_SIZE;
+    const uint32_t win = chunk_start / PS_OBJECT_WINDOW_SIZE;
+
+    ps_window_location(fid, max_size, win, p_uid, p_offset);
+    *p_offset += STORED_WINDOW_DATA_SIZE + chunk_start -
+                 (win * PS_OBJECT_WINDOW_SIZE);
+}
+
+#if PS_OBJECT_STREAM
+/**
+ * \brief Gets the number of segment files of an object.
+ *
+ * \param[in] info  Object information
+ *
+ * \return Returns the number of windows of object data stored in segment files
+ */
+static uint32_t ps_object_num_segments(const struct ps_object_info_t *info)
+{
+    return PS_UTILS_MIN((info->current_size + PS_OBJECT_WINDOW_SIZE - 1) /
+                        PS_OBJECT_WINDOW_SIZE,
+                        PS_OBJECT_LAST_WINDOW(info->max_size));
+}
+#endif
+
+/**
+ * \brief Reads the crypto metadata of a window of object data in the window of
+ *        the object structure, and authenticates it with the IV of the header
+ *        of the version of the object it belongs to and the window index.
+ *
+ * \param[in]     fid        File ID
+ * \param[in]     header_iv  IV of the header of the version of the object
+ * \param[in]     win        Index of the window
+ * \param[in,out] obj        Pointer to the object structure
+ * \param[out]    p_blocks   Pointer to a counter of decryption blocks used
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_read_window(uint32_t fid,
+                                          const uint8_t *header_iv,
+                                          uint32_t win,
+                                          struct ps_object_t *obj,
+                                          uint32_t *p_blocks)
+{
+    psa_status_t err;
+    union ps_crypto_t crypto = obj->header.crypto;
+    psa_storage_uid_t uid;
+    size_t window_offset;
+    size_t data_length;
+
+    ps_window_location(fid, obj->header.info.max_size, win, &uid,
+                       &window_offset);
+
+    err = psa_its_get(uid, window_offset, STORED_WINDOW_DATA_SIZE,
+                      (void *)&obj->window, &data_length);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (data_length != STORED_WINDOW_DATA_SIZE) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    /* The metadata only authenticates with the header and the index of the
+     * window it was written for, so that the window of another version of
+     * the object stored with the same File ID is rejected.
+     */
+    (void)memcpy(obj->window.header_iv, header_iv, PS_IV_LEN_BYTES);
+    obj->window.win = win;
+
+    (void)memcpy(crypto.ref.iv, obj->window.iv, PS_IV_LEN_BYTES);
+    (void)memcpy(crypto.ref.tag, obj->window.tag, PS_TAG_LEN_BYTES);
+
+    *p_blocks += ps_crypto_to_blocks(PS_WINDOW_AUTH_SIZE);
+
+    err = ps_crypto_authenticate(&crypto,
+                                 (const uint8_t *)obj->window.header_iv,
+                                 PS_WINDOW_AUTH_SIZE);
+    if (err == PSA_ERROR_INVALID_SIGNATURE) {
+        /* The window does not match the header of the object */
+        return err;
+    }
+
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Authenticates the crypto metadata of a window of object data of the
+ *        version of the object being written, with the IV of its header and
+ *        the window index.
+ *
+ * \param[in]     win  Index of the window
+ * \param[in,out] obj  Pointer to the object structure, whose window is
+ *                     updated with the IV and tag of the window
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_tag_window(uint32_t win,
+                                         struct ps_object_t *obj)
+{
+    psa_status_t err;
+    union ps_crypto_t crypto = obj->header.crypto;
+
+    (void)memcpy(obj->window.header_iv, ps_header_iv, PS_IV_LEN_BYTES);
+    obj->window.win = win;
+
+    /* Get a new IV for each version of the window */
+    err = ps_crypto_get_iv(&crypto);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = ps_crypto_generate_auth_tag(&crypto,
+                                      (const uint8_t *)obj->window.header_iv,
+                                      PS_WINDOW_AUTH_SIZE);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    (void)memcpy(obj->window.iv, crypto.ref.iv, PS_IV_LEN_BYTES);
+    (void)memcpy(obj->window.tag, crypto.ref.tag, PS_TAG_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Reads and performs authenticated decryption on a chunk of object
+ *        data, with the chunk index as the associated data.
+ *
+ * \param[in]     fid       File ID
+ * \param[in]     idx       Index of the chunk
+ * \param[in]     obj       Pointer to the object structure, whose window holds
+ *                          the crypto metadata of the window of the chunk
+ * \param[out]    out       Pointer to store the decrypted chunk, which may be
+ *                          ps_chunk_buf
+ * \param[in,out] p_len     Size of the chunk to read and of the output buffer
+ *                          in bytes, updated with the size of the decrypted
+ *                          chunk
+ * \param[out]    p_blocks  Pointer to a counter of decryption blocks used
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_read_chunk(uint32_t fid, uint32_t idx,
+                                         const struct ps_object_t *obj,
+                                         uint8_t *out, size_t *p_len,
+                                         uint32_t *p_blocks)
+{
+    psa_status_t err;
+    union ps_crypto_t crypto = obj->header.crypto;
+    const struct ps_obj_chunk_t *chunk =
+        &obj->window.chunk[idx % PS_OBJECT_WINDOW_CHUNKS];
+    psa_storage_uid_t uid;
+    size_t chunk_offset;
+    size_t data_length;
+
+    ps_chunk_location(fid, obj->header.info.max_size, idx, &uid, &chunk_offset);
+
+    err = psa_its_get(uid, chunk_offset, *p_len, ps_chunk_buf, &data_length);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    (void)memcpy(crypto.ref.iv, chunk->iv, PS_IV_LEN_BYTES);
+    (void)memcpy(crypto.ref.tag, chunk->tag, PS_TAG_LEN_BYTES);
+
+    /* Assume that we used the key even if the crypto operation fails */
+    *p_blocks += ps_crypto_to_blocks(data_length);
+
+    err = ps_crypto_auth_and_decrypt(&crypto,
+                                     (const uint8_t *)&idx, sizeof(idx),
+                                     ps_chunk_buf, data_length,
+                                     out, *p_len, p_len);
+    if (err == PSA_ERROR_INVALID_SIGNATURE) {
+        /* The chunk does not match its tag */
+        return err;
+    }
+
+    if (err != PSA_SUCCESS || *p_len != data_length) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Performs authenticated encryption on a chunk of object data, in
+ *        place, with the chunk index as the associated data.
+ *
+ * \param[in]     idx     Index of the chunk
+ * \param[in]     len     Size of the chunk in bytes
+ * \param[in,out] obj     Pointer to the object structure, whose window is
+ *                        updated with the crypto metadata of the chunk
+ * \param[in,out] p_data  Pointer to the chunk in the window of object data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_encrypt_chunk(uint32_t idx, uint32_t len,
+                                            struct ps_object_t *obj,
+                                            uint8_t *p_data)
+{
+    psa_status_t err;
+    union ps_crypto_t crypto = obj->header.crypto;
+    struct ps_obj_chunk_t *chunk =
+        &obj->window.chunk[idx % PS_OBJECT_WINDOW_CHUNKS];
+    size_t out_len;
+
+    /* Get a new IV for each encryption */
+    err = ps_crypto_get_iv(&crypto);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = ps_crypto_encrypt_and_tag(&crypto,
+                                    (const uint8_t *)&idx, sizeof(idx),
+                                    p_data, len,
+                                    ps_chunk_buf, sizeof(ps_chunk_buf),
+                                    &out_len);
+    if (err != PSA_SUCCESS || out_len != len) {
+        /* The crypto layer may have left plaintext in the chunk buffer */
+        (void)memset(ps_chunk_buf, 0, sizeof(ps_chunk_buf));
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    (void)memcpy(p_data, ps_chunk_buf, len);
+    (void)memcpy(chunk->iv, crypto.ref.iv, PS_IV_LEN_BYTES);
+    (void)memcpy(chunk->tag, crypto.ref.tag, PS_TAG_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_encrypted_object_read_data(uint32_t fid,
+                                           struct ps_object_t *obj,
+                                           uint32_t offset,
+                                           uint32_t size,
+                                           uint32_t *p_blocks)
+{
+    psa_status_t err;
+    uint32_t data_size = obj->header.info.current_size;
+    uint32_t start;
+    uint32_t idx;
+    uint32_t last;
+    size_t data_length;
+
+    if (offset >= data_size || size == 0) {
+        return PSA_SUCCESS;
+    }
+
+    /* Limit the range to the window of object data holding its start */
+    start = offset - (offset % PS_OBJECT_WINDOW_SIZE);
+    size = PS_UTILS_MIN(size, PS_UTILS_MIN(data_size,
+                                           start + PS_OBJECT_WINDOW_SIZE) -
+                              offset);
+    last = (offset + size - 1) / PS_ENCRYPTION_CHUNK_SIZE;
+
+    err = ps_object_read_window(fid, obj->header.crypto.ref.iv,
+                                start / PS_OBJECT_WINDOW_SIZE, obj, p_blocks);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Decrypt the chunks covering the range, at their place in the window */
+    for (idx = offset / PS_ENCRYPTION_CHUNK_SIZE; idx <= last; idx++) {
+        data_length = ps_chunk_size(data_size, idx);
+
+        err = ps_object_read_chunk(fid, idx, obj,
+                                   obj->data +
+                                   (idx * PS_ENCRYPTION_CHUNK_SIZE) - start,
+                                   &data_length, p_blocks);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if (data_length != ps_chunk_size(data_size, idx)) {
+            return PSA_ERROR_DATA_CORRUPT;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_encrypted_object_read_range(uint32_t fid,
+                                            struct ps_object_t *obj,
+                                            uint32_t offset,
+                                            uint32_t size,
+                                            uint32_t *p_blocks)
+{
+    psa_status_t err;
+    size_t data_length;
+
+    *p_blocks = 0;
+
+    /* Read the object header, which starts with the IV */
+    err = psa_its_get(fid, PS_OBJECT_START_POSITION, STORED_HEADER_DATA_SIZE,
+                      (void *)obj->header.crypto.ref.iv, &data_length);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (data_length != STORED_HEADER_DATA_SIZE ||
+        obj->header.fid != fid ||
+        obj->header.info.max_size > PS_MAX_OBJECT_DATA_SIZE ||
+        obj->header.info.current_size > obj->header.info.max_size) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    /* Authenticate the header with the tag of the object, which is the one
+     * stored in the object table for the given File ID.
+     */
+    *p_blocks += ps_crypto_to_blocks(PS_HEADER_AUTH_SIZE);
+
+    err = ps_crypto_authenticate(&obj->header.crypto,
+                                 (const uint8_t *)&obj->header.info,
+                                 PS_HEADER_AUTH_SIZE);
+    if (err == PSA_ERROR_INVALID_SIGNATURE) {
+        /* The header does not match the tag of the object table */
+        return err;
+    }
+
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return ps_encrypted_object_read_data(fid, obj, offset, size, p_blocks);
+}
+
+psa_status_t ps_encrypted_object_write_window(uint32_t old_fid, uint32_t fid,
+                                              struct ps_object_t *obj,
+                                              uint32_t start,
+                                              uint32_t offset, uint32_t size)
+{
+    psa_status_t err;
+    uint32_t data_size = obj->header.info.current_size;
+    uint32_t end = offset + size;
+    uint32_t first = offset / PS_ENCRYPTION_CHUNK_SIZE;
+    uint32_t stop = (size == 0) ? first : PS_OBJECT_NUM_CHUNKS(end);
+    uint32_t win = start / PS_OBJECT_WINDOW_SIZE;
+    uint32_t num_blocks = 0;
+    uint32_t win_size;
+    uint32_t win_chunks;
+    uint32_t chunk_start;
+    uint32_t idx;
+    uint32_t len;
+    uint8_t *p_data;
+    union ps_crypto_t crypto;
+    psa_storage_uid_t uid;
+    size_t chunk_offset;
+    size_t data_length;
+
+    if (end < offset || end > data_size ||
+        (start % PS_OBJECT_WINDOW_SIZE) != 0 ||
+        (start != 0 && start >= data_size)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    win_size = PS_UTILS_MIN(PS_OBJECT_WINDOW_SIZE, data_size - start);
+    win_chunks = PS_OBJECT_NUM_CHUNKS(win_size);
+
+    if (start == 0) {
+        /* Get a new IV for the header of the new version of the object, which
+         * its windows are bound to.
+         */
+        crypto = obj->header.crypto;
+        err = ps_crypto_get_iv(&crypto);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+        (void)memcpy(ps_header_iv, crypto.ref.iv, PS_IV_LEN_BYTES);
+    }
+
+    if (old_fid != PS_INVALID_FID &&
+        (offset > start || end < start + win_size)) {
+        /* Some chunks of the window are kept from the old version of the
+         * object, so start from the crypto metadata of its window, which is
+         * bound to the header of the old version still held in obj.
+         */
+        err = ps_object_read_window(old_fid, obj->header.crypto.ref.iv, win,
+                                    obj, &num_blocks);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    for (idx = start / PS_ENCRYPTION_CHUNK_SIZE;
+         idx < PS_OBJECT_NUM_CHUNKS(start + win_size); idx++) {
+        chunk_start = idx * PS_ENCRYPTION_CHUNK_SIZE;
+        p_data = obj->data + (chunk_start - start);
+        len = ps_chunk_size(data_size, idx);
+
+        if (idx < first || idx >= stop) {
+            /* The chunk is unchanged, so its ciphertext is copied from the old
+             * version of the object, and its crypto metadata is kept.
+             */
+            ps_chunk_location(old_fid, obj->header.info.max_size, idx, &uid,
+                              &chunk_offset);
+
+            err = psa_its_get(uid, chunk_offset, len, p_data, &data_length);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+
+            if (data_length != len) {
+                return PSA_ERROR_DATA_CORRUPT;
+            }
+
+            continue;
+        }
+
+        /* The bytes of a partially overwritten chunk which are kept are
+         * decrypted from the old version of the object.
+         */
+        if (offset > chunk_start || end < chunk_start + len) {
+            data_length = PS_ENCRYPTION_CHUNK_SIZE;
+
+            err = ps_object_read_chunk(old_fid, idx, obj, ps_chunk_buf,
+                                       &data_length, &num_blocks);
+            if (err != PSA_SUCCESS) {
+                goto wipe_chunk_and_return;
+            }
+
+            if (offset > chunk_start) {
+                if (data_length < offset - chunk_start) {
+                    err = PSA_ERROR_DATA_CORRUPT;
+                    goto wipe_chunk_and_return;
+                }
+                (void)memcpy(p_data, ps_chunk_buf, offset - chunk_start);
+            }
+
+            if (end < chunk_start + len) {
+                if (data_length < len) {
+                    err = PSA_ERROR_DATA_CORRUPT;
+                    goto wipe_chunk_and_return;
+                }
+                (void)memcpy(p_data + (end - chunk_start),
+                             ps_chunk_buf + (end - chunk_start),
+                             chunk_start + len - end);
+            }
+
+            /* The plaintext of the old chunk is not kept in the buffer */
+            (void)memset(ps_chunk_buf, 0, sizeof(ps_chunk_buf));
+        }
+
+        err = ps_object_encrypt_chunk(idx, len, obj, p_data);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    (void)memset(&obj->window.chunk[win_chunks], 0,
+                 (PS_OBJECT_WINDOW_CHUNKS - win_chunks) *
+                 sizeof(struct ps_obj_chunk_t));
+
+    err = ps_object_tag_window(win, obj);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
 
+#if PS_OBJECT_STREAM
+    /* The windows other than the last one are stored in segment files, with
+     * their crypto metadata, the last one is stored with the object header.
+     */
+    if (win < PS_OBJECT_LAST_WINDOW(obj->header.info.max_size)) {
+        return psa_its_set(PS_OBJECT_SEGMENT_UID(fid, win),
+                           STORED_WINDOW_DATA_SIZE + win_size,
+                           (const void *)&obj->window,
+                           PSA_STORAGE_FLAG_NONE);
+    }
+#else
+    (void)fid;
+#endif
+
+    return PSA_SUCCESS;
+
+wipe_chunk_and_return:
+    /* The chunk buffer may hold plaintext of the old version of the object */
+    (void)memset(ps_chunk_buf, 0, sizeof(ps_chunk_buf));
+
+    return err;
+}
+
+psa_status_t ps_encrypted_object_write_header(uint32_t fid,
+                                              struct ps_object_t *obj)
+{
+    psa_status_t err;
+    uint32_t data_size = obj->header.info.current_size;
+    uint32_t last_start = PS_OBJECT_LAST_WINDOW(obj->header.info.max_size) *
+                          PS_OBJECT_WINDOW_SIZE;
+#if PS_OBJECT_STREAM
+    uint32_t win;
+#endif
+
+    obj->header.fid = fid;
+
+    if (data_size == 0) {
+        /* Get a new IV for each version of the header */
+        err = ps_crypto_get_iv(&obj->header.crypto);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    } else {
+        /* The IV of the header is the one its windows are bound to */
+        (void)memcpy(obj->header.crypto.ref.iv, ps_header_iv,
+                     PS_IV_LEN_BYTES);
+    }
+
+    /* The tag of the header is stored in the object table */
+    err = ps_crypto_generate_auth_tag(&obj->header.crypto,
+                                      (const uint8_t *)&obj->header.info,
+                                      PS_HEADER_AUTH_SIZE);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+#if PS_OBJECT_STREAM
+    /* Remove the segment files left after the ones of the object by an
+     * interrupted update or removal of an object with the same File ID. Those
+     * are always the first segment files of that object.
+     */
+    for (win = ps_object_num_segments(&obj->header.info);
+         win < PS_OBJECT_MAX_SEGMENTS; win++) {
+        err = psa_its_remove(PS_OBJECT_SEGMENT_UID(fid, win));
+        if (err == PSA_ERROR_DOES_NOT_EXIST) {
+            break;
+        }
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+#endif
+
+    /* Write the header, which starts with the IV, and the last window, if
+     * any, with its crypto metadata, to the persistent area.
+     */
+    return psa_its_set(fid, STORED_HEADER_DATA_SIZE +
+                       ((data_size > last_start) ?
+                        (STORED_WINDOW_DATA_SIZE + data_size - last_start) :
+                        0),
+                       (const void *)obj->header.crypto.ref.iv,
+                       PSA_STORAGE_FLAG_NONE);
+}
+
+psa_status_t ps_encrypted_object_write_range(uint32_t old_fid, uint32_t fid,
+                                             struct ps_object_t *obj,
+                                             uint32_t offset, uint32_t size)
+{
+    psa_status_t err;
+
+    /* The object data is held in a single window */
+    if (obj->header.info.current_size > PS_OBJECT_WINDOW_SIZE) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    err = ps_encrypted_object_write_window(old_fid, fid, obj, 0, offset, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return ps_encrypted_object_write_header(fid, obj);
+}
+
+#if PS_OBJECT_STREAM
+psa_status_t ps_encrypted_object_remove(uint32_t fid,
+                                        const struct ps_object_info_t *info)
+{
+    psa_status_t err;
+    uint32_t win = ps_object_num_segments(info);
+
+    /* Remove the segment files from the last one, so that an interrupted
+     * removal leaves the first ones, which are removed when the File ID is
+     * used again.
+     */
+    while (win > 0) {
+        win--;
+
+        err = psa_its_remove(PS_OBJECT_SEGMENT_UID(fid, win));
+        if (err != PSA_SUCCESS && err != PSA_ERROR_DOES_NOT_EXIST) {
+            return err;
+        }
+    }
+
+    return psa_its_remove(fid);
+}
+#endif
+
+psa_status_t ps_encrypted_object_read(uint32_t fid,
+                                      struct ps_object_t *obj,
+                                      uint32_t *p_blocks)
+{
+    return ps_encrypted_object_read_range(fid, obj, 0, PS_MAX_OBJECT_DATA_SIZE,
+                                          p_blocks);
+}
+
+psa_status_t ps_encrypted_object_write(uint32_t fid, struct ps_object_t *obj)
+{
+    return ps_encrypted_object_write_range(PS_INVALID_FID, fid, obj, 0,
+                                           obj->header.info.current_size);
+}
+#else
 __PACKED_STRUCT auth_data_t {
     uint32_t fid;
 #if PS_AES_KEY_USAGE_LIMIT != 0
@@ -88,6 +786,11 @@ static psa_status_t ps_object_auth_decrypt(uint32_t fid,
                                      p_obj_data,
                                      sizeof(*obj) - offsetof(struct ps_object_t, header.info),
                                      &out_len);
+    if (err == PSA_ERROR_INVALID_SIGNATURE) {
+        /* The object does not match the tag of the object table */
+        return err;
+    }
+
     if (err != PSA_SUCCESS || out_len != cur_size) {
         return PSA_ERROR_GENERIC_ERROR;
     }
@@ -199,6 +902,19 @@ psa_status_t ps_encrypted_object_read(uint32_t fid,
     return PSA_SUCCESS;
 }
 
+psa_status_t ps_encrypted_object_read_range(uint32_t fid,
+                                            struct ps_object_t *obj,
+                                            uint32_t offset,
+                                            uint32_t size,
+                                            uint32_t *p_blocks)
+{
+    /* The object is encrypted as a whole */
+    (void)offset;
+    (void)size;
+
+    return ps_encrypted_object_read(fid, obj, p_blocks);
+}
+
 uint32_t ps_encrypted_object_blocks(uint32_t size)
 {
     uint32_t wrt_size = PS_ENCRYPT_SIZE(size);
@@ -232,3 +948,16 @@ psa_status_t ps_encrypted_object_write(uint32_t fid, struct ps_object_t *obj)
     return psa_its_set(fid, wrt_size, (const void *)obj->header.crypto.ref.iv,
                        PSA_STORAGE_FLAG_NONE);
 }
+
+psa_status_t ps_encrypted_object_write_range(uint32_t old_fid, uint32_t fid,
+                                             struct ps_object_t *obj,
+                                             uint32_t offset, uint32_t size)
+{
+    /* The object is encrypted as a whole */
+    (void)old_fid;
+    (void)offset;
+    (void)size;
+
+    return ps_encrypted_object_write(fid, obj);
+}
+#endif /* PS_OBJECT_CHUNKS */
@@ -48,6 +48,142 @@ psa_status_t ps_encrypted_object_read(uint32_t fid,
 psa_status_t ps_encrypted_object_write(uint32_t fid,
                                        struct ps_object_t *obj);
 
+/**
+ * \brief Reads the header of the object referenced by the object File ID, and
+ *        the object data in the given range.
+ *
+ * \details With PS_ENCRYPTION_CHUNK_SIZE, only the chunks of object data
+ *          covering the range are decrypted, at their place in the object
+ *          data. With PS_STREAM_WINDOW_SIZE, the range is limited to the
+ *          window of object data holding its start, as by
+ *          \ref ps_encrypted_object_read_data. Otherwise, the whole object is
+ *          decrypted.
+ *
+ * \param[in]  fid      File ID
+ * \param[out] obj      Pointer to the object structure to fill in
+ * \param[in]  offset   Offset of the range in the object data
+ * \param[in]  size     Size of the range in bytes, which may be 0 to only read
+ *                      the object header, and is limited to the object data
+ * \param[out] p_blocks Pointer to a counter of decryption blocks used.
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_read_range(uint32_t fid,
+                                            struct ps_object_t *obj,
+                                            uint32_t offset,
+                                            uint32_t size,
+                                            uint32_t *p_blocks);
+
+/**
+ * \brief Writes a new version of an object whose data has changed in the
+ *        given range.
+ *
+ * \details With PS_ENCRYPTION_CHUNK_SIZE, only the chunks of object data
+ *          covering the range are encrypted. The other chunks are copied from
+ *          the old version of the object without being decrypted, and the
+ *          bytes of the partially overwritten chunks which are not in the range
+ *          are decrypted from it. So obj must hold the header of the old
+ *          version, as read by \ref ps_encrypted_object_read_range, updated
+ *          with the new object information, and the object data must fit in
+ *          a single window. Otherwise, the whole object is encrypted, and obj
+ *          must hold the whole new object.
+ *
+ * \param[in]     old_fid  File ID of the old version of the object, or
+ *                         PS_INVALID_FID if the range covers the whole object
+ * \param[in]     fid      File ID of the new version of the object
+ * \param[in,out] obj      Pointer to the object structure to write. It
+ *                         contains the encrypted object when the function
+ *                         returns.
+ * \param[in]     offset   Offset of the range in the object data
+ * \param[in]     size     Size of the range in bytes
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_write_range(uint32_t old_fid, uint32_t fid,
+                                             struct ps_object_t *obj,
+                                             uint32_t offset, uint32_t size);
+
+#if PS_OBJECT_CHUNKS
+/**
+ * \brief Decrypts the chunks of object data covering the given range, limited
+ *        to the window of object data holding its start, at their place in
+ *        the window.
+ *
+ * \param[in]     fid      File ID
+ * \param[in,out] obj      Pointer to the object structure, whose header has
+ *                         been read by \ref ps_encrypted_object_read_range
+ * \param[in]     offset   Offset of the range in the object data
+ * \param[in]     size     Size of the range in bytes
+ * \param[out]    p_blocks Pointer to a counter of decryption blocks used,
+ *                         which is increased.
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_read_data(uint32_t fid,
+                                           struct ps_object_t *obj,
+                                           uint32_t offset,
+                                           uint32_t size,
+                                           uint32_t *p_blocks);
+
+/**
+ * \brief Encrypts a window of object data of a new version of an object whose
+ *        data has changed in the given range, and stores it in its segment
+ *        file unless it is the last window of the object.
+ *
+ * \details The chunks of the window which are not in the range are copied
+ *          from the old version of the object, and the bytes of the partially
+ *          overwritten chunks which are not in the range are decrypted from
+ *          it, as done by \ref ps_encrypted_object_write_range. The crypto
+ *          metadata of the chunks is stored with the window, authenticated
+ *          with the IV of the new object header, which is drawn when the
+ *          first window is written. The windows of the object must be written
+ *          in order, and be followed by \ref ps_encrypted_object_write_header.
+ *
+ * \param[in]     old_fid  File ID of the old version of the object, or
+ *                         PS_INVALID_FID if the range covers the whole object
+ * \param[in]     fid      File ID of the new version of the object
+ * \param[in,out] obj      Pointer to the object structure, whose data holds
+ *                         the window with the new data in the range. It
+ *                         contains the encrypted window when the function
+ *                         returns.
+ * \param[in]     start    Offset of the window in the object data
+ * \param[in]     offset   Offset of the range in the object data
+ * \param[in]     size     Size of the range in bytes
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_write_window(uint32_t old_fid, uint32_t fid,
+                                              struct ps_object_t *obj,
+                                              uint32_t start,
+                                              uint32_t offset, uint32_t size);
+
+/**
+ * \brief Writes the header of a new version of an object, with the last
+ *        window of object data, once all the windows have been written by
+ *        \ref ps_encrypted_object_write_window.
+ *
+ * \param[in]     fid  File ID of the new version of the object
+ * \param[in,out] obj  Pointer to the object structure to write
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_write_header(uint32_t fid,
+                                              struct ps_object_t *obj);
+#endif /* PS_OBJECT_CHUNKS */
+
+#if PS_OBJECT_STREAM
+/**
+ * \brief Removes the file and the segment files of an object.
+ *
+ * \param[in] fid   File ID of the object
+ * \param[in] info  Object information of the object
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_remove(uint32_t fid,
+                                        const struct ps_object_info_t *info);
+#endif
+
 /**
  * \brief Determines the number of encryption blocks that will be used to write
  *        an object of the specified size.
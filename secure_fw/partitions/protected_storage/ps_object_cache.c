@@ -0,0 +1,200 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "ps_object_cache.h"
+
+#include <string.h>
+
+#include "ps_utils.h"
+
+#if PS_OBJECT_CACHE_SIZE != 0
+
+/* Maximum number of objects in the cache */
+#define PS_OBJECT_CACHE_MAX_ENTRIES  PS_UTILS_MIN(PS_NUM_ASSETS, 8)
+
+/*!
+ * \struct ps_object_cache_entry_t
+ *
+ * \brief Object in the cache. The data of the objects is stored back to back
+ *        in the cache buffer, in the order of the entries.
+ */
+struct ps_object_cache_entry_t {
+    psa_storage_uid_t uid; /*!< Unique identifier of the object */
+    int32_t client_id;     /*!< Identifier of the object's owner */
+    uint32_t fid;          /*!< File ID of the version of the object */
+    uint32_t size;         /*!< Size of the object data */
+    uint32_t last_use;     /*!< Value of the use counter at the last use */
+};
+
+static struct {
+    struct ps_object_cache_entry_t entry[PS_OBJECT_CACHE_MAX_ENTRIES];
+    uint32_t num_entries;  /*!< Number of objects in the cache */
+    uint32_t used;         /*!< Bytes of the buffer used */
+    uint32_t use_counter;  /*!< Incremented at each use of an entry */
+    struct tfm_ps_cache_stats_t stats;
+    uint8_t buf[PS_OBJECT_CACHE_SIZE];
+} ps_cache;
+
+/**
+ * \brief Gets the offset of the data of an entry in the cache buffer.
+ *
+ * \param[in] idx  Index of the entry
+ *
+ * \return Returns the offset in bytes
+ */
+static uint32_t ps_cache_data_offset(uint32_t idx)
+{
+    uint32_t offset = 0;
+    uint32_t i;
+
+    for (i = 0; i < idx; i++) {
+        offset += ps_cache.entry[i].size;
+    }
+
+    return offset;
+}
+
+/**
+ * \brief Removes an entry from the cache, moving the data of the following
+ *        entries down and erasing the freed end of the buffer.
+ *
+ * \param[in] idx  Index of the entry
+ */
+static void ps_cache_remove(uint32_t idx)
+{
+    uint32_t offset = ps_cache_data_offset(idx);
+    uint32_t size = ps_cache.entry[idx].size;
+
+    (void)memmove(&ps_cache.buf[offset], &ps_cache.buf[offset + size],
+                  ps_cache.used - offset - size);
+    ps_cache.used -= size;
+    (void)memset(&ps_cache.buf[ps_cache.used], 0, size);
+
+    (void)memmove(&ps_cache.entry[idx], &ps_cache.entry[idx + 1],
+                  (ps_cache.num_entries - idx - 1) *
+                  sizeof(struct ps_object_cache_entry_t));
+    ps_cache.num_entries--;
+    (void)memset(&ps_cache.entry[ps_cache.num_entries], 0,
+                 sizeof(struct ps_object_cache_entry_t));
+}
+
+/**
+ * \brief Finds the entry of an object.
+ *
+ * \param[in] uid        Unique identifier of the object
+ * \param[in] client_id  Identifier of the object's owner (client)
+ *
+ * \return Returns the index of the entry, or num_entries if the object is not
+ *         in the cache
+ */
+static uint32_t ps_cache_find(psa_storage_uid_t uid, int32_t client_id)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < ps_cache.num_entries; idx++) {
+        if (ps_cache.entry[idx].uid == uid &&
+            ps_cache.entry[idx].client_id == client_id) {
+            break;
+        }
+    }
+
+    return idx;
+}
+
+const uint8_t *ps_object_cache_get(psa_storage_uid_t uid, int32_t client_id,
+                                   uint32_t fid, uint32_t size)
+{
+    uint32_t idx = ps_cache_find(uid, client_id);
+
+    if (idx == ps_cache.num_entries) {
+        ps_cache.stats.misses++;
+        return NULL;
+    }
+
+    if (ps_cache.entry[idx].fid != fid || ps_cache.entry[idx].size != size) {
+        /* The object has been changed since it was cached */
+        ps_cache_remove(idx);
+        ps_cache.stats.invalidations++;
+        ps_cache.stats.misses++;
+        return NULL;
+    }
+
+    ps_cache.entry[idx].last_use = ++ps_cache.use_counter;
+    ps_cache.stats.hits++;
+
+    return &ps_cache.buf[ps_cache_data_offset(idx)];
+}
+
+void ps_object_cache_put(psa_storage_uid_t uid, int32_t client_id,
+                         uint32_t fid, const uint8_t *data, uint32_t size)
+{
+    uint32_t idx;
+    uint32_t lru;
+
+    if (size > PS_OBJECT_CACHE_SIZE) {
+        return;
+    }
+
+    idx = ps_cache_find(uid, client_id);
+    if (idx != ps_cache.num_entries) {
+        ps_cache_remove(idx);
+    }
+
+    /* Evict the least recently used objects until the object fits */
+    while (ps_cache.num_entries == PS_OBJECT_CACHE_MAX_ENTRIES ||
+           ps_cache.used + size > PS_OBJECT_CACHE_SIZE) {
+        lru = 0;
+        for (idx = 1; idx < ps_cache.num_entries; idx++) {
+            if (ps_cache.entry[idx].last_use < ps_cache.entry[lru].last_use) {
+                lru = idx;
+            }
+        }
+
+        ps_cache_remove(lru);
+        ps_cache.stats.evictions++;
+    }
+
+    idx = ps_cache.num_entries;
+    ps_cache.entry[idx].uid = uid;
+    ps_cache.entry[idx].client_id = client_id;
+    ps_cache.entry[idx].fid = fid;
+    ps_cache.entry[idx].size = size;
+    ps_cache.entry[idx].last_use = ++ps_cache.use_counter;
+    (void)memcpy(&ps_cache.buf[ps_cache.used], data, size);
+
+    ps_cache.num_entries++;
+    ps_cache.used += size;
+}
+
+void ps_object_cache_invalidate(psa_storage_uid_t uid, int32_t client_id)
+{
+    uint32_t idx = ps_cache_find(uid, client_id);
+
+    if (idx != ps_cache.num_entries) {
+        ps_cache_remove(idx);
+        ps_cache.stats.invalidations++;
+    }
+}
+
+void ps_object_cache_wipe(void)
+{
+    (void)memset(ps_cache.buf, 0, sizeof(ps_cache.buf));
+    (void)memset(ps_cache.entry, 0, sizeof(ps_cache.entry));
+    ps_cache.num_entries = 0;
+    ps_cache.used = 0;
+    ps_cache.stats.wipes++;
+}
+
+void ps_object_cache_get_stats(struct tfm_ps_cache_stats_t *p_stats)
+{
+    *p_stats = ps_cache.stats;
+    p_stats->capacity = PS_OBJECT_CACHE_SIZE;
+    p_stats->used_bytes = ps_cache.used;
+    p_stats->num_objects = ps_cache.num_entries;
+}
+
+#endif /* PS_OBJECT_CACHE_SIZE != 0 */
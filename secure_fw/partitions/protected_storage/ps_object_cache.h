@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: Copyright The TrustedFirmware-M Contributors
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  ps_object_cache.h
+ *
+ * \brief Cache of the plaintext data of recently read PS objects. It holds at
+ *        most PS_OBJECT_CACHE_SIZE bytes of object data, evicting the least
+ *        recently used objects first. An entry is bound to the File ID of the
+ *        version of the object it was read from, so it is only served while
+ *        that version is the one in the object table.
+ */
+
+#ifndef __PS_OBJECT_CACHE_H__
+#define __PS_OBJECT_CACHE_H__
+
+#include <stdint.h>
+
+#include "config_tfm.h"
+#include "psa/protected_storage.h"
+#include "tfm_ps_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if PS_OBJECT_CACHE_SIZE != 0
+/**
+ * \brief Gets the data of an object from the cache.
+ *
+ * \param[in] uid        Unique identifier of the object
+ * \param[in] client_id  Identifier of the object's owner (client)
+ * \param[in] fid        File ID of the current version of the object
+ * \param[in] size       Current size of the object data
+ *
+ * \return Returns a pointer to the object data, or NULL if the current
+ *         version of the object is not in the cache
+ */
+const uint8_t *ps_object_cache_get(psa_storage_uid_t uid, int32_t client_id,
+                                   uint32_t fid, uint32_t size);
+
+/**
+ * \brief Adds the data of an object to the cache, evicting the least recently
+ *        used objects as needed. The object is not cached if its data is
+ *        bigger than the cache.
+ *
+ * \param[in] uid        Unique identifier of the object
+ * \param[in] client_id  Identifier of the object's owner (client)
+ * \param[in] fid        File ID of the version of the object read
+ * \param[in] data       Plaintext data of the object
+ * \param[in] size       Size of the object data
+ */
+void ps_object_cache_put(psa_storage_uid_t uid, int32_t client_id,
+                         uint32_t fid, const uint8_t *data, uint32_t size);
+
+/**
+ * \brief Removes an object from the cache, if it is in it, and erases its
+ *        data.
+ *
+ * \param[in] uid        Unique identifier of the object
+ * \param[in] client_id  Identifier of the object's owner (client)
+ */
+void ps_object_cache_invalidate(psa_storage_uid_t uid, int32_t client_id);
+
+/**
+ * \brief Removes all the objects from the cache and erases their data.
+ */
+void ps_object_cache_wipe(void);
+
+/**
+ * \brief Gets the counters of the cache.
+ *
+ * \param[out] p_stats  Counters of the cache
+ */
+void ps_object_cache_get_stats(struct tfm_ps_cache_stats_t *p_stats);
+#endif /* PS_OBJECT_CACHE_SIZE != 0 */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PS_OBJECT_CACHE_H__ */
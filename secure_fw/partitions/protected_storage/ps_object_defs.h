@@ -30,6 +30,87 @@ struct ps_object_info_t {
     psa_storage_create_flags_t create_flags; /*!< Object creation flags */
 };
 
+#define PS_MAX_OBJECT_DATA_SIZE  PS_MAX_ASSET_SIZE
+
+#if defined(PS_ENCRYPTION) && (PS_ENCRYPTION_CHUNK_SIZE != 0)
+/* The object data is encrypted in chunks */
+#define PS_OBJECT_CHUNKS 1
+
+/* Number of chunks of the given size of object data */
+#define PS_OBJECT_NUM_CHUNKS(size) (((size) + PS_ENCRYPTION_CHUNK_SIZE - 1) / \
+                                    PS_ENCRYPTION_CHUNK_SIZE)
+
+
+#else
+#define PS_OBJECT_CHUNKS 0
+#endif
+
+#if PS_OBJECT_CHUNKS && (PS_STREAM_WINDOW_SIZE != 0)
+/* The object data is streamed through a window of the object data */
+#define PS_OBJECT_STREAM 1
+
+/* Size of the window of object data held in RAM */
+#define PS_OBJECT_WINDOW_SIZE PS_STREAM_WINDOW_SIZE
+#else
+#define PS_OBJECT_STREAM 0
+
+/* The whole object data is held in RAM */
+#define PS_OBJECT_WINDOW_SIZE PS_MAX_OBJECT_DATA_SIZE
+#endif
+
+/* Index of the last window of object data for the given maximum size of the
+ * object, whose data is stored with the object header. The data of the other
+ * windows is stored in segment files.
+ */
+#define PS_OBJECT_LAST_WINDOW(max_size) \
+    (((max_size) == 0) ? 0 : (((max_size) - 1) / PS_OBJECT_WINDOW_SIZE))
+
+#if PS_OBJECT_STREAM
+/* Maximum number of segment files of an object */
+#define PS_OBJECT_MAX_SEGMENTS PS_OBJECT_LAST_WINDOW(PS_MAX_OBJECT_DATA_SIZE)
+
+/* UID of the segment file storing the window of object data of the given
+ * index, for the object stored in the file of the given File ID.
+ */
+#define PS_OBJECT_SEGMENT_UID(fid, win) \
+    ((((psa_storage_uid_t)(win) + 1) << 32) | (psa_storage_uid_t)(fid))
+#else
+#define PS_OBJECT_MAX_SEGMENTS 0
+#endif
+
+#if PS_OBJECT_CHUNKS
+/* Number of chunks of a window of object data */
+#define PS_OBJECT_WINDOW_CHUNKS PS_OBJECT_NUM_CHUNKS(PS_OBJECT_WINDOW_SIZE)
+
+/*!
+ * \struct ps_obj_chunk_t
+ *
+ * \brief Crypto metadata of an encrypted chunk of object data.
+ */
+struct ps_obj_chunk_t {
+    uint8_t iv[PS_IV_LEN_BYTES];   /*!< IV value of the chunk */
+    uint8_t tag[PS_TAG_LEN_BYTES]; /*!< MAC value of the chunk */
+};
+
+/*!
+ * \struct ps_obj_window_t
+ *
+ * \brief Crypto metadata of the chunks of a window of object data, stored
+ *        before the encrypted chunks of the window. It is authenticated with
+ *        the IV of the object header, which binds it to a single version of
+ *        the object.
+ */
+struct ps_obj_window_t {
+    uint8_t iv[PS_IV_LEN_BYTES];        /*!< IV value of the window */
+    uint8_t tag[PS_TAG_LEN_BYTES];      /*!< MAC value of the window */
+    uint8_t header_iv[PS_IV_LEN_BYTES]; /*!< IV value of the object header */
+    uint32_t win;                       /*!< Index of the window */
+    struct ps_obj_chunk_t chunk[PS_OBJECT_WINDOW_CHUNKS]; /*!< Crypto metadata
+                                                           *   of each chunk
+                                                           */
+};
+#endif
+
 /*!
  * \struct ps_obj_header_t
  *
@@ -43,15 +124,15 @@ struct ps_obj_header_t {
     uint32_t fid;                  /*!< File ID */
 #endif
     struct ps_object_info_t info; /*!< Object information */
+#if PS_OBJECT_CHUNKS
+    uint32_t fid;                  /*!< File ID */
+#endif
 };
 
-
-#define PS_MAX_OBJECT_DATA_SIZE  PS_MAX_ASSET_SIZE
-
 #ifdef PS_ENCRYPTION
-#define PS_OBJECT_BUF_SIZE (PS_MAX_OBJECT_DATA_SIZE + PS_TAG_LEN_BYTES)
+#define PS_OBJECT_BUF_SIZE (PS_OBJECT_WINDOW_SIZE + PS_TAG_LEN_BYTES)
 #else
-#define PS_OBJECT_BUF_SIZE PS_MAX_OBJECT_DATA_SIZE
+#define PS_OBJECT_BUF_SIZE PS_OBJECT_WINDOW_SIZE
 #endif
 
 
@@ -63,7 +144,14 @@ struct ps_obj_header_t {
  */
 struct ps_object_t {
     struct ps_obj_header_t header;    /*!< Object header */
-    uint8_t data[PS_OBJECT_BUF_SIZE]; /*!< Object data (and tag if encrypted) */
+#if PS_OBJECT_CHUNKS
+    struct ps_obj_window_t window;    /*!< Crypto metadata of the window of
+                                       *   object data
+                                       */
+#endif
+    uint8_t data[PS_OBJECT_BUF_SIZE]; /*!< Window of object data (and tag if
+                                       *   encrypted)
+                                       */
 };
 
 
@@ -75,8 +163,11 @@ struct ps_object_t {
  *
  * \brief Specifies the maximum number of objects in the system, which is the
  *        number of defined assets, the object table and 2 temporary objects to
- *        store the temporary object table and temporary updated object.
+ *        store the temporary object table and temporary updated object, plus
+ *        the records of the object table journal and the segment files of the
+ *        assets and of the temporary updated object.
  */
-#define PS_MAX_NUM_OBJECTS (PS_NUM_ASSETS + 3)
+#define PS_MAX_NUM_OBJECTS (PS_NUM_ASSETS + 3 + PS_OBJ_TABLE_JOURNAL_SIZE + \
+                            ((PS_NUM_ASSETS + 1) * PS_OBJECT_MAX_SEGMENTS))
 
 #endif /* __PS_OBJECT_DEFS_H__ */
@@ -18,6 +18,7 @@
 #ifdef PS_ENCRYPTION
 #include "ps_encrypted_object.h"
 #endif
+#include "ps_object_cache.h"
 #include "ps_object_defs.h"
 #include "ps_object_table.h"
 #include "ps_utils.h"
@@ -35,6 +36,58 @@
 static struct ps_object_t g_ps_object;
 static struct ps_obj_table_info_t g_obj_tbl_info;
 
+/* Range of g_ps_object.data which may hold data of an object since the last
+ * erase of g_ps_object. Only this range and the object header are erased at
+ * the end of a request, the rest of g_ps_object is already erased.
+ */
+static struct {
+    uint32_t start;
+    uint32_t end;
+} g_ps_object_dirty;
+
+/**
+ * \brief Extends the range of g_ps_object.data which is erased at the end of
+ *        the request to a range which data of an object is written to.
+ *
+ * \param[in] offset  Offset of the range in the object data
+ * \param[in] size    Size of the range in bytes
+ */
+static void ps_object_set_dirty(uint32_t offset, uint32_t size)
+{
+    uint32_t end;
+
+    if (offset >= PS_OBJECT_BUF_SIZE || size == 0) {
+        return;
+    }
+
+    end = offset + PS_UTILS_MIN(size, PS_OBJECT_BUF_SIZE - offset);
+
+    if (g_ps_object_dirty.end == 0) {
+        g_ps_object_dirty.start = offset;
+        g_ps_object_dirty.end = end;
+    } else {
+        g_ps_object_dirty.start = PS_UTILS_MIN(g_ps_object_dirty.start,
+                                               offset);
+        g_ps_object_dirty.end = PS_UTILS_MAX(g_ps_object_dirty.end, end);
+    }
+}
+
+/**
+ * \brief Erases the object header and the range of the object data of
+ *        g_ps_object which may hold data of an object.
+ */
+static void ps_object_erase(void)
+{
+    (void)memset(&g_ps_object.header, PS_DEFAULT_EMPTY_BUFF_VAL,
+                 PS_OBJECT_HEADER_SIZE);
+    (void)memset(&g_ps_object.data[g_ps_object_dirty.start],
+                 PS_DEFAULT_EMPTY_BUFF_VAL,
+                 g_ps_object_dirty.end - g_ps_object_dirty.start);
+
+    g_ps_object_dirty.start = 0;
+    g_ps_object_dirty.end = 0;
+}
+
 /**
  * \brief Initialize g_ps_object based on the input parameters and empty data.
  *
@@ -53,8 +106,11 @@ __STATIC_INLINE void ps_init_empty_object(
                                         uint32_t size,
                                         struct ps_object_t *obj)
 {
-    /* Set all object data to 0 */
-    (void)memset(obj, PS_DEFAULT_EMPTY_BUFF_VAL, PS_MAX_OBJECT_SIZE);
+    /* Set the object header to 0. The object data is already erased, as it
+     * is at the end of each request.
+     */
+    (void)memset(&obj->header, PS_DEFAULT_EMPTY_BUFF_VAL,
+                 PS_OBJECT_HEADER_SIZE);
 
 #ifdef PS_ENCRYPTION
     obj->header.crypto.ref.uid = uid;
@@ -72,6 +128,27 @@ __STATIC_INLINE void ps_init_empty_object(
     obj->header.info.create_flags = create_flags;
 }
 
+/**
+ * \brief Removes an object from the persistent area.
+ *
+ * \param[in] fid   File ID of the object
+ * \param[in] info  Object information of the object
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_remove_object(uint32_t fid,
+                                     const struct ps_object_info_t *info)
+{
+#if PS_OBJECT_STREAM
+    /* The object data may also be stored in segment files */
+    return ps_encrypted_object_remove(fid, info);
+#else
+    (void)info;
+
+    return psa_its_remove(fid);
+#endif
+}
+
 /**
  * \brief Update the object table for the specified object with the content
  *        of g_obj_tbl_info. Also removes the old object table.
@@ -96,7 +173,7 @@ static psa_status_t ps_update_table(psa_storage_uid_t uid, int32_t client_id)
         /* Remove object as object table is not persistent and propagate
          * object table manipulation error.
          */
-        (void)psa_its_remove(g_obj_tbl_info.fid);
+        (void)ps_remove_object(g_obj_tbl_info.fid, &g_obj_tbl_info.info);
     }
 
     return err;
@@ -116,6 +193,12 @@ static void ps_switch_key(void)
     }
     g_ps_object.header.crypto.ref.key_gen_nr++;
     g_obj_tbl_info.num_blocks = 0;
+    /* Do not keep the keys of the previous generation resident */
+    ps_crypto_clear_keys();
+#if PS_OBJECT_CACHE_SIZE != 0
+    /* Do not keep plaintext read with the previous key */
+    ps_object_cache_wipe();
+#endif
 }
 #endif /* PS_AES_KEY_USAGE_LIMIT == 0 */
 
@@ -143,14 +226,192 @@ static psa_status_t ps_switch_keys_if_necessary(uint32_t num_blocks)
 #else
     /* Always need to be able to decrypt the object once more to read it back */
     if (g_obj_tbl_info.num_blocks + num_blocks > PS_AES_KEY_USAGE_LIMIT) {
+        err = ps_object_table_open_batch();
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
         ps_switch_key();
-        /* Re-store object, using new key */
+        /* Re-store object, using new key. The object data is encrypted in
+         * place and followed by the tag.
+         */
+        ps_object_set_dirty(0, g_ps_object.header.info.current_size +
+                               PS_TAG_LEN_BYTES);
         err = ps_encrypted_object_write(g_obj_tbl_info.fid, &g_ps_object);
         g_obj_tbl_info.num_blocks += num_blocks;
     }
 #endif /* PS_AES_KEY_USAGE_LIMIT == 0 */
     return err;
 }
+
+#if PS_OBJECT_CHUNKS
+/**
+ * \brief Extends the range of g_ps_object.data which is erased at the end of
+ *        the request to the chunks decrypted for a range of object data.
+ *
+ * \param[in] offset  Offset of the range in the object data
+ * \param[in] size    Size of the range in bytes
+ */
+static void ps_object_set_dirty_chunks(uint32_t offset, uint32_t size)
+{
+    uint32_t data_size = g_ps_object.header.info.current_size;
+    uint32_t start;
+    uint32_t end;
+
+    if (offset >= data_size || size == 0) {
+        return;
+    }
+
+    /* Only the chunks covering the range, in the window of object data
+     * holding its start, are decrypted.
+     */
+    start = offset - (offset % PS_OBJECT_WINDOW_SIZE);
+    end = PS_UTILS_MIN(offset + PS_UTILS_MIN(size, data_size - offset),
+                       start + PS_OBJECT_WINDOW_SIZE);
+    offset -= offset % PS_ENCRYPTION_CHUNK_SIZE;
+    end = PS_UTILS_MIN(PS_OBJECT_NUM_CHUNKS(end) * PS_ENCRYPTION_CHUNK_SIZE,
+                       data_size);
+    ps_object_set_dirty(offset - start, end - offset);
+}
+#endif /* PS_OBJECT_CHUNKS */
+
+/**
+ * \brief Reads an object in g_ps_object, based on its object table info
+ *        stored in g_obj_tbl_info, and decrypts a range of its data.
+ *
+ * \param[in]  uid        Unique identifier for the data
+ * \param[in]  client_id  Identifier of the asset's owner (client)
+ * \param[in]  offset     Offset of the object data to decrypt
+ * \param[in]  size       Size of the object data to decrypt
+ * \param[out] p_blocks   Number of decryption blocks used
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_read_encrypted_object(psa_storage_uid_t uid,
+                                             int32_t client_id,
+                                             uint32_t offset, uint32_t size,
+                                             uint32_t *p_blocks)
+{
+    psa_status_t err;
+
+    g_ps_object.header.crypto.ref.uid = uid;
+    g_ps_object.header.crypto.ref.client_id = client_id;
+
+    err = ps_encrypted_object_read_range(g_obj_tbl_info.fid, &g_ps_object,
+                                         offset, size, p_blocks);
+    if (err != PSA_SUCCESS) {
+        /* Any part of the object data may have been decrypted */
+        ps_object_set_dirty(0, PS_OBJECT_BUF_SIZE);
+        return err;
+    }
+
+#if PS_OBJECT_CHUNKS
+    ps_object_set_dirty_chunks(offset, size);
+#else
+    /* The object is decrypted as a whole, in place, and the tag is copied
+     * after the ciphertext.
+     */
+    ps_object_set_dirty(0, g_ps_object.header.info.current_size +
+                           PS_TAG_LEN_BYTES);
+#endif
+
+    return PSA_SUCCESS;
+}
+
+#if PS_OBJECT_STREAM
+/**
+ * \brief Writes a range of the data of the object read in g_ps_object to the
+ *        client. The window of object data holding the start of the range is
+ *        already decrypted in g_ps_object, the following ones are decrypted in
+ *        turn.
+ *
+ * \param[in]  offset    Offset of the range in the object data
+ * \param[in]  size      Size of the range in bytes, limited to the object data
+ * \param[out] p_blocks  Pointer to a counter of decryption blocks used
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_write_asset_data(uint32_t offset, uint32_t size,
+                                        uint32_t *p_blocks)
+{
+    psa_status_t err;
+    uint32_t start = offset - (offset % PS_OBJECT_WINDOW_SIZE);
+    uint32_t len;
+
+    for (;;) {
+        len = PS_UTILS_MIN(size, start + PS_OBJECT_WINDOW_SIZE - offset);
+        ps_req_mngr_write_asset_data(g_ps_object.data + (offset - start), len);
+
+        offset += len;
+        size -= len;
+        if (size == 0) {
+            return PSA_SUCCESS;
+        }
+
+        /* Decrypt the next window */
+        start += PS_OBJECT_WINDOW_SIZE;
+
+        err = ps_encrypted_object_read_data(g_obj_tbl_info.fid, &g_ps_object,
+                                            offset, size, p_blocks);
+        if (err != PSA_SUCCESS) {
+            ps_object_set_dirty(0, PS_OBJECT_BUF_SIZE);
+            return err;
+        }
+
+        ps_object_set_dirty_chunks(offset, size);
+    }
+}
+
+/**
+ * \brief Streams the data of a new version of the object in g_ps_object, whose
+ *        data has changed in the given range, to its new file ID stored in
+ *        g_obj_tbl_info. Each window of object data is filled with the new
+ *        data read from the client, encrypted and stored before the next one.
+ *
+ * \param[in] old_fid  File ID of the old version of the object, if any
+ * \param[in] offset   Offset of the object data changed since the old version
+ * \param[in] size     Size of the object data changed since the old version
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_stream_object(uint32_t old_fid, uint32_t offset,
+                                     uint32_t size)
+{
+    psa_status_t err;
+    uint32_t data_size = g_ps_object.header.info.current_size;
+    uint32_t start;
+    uint32_t first;
+    uint32_t end;
+
+    for (start = 0; start < data_size; start += PS_OBJECT_WINDOW_SIZE) {
+        /* The window is filled with the new data and with the ciphertext of
+         * the old version of the object.
+         */
+        ps_object_set_dirty(0, PS_UTILS_MIN(PS_OBJECT_WINDOW_SIZE,
+                                            data_size - start));
+
+        first = PS_UTILS_MAX(offset, start);
+        end = PS_UTILS_MIN(offset + size, start + PS_OBJECT_WINDOW_SIZE);
+        if (first < end) {
+            err = ps_req_mngr_read_asset_data(g_ps_object.data +
+                                              (first - start),
+                                              end - first);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+        }
+
+        err = ps_encrypted_object_write_window(old_fid, g_obj_tbl_info.fid,
+                                               &g_ps_object, start,
+                                               offset, size);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    return ps_encrypted_object_write_header(g_obj_tbl_info.fid, &g_ps_object);
+}
+#endif /* PS_OBJECT_STREAM */
 #else
 enum read_type_t {
     READ_HEADER_ONLY = 0,
@@ -190,6 +451,8 @@ static psa_status_t ps_read_object(enum read_type_t type)
 
     /* Read object data if any */
     if (type == READ_ALL_OBJECT && g_ps_object.header.info.current_size > 0) {
+        ps_object_set_dirty(0, g_ps_object.header.info.current_size);
+
         err = psa_its_get(g_obj_tbl_info.fid,
                           PS_OBJECT_HEADER_SIZE,
                           g_ps_object.header.info.current_size,
@@ -228,27 +491,84 @@ static psa_status_t ps_write_object(uint32_t wrt_size)
 #endif /* !PS_ENCRYPTION */
 
 /**
- * \brief Writes g_ps_object, encrypting it if necessary. Also uses g_obj_tbl_info.
+ * \brief Writes g_ps_object, with the object data changed by the request read
+ *        from the client, encrypting it if necessary. Also uses g_obj_tbl_info.
  *
  * \param[in]  uid       Unique identifier for the data
  * \param[in]  client_id Identifier of the asset's owner (client)
+ * \param[in]  old_fid   File ID of the old version of the object, if any
+ * \param[in]  offset    Offset of the object data changed since the old version
+ * \param[in]  size      Size of the object data changed since the old version
  * \param[out] p_blocks  New number of encryption blocks needed to read/write
  *                       the object, if changed.
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
-static psa_status_t ps_store_object(psa_storage_uid_t uid, int32_t client_id, uint32_t *p_blocks)
+static psa_status_t ps_store_object(psa_storage_uid_t uid, int32_t client_id,
+                                    uint32_t old_fid, uint32_t offset,
+                                    uint32_t size, uint32_t *p_blocks)
 {
     psa_status_t err;
-#ifndef PS_ENCRYPTION
+    /* The object information is encrypted in place with the object data, so
+     * keep a copy of it for the object table.
+     */
+    const struct ps_object_info_t info = g_ps_object.header.info;
+#ifdef PS_ENCRYPTION
+    /* The encryption replaces the tag the object table points to, which must
+     * stay the one of the old version of the object if the write fails.
+     */
+    uint8_t old_tag[PS_TAG_LEN_BYTES];
+#endif
+#if PS_OBJECT_STREAM
+    (void)p_blocks;
+#elif !defined(PS_ENCRYPTION)
     uint32_t wrt_size;
+#elif PS_AES_KEY_USAGE_LIMIT != 0
+    uint32_t num_blocks;
+#endif
+
+#if !defined(PS_ENCRYPTION) || (PS_AES_KEY_USAGE_LIMIT != 0)
+    /* The whole object is written */
+    (void)old_fid;
+    (void)offset;
+    (void)size;
+#endif
+
+#ifdef PS_ENCRYPTION
+    (void)memcpy(old_tag, g_obj_tbl_info.tag, PS_TAG_LEN_BYTES);
+
+    /* The new IVs of the object must not depend on an IV restored at boot */
+    err = ps_object_table_open_batch();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif
+
+#if PS_OBJECT_STREAM
+    /* The object data does not fit in g_ps_object.data */
+    err = ps_stream_object(old_fid, offset, size);
+#else
+    /* Update the object data */
+    ps_object_set_dirty(offset, size);
+    err = ps_req_mngr_read_asset_data(g_ps_object.data + offset, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+#ifdef PS_ENCRYPTION
+    /* The object data is replaced by its ciphertext, which is followed by the
+     * tag when the object is encrypted as a whole.
+     */
+    ps_object_set_dirty(0, g_ps_object.header.info.current_size +
+                           (PS_OBJECT_CHUNKS ? 0 : PS_TAG_LEN_BYTES));
 #endif
 
 #ifdef PS_ENCRYPTION
 #if PS_AES_KEY_USAGE_LIMIT == 0
-    err = ps_encrypted_object_write(g_obj_tbl_info.fid, &g_ps_object);
+    err = ps_encrypted_object_write_range(old_fid, g_obj_tbl_info.fid,
+                                          &g_ps_object, offset, size);
 #else
-    uint32_t num_blocks = ps_encrypted_object_blocks(g_ps_object.header.info.current_size);
+    num_blocks = ps_encrypted_object_blocks(g_ps_object.header.info.current_size);
 
     /* Switch to new key if this write will not leave enough blocks to read the object */
     if (2 * num_blocks >= PS_AES_KEY_USAGE_LIMIT - g_obj_tbl_info.num_blocks) {
@@ -268,20 +588,110 @@ static psa_status_t ps_store_object(psa_storage_uid_t uid, int32_t client_id, ui
     /* Write g_ps_object */
     err = ps_write_object(wrt_size);
 #endif /* PS_ENCRYPTION */
+#endif /* PS_OBJECT_STREAM */
+
+    /* Keep the object information in the object table in line with the
+     * stored object.
+     */
+    if (err == PSA_SUCCESS) {
+        g_obj_tbl_info.info = info;
+    }
+
+#ifdef PS_ENCRYPTION
+    if (err != PSA_SUCCESS) {
+        (void)memcpy(g_obj_tbl_info.tag, old_tag, PS_TAG_LEN_BYTES);
+    }
+#endif
 
     return err;
 }
 
+/**
+ * \brief Sets the object information of the objects of an object table
+ *        upgraded from the object system version 1, which only stored it in
+ *        the object headers, and stores the upgraded object table.
+ *
+ * \details An object which does not authenticate, or whose file is corrupted,
+ *          is removed from the object table, as it could not be read by a
+ *          request either. Any other error, such as a storage failure, is
+ *          returned without saving the upgraded table, so that the upgrade is
+ *          done again at the next boot.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_upgrade_objects(void)
+{
+    psa_status_t err;
+    uint32_t idx = 0;
+    psa_storage_uid_t uid;
+    int32_t client_id;
+#ifdef PS_ENCRYPTION
+    uint32_t num_blocks;
+#endif
+
+    while (ps_object_table_get_upgraded_obj(&idx, &uid, &client_id) ==
+           PSA_SUCCESS) {
+        err = ps_object_table_get_obj_tbl_info(uid, client_id,
+                                               &g_obj_tbl_info);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+#ifdef PS_ENCRYPTION
+        num_blocks = 0;
+        err = ps_read_encrypted_object(uid, client_id, 0, 0, &num_blocks);
+#if PS_AES_KEY_USAGE_LIMIT != 0
+        g_obj_tbl_info.num_blocks += num_blocks;
+        if (err == PSA_SUCCESS) {
+            /* The object is decrypted as a whole, and encrypted again with a
+             * new key if it could not be read once more.
+             */
+            err = ps_switch_keys_if_necessary(num_blocks);
+            if (err != PSA_SUCCESS) {
+                ps_object_erase();
+                return err;
+            }
+        }
+#endif
+#else
+        err = ps_read_object(READ_HEADER_ONLY);
+#endif /* PS_ENCRYPTION */
+        if (err == PSA_SUCCESS) {
+            g_obj_tbl_info.info = g_ps_object.header.info;
+            ps_object_table_set_upgraded_obj(uid, client_id, &g_obj_tbl_info);
+        } else if (err == PSA_ERROR_INVALID_SIGNATURE ||
+                   err == PSA_ERROR_DATA_CORRUPT) {
+            ps_object_table_set_upgraded_obj(uid, client_id, NULL);
+        } else {
+            ps_object_erase();
+            return err;
+        }
+
+        ps_object_erase();
+    }
+
+    return ps_object_table_save_upgrade();
+}
+
 psa_status_t ps_system_prepare(void)
 {
     psa_status_t err;
 
-    /* Reuse the allocated g_ps_object.data to store a temporary object table
+    /* Reuse the allocated g_ps_object to store a temporary object table
      * data to be validate inside the function.
-     * The stored date will be cleaned up when the g_ps_object.data will
-     * be used for the first time in the object system.
      */
-    err = ps_object_table_init(g_ps_object.data);
+    err = ps_object_table_init((uint8_t *)&g_ps_object);
+
+    /* Erase the temporary object table, so that the requests only have to
+     * erase the parts of g_ps_object they use.
+     */
+    (void)memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL, PS_MAX_OBJECT_SIZE);
+    g_ps_object_dirty.start = 0;
+    g_ps_object_dirty.end = 0;
+
+#if PS_OBJECT_CACHE_SIZE != 0
+    ps_object_cache_wipe();
+#endif
 
 #ifdef PS_ENCRYPTION
 #if PS_AES_KEY_USAGE_LIMIT != 0
@@ -299,7 +709,11 @@ psa_status_t ps_system_prepare(void)
     g_obj_tbl_info.tag = g_ps_object.header.crypto.ref.tag;
 #endif
 
-    return err;
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return ps_upgrade_objects();
 }
 
 psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
@@ -309,6 +723,11 @@ psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
     psa_status_t err;
 #ifdef PS_ENCRYPTION
     uint32_t num_blocks = 0;
+    uint32_t rd_offset = offset;
+    uint32_t rd_size = size;
+#endif
+#if PS_OBJECT_CACHE_SIZE != 0
+    const uint8_t *p_cached;
 #endif
 
     /* Retrieve the object information from the object table if the object
@@ -319,12 +738,37 @@ psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
         return err;
     }
 
+#if PS_OBJECT_CACHE_SIZE != 0
+    /* Serve the read from the cache if it holds the current version of the
+     * object, without any object I/O or decryption.
+     */
+    p_cached = ps_object_cache_get(uid, client_id, g_obj_tbl_info.fid,
+                                   g_obj_tbl_info.info.current_size);
+    if (p_cached != NULL) {
+        if (offset > g_obj_tbl_info.info.current_size) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        size = PS_UTILS_MIN(size, g_obj_tbl_info.info.current_size - offset);
+        ps_req_mngr_write_asset_data(p_cached + offset, size);
+        *p_data_length = size;
+
+        return PSA_SUCCESS;
+    }
+#endif
+
     /* Read object */
 #ifdef PS_ENCRYPTION
-    g_ps_object.header.crypto.ref.uid = uid;
-    g_ps_object.header.crypto.ref.client_id = client_id;
+#if PS_OBJECT_CACHE_SIZE != 0
+    /* Decrypt the whole object if it can be cached */
+    if (g_obj_tbl_info.info.current_size <= PS_OBJECT_CACHE_SIZE) {
+        rd_offset = 0;
+        rd_size = PS_MAX_OBJECT_DATA_SIZE;
+    }
+#endif
 
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object, &num_blocks);
+    err = ps_read_encrypted_object(uid, client_id, rd_offset, rd_size,
+                                   &num_blocks);
 #if PS_AES_KEY_USAGE_LIMIT != 0
     g_obj_tbl_info.num_blocks += num_blocks;
 #endif
@@ -346,10 +790,22 @@ psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
                         g_ps_object.header.info.current_size - offset);
 
     /* Copy the decrypted object data to the output buffer */
+#if PS_OBJECT_STREAM
+    err = ps_write_asset_data(offset, size, &num_blocks);
+    if (err != PSA_SUCCESS) {
+        goto switch_keys_and_return;
+    }
+#else
     ps_req_mngr_write_asset_data(g_ps_object.data + offset, size);
+#endif
 
     *p_data_length = size;
 
+#if PS_OBJECT_CACHE_SIZE != 0
+    ps_object_cache_put(uid, client_id, g_obj_tbl_info.fid, g_ps_object.data,
+                        g_ps_object.header.info.current_size);
+#endif
+
 switch_keys_and_return:
 #ifdef PS_ENCRYPTION
     if (err == PSA_SUCCESS) {
@@ -369,8 +825,7 @@ update_table_and_return:
 #endif
 
     /* Remove data stored in the object before leaving the function */
-    (void)memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
-                 PS_MAX_OBJECT_SIZE);
+    ps_object_erase();
 
     return err;
 }
@@ -381,6 +836,7 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
 {
     psa_status_t err;
     uint32_t old_fid = PS_INVALID_FID;
+    struct ps_object_info_t old_info = {0};
     uint32_t fid_am_reserved = 1;
     uint32_t num_blocks = 0;
     bool object_exists = false;
@@ -390,6 +846,11 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
+#if PS_OBJECT_CACHE_SIZE != 0
+    /* The cached data of the object is about to be out of date */
+    ps_object_cache_invalidate(uid, client_id);
+#endif
+
     /* Retrieve the object information from the object table if the object
      * exists.
      */
@@ -397,11 +858,8 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
     if (err == PSA_SUCCESS) {
         object_exists = true;
 #ifdef PS_ENCRYPTION
-        /* Read the object */
-        g_ps_object.header.crypto.ref.uid = uid;
-        g_ps_object.header.crypto.ref.client_id = client_id;
-
-        err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object, &num_blocks);
+        /* Read the object header, the whole content is replaced */
+        err = ps_read_encrypted_object(uid, client_id, 0, 0, &num_blocks);
 #if PS_AES_KEY_USAGE_LIMIT != 0
         g_obj_tbl_info.num_blocks += num_blocks;
 #endif /* PS_AES_KEY_USAGE_LIMIT */
@@ -426,8 +884,9 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
         g_ps_object.header.info.create_flags = create_flags;
         g_ps_object.header.info.max_size = size;
 
-        /* Save old file ID */
+        /* Save old file ID and object information */
         old_fid = g_obj_tbl_info.fid;
+        old_info = g_obj_tbl_info.info;
     } else if (err == PSA_ERROR_DOES_NOT_EXIST) {
         /* If the object does not exist, then initialize it based on the input
          * arguments and empty content. Requests 2 FIDs to prevent exhaustion.
@@ -441,12 +900,6 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
         return err;
     }
 
-    /* Update the object data */
-    err = ps_req_mngr_read_asset_data(g_ps_object.data, size);
-    if (err != PSA_SUCCESS) {
-        goto switch_keys_and_return;
-    }
-
     /* Get new file ID */
     err = ps_object_table_get_free_fid(fid_am_reserved,
                                        &g_obj_tbl_info.fid);
@@ -457,7 +910,7 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
     /* Update the current object size */
     g_ps_object.header.info.current_size = size;
 
-    err = ps_store_object(uid, client_id, &num_blocks);
+    err = ps_store_object(uid, client_id, old_fid, 0, size, &num_blocks);
     if (err != PSA_SUCCESS) {
         /* If we failed to store the updated object, we need to keep the old version */
         if (old_fid != PS_INVALID_FID) {
@@ -488,11 +941,11 @@ update_table_and_return:
 
     if ((err == PSA_SUCCESS) && (old_fid != PS_INVALID_FID)) {
         /* Remove old object */
-        err = psa_its_remove(old_fid);
+        err = ps_remove_object(old_fid, &old_info);
     }
 
     /* Remove data stored in the object before leaving the function */
-    (void)memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL, PS_MAX_OBJECT_SIZE);
+    ps_object_erase();
 
     return err;
 }
@@ -502,8 +955,14 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
 {
     psa_status_t err;
     uint32_t old_fid = PS_INVALID_FID;
+    struct ps_object_info_t old_info = {0};
     uint32_t num_blocks = 0;
 
+#if PS_OBJECT_CACHE_SIZE != 0
+    /* The cached data of the object is about to be out of date */
+    ps_object_cache_invalidate(uid, client_id);
+#endif
+
     /* Retrieve the object information from the object table if the object
      * exists.
      */
@@ -512,12 +971,12 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
         return err;
     }
 
-    /* Read the object */
+    /* Read the object. The object data in the range to write is overwritten,
+     * so only the object header needs to be read when the object data is
+     * encrypted in chunks.
+     */
 #ifdef PS_ENCRYPTION
-    g_ps_object.header.crypto.ref.uid = uid;
-    g_ps_object.header.crypto.ref.client_id = client_id;
-
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object, &num_blocks);
+    err = ps_read_encrypted_object(uid, client_id, offset, 0, &num_blocks);
 #if PS_AES_KEY_USAGE_LIMIT != 0
     g_obj_tbl_info.num_blocks += num_blocks;
 #endif
@@ -549,14 +1008,9 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
         goto switch_keys_and_return;
     }
 
-    /* Update the object data */
-    err = ps_req_mngr_read_asset_data(g_ps_object.data + offset, size);
-    if (err != PSA_SUCCESS) {
-        goto switch_keys_and_return;
-    }
-
-    /* Save old file ID */
+    /* Save old file ID and object information */
     old_fid = g_obj_tbl_info.fid;
+    old_info = g_obj_tbl_info.info;
 
     /* Get new file ID */
     err = ps_object_table_get_free_fid(1, &g_obj_tbl_info.fid);
@@ -569,7 +1023,7 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
         g_ps_object.header.info.current_size = offset + size;
     }
 
-    err = ps_store_object(uid, client_id, &num_blocks);
+    err = ps_store_object(uid, client_id, old_fid, offset, size, &num_blocks);
     if (err != PSA_SUCCESS) {
         /* We couldn't write the new data, so keep the old */
         g_obj_tbl_info.fid = old_fid;
@@ -595,12 +1049,11 @@ update_table_and_return:
 
     if (err == PSA_SUCCESS) {
         /* Remove old object */
-        err = psa_its_remove(old_fid);
+        err = ps_remove_object(old_fid, &old_info);
     }
 
     /* Remove data stored in the object before leaving the function */
-    (void)memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
-                 PS_MAX_OBJECT_SIZE);
+    ps_object_erase();
 
     return err;
 }
@@ -609,58 +1062,22 @@ psa_status_t ps_object_get_info(psa_storage_uid_t uid, int32_t client_id,
                                 struct psa_storage_info_t *info)
 {
     psa_status_t err;
-#ifdef PS_ENCRYPTION
-    uint32_t num_blocks = 0;
-#endif
 
     /* Retrieve the object information from the object table if the object
-     * exists.
+     * exists. The object table authenticates the object information, so the
+     * object itself does not need to be read and decrypted.
      */
     err = ps_object_table_get_obj_tbl_info(uid, client_id, &g_obj_tbl_info);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-#ifdef PS_ENCRYPTION
-    g_ps_object.header.crypto.ref.uid = uid;
-    g_ps_object.header.crypto.ref.client_id = client_id;
-
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object, &num_blocks);
-#if PS_AES_KEY_USAGE_LIMIT != 0
-    g_obj_tbl_info.num_blocks += num_blocks;
-#endif
-#else
-    err = ps_read_object(READ_HEADER_ONLY);
-#endif /* PS_ENCRYPTION */
-    if (err != PSA_SUCCESS) {
-        goto update_table_and_return;
-    }
-
     /* Copy PS object info to the PSA PS info struct */
-    info->size = g_ps_object.header.info.current_size;
-    info->capacity = g_ps_object.header.info.max_size;
-    info->flags = g_ps_object.header.info.create_flags;
-
-#ifdef PS_ENCRYPTION
-    err = ps_switch_keys_if_necessary(num_blocks);
-#endif /* PS_ENCRYPTION */
-
-update_table_and_return:
-#ifdef PS_ENCRYPTION
-#if PS_AES_KEY_USAGE_LIMIT != 0
-    if (err == PSA_SUCCESS) {
-        err = ps_update_table(uid, client_id);
-    } else {
-        (void)ps_update_table(uid, client_id);
-    }
-#endif
-#endif
-
-    /* Remove data stored in the object before leaving the function */
-    (void)memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
-                 PS_MAX_OBJECT_SIZE);
+    info->size = g_obj_tbl_info.info.current_size;
+    info->capacity = g_obj_tbl_info.info.max_size;
+    info->flags = g_obj_tbl_info.info.create_flags;
 
-    return err;
+    return PSA_SUCCESS;
 }
 
 psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id)
@@ -670,6 +1087,11 @@ psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id)
     uint32_t num_blocks = 0;
 #endif
 
+#if PS_OBJECT_CACHE_SIZE != 0
+    /* The cached data of the object is about to be out of date */
+    ps_object_cache_invalidate(uid, client_id);
+#endif
+
     /* Retrieve the object information from the object table if the object
      * exists.
      */
@@ -679,10 +1101,7 @@ psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id)
     }
 
 #ifdef PS_ENCRYPTION
-    g_ps_object.header.crypto.ref.uid = uid;
-    g_ps_object.header.crypto.ref.client_id = client_id;
-
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object, &num_blocks);
+    err = ps_read_encrypted_object(uid, client_id, 0, 0, &num_blocks);
 #if PS_AES_KEY_USAGE_LIMIT != 0
     g_obj_tbl_info.num_blocks += num_blocks;
 #endif
@@ -721,7 +1140,7 @@ psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id)
     }
 
     /* Remove old object */
-    err = psa_its_remove(g_obj_tbl_info.fid);
+    err = ps_remove_object(g_obj_tbl_info.fid, &g_obj_tbl_info.info);
 
 switch_keys_and_return:
 #ifdef PS_ENCRYPTION
@@ -741,8 +1160,7 @@ update_table_and_return:
 #endif
 
     /* Remove data stored in the object before leaving the function */
-    (void)memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
-                 PS_MAX_OBJECT_SIZE);
+    ps_object_erase();
 
     return err;
 }
@@ -756,5 +1174,9 @@ psa_status_t ps_system_wipe_all(void)
      * this function doesn't block on the lock and directly
      * moves to erasing the flash instead.
      */
+#if PS_OBJECT_CACHE_SIZE != 0
+    ps_object_cache_wipe();
+#endif
+
     return ps_object_table_create();
 }
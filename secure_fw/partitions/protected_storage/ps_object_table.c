@@ -30,7 +30,11 @@
  *
  * \brief Current object system version.
  */
-#define PS_OBJECT_SYSTEM_VERSION  0x01
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+#define PS_OBJECT_SYSTEM_VERSION  0x03
+#else
+#define PS_OBJECT_SYSTEM_VERSION  0x02
+#endif
 
 /*!
  * \struct ps_obj_table_info_t
@@ -48,8 +52,48 @@ struct ps_obj_table_entry_t {
 #endif
     psa_storage_uid_t uid;          /*!< Object UID */
     int32_t client_id;              /*!< Client ID */
+    struct ps_object_info_t info;   /*!< Object information, authenticated
+                                     *   with the table so that it can be
+                                     *   returned without reading the object
+                                     */
 };
 
+#if defined(PS_ENCRYPTION) && (PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES != 0)
+/* The table entries are authenticated by a hash tree, whose root is
+ * authenticated with the table header. The tree only makes the updates of
+ * the table incremental: the whole table is checked against the root when it
+ * is loaded, and the entries are not verified again when they are looked up.
+ */
+#define PS_OBJ_TABLE_HASH_TREE 1
+#else
+#define PS_OBJ_TABLE_HASH_TREE 0
+#endif
+
+#if PS_ROLLBACK_PROTECTION && (PS_NV_COUNTER_BATCH_SIZE > 1)
+/* The commits of the object table share one increment of the PS NV counters
+ * per batch of PS_NV_COUNTER_BATCH_SIZE commits.
+ */
+#define PS_OBJ_TABLE_NVC_BATCH 1
+#else
+#define PS_OBJ_TABLE_NVC_BATCH 0
+#endif
+
+#if PS_ROLLBACK_PROTECTION
+/*!
+ * \def PS_COMMIT_NR_TO_NVC
+ *
+ * \brief Gets the value of PS NV counter 1 a commit number belongs to. The
+ *        commits of a batch are numbered from the value of the counter times
+ *        PS_NV_COUNTER_BATCH_SIZE.
+ *
+ * \param[in] commit_nr  Commit number of a table or record
+ *
+ * \return Returns the value of PS NV counter 1
+ */
+#define PS_COMMIT_NR_TO_NVC(commit_nr) \
+                                  ((commit_nr) / PS_NV_COUNTER_BATCH_SIZE)
+#endif /* PS_ROLLBACK_PROTECTION */
+
 /* Specifies number of entries in the table. The number of entries is the
  * number of assets, defined in asset_defs.h, plus one extra entry to store
  * a new object when the code processes a change in a file.
@@ -74,11 +118,76 @@ struct ps_obj_table_t {
                                   */
 #endif /* PS_ROLLBACK_PROTECTION */
 
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+  uint32_t commit_nr;            /*!< Commit number of the table, which the
+                                  *   records of the journal are chained to.
+                                  *   It is the value of PS NV counter 1 with
+                                  *   rollback protection.
+                                  */
+#endif
+
+#if PS_OBJ_TABLE_HASH_TREE
+  uint8_t root[PS_HASH_LEN_BYTES]; /*!< Root of the hash tree of the
+                                    *   entries.
+                                    */
+#endif
+
   struct ps_obj_table_entry_t obj_db[PS_OBJ_TABLE_ENTRIES]; /*!< Table's
                                                              *   entries
                                                              */
 };
 
+/*!
+ * \def PS_OBJECT_SYSTEM_VERSION_1
+ *
+ * \brief First object system version, whose object tables are upgraded to the
+ *        current version at init.
+ */
+#define PS_OBJECT_SYSTEM_VERSION_1  0x01
+
+/*!
+ * \struct ps_obj_table_entry_v1_t
+ *
+ * \brief Object table entry of the object system version 1, without the
+ *        object information, which is only stored in the object header.
+ */
+struct ps_obj_table_entry_v1_t {
+#ifdef PS_ENCRYPTION
+    uint8_t tag[PS_TAG_LEN_BYTES];  /*!< MAC value of AEAD object */
+#if PS_AES_KEY_USAGE_LIMIT != 0
+    uint32_t num_blocks;            /*!< blocks encrypted/decrypted with current key */
+#endif
+#else
+    uint32_t version;               /*!< File version */
+#endif
+    psa_storage_uid_t uid;          /*!< Object UID */
+    int32_t client_id;              /*!< Client ID */
+};
+
+/*!
+ * \struct ps_obj_table_v1_t
+ *
+ * \brief Object table structure of the object system version 1. Its header
+ *        is the one of the current object table, up to the swap count.
+ */
+struct ps_obj_table_v1_t {
+#ifdef PS_ENCRYPTION
+  union ps_crypto_t crypto;      /*!< Crypto metadata. */
+#endif
+
+  uint8_t version;               /*!< PS object system version. */
+
+#if (!PS_ROLLBACK_PROTECTION)
+  uint8_t swap_count;            /*!< Swap counter to distinguish 2 different
+                                  *   object tables.
+                                  */
+#endif /* PS_ROLLBACK_PROTECTION */
+
+  struct ps_obj_table_entry_v1_t obj_db[PS_OBJ_TABLE_ENTRIES]; /*!< Table's
+                                                                *   entries
+                                                                */
+};
+
 #ifdef PS_ENCRYPTION
 /* Constants used to derive key for the object table */
 /* Avoid potential clashes with objects */
@@ -140,6 +249,134 @@ static inline uint32_t ps_object_fs_id_to_idx(uint32_t fid)
     return idx;
 }
 
+/* Maximum number of entries changed by a change of the table, as the update of
+ * an object clears its old entry and fills its new one.
+ */
+#define PS_OBJ_TABLE_MAX_CHANGES 2
+
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+/*!
+ * \def PS_JOURNAL_FS_ID
+ *
+ * \brief File ID to be used in order to store a record of the object table
+ *        journal in the file system.
+ *
+ * \param[in] n  Position of the record in the journal.
+ *
+ * \return Returns file ID
+ */
+#define PS_JOURNAL_FS_ID(n) (PS_OBJECT_FS_ID(PS_OBJ_TABLE_ENTRIES) + (n))
+
+/*!
+ * \struct ps_obj_table_change_t
+ *
+ * \brief Change of an object table entry.
+ */
+struct ps_obj_table_change_t {
+    uint32_t idx;                       /*!< Index of the entry */
+    struct ps_obj_table_entry_t entry;  /*!< New content of the entry */
+};
+
+/*!
+ * \struct ps_obj_table_record_t
+ *
+ * \brief Record of the object table journal. It holds the entries changed by
+ *        one commit, which are applied on top of the table with the commit
+ *        number base_nr and of the previous records when the table is loaded.
+ */
+struct ps_obj_table_record_t {
+#ifdef PS_ENCRYPTION
+    union ps_crypto_t crypto;              /*!< Crypto metadata */
+    uint8_t prev_tag[PS_TAG_LEN_BYTES];    /*!< Tag of the previous record, or
+                                            *   of the table for the first
+                                            *   record
+                                            */
+#endif
+    uint32_t base_nr;                      /*!< Commit number of the table */
+    uint32_t commit_nr;                    /*!< Commit number of the record */
+    uint32_t num_changes;                  /*!< Number of changed entries */
+    struct ps_obj_table_change_t
+                  change[PS_OBJ_TABLE_MAX_CHANGES]; /*!< Changed entries */
+};
+
+/*!
+ * \struct ps_obj_table_journal_t
+ *
+ * \brief State of the object table journal.
+ */
+struct ps_obj_table_journal_t {
+#ifdef PS_ENCRYPTION
+    union ps_crypto_t crypto;  /*!< Crypto metadata of the last commit */
+#endif
+    uint32_t commit_nr;        /*!< Commit number of the last commit */
+    uint32_t len;              /*!< Number of records in the journal */
+};
+
+/* Record buffer, used to write a record and to replay the journal */
+static struct ps_obj_table_record_t ps_obj_table_record;
+
+/* Record size */
+#define PS_OBJ_TABLE_RECORD_SIZE  sizeof(struct ps_obj_table_record_t)
+#endif /* PS_OBJ_TABLE_JOURNAL_SIZE != 0 */
+
+#if PS_OBJ_TABLE_INDEX
+/* Number of slots of the index. Keeping at least half of the slots empty
+ * keeps the probe sequences short.
+ */
+#define PS_OBJ_TABLE_INDEX_SLOTS  (2 * PS_OBJ_TABLE_ENTRIES)
+
+/* Marks an empty slot of the index */
+#define PS_OBJ_TABLE_INDEX_EMPTY  UINT16_MAX
+
+/* Check at compilation time if the entry indexes fit in the index slots */
+PS_UTILS_BOUND_CHECK(OBJ_TABLE_ENTRIES_NOT_FIT_IN_INDEX,
+                     PS_OBJ_TABLE_ENTRIES, PS_OBJ_TABLE_INDEX_EMPTY);
+
+/*!
+ * \struct ps_obj_table_index_t
+ *
+ * \brief In-RAM index of the object table. The used entries are found by
+ *        open addressing, with linear probing, from a hash of their UID and
+ *        client ID. The free entries are kept in a stack.
+ */
+struct ps_obj_table_index_t {
+    uint16_t slot[PS_OBJ_TABLE_INDEX_SLOTS];  /*!< Entry index of each slot */
+    uint16_t free_idx[PS_OBJ_TABLE_ENTRIES];  /*!< Stack of the free entries */
+    uint16_t free_pos[PS_OBJ_TABLE_ENTRIES];  /*!< Position of each free
+                                               *   entry in the stack
+                                               */
+    uint16_t num_free;                        /*!< Number of free entries */
+};
+#endif /* PS_OBJ_TABLE_INDEX */
+
+#if PS_OBJ_TABLE_HASH_TREE
+/* Number of leaves of the hash tree, each one the hash of a page of entries */
+#define PS_OBJ_TABLE_TREE_LEAVES ((PS_OBJ_TABLE_ENTRIES + \
+                                   PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES - 1) / \
+                                  PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES)
+
+/* Number of nodes of the hash tree, plus the unused node 0 */
+#define PS_OBJ_TABLE_TREE_NODES  (2 * PS_OBJ_TABLE_TREE_LEAVES)
+
+/*!
+ * \struct ps_obj_table_tree_t
+ *
+ * \brief In-RAM hash tree of the object table entries. Node 1 is the root,
+ *        the children of node n are the nodes 2n and 2n + 1, and the leaves
+ *        are the last PS_OBJ_TABLE_TREE_LEAVES nodes. The shape of the tree
+ *        only depends on the number of entries, so a leaf cannot be taken
+ *        for an internal node.
+ */
+struct ps_obj_table_tree_t {
+    uint8_t node[PS_OBJ_TABLE_TREE_NODES][PS_HASH_LEN_BYTES]; /*!< Hash of
+                                                               *   each node
+                                                               */
+    uint32_t dirty[(PS_OBJ_TABLE_TREE_NODES + 31) / 32]; /*!< Nodes to hash
+                                                          *   again
+                                                          */
+};
+#endif /* PS_OBJ_TABLE_HASH_TREE */
+
 /*!
  * \struct ps_obj_table_ctx_t
  *
@@ -149,6 +386,32 @@ struct ps_obj_table_ctx_t {
     struct ps_obj_table_t obj_table;  /*!< Object tables */
     uint8_t active_table;             /*!< Active object table */
     uint8_t scratch_table;            /*!< Scratch object table */
+#if PS_OBJ_TABLE_INDEX
+    struct ps_obj_table_index_t index; /*!< Index of the object table */
+#endif
+#if PS_OBJ_TABLE_HASH_TREE
+    struct ps_obj_table_tree_t tree;  /*!< Hash tree of the object table */
+#endif
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    struct ps_obj_table_journal_t journal; /*!< Journal of the object table */
+    uint8_t old_table;                /*!< Set when the scratch table is an
+                                       *   old table to be removed
+                                       */
+#endif
+#if PS_OBJ_TABLE_NVC_BATCH
+    uint32_t nvc_batch_left;          /*!< Number of commits left in the
+                                       *   batch of the current value of PS
+                                       *   NV counter 1
+                                       */
+    uint32_t nvc_batch_commit_nr;     /*!< Commit number of the next commit
+                                       *   of the batch
+                                       */
+#endif
+    uint8_t upgrade;                  /*!< Set when the table is upgraded
+                                       *   from the object system version 1,
+                                       *   until it is saved with the object
+                                       *   information of its entries
+                                       */
 };
 
 /* Object table context */
@@ -170,9 +433,18 @@ static struct ps_obj_table_ctx_t ps_obj_table_ctx;
 #define PS_CRYPTO_ASSOCIATED_DATA(crypto) ((uint8_t *)crypto + \
                                             PS_NON_AUTH_OBJ_TABLE_SIZE)
 
+#if PS_OBJ_TABLE_HASH_TREE
+/* Only the table header, which holds the root of the hash tree of the
+ * entries, is authenticated.
+ */
+#define PS_OBJ_TABLE_AUTH_SIZE (offsetof(struct ps_obj_table_t, obj_db) - \
+                                PS_NON_AUTH_OBJ_TABLE_SIZE)
+#else
+#define PS_OBJ_TABLE_AUTH_SIZE (PS_OBJ_TABLE_SIZE - PS_NON_AUTH_OBJ_TABLE_SIZE)
+#endif
+
 #if PS_ROLLBACK_PROTECTION
-#define PS_OBJ_TABLE_AUTH_DATA_SIZE (PS_OBJ_TABLE_SIZE - \
-                                     PS_NON_AUTH_OBJ_TABLE_SIZE)
+#define PS_OBJ_TABLE_AUTH_DATA_SIZE PS_OBJ_TABLE_AUTH_SIZE
 
 struct ps_crypto_assoc_data_t {
     uint8_t  obj_table_data[PS_OBJ_TABLE_AUTH_DATA_SIZE];
@@ -184,8 +456,21 @@ struct ps_crypto_assoc_data_t {
 #else
 
 /* The associated data is the header, minus the the tag data */
-#define PS_CRYPTO_ASSOCIATED_DATA_LEN (PS_OBJ_TABLE_SIZE - \
-                                       PS_NON_AUTH_OBJ_TABLE_SIZE)
+#define PS_CRYPTO_ASSOCIATED_DATA_LEN PS_OBJ_TABLE_AUTH_SIZE
+#endif /* PS_ROLLBACK_PROTECTION */
+
+/* Object table size of the object system version 1 */
+#define PS_OBJ_TABLE_V1_SIZE         sizeof(struct ps_obj_table_v1_t)
+
+/* The whole object table of the object system version 1 is authenticated */
+#define PS_OBJ_TABLE_V1_AUTH_SIZE    (PS_OBJ_TABLE_V1_SIZE - \
+                                      PS_NON_AUTH_OBJ_TABLE_SIZE)
+
+#if PS_ROLLBACK_PROTECTION
+struct ps_crypto_assoc_data_v1_t {
+    uint8_t  obj_table_data[PS_OBJ_TABLE_V1_AUTH_SIZE];
+    uint32_t nv_counter;
+};
 #endif /* PS_ROLLBACK_PROTECTION */
 
 #if PS_AES_KEY_USAGE_LIMIT != 0
@@ -193,16 +478,16 @@ struct ps_crypto_assoc_data_t {
 #endif
 
 /* The ps_object_table_init function uses the static memory allocated for
- * the object data manipulation, in ps_object_table.c (g_ps_object), to load a
+ * the object manipulation, in ps_object_system.c (g_ps_object), to load a
  * temporary object table to be validated at that stage.
  * To make sure the object table data fits in the static memory allocated for
  * object manipulation, the following macro checks if the memory allocated is
  * big enough, at compile time
  */
 
-/* Check at compilation time if metadata fits in g_ps_object.data */
+/* Check at compilation time if metadata fits in g_ps_object */
 PS_UTILS_BOUND_CHECK(OBJ_TABLE_NOT_FIT_IN_STATIC_OBJ_DATA_BUF,
-                     PS_OBJ_TABLE_SIZE, PS_MAX_ASSET_SIZE);
+                     PS_OBJ_TABLE_SIZE, PS_MAX_OBJECT_SIZE);
 
 enum ps_obj_table_state {
     PS_OBJ_TABLE_VALID = 0,   /*!< Table content is valid */
@@ -233,17 +518,27 @@ struct ps_obj_table_init_ctx_t {
     uint32_t nvc_1;        /*!< Non-volatile counter value 1 */
     uint32_t nvc_3;        /*!< Non-volatile counter value 3 */
 #endif /* PS_ROLLBACK_PROTECTION */
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    struct ps_obj_table_journal_t journal[PS_NUM_OBJ_TABLES]; /*!< Journal
+                                                               *   of each
+                                                               *   object
+                                                               *   table
+                                                               */
+#endif
 };
 
 /**
  * \brief Reads object table from persistent memory.
  *
  * \param[out] init_ctx  Pointer to the init object table context
+ * \param[in]  size      Size of the object table, which depends on the
+ *                       object system version
  *
  */
 __attribute__ ((always_inline))
 __STATIC_INLINE void ps_object_table_fs_read_table(
-                                       struct ps_obj_table_init_ctx_t *init_ctx)
+                                       struct ps_obj_table_init_ctx_t *init_ctx,
+                                       size_t size)
 {
     psa_status_t err;
     size_t data_length;
@@ -252,7 +547,7 @@ __STATIC_INLINE void ps_object_table_fs_read_table(
 
     err = psa_its_get(PS_TABLE_FS_ID(PS_OBJ_TABLE_IDX_0),
                       PS_OBJECT_TABLE_OBJECT_OFFSET,
-                      PS_OBJ_TABLE_SIZE,
+                      size,
                       (void *)init_ctx->p_table[PS_OBJ_TABLE_IDX_0],
                       &data_length);
     if (err != PSA_SUCCESS) {
@@ -262,7 +557,7 @@ __STATIC_INLINE void ps_object_table_fs_read_table(
     /* Read file with the table 1 data */
     err = psa_its_get(PS_TABLE_FS_ID(PS_OBJ_TABLE_IDX_1),
                       PS_OBJECT_TABLE_OBJECT_OFFSET,
-                      PS_OBJ_TABLE_SIZE,
+                      size,
                       (void *)init_ctx->p_table[PS_OBJ_TABLE_IDX_1],
                       &data_length);
     if (err != PSA_SUCCESS) {
@@ -303,284 +598,376 @@ __STATIC_INLINE psa_status_t ps_object_table_fs_write_table(
     return PSA_SUCCESS;
 }
 
-#ifdef PS_ENCRYPTION
-#if PS_ROLLBACK_PROTECTION
+#if PS_OBJ_TABLE_HASH_TREE
 /**
- * \brief Aligns all PS non-volatile counters.
+ * \brief Computes the hash of a page of entries of a table.
  *
- * \param[in] nvc_1  Value of PS non-volatile counter 1
+ * \param[in]  table  Pointer to the object table
+ * \param[in]  leaf   Leaf index, which is the page index
+ * \param[out] hash   Pointer to store the hash
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
-static psa_status_t ps_object_table_align_nv_counters(uint32_t nvc_1)
+static psa_status_t ps_table_tree_hash_leaf(const struct ps_obj_table_t *table,
+                                            uint32_t leaf, uint8_t *hash)
 {
-    psa_status_t err;
-    uint32_t nvc_x_val = 0;
+    uint32_t first = leaf * PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES;
+    uint32_t num = PS_OBJ_TABLE_ENTRIES - first;
 
-    /* Align PS NVC 2 with NVC 1 */
-    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_2, &nvc_x_val);
-    if (err != PSA_SUCCESS) {
-        return PSA_ERROR_GENERIC_ERROR;
+    if (num > PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES) {
+        num = PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES;
     }
 
-    for (; nvc_x_val < nvc_1; nvc_x_val++) {
-        err = ps_increment_nv_counter(TFM_PS_NV_COUNTER_2);
+    return ps_crypto_hash((const uint8_t *)&table->obj_db[first],
+                          num * PS_OBJECTS_TABLE_ENTRY_SIZE, hash);
+}
+
+/**
+ * \brief Computes the hash of a node of the tree from its children.
+ *
+ * \param[in,out] tree  Pointer to the hash tree
+ * \param[in]     node  Internal node index
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_table_tree_hash_node(struct ps_obj_table_tree_t *tree,
+                                            uint32_t node)
+{
+    /* The two children are contiguous */
+    return ps_crypto_hash(tree->node[2 * node], 2 * PS_HASH_LEN_BYTES,
+                          tree->node[node]);
+}
+
+/**
+ * \brief Computes the whole hash tree of a table.
+ *
+ * \param[in]  table  Pointer to the object table
+ * \param[out] tree   Pointer to the hash tree
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_table_tree_build(const struct ps_obj_table_t *table,
+                                        struct ps_obj_table_tree_t *tree)
+{
+    psa_status_t err;
+    uint32_t i;
+
+    for (i = 0; i < PS_OBJ_TABLE_TREE_LEAVES; i++) {
+        err = ps_table_tree_hash_leaf(table, i,
+                                   tree->node[PS_OBJ_TABLE_TREE_LEAVES + i]);
         if (err != PSA_SUCCESS) {
             return err;
         }
     }
 
-    /* Align PS NVC 3 with NVC 1 */
-    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_3, &nvc_x_val);
-    if (err != PSA_SUCCESS) {
-        return PSA_ERROR_GENERIC_ERROR;
-    }
-
-    for (; nvc_x_val < nvc_1; nvc_x_val++) {
-        err = ps_increment_nv_counter(TFM_PS_NV_COUNTER_3);
+    for (i = PS_OBJ_TABLE_TREE_LEAVES - 1; i > 0; i--) {
+        err = ps_table_tree_hash_node(tree, i);
         if (err != PSA_SUCCESS) {
             return err;
         }
     }
 
+    (void)memset(tree->dirty, 0, sizeof(tree->dirty));
+
     return PSA_SUCCESS;
 }
 
 /**
- * \brief Generates table authentication tag.
- *
- * \param[in]     nvc_1      Value of PS non-volatile counter 1
- * \param[in,out] obj_table  Pointer to the object table to generate
- *                           authentication
+ * \brief Marks the leaf of an entry, and its path to the root, to be hashed
+ *        again.
  *
- * \return Returns error code as specified in \ref psa_status_t
+ * \param[in] idx  Entry index
  */
-__attribute__ ((always_inline))
-__STATIC_INLINE psa_status_t ps_object_table_nvc_generate_auth_tag(
-                                              uint32_t nvc_1,
-                                              struct ps_obj_table_t *obj_table)
+static void ps_table_tree_set_dirty(uint32_t idx)
 {
-    struct ps_crypto_assoc_data_t assoc_data;
-    union ps_crypto_t *crypto = &obj_table->crypto;
-    psa_status_t err;
+    struct ps_obj_table_tree_t *tree = &ps_obj_table_ctx.tree;
+    uint32_t node = PS_OBJ_TABLE_TREE_LEAVES +
+                    (idx / PS_OBJ_TABLE_MERKLE_PAGE_ENTRIES);
 
-    /* Get new IV */
-    err = ps_crypto_get_iv(crypto);
-    if (err != PSA_SUCCESS) {
-        return err;
+    for (; node > 0; node /= 2) {
+        tree->dirty[node / 32] |= 1U << (node % 32);
     }
-
-    assoc_data.nv_counter = nvc_1;
-    (void)memcpy(assoc_data.obj_table_data,
-                 PS_CRYPTO_ASSOCIATED_DATA(crypto),
-                 PS_OBJ_TABLE_AUTH_DATA_SIZE);
-
-    return ps_crypto_generate_auth_tag(crypto, (const uint8_t *)&assoc_data,
-                                       PS_CRYPTO_ASSOCIATED_DATA_LEN);
 }
 
 /**
- * \brief Authenticates table of objects.
- *
- * \param[in]     table_idx  Table index in the init context
- * \param[in,out] init_ctx   Pointer to the object table to authenticate
+ * \brief Hashes again the dirty nodes of the hash tree of the table in the
+ *        context, and sets the root in the table header.
  *
+ * \return Returns error code as specified in \ref psa_status_t
  */
-static void ps_object_table_authenticate(uint8_t table_idx,
-                                       struct ps_obj_table_init_ctx_t *init_ctx)
+static psa_status_t ps_table_tree_update(void)
 {
-    struct ps_crypto_assoc_data_t assoc_data;
-    union ps_crypto_t *crypto = &init_ctx->p_table[table_idx]->crypto;
+    struct ps_obj_table_tree_t *tree = &ps_obj_table_ctx.tree;
+    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
     psa_status_t err;
+    uint32_t node;
 
-    /* Init associated data with NVC 1 */
-    assoc_data.nv_counter = init_ctx->nvc_1;
-    (void)memcpy(assoc_data.obj_table_data,
-                 PS_CRYPTO_ASSOCIATED_DATA(crypto),
-                 PS_OBJ_TABLE_AUTH_DATA_SIZE);
+    /* The children of a node have higher indexes, so they are hashed first */
+    for (node = PS_OBJ_TABLE_TREE_NODES - 1; node > 0; node--) {
+        if ((tree->dirty[node / 32] & (1U << (node % 32))) == 0) {
+            continue;
+        }
 
-    err = ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
-                                 PS_CRYPTO_ASSOCIATED_DATA_LEN);
-#ifdef PS_SUPPORT_FORMAT_TRANSITION
-    if (err != PSA_SUCCESS) {
-        err = ps_crypto_authenticate_transition(crypto, (const uint8_t *)&assoc_data,
-                                                PS_CRYPTO_ASSOCIATED_DATA_LEN);
-    }
-#endif /* PS_SUPPORT_FORMAT_TRANSITION */
-    if (err == PSA_SUCCESS) {
-        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_NVC_1_VALID;
-        return;
-    }
+        if (node >= PS_OBJ_TABLE_TREE_LEAVES) {
+            err = ps_table_tree_hash_leaf(p_table,
+                                          node - PS_OBJ_TABLE_TREE_LEAVES,
+                                          tree->node[node]);
+        } else {
+            err = ps_table_tree_hash_node(tree, node);
+        }
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
 
-    if (init_ctx->nvc_3 == PS_INVALID_NVC_VALUE) {
-        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_INVALID;
-        return;
+        tree->dirty[node / 32] &= ~(1U << (node % 32));
     }
 
-    /* Check with NVC 3 */
-    assoc_data.nv_counter = init_ctx->nvc_3;
+    (void)memcpy(p_table->root, tree->node[1], PS_HASH_LEN_BYTES);
 
-    err = ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
-                                 PS_CRYPTO_ASSOCIATED_DATA_LEN);
-#ifdef PS_SUPPORT_FORMAT_TRANSITION
-    if (err != PSA_SUCCESS) {
-        err = ps_crypto_authenticate_transition(crypto, (const uint8_t *)&assoc_data,
-                                                PS_CRYPTO_ASSOCIATED_DATA_LEN);
-    }
-#endif /* PS_SUPPORT_FORMAT_TRANSITION */
-    if (err != PSA_SUCCESS) {
-        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_INVALID;
-    } else {
-        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_NVC_3_VALID;
-    }
+    return PSA_SUCCESS;
 }
 
 /**
- * \brief Authenticates tables of objects.
- *
- * \param[in,out] init_ctx  Pointer to the object table to authenticate
+ * \brief Checks the entries of the authenticated tables against the root of
+ *        their hash tree.
  *
- * \return Returns error code as specified in \ref psa_status_t
+ * \param[in,out] init_ctx  Pointer to the init object table context
  */
-__attribute__ ((always_inline))
-__STATIC_INLINE psa_status_t ps_object_table_nvc_authenticate(
+static void ps_object_table_authenticate_entries(
                                       struct ps_obj_table_init_ctx_t *init_ctx)
 {
+    /* The tree of the context is only used as a scratch buffer here, it is
+     * built for the active table once the table is selected.
+     */
+    struct ps_obj_table_tree_t *tree = &ps_obj_table_ctx.tree;
     psa_status_t err;
-    uint32_t nvc_2;
+    uint32_t i;
 
-    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_1, &init_ctx->nvc_1);
-    if (err != PSA_SUCCESS) {
-        return err;
-    }
+    for (i = 0; i < PS_NUM_OBJ_TABLES; i++) {
+        if (init_ctx->table_state[i] == PS_OBJ_TABLE_INVALID) {
+            continue;
+        }
 
-    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_2, &nvc_2);
-    if (err != PSA_SUCCESS) {
-        return err;
+        err = ps_table_tree_build(init_ctx->p_table[i], tree);
+        if (err != PSA_SUCCESS
+            || memcmp(tree->node[1], init_ctx->p_table[i]->root,
+                      PS_HASH_LEN_BYTES) != 0) {
+            init_ctx->table_state[i] = PS_OBJ_TABLE_INVALID;
+        }
     }
+}
+#endif /* PS_OBJ_TABLE_HASH_TREE */
 
-    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_3, &init_ctx->nvc_3);
-    if (err != PSA_SUCCESS) {
-        return err;
-    }
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+#ifdef PS_ENCRYPTION
+/* The associated data of a record is the record minus the crypto data */
+#define PS_OBJ_TABLE_RECORD_AUTH_DATA_SIZE (PS_OBJ_TABLE_RECORD_SIZE - \
+                                            PS_NON_AUTH_OBJ_TABLE_SIZE)
+#endif
 
-    /* Check if NVC 3 value can be used to validate an object table */
-    if (init_ctx->nvc_3 != nvc_2) {
-        /* If NVC 3 is different from NVC 2, it is possible to load an old PS
-         * area image in the system by manipulating the FS to return a system
-         * error from the file system layer and triggering power fault before
-         * increasing the NVC 3. So, in that case, NVC 3 value cannot be used to
-         * validate an old object table at the init process.
-         */
-        init_ctx->nvc_3 = PS_INVALID_NVC_VALUE;
+/**
+ * \brief Checks that a record is the next one of the journal of a table.
+ *
+ * \param[in,out] record   Pointer to the record
+ * \param[in]     table    Pointer to the object table
+ * \param[in]     journal  Pointer to the journal state of the object table
+ *
+ * \return Returns PSA_SUCCESS if the record is the next one of the journal.
+ *         Otherwise, it returns an error code as specified in
+ *         \ref psa_status_t
+ */
+static psa_status_t ps_object_table_check_record(
+                                   struct ps_obj_table_record_t *record,
+                                   const struct ps_obj_table_t *table,
+                                   const struct ps_obj_table_journal_t *journal)
+{
+    uint32_t i;
+
+    /* A record of an older table, or an older record left at this position of
+     * the journal, is not part of the journal.
+     */
+    if (record->base_nr != table->commit_nr
+        || record->commit_nr <= journal->commit_nr
+        || record->num_changes == 0
+        || record->num_changes > PS_OBJ_TABLE_MAX_CHANGES) {
+        return PSA_ERROR_DATA_INVALID;
     }
 
-    /* Authenticate table 0 if data is valid */
-    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_0] != PS_OBJ_TABLE_INVALID) {
-        ps_object_table_authenticate(PS_OBJ_TABLE_IDX_0, init_ctx);
+    for (i = 0; i < record->num_changes; i++) {
+        if (record->change[i].idx >= PS_OBJ_TABLE_ENTRIES) {
+            return PSA_ERROR_DATA_INVALID;
+        }
     }
 
-    /* Authenticate table 1 if data is valid */
-    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] != PS_OBJ_TABLE_INVALID) {
-        ps_object_table_authenticate(PS_OBJ_TABLE_IDX_1, init_ctx);
+#ifdef PS_ENCRYPTION
+    if (memcmp(record->prev_tag, journal->crypto.ref.tag,
+               PS_TAG_LEN_BYTES) != 0) {
+        return PSA_ERROR_DATA_INVALID;
     }
 
+    /* The record is authenticated with the key of the table */
+    record->crypto.ref.client_id = table->crypto.ref.client_id;
+    record->crypto.ref.uid = table->crypto.ref.uid;
+#if PS_AES_KEY_USAGE_LIMIT != 0
+    record->crypto.ref.key_gen_nr = table->crypto.ref.key_gen_nr;
+#endif
+
+    return ps_crypto_authenticate(&record->crypto,
+                                  PS_CRYPTO_ASSOCIATED_DATA(&record->crypto),
+                                  PS_OBJ_TABLE_RECORD_AUTH_DATA_SIZE);
+#else
     return PSA_SUCCESS;
+#endif /* PS_ENCRYPTION */
 }
-#else /* PS_ROLLBACK_PROTECTION */
 
 /**
- * \brief Generates table authentication
+ * \brief Replays the journal of an object table on top of it.
  *
- * \param[in,out] obj_table  Pointer to the object table to generate
- *                           authentication
+ * \details The records are applied in order as long as they are chained to
+ *          the table and to the previous record. The journal state of the
+ *          table is set from the last record applied, or from the table if
+ *          there is none.
  *
- * \return Returns error code as specified in \ref psa_status_t
+ * \param[in]     table_idx  Table index in the init context
+ * \param[in,out] init_ctx   Pointer to the init object table context
  */
-__attribute__ ((always_inline))
-__STATIC_INLINE psa_status_t ps_object_table_generate_auth_tag(
-                                              struct ps_obj_table_t *obj_table)
+static void ps_object_table_replay_journal(uint8_t table_idx,
+                                       struct ps_obj_table_init_ctx_t *init_ctx)
 {
-    union ps_crypto_t *crypto = &obj_table->crypto;
+    struct ps_obj_table_t *p_table = init_ctx->p_table[table_idx];
+    struct ps_obj_table_journal_t *journal = &init_ctx->journal[table_idx];
+    struct ps_obj_table_record_t *record = &ps_obj_table_record;
+    size_t data_length;
     psa_status_t err;
+    uint32_t i;
 
-    /* Get new IV */
-    err = ps_crypto_get_iv(crypto);
-    if (err != PSA_SUCCESS) {
-        return err;
-    }
+#ifdef PS_ENCRYPTION
+    journal->crypto = p_table->crypto;
+#endif
+    journal->commit_nr = p_table->commit_nr;
+    journal->len = 0;
+
+    while (journal->len < PS_OBJ_TABLE_JOURNAL_SIZE) {
+        err = psa_its_get(PS_JOURNAL_FS_ID(journal->len), 0,
+                          PS_OBJ_TABLE_RECORD_SIZE, (void *)record,
+                          &data_length);
+        if (err != PSA_SUCCESS || data_length != PS_OBJ_TABLE_RECORD_SIZE) {
+            break;
+        }
 
-    return ps_crypto_generate_auth_tag(crypto,
-                                       PS_CRYPTO_ASSOCIATED_DATA(crypto),
-                                       PS_CRYPTO_ASSOCIATED_DATA_LEN);
+        err = ps_object_table_check_record(record, p_table, journal);
+        if (err != PSA_SUCCESS) {
+            break;
+        }
+
+        for (i = 0; i < record->num_changes; i++) {
+            (void)memcpy(&p_table->obj_db[record->change[i].idx],
+                         &record->change[i].entry,
+                         PS_OBJECTS_TABLE_ENTRY_SIZE);
+        }
+
+#ifdef PS_ENCRYPTION
+        journal->crypto = record->crypto;
+#endif
+        journal->commit_nr = record->commit_nr;
+        journal->len++;
+    }
 }
 
 /**
- * \brief Authenticates tables of objects.
- *
- * \param[in,out] init_ctx  Pointer to the object table to authenticate
+ * \brief Replays the journals of the valid object tables.
  *
+ * \param[in,out] init_ctx  Pointer to the init object table context
  */
-__attribute__ ((always_inline))
-__STATIC_INLINE void ps_object_table_authenticate_ctx_tables(
+static void ps_object_table_replay_journals(
                                       struct ps_obj_table_init_ctx_t *init_ctx)
 {
-    psa_status_t err;
-    union ps_crypto_t *crypto =
-                                &init_ctx->p_table[PS_OBJ_TABLE_IDX_0]->crypto;
+    uint32_t i;
 
-    /* Authenticate table 0 if data is valid */
-    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_0] != PS_OBJ_TABLE_INVALID) {
-        err = ps_crypto_authenticate(crypto,
-                                     PS_CRYPTO_ASSOCIATED_DATA(crypto),
-                                     PS_CRYPTO_ASSOCIATED_DATA_LEN);
-#ifdef PS_SUPPORT_FORMAT_TRANSITION
-        if (err != PSA_SUCCESS) {
-            err = ps_crypto_authenticate_transition(crypto,
-                                                    PS_CRYPTO_ASSOCIATED_DATA(crypto),
-                                                    PS_CRYPTO_ASSOCIATED_DATA_LEN);
+    for (i = 0; i < PS_NUM_OBJ_TABLES; i++) {
+        if (init_ctx->table_state[i] == PS_OBJ_TABLE_INVALID) {
+            continue;
         }
-#endif /* PS_SUPPORT_FORMAT_TRANSITION */
-        if (err != PSA_SUCCESS) {
-            init_ctx->table_state[PS_OBJ_TABLE_IDX_0] = PS_OBJ_TABLE_INVALID;
+
+        ps_object_table_replay_journal(i, init_ctx);
+
+#if PS_ROLLBACK_PROTECTION
+        /* The table is valid if its journal brings it up to NVC 1 or NVC 3,
+         * as a table without journal has to be.
+         */
+        if (PS_COMMIT_NR_TO_NVC(init_ctx->journal[i].commit_nr)
+            == init_ctx->nvc_1) {
+            init_ctx->table_state[i] = PS_OBJ_TABLE_NVC_1_VALID;
+        } else if (init_ctx->nvc_3 != PS_INVALID_NVC_VALUE
+                   && PS_COMMIT_NR_TO_NVC(init_ctx->journal[i].commit_nr)
+                      == init_ctx->nvc_3) {
+            init_ctx->table_state[i] = PS_OBJ_TABLE_NVC_3_VALID;
+        } else {
+            init_ctx->table_state[i] = PS_OBJ_TABLE_INVALID;
         }
+#endif /* PS_ROLLBACK_PROTECTION */
     }
+}
+#endif /* PS_OBJ_TABLE_JOURNAL_SIZE != 0 */
 
-    /* Authenticate table 1 if data is valid */
-    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] != PS_OBJ_TABLE_INVALID) {
-        crypto = &init_ctx->p_table[PS_OBJ_TABLE_IDX_1]->crypto;
+#ifdef PS_ENCRYPTION
+#if PS_ROLLBACK_PROTECTION
+/**
+ * \brief Aligns all PS non-volatile counters.
+ *
+ * \param[in] nvc_1  Value of PS non-volatile counter 1
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_align_nv_counters(uint32_t nvc_1)
+{
+    psa_status_t err;
+    uint32_t nvc_x_val = 0;
 
-        err = ps_crypto_authenticate(crypto,
-                                     PS_CRYPTO_ASSOCIATED_DATA(crypto),
-                                     PS_CRYPTO_ASSOCIATED_DATA_LEN);
-#ifdef PS_SUPPORT_FORMAT_TRANSITION
+    /* Align PS NVC 2 with NVC 1 */
+    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_2, &nvc_x_val);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    for (; nvc_x_val < nvc_1; nvc_x_val++) {
+        err = ps_increment_nv_counter(TFM_PS_NV_COUNTER_2);
         if (err != PSA_SUCCESS) {
-            err = ps_crypto_authenticate_transition(crypto,
-                                                    PS_CRYPTO_ASSOCIATED_DATA(crypto),
-                                                    PS_CRYPTO_ASSOCIATED_DATA_LEN);
+            return err;
         }
-#endif /* PS_SUPPORT_FORMAT_TRANSITION */
+    }
+
+    /* Align PS NVC 3 with NVC 1 */
+    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_3, &nvc_x_val);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    for (; nvc_x_val < nvc_1; nvc_x_val++) {
+        err = ps_increment_nv_counter(TFM_PS_NV_COUNTER_3);
         if (err != PSA_SUCCESS) {
-            init_ctx->table_state[PS_OBJ_TABLE_IDX_1] = PS_OBJ_TABLE_INVALID;
+            return err;
         }
     }
+
+    return PSA_SUCCESS;
 }
-#endif /* PS_ROLLBACK_PROTECTION */
-#endif /* PS_ENCRYPTION */
 
+#if PS_OBJ_TABLE_NVC_BATCH
 /**
- * \brief Saves object table in the persistent memory.
+ * \brief Opens a new batch of commits of the object table.
  *
- * \param[in,out] obj_table  Pointer to the object table to save
+ * \details PS NV counter 1 is incremented and the commits of the batch are
+ *          numbered from its new value times PS_NV_COUNTER_BATCH_SIZE. The IVs
+ *          issued from then on are bound to the new value, which no IV has
+ *          been bound to before, as the IV restored at boot may have been
+ *          rolled back within the previous batch.
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
-static psa_status_t ps_object_table_save_table(
-                                              struct ps_obj_table_t *obj_table)
+static psa_status_t ps_object_table_new_batch(void)
 {
     psa_status_t err;
-
-#if PS_ROLLBACK_PROTECTION
     uint32_t nvc_1 = 0;
 
     err = ps_increment_nv_counter(TFM_PS_NV_COUNTER_1);
@@ -592,96 +979,609 @@ static psa_status_t ps_object_table_save_table(
     if (err != PSA_SUCCESS) {
         return err;
     }
-#else
-    obj_table->swap_count++;
 
-    if (obj_table->swap_count == PS_FLASH_DEFAULT_VAL) {
-        /* When a flash block is erased, the default value is usually 0xFF
-         * (i.e. all 1s). Since the swap count is updated last (when encryption
-         * is disabled), it is possible that due to a power failure, the swap
-         * count value in metadata header is 0xFFFF..., which mean it will
-         * appear to be most recent block.
-         */
-        obj_table->swap_count = 0;
+    if (nvc_1 > (UINT32_MAX / PS_NV_COUNTER_BATCH_SIZE)) {
+        /* The commit numbers of the batch do not fit in 32 bits */
+        return PSA_ERROR_GENERIC_ERROR;
     }
-#endif /* PS_ROLLBACK_PROTECTION */
 
-#ifdef PS_ENCRYPTION
-#if PS_ROLLBACK_PROTECTION
-    /* Generate authentication tag from the current table content and PS
-     * NV counter 1.
-     */
-    err = ps_object_table_nvc_generate_auth_tag(nvc_1, obj_table);
-#else
-    /* Generate authentication tag from the current table content */
-    err = ps_object_table_generate_auth_tag(obj_table);
-#endif /* PS_ROLLBACK_PROTECTION */
-    if (err != PSA_SUCCESS) {
-        return err;
-    }
-#endif /* PS_ENCRYPTION */
+    ps_crypto_bind_iv(nvc_1);
 
-    err = ps_object_table_fs_write_table(obj_table);
+    ps_obj_table_ctx.nvc_batch_commit_nr = nvc_1 * PS_NV_COUNTER_BATCH_SIZE;
+    ps_obj_table_ctx.nvc_batch_left = PS_NV_COUNTER_BATCH_SIZE;
 
-#if PS_ROLLBACK_PROTECTION
-    if (err != PSA_SUCCESS) {
-        return err;
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Gets the commit number of a new commit of the object table.
+ *
+ * \details The commits of a batch share one increment of PS NV counter 1, and
+ *          are numbered from its value times PS_NV_COUNTER_BATCH_SIZE. A new
+ *          batch is opened when none is open, or when the current one is
+ *          full.
+ *
+ * \param[out] commit_nr  Commit number of the new commit
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_next_commit_nr(uint32_t *commit_nr)
+{
+    psa_status_t err;
+
+    if (ps_obj_table_ctx.nvc_batch_left == 0) {
+        err = ps_object_table_new_batch();
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
     }
 
-    /* Align PS NV counters to have the same value */
-    err = ps_object_table_align_nv_counters(nvc_1);
-#endif /* PS_ROLLBACK_PROTECTION */
+    ps_obj_table_ctx.nvc_batch_left--;
+    *commit_nr = ps_obj_table_ctx.nvc_batch_commit_nr++;
 
-    return err;
+    return PSA_SUCCESS;
 }
-
+#else
 /**
- * \brief Checks the validity of the table version.
+ * \brief Gets the commit number of a new commit of the object table.
  *
- * \param[in,out] init_ctx  Pointer to the init object table context
+ * \details PS NV counter 1 is incremented and its new value is the commit
+ *          number.
+ *
+ * \param[out] commit_nr  Commit number of the new commit
  *
+ * \return Returns error code as specified in \ref psa_status_t
  */
-__attribute__ ((always_inline))
-__STATIC_INLINE void ps_object_table_validate_version(
-                                      struct ps_obj_table_init_ctx_t *init_ctx)
+static psa_status_t ps_object_table_next_commit_nr(uint32_t *commit_nr)
 {
-    /* Looks for exact version number.
-     * FIXME: backward compatibility could be considered in future revisions.
-     */
-    if (PS_OBJECT_SYSTEM_VERSION !=
-        init_ctx->p_table[PS_OBJ_TABLE_IDX_0]->version) {
-        init_ctx->table_state[PS_OBJ_TABLE_IDX_0] = PS_OBJ_TABLE_INVALID;
-    }
+    psa_status_t err;
 
-    if (PS_OBJECT_SYSTEM_VERSION !=
-        init_ctx->p_table[PS_OBJ_TABLE_IDX_1]->version) {
-        init_ctx->table_state[PS_OBJ_TABLE_IDX_1] = PS_OBJ_TABLE_INVALID;
+    err = ps_increment_nv_counter(TFM_PS_NV_COUNTER_1);
+    if (err != PSA_SUCCESS) {
+        return err;
     }
+
+    return ps_read_nv_counter(TFM_PS_NV_COUNTER_1, commit_nr);
 }
+#endif /* PS_OBJ_TABLE_NVC_BATCH */
 
 /**
- * \brief Sets the active object table based on the swap count and validity of
- *        the object table data.
+ * \brief Generates table authentication tag.
  *
- * \param[in] init_ctx  Pointer to the init object table context
+ * \param[in]     nvc_1      Value of PS non-volatile counter 1
+ * \param[in,out] obj_table  Pointer to the object table to generate
+ *                           authentication
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
-static psa_status_t ps_set_active_object_table(
-                                const struct ps_obj_table_init_ctx_t *init_ctx)
+__attribute__ ((always_inline))
+__STATIC_INLINE psa_status_t ps_object_table_nvc_generate_auth_tag(
+                                              uint32_t nvc_1,
+                                              struct ps_obj_table_t *obj_table)
 {
-#if (!PS_ROLLBACK_PROTECTION)
-    uint8_t table0_swap_count =
-                             init_ctx->p_table[PS_OBJ_TABLE_IDX_0]->swap_count;
-    uint8_t table1_swap_count =
-                             init_ctx->p_table[PS_OBJ_TABLE_IDX_1]->swap_count;
-#endif
+    struct ps_crypto_assoc_data_t assoc_data;
+    union ps_crypto_t *crypto = &obj_table->crypto;
+    psa_status_t err;
 
-    /* Check if there is an invalid object table */
-    if ((init_ctx->table_state[PS_OBJ_TABLE_IDX_0] == PS_OBJ_TABLE_INVALID)
-         && (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] ==
-                                                       PS_OBJ_TABLE_INVALID)) {
-        /* Both tables are invalid */
+    /* Get new IV */
+    err = ps_crypto_get_iv(crypto);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    assoc_data.nv_counter = nvc_1;
+    (void)memcpy(assoc_data.obj_table_data,
+                 PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                 PS_OBJ_TABLE_AUTH_DATA_SIZE);
+
+    return ps_crypto_generate_auth_tag(crypto, (const uint8_t *)&assoc_data,
+                                       PS_CRYPTO_ASSOCIATED_DATA_LEN);
+}
+
+/**
+ * \brief Authenticates table of objects.
+ *
+ * \param[in]     table_idx  Table index in the init context
+ * \param[in,out] init_ctx   Pointer to the object table to authenticate
+ *
+ */
+static void ps_object_table_authenticate(uint8_t table_idx,
+                                       struct ps_obj_table_init_ctx_t *init_ctx)
+{
+    struct ps_crypto_assoc_data_t assoc_data;
+    union ps_crypto_t *crypto = &init_ctx->p_table[table_idx]->crypto;
+    psa_status_t err;
+
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    /* The table is authenticated with its own commit number. Whether it is
+     * valid with NVC 1 or NVC 3 depends on its journal, which is replayed
+     * later on.
+     */
+    assoc_data.nv_counter = init_ctx->p_table[table_idx]->commit_nr;
+    (void)memcpy(assoc_data.obj_table_data,
+                 PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                 PS_OBJ_TABLE_AUTH_DATA_SIZE);
+
+    err = ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
+                                 PS_CRYPTO_ASSOCIATED_DATA_LEN);
+#ifdef PS_SUPPORT_FORMAT_TRANSITION
+    if (err != PSA_SUCCESS) {
+        err = ps_crypto_authenticate_transition(crypto, (const uint8_t *)&assoc_data,
+                                                PS_CRYPTO_ASSOCIATED_DATA_LEN);
+    }
+#endif /* PS_SUPPORT_FORMAT_TRANSITION */
+    if (err != PSA_SUCCESS) {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_INVALID;
+    } else {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_VALID;
+    }
+#else
+    /* Init associated data with NVC 1 */
+    assoc_data.nv_counter = init_ctx->nvc_1;
+    (void)memcpy(assoc_data.obj_table_data,
+                 PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                 PS_OBJ_TABLE_AUTH_DATA_SIZE);
+
+    err = ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
+                                 PS_CRYPTO_ASSOCIATED_DATA_LEN);
+#ifdef PS_SUPPORT_FORMAT_TRANSITION
+    if (err != PSA_SUCCESS) {
+        err = ps_crypto_authenticate_transition(crypto, (const uint8_t *)&assoc_data,
+                                                PS_CRYPTO_ASSOCIATED_DATA_LEN);
+    }
+#endif /* PS_SUPPORT_FORMAT_TRANSITION */
+    if (err == PSA_SUCCESS) {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_NVC_1_VALID;
+        return;
+    }
+
+    if (init_ctx->nvc_3 == PS_INVALID_NVC_VALUE) {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_INVALID;
+        return;
+    }
+
+    /* Check with NVC 3 */
+    assoc_data.nv_counter = init_ctx->nvc_3;
+
+    err = ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
+                                 PS_CRYPTO_ASSOCIATED_DATA_LEN);
+#ifdef PS_SUPPORT_FORMAT_TRANSITION
+    if (err != PSA_SUCCESS) {
+        err = ps_crypto_authenticate_transition(crypto, (const uint8_t *)&assoc_data,
+                                                PS_CRYPTO_ASSOCIATED_DATA_LEN);
+    }
+#endif /* PS_SUPPORT_FORMAT_TRANSITION */
+    if (err != PSA_SUCCESS) {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_INVALID;
+    } else {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_NVC_3_VALID;
+    }
+#endif /* PS_OBJ_TABLE_JOURNAL_SIZE != 0 */
+}
+
+/**
+ * \brief Authenticates tables of objects.
+ *
+ * \param[in,out] init_ctx  Pointer to the object table to authenticate
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+__attribute__ ((always_inline))
+__STATIC_INLINE psa_status_t ps_object_table_nvc_authenticate(
+                                      struct ps_obj_table_init_ctx_t *init_ctx)
+{
+    psa_status_t err;
+    uint32_t nvc_2;
+
+    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_1, &init_ctx->nvc_1);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_2, &nvc_2);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = ps_read_nv_counter(TFM_PS_NV_COUNTER_3, &init_ctx->nvc_3);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Check if NVC 3 value can be used to validate an object table */
+    if (init_ctx->nvc_3 != nvc_2) {
+        /* If NVC 3 is different from NVC 2, it is possible to load an old PS
+         * area image in the system by manipulating the FS to return a system
+         * error from the file system layer and triggering power fault before
+         * increasing the NVC 3. So, in that case, NVC 3 value cannot be used to
+         * validate an old object table at the init process.
+         */
+        init_ctx->nvc_3 = PS_INVALID_NVC_VALUE;
+    }
+
+    /* Authenticate table 0 if data is valid */
+    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_0] != PS_OBJ_TABLE_INVALID) {
+        ps_object_table_authenticate(PS_OBJ_TABLE_IDX_0, init_ctx);
+    }
+
+    /* Authenticate table 1 if data is valid */
+    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] != PS_OBJ_TABLE_INVALID) {
+        ps_object_table_authenticate(PS_OBJ_TABLE_IDX_1, init_ctx);
+    }
+
+    return PSA_SUCCESS;
+}
+#else /* PS_ROLLBACK_PROTECTION */
+
+/**
+ * \brief Generates table authentication
+ *
+ * \param[in,out] obj_table  Pointer to the object table to generate
+ *                           authentication
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+__attribute__ ((always_inline))
+__STATIC_INLINE psa_status_t ps_object_table_generate_auth_tag(
+                                              struct ps_obj_table_t *obj_table)
+{
+    union ps_crypto_t *crypto = &obj_table->crypto;
+    psa_status_t err;
+
+    /* Get new IV */
+    err = ps_crypto_get_iv(crypto);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return ps_crypto_generate_auth_tag(crypto,
+                                       PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                                       PS_CRYPTO_ASSOCIATED_DATA_LEN);
+}
+
+/**
+ * \brief Authenticates tables of objects.
+ *
+ * \param[in,out] init_ctx  Pointer to the object table to authenticate
+ *
+ */
+__attribute__ ((always_inline))
+__STATIC_INLINE void ps_object_table_authenticate_ctx_tables(
+                                      struct ps_obj_table_init_ctx_t *init_ctx)
+{
+    psa_status_t err;
+    union ps_crypto_t *crypto =
+                                &init_ctx->p_table[PS_OBJ_TABLE_IDX_0]->crypto;
+
+    /* Authenticate table 0 if data is valid */
+    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_0] != PS_OBJ_TABLE_INVALID) {
+        err = ps_crypto_authenticate(crypto,
+                                     PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                                     PS_CRYPTO_ASSOCIATED_DATA_LEN);
+#ifdef PS_SUPPORT_FORMAT_TRANSITION
+        if (err != PSA_SUCCESS) {
+            err = ps_crypto_authenticate_transition(crypto,
+                                                    PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                                                    PS_CRYPTO_ASSOCIATED_DATA_LEN);
+        }
+#endif /* PS_SUPPORT_FORMAT_TRANSITION */
+        if (err != PSA_SUCCESS) {
+            init_ctx->table_state[PS_OBJ_TABLE_IDX_0] = PS_OBJ_TABLE_INVALID;
+        }
+    }
+
+    /* Authenticate table 1 if data is valid */
+    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] != PS_OBJ_TABLE_INVALID) {
+        crypto = &init_ctx->p_table[PS_OBJ_TABLE_IDX_1]->crypto;
+
+        err = ps_crypto_authenticate(crypto,
+                                     PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                                     PS_CRYPTO_ASSOCIATED_DATA_LEN);
+#ifdef PS_SUPPORT_FORMAT_TRANSITION
+        if (err != PSA_SUCCESS) {
+            err = ps_crypto_authenticate_transition(crypto,
+                                                    PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                                                    PS_CRYPTO_ASSOCIATED_DATA_LEN);
+        }
+#endif /* PS_SUPPORT_FORMAT_TRANSITION */
+        if (err != PSA_SUCCESS) {
+            init_ctx->table_state[PS_OBJ_TABLE_IDX_1] = PS_OBJ_TABLE_INVALID;
+        }
+    }
+}
+#endif /* PS_ROLLBACK_PROTECTION */
+#endif /* PS_ENCRYPTION */
+
+/**
+ * \brief Saves object table in the persistent memory.
+ *
+ * \param[in,out] obj_table  Pointer to the object table to save
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_save_table(
+                                              struct ps_obj_table_t *obj_table)
+{
+    psa_status_t err;
+
+#if PS_ROLLBACK_PROTECTION
+    uint32_t commit_nr = 0;
+#endif
+
+#if PS_OBJ_TABLE_HASH_TREE
+    /* Set the root of the hash tree of the entries in the table header */
+    err = ps_table_tree_update();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif
+
+#if PS_ROLLBACK_PROTECTION
+    err = ps_object_table_next_commit_nr(&commit_nr);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#else
+    obj_table->swap_count++;
+
+    if (obj_table->swap_count == PS_FLASH_DEFAULT_VAL) {
+        /* When a flash block is erased, the default value is usually 0xFF
+         * (i.e. all 1s). Since the swap count is updated last (when encryption
+         * is disabled), it is possible that due to a power failure, the swap
+         * count value in metadata header is 0xFFFF..., which mean it will
+         * appear to be most recent block.
+         */
+        obj_table->swap_count = 0;
+    }
+#endif /* PS_ROLLBACK_PROTECTION */
+
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+#if PS_ROLLBACK_PROTECTION
+    obj_table->commit_nr = commit_nr;
+#else
+    obj_table->commit_nr = ps_obj_table_ctx.journal.commit_nr + 1;
+#endif
+#endif /* PS_OBJ_TABLE_JOURNAL_SIZE != 0 */
+
+#ifdef PS_ENCRYPTION
+#if PS_ROLLBACK_PROTECTION
+    /* Generate authentication tag from the current table content and its
+     * commit number, which is the value of PS NV counter 1 without batches.
+     */
+    err = ps_object_table_nvc_generate_auth_tag(commit_nr, obj_table);
+#else
+    /* Generate authentication tag from the current table content */
+    err = ps_object_table_generate_auth_tag(obj_table);
+#endif /* PS_ROLLBACK_PROTECTION */
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif /* PS_ENCRYPTION */
+
+    err = ps_object_table_fs_write_table(obj_table);
+
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* The new table holds all the changes of the journal */
+#ifdef PS_ENCRYPTION
+    ps_obj_table_ctx.journal.crypto = obj_table->crypto;
+#endif
+    ps_obj_table_ctx.journal.commit_nr = obj_table->commit_nr;
+    ps_obj_table_ctx.journal.len = 0;
+    ps_obj_table_ctx.old_table = 1;
+#endif /* PS_OBJ_TABLE_JOURNAL_SIZE != 0 */
+
+#if PS_ROLLBACK_PROTECTION
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Align PS NV counters to have the same value */
+    err = ps_object_table_align_nv_counters(PS_COMMIT_NR_TO_NVC(commit_nr));
+#endif /* PS_ROLLBACK_PROTECTION */
+
+    return err;
+}
+
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+/**
+ * \brief Appends a record of changed entries to the object table journal.
+ *
+ * \param[in] idx          Array of the indexes of the changed entries
+ * \param[in] num_changes  Number of changed entries
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_append_record(const uint32_t *idx,
+                                                  uint32_t num_changes)
+{
+    struct ps_obj_table_record_t *record = &ps_obj_table_record;
+    struct ps_obj_table_journal_t *journal = &ps_obj_table_ctx.journal;
+    const struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+    psa_status_t err;
+    uint32_t i;
+
+    (void)memset(record, PS_DEFAULT_EMPTY_BUFF_VAL, PS_OBJ_TABLE_RECORD_SIZE);
+
+    record->base_nr = p_table->commit_nr;
+    record->num_changes = num_changes;
+    for (i = 0; i < num_changes; i++) {
+        record->change[i].idx = idx[i];
+        (void)memcpy(&record->change[i].entry, &p_table->obj_db[idx[i]],
+                     PS_OBJECTS_TABLE_ENTRY_SIZE);
+    }
+
+#if PS_ROLLBACK_PROTECTION
+    err = ps_object_table_next_commit_nr(&record->commit_nr);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#else
+    record->commit_nr = journal->commit_nr + 1;
+#endif /* PS_ROLLBACK_PROTECTION */
+
+#ifdef PS_ENCRYPTION
+    /* Chain the record to the previous one, and authenticate it with the key
+     * of the table.
+     */
+    record->crypto = p_table->crypto;
+    (void)memcpy(record->prev_tag, journal->crypto.ref.tag, PS_TAG_LEN_BYTES);
+
+    err = ps_crypto_get_iv(&record->crypto);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = ps_crypto_generate_auth_tag(&record->crypto,
+                                   PS_CRYPTO_ASSOCIATED_DATA(&record->crypto),
+                                   PS_OBJ_TABLE_RECORD_AUTH_DATA_SIZE);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif /* PS_ENCRYPTION */
+
+    /* Older records at this position are overwritten, as they are no longer
+     * part of the journal.
+     */
+    err = psa_its_set(PS_JOURNAL_FS_ID(journal->len),
+                      PS_OBJ_TABLE_RECORD_SIZE,
+                      (const void *)record,
+                      PSA_STORAGE_FLAG_NONE);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+#ifdef PS_ENCRYPTION
+    journal->crypto = record->crypto;
+#endif
+    journal->commit_nr = record->commit_nr;
+    journal->len++;
+
+#if PS_ROLLBACK_PROTECTION
+    /* Align PS NV counters to have the same value */
+    err = ps_object_table_align_nv_counters(
+                                     PS_COMMIT_NR_TO_NVC(record->commit_nr));
+#endif /* PS_ROLLBACK_PROTECTION */
+
+    return err;
+}
+#endif /* PS_OBJ_TABLE_JOURNAL_SIZE != 0 */
+
+/**
+ * \brief Saves the changes of the object table in the persistent memory.
+ *
+ * \details The changed entries are appended to the journal while it is not
+ *          full, otherwise the whole table is saved.
+ *
+ * \param[in] idx          Array of the indexes of the changed entries
+ * \param[in] num_changes  Number of changed entries
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_save_changes(const uint32_t *idx,
+                                                 uint32_t num_changes)
+{
+    psa_status_t err;
+#if PS_OBJ_TABLE_HASH_TREE
+    uint32_t i;
+
+    /* The tree is only needed to save the whole table, so it is updated
+     * then.
+     */
+    for (i = 0; i < num_changes; i++) {
+        ps_table_tree_set_dirty(idx[i]);
+    }
+#endif
+
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    if (ps_obj_table_ctx.journal.len < PS_OBJ_TABLE_JOURNAL_SIZE) {
+        err = ps_object_table_append_record(idx, num_changes);
+    } else {
+        err = ps_object_table_save_table(&ps_obj_table_ctx.obj_table);
+    }
+
+    if (err != PSA_SUCCESS) {
+        /* The table in RAM may no longer match the table and journal in the
+         * persistent memory, so the whole table is saved on the next change.
+         */
+        ps_obj_table_ctx.journal.len = PS_OBJ_TABLE_JOURNAL_SIZE;
+#if PS_OBJ_TABLE_NVC_BATCH
+        /* The next change increments the PS NV counters again */
+        ps_obj_table_ctx.nvc_batch_left = 0;
+#endif
+    }
+#else
+    (void)idx;
+    (void)num_changes;
+
+    err = ps_object_table_save_table(&ps_obj_table_ctx.obj_table);
+#endif /* PS_OBJ_TABLE_JOURNAL_SIZE != 0 */
+
+#if PS_OBJ_TABLE_HASH_TREE
+    if (err != PSA_SUCCESS) {
+        /* The caller restores the changed entries */
+        for (i = 0; i < num_changes; i++) {
+            ps_table_tree_set_dirty(idx[i]);
+        }
+    }
+#endif
+
+    return err;
+}
+
+/**
+ * \brief Checks the validity of the table version.
+ *
+ * \param[in,out] init_ctx  Pointer to the init object table context
+ *
+ */
+__attribute__ ((always_inline))
+__STATIC_INLINE void ps_object_table_validate_version(
+                                      struct ps_obj_table_init_ctx_t *init_ctx)
+{
+    /* Looks for exact version number.
+     * FIXME: backward compatibility could be considered in future revisions.
+     */
+    if (PS_OBJECT_SYSTEM_VERSION !=
+        init_ctx->p_table[PS_OBJ_TABLE_IDX_0]->version) {
+        init_ctx->table_state[PS_OBJ_TABLE_IDX_0] = PS_OBJ_TABLE_INVALID;
+    }
+
+    if (PS_OBJECT_SYSTEM_VERSION !=
+        init_ctx->p_table[PS_OBJ_TABLE_IDX_1]->version) {
+        init_ctx->table_state[PS_OBJ_TABLE_IDX_1] = PS_OBJ_TABLE_INVALID;
+    }
+}
+
+/**
+ * \brief Sets the active object table based on the swap count and validity of
+ *        the object table data.
+ *
+ * \param[in] init_ctx  Pointer to the init object table context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_set_active_object_table(
+                                const struct ps_obj_table_init_ctx_t *init_ctx)
+{
+#if (!PS_ROLLBACK_PROTECTION)
+    uint8_t table0_swap_count =
+                             init_ctx->p_table[PS_OBJ_TABLE_IDX_0]->swap_count;
+    uint8_t table1_swap_count =
+                             init_ctx->p_table[PS_OBJ_TABLE_IDX_1]->swap_count;
+#else
+    uint8_t table1_latest = (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] ==
+                             PS_OBJ_TABLE_NVC_1_VALID);
+#endif
+
+    /* Check if there is an invalid object table */
+    if ((init_ctx->table_state[PS_OBJ_TABLE_IDX_0] == PS_OBJ_TABLE_INVALID)
+         && (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] ==
+                                                       PS_OBJ_TABLE_INVALID)) {
+        /* Both tables are invalid */
         return PSA_ERROR_GENERIC_ERROR;
     } else if (init_ctx->table_state[PS_OBJ_TABLE_IDX_0] ==
                                                         PS_OBJ_TABLE_INVALID) {
@@ -689,88 +1589,411 @@ static psa_status_t ps_set_active_object_table(
           ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_1;
           ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_0;
 
-          /* As table 1 is the active object, load the content into the
-           * PS object table context.
-           */
-          (void)memcpy(&ps_obj_table_ctx.obj_table,
-                       init_ctx->p_table[PS_OBJ_TABLE_IDX_1],
-                       PS_OBJ_TABLE_SIZE);
+          /* As table 1 is the active object, load the content into the
+           * PS object table context.
+           */
+          (void)memcpy(&ps_obj_table_ctx.obj_table,
+                       init_ctx->p_table[PS_OBJ_TABLE_IDX_1],
+                       PS_OBJ_TABLE_SIZE);
+
+          return PSA_SUCCESS;
+    } else if (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] ==
+                                                        PS_OBJ_TABLE_INVALID) {
+        /* Table 1 is invalid, the active one is table 0 */
+        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_0;
+        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_1;
+
+        /* As table 0 is already in the PS object table context, it is not
+         * needed to copy the table in the context.
+         */
+
+        return PSA_SUCCESS;
+    }
+
+#if PS_ROLLBACK_PROTECTION
+#if PS_OBJ_TABLE_NVC_BATCH
+    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_0] ==
+        init_ctx->table_state[PS_OBJ_TABLE_IDX_1]) {
+        /* Both tables belong to the same batch of PS NV counter 1, the latest
+         * one is the one with the highest commit number.
+         */
+        table1_latest = (init_ctx->journal[PS_OBJ_TABLE_IDX_1].commit_nr >
+                         init_ctx->journal[PS_OBJ_TABLE_IDX_0].commit_nr);
+    }
+#endif
+
+    if (table1_latest) {
+        /* Table 0 is invalid, the active one is table 1 */
+        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_1;
+        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_0;
+    } else {
+        /* In case both tables are valid or table 0 is valid, table 0 is the
+         * valid on as it is already in the PS object table context.
+         */
+        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_0;
+        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_1;
+    }
+#else
+    /* Logic: if the swap count is 0, then it has rolled over. The object table
+     * with a swap count of 0 is the latest one, unless the other block has a
+     * swap count of 1, in which case the roll over occurred in the previous
+     * update. In all other cases, the table with the highest swap count is the
+     * latest one.
+     */
+    if ((table1_swap_count == 0) && (table0_swap_count != 1)) {
+        /* Table 1 swap count has rolled over and table 0 swap count has not,
+         * so table 1 is the latest.
+         */
+        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_1;
+        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_0;
+
+    } else if ((table0_swap_count == 0) && (table1_swap_count != 1)) {
+        /* Table 0 swap count has rolled over and table 1 swap count has not,
+         * so table 0 is the latest.
+         */
+        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_0;
+        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_1;
+
+    } else if (table1_swap_count > table0_swap_count) {
+        /* Neither swap count has just rolled over and table 1 has a
+         * higher swap count, so table 1 is the latest.
+         */
+        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_1;
+        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_0;
+
+    } else {
+        /* Neither swap count has just rolled over and table 0 has a
+         * higher or equal swap count, so table 0 is the latest.
+         */
+        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_0;
+        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_1;
+    }
+#endif /* PS_ROLLBACK_PROTECTION */
+
+    /* If active object table is table 1, then copy the content into the
+     * PS object table context.
+     */
+    if (ps_obj_table_ctx.active_table == PS_OBJ_TABLE_IDX_1) {
+        (void)memcpy(&ps_obj_table_ctx.obj_table,
+                     init_ctx->p_table[PS_OBJ_TABLE_IDX_1],
+                     PS_OBJ_TABLE_SIZE);
+    }
+
+    return PSA_SUCCESS;
+}
+
+#ifdef PS_ENCRYPTION
+/**
+ * \brief Checks the authentication tag of an object table of the object
+ *        system version 1.
+ *
+ * \param[in] crypto   Pointer to the crypto metadata of the table
+ * \param[in] add      Pointer to the associated data
+ * \param[in] add_len  Length of the associated data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_v1_check_tag(const union ps_crypto_t *crypto,
+                                                 const uint8_t *add,
+                                                 uint32_t add_len)
+{
+    psa_status_t err;
+
+    err = ps_crypto_authenticate(crypto, add, add_len);
+#ifdef PS_SUPPORT_FORMAT_TRANSITION
+    if (err != PSA_SUCCESS) {
+        err = ps_crypto_authenticate_transition(crypto, add, add_len);
+    }
+#endif /* PS_SUPPORT_FORMAT_TRANSITION */
+
+    return err;
+}
+
+/**
+ * \brief Authenticates an object table of the object system version 1, whose
+ *        associated data is the whole table.
+ *
+ * \param[in] init_ctx    Pointer to the init object table context
+ * \param[in] p_table_v1  Pointer to the object table to authenticate
+ *
+ * \return Returns the state of the object table
+ */
+static enum ps_obj_table_state ps_object_table_v1_authenticate(
+                                 const struct ps_obj_table_init_ctx_t *init_ctx,
+                                 const struct ps_obj_table_v1_t *p_table_v1)
+{
+    const union ps_crypto_t *crypto = &p_table_v1->crypto;
+#if PS_ROLLBACK_PROTECTION
+    struct ps_crypto_assoc_data_v1_t assoc_data;
+
+    /* Check with NVC 1, then with NVC 3 if it can be used */
+    assoc_data.nv_counter = init_ctx->nvc_1;
+    (void)memcpy(assoc_data.obj_table_data,
+                 PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                 PS_OBJ_TABLE_V1_AUTH_SIZE);
+
+    if (ps_object_table_v1_check_tag(crypto, (const uint8_t *)&assoc_data,
+                                     sizeof(assoc_data)) == PSA_SUCCESS) {
+        return PS_OBJ_TABLE_NVC_1_VALID;
+    }
+
+    if (init_ctx->nvc_3 == PS_INVALID_NVC_VALUE) {
+        return PS_OBJ_TABLE_INVALID;
+    }
+
+    assoc_data.nv_counter = init_ctx->nvc_3;
+
+    if (ps_object_table_v1_check_tag(crypto, (const uint8_t *)&assoc_data,
+                                     sizeof(assoc_data)) == PSA_SUCCESS) {
+        return PS_OBJ_TABLE_NVC_3_VALID;
+    }
+#else
+    (void)init_ctx;
+
+    if (ps_object_table_v1_check_tag(crypto, PS_CRYPTO_ASSOCIATED_DATA(crypto),
+                                     PS_OBJ_TABLE_V1_AUTH_SIZE) ==
+        PSA_SUCCESS) {
+        return PS_OBJ_TABLE_VALID;
+    }
+#endif /* PS_ROLLBACK_PROTECTION */
+
+    return PS_OBJ_TABLE_INVALID;
+}
+#endif /* PS_ENCRYPTION */
+
+/**
+ * \brief Loads the latest valid object table of the object system version 1,
+ *        and upgrades it to the current version in the PS object table
+ *        context.
+ *
+ * \details The entries of the upgraded table have no object information
+ *          until it is read from the objects, see
+ *          \ref ps_object_table_set_upgraded_obj. The table of version 1 is
+ *          kept as the active table until the upgraded table is saved, so
+ *          that the upgrade starts again after a power failure.
+ *
+ * \param[in,out] init_ctx  Pointer to the init object table context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_v1_load(
+                                       struct ps_obj_table_init_ctx_t *init_ctx)
+{
+    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+    struct ps_obj_table_v1_t *p_table_v1;
+    psa_status_t err;
+    uint32_t idx;
+    uint8_t i;
+
+    /* Read the tables again, with the size of version 1 */
+    for (i = 0; i < PS_NUM_OBJ_TABLES; i++) {
+        init_ctx->table_state[i] = PS_OBJ_TABLE_VALID;
+    }
+
+    ps_object_table_fs_read_table(init_ctx, PS_OBJ_TABLE_V1_SIZE);
+
+    for (i = 0; i < PS_NUM_OBJ_TABLES; i++) {
+        if (init_ctx->table_state[i] == PS_OBJ_TABLE_INVALID) {
+            continue;
+        }
+
+        TFM_COVERITY_DEVIATE_LINE(MISRA_C_2023_Rule_11_3, "Intentional pointer cast");
+        p_table_v1 = (struct ps_obj_table_v1_t *)init_ctx->p_table[i];
+
+#ifdef PS_ENCRYPTION
+        p_table_v1->crypto.ref.client_id = PS_OBJ_TABLE_CLIENT_ID;
+        p_table_v1->crypto.ref.uid = PS_OBJ_TABLE_UID;
+        init_ctx->table_state[i] =
+                         ps_object_table_v1_authenticate(init_ctx, p_table_v1);
+#endif
+
+        if (p_table_v1->version != PS_OBJECT_SYSTEM_VERSION_1) {
+            init_ctx->table_state[i] = PS_OBJ_TABLE_INVALID;
+        }
+    }
+
+    /* The header fields which select the latest table are at the same place
+     * in both versions. The latest table is then at the start of the context.
+     */
+    err = ps_set_active_object_table(init_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Keep the latest table in the buffer of table 1, which is no longer
+     * needed, while the table of the context is rebuilt in the current
+     * version.
+     */
+    TFM_COVERITY_DEVIATE_LINE(MISRA_C_2023_Rule_11_3, "Intentional pointer cast");
+    p_table_v1 = (struct ps_obj_table_v1_t *)
+                                        init_ctx->p_table[PS_OBJ_TABLE_IDX_1];
+    (void)memcpy(p_table_v1, p_table, PS_OBJ_TABLE_V1_SIZE);
+    (void)memset(p_table, PS_DEFAULT_EMPTY_BUFF_VAL, PS_OBJ_TABLE_SIZE);
+
+#ifdef PS_ENCRYPTION
+    p_table->crypto = p_table_v1->crypto;
+#endif
+    p_table->version = PS_OBJECT_SYSTEM_VERSION;
+#if (!PS_ROLLBACK_PROTECTION)
+    p_table->swap_count = p_table_v1->swap_count;
+#endif
+
+    for (idx = 0; idx < PS_OBJ_TABLE_ENTRIES; idx++) {
+#ifdef PS_ENCRYPTION
+        (void)memcpy(p_table->obj_db[idx].tag, p_table_v1->obj_db[idx].tag,
+                     PS_TAG_LEN_BYTES);
+#if PS_AES_KEY_USAGE_LIMIT != 0
+        p_table->obj_db[idx].num_blocks = p_table_v1->obj_db[idx].num_blocks;
+#endif
+#else
+        p_table->obj_db[idx].version = p_table_v1->obj_db[idx].version;
+#endif
+        p_table->obj_db[idx].uid = p_table_v1->obj_db[idx].uid;
+        p_table->obj_db[idx].client_id = p_table_v1->obj_db[idx].client_id;
+    }
+
+#if (PS_OBJ_TABLE_JOURNAL_SIZE != 0) && defined(PS_ENCRYPTION)
+    /* There is no journal, the table holds the latest IV */
+    init_ctx->journal[ps_obj_table_ctx.active_table].crypto = p_table->crypto;
+#endif
+
+    ps_obj_table_ctx.upgrade = 1;
+
+    return PSA_SUCCESS;
+}
+
+#if PS_OBJ_TABLE_INDEX
+/**
+ * \brief Gets the index slot where the probe sequence of an object starts.
+ *
+ * \param[in] uid        Object UID
+ * \param[in] client_id  Client UID
+ *
+ * \return Returns the first index slot to probe
+ */
+static uint32_t ps_table_index_hash(psa_storage_uid_t uid, int32_t client_id)
+{
+    /* Multiplicative hash of the UID and client ID words, with the high bits
+     * folded in as they are the best mixed.
+     */
+    uint32_t hash = ((uint32_t)uid * 0x9E3779B1U) ^
+                    ((uint32_t)(uid >> 32) * 0x85EBCA77U) ^
+                    ((uint32_t)client_id * 0xC2B2AE3DU);
+
+    hash ^= hash >> 16;
+
+    return hash % PS_OBJ_TABLE_INDEX_SLOTS;
+}
+
+/**
+ * \brief Gets the index slot where the probe sequence of an entry starts.
+ *
+ * \param[in] idx  Entry index
+ *
+ * \return Returns the first index slot to probe
+ */
+static uint32_t ps_table_index_entry_hash(uint32_t idx)
+{
+    const struct ps_obj_table_entry_t *entry =
+                                        &ps_obj_table_ctx.obj_table.obj_db[idx];
+
+    return ps_table_index_hash(entry->uid, entry->client_id);
+}
 
-          return PSA_SUCCESS;
-    } else if (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] ==
-                                                        PS_OBJ_TABLE_INVALID) {
-        /* Table 1 is invalid, the active one is table 0 */
-        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_0;
-        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_1;
+/**
+ * \brief Removes an entry from the stack of free entries.
+ *
+ * \param[in] idx  Entry index, which must be free
+ */
+static void ps_table_index_take_free(uint32_t idx)
+{
+    struct ps_obj_table_index_t *index = &ps_obj_table_ctx.index;
+    uint16_t pos = index->free_pos[idx];
+    uint16_t last = index->free_idx[--index->num_free];
 
-        /* As table 0 is already in the PS object table context, it is not
-         * needed to copy the table in the context.
-         */
+    index->free_idx[pos] = last;
+    index->free_pos[last] = pos;
+}
 
-        return PSA_SUCCESS;
-    }
+/**
+ * \brief Pushes an entry on the stack of free entries.
+ *
+ * \param[in] idx  Entry index, which must not be free
+ */
+static void ps_table_index_put_free(uint32_t idx)
+{
+    struct ps_obj_table_index_t *index = &ps_obj_table_ctx.index;
 
-#if PS_ROLLBACK_PROTECTION
-    if (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] ==
-                                                    PS_OBJ_TABLE_NVC_1_VALID) {
-        /* Table 0 is invalid, the active one is table 1 */
-        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_1;
-        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_0;
-    } else {
-        /* In case both tables are valid or table 0 is valid, table 0 is the
-         * valid on as it is already in the PS object table context.
-         */
-        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_0;
-        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_1;
-    }
-#else
-    /* Logic: if the swap count is 0, then it has rolled over. The object table
-     * with a swap count of 0 is the latest one, unless the other block has a
-     * swap count of 1, in which case the roll over occurred in the previous
-     * update. In all other cases, the table with the highest swap count is the
-     * latest one.
-     */
-    if ((table1_swap_count == 0) && (table0_swap_count != 1)) {
-        /* Table 1 swap count has rolled over and table 0 swap count has not,
-         * so table 1 is the latest.
-         */
-        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_1;
-        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_0;
+    index->free_pos[idx] = index->num_free;
+    index->free_idx[index->num_free++] = (uint16_t)idx;
+}
 
-    } else if ((table0_swap_count == 0) && (table1_swap_count != 1)) {
-        /* Table 0 swap count has rolled over and table 1 swap count has not,
-         * so table 0 is the latest.
-         */
-        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_0;
-        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_1;
+/**
+ * \brief Adds an entry, which has just been filled in the table, to the index.
+ *
+ * \param[in] idx  Entry index
+ */
+static void ps_table_index_add(uint32_t idx)
+{
+    struct ps_obj_table_index_t *index = &ps_obj_table_ctx.index;
+    uint32_t slot = ps_table_index_entry_hash(idx);
 
-    } else if (table1_swap_count > table0_swap_count) {
-        /* Neither swap count has just rolled over and table 1 has a
-         * higher swap count, so table 1 is the latest.
-         */
-        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_1;
-        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_0;
+    while (index->slot[slot] != PS_OBJ_TABLE_INDEX_EMPTY) {
+        slot = (slot + 1) % PS_OBJ_TABLE_INDEX_SLOTS;
+    }
 
-    } else {
-        /* Neither swap count has just rolled over and table 0 has a
-         * higher or equal swap count, so table 0 is the latest.
-         */
-        ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_0;
-        ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_1;
+    index->slot[slot] = (uint16_t)idx;
+    ps_table_index_take_free(idx);
+}
+
+/**
+ * \brief Removes an entry, before it is cleared in the table, from the index.
+ *
+ * \param[in] idx  Entry index
+ */
+static void ps_table_index_remove(uint32_t idx)
+{
+    struct ps_obj_table_index_t *index = &ps_obj_table_ctx.index;
+    uint32_t slot = ps_table_index_entry_hash(idx);
+    uint32_t next;
+    uint32_t home;
+
+    while (index->slot[slot] != idx) {
+        if (index->slot[slot] == PS_OBJ_TABLE_INDEX_EMPTY) {
+            /* Entry with the same UID and client ID as a previous one, which
+             * is not indexed.
+             */
+            ps_table_index_put_free(idx);
+            return;
+        }
+        slot = (slot + 1) % PS_OBJ_TABLE_INDEX_SLOTS;
     }
-#endif /* PS_ROLLBACK_PROTECTION */
 
-    /* If active object table is table 1, then copy the content into the
-     * PS object table context.
+    /* Shift back the following entries of the probe sequence which would no
+     * longer be found once the slot is emptied, so that no tombstone is needed.
      */
-    if (ps_obj_table_ctx.active_table == PS_OBJ_TABLE_IDX_1) {
-        (void)memcpy(&ps_obj_table_ctx.obj_table,
-                     init_ctx->p_table[PS_OBJ_TABLE_IDX_1],
-                     PS_OBJ_TABLE_SIZE);
+    next = slot;
+    for (;;) {
+        next = (next + 1) % PS_OBJ_TABLE_INDEX_SLOTS;
+        if (index->slot[next] == PS_OBJ_TABLE_INDEX_EMPTY) {
+            break;
+        }
+
+        home = ps_table_index_entry_hash(index->slot[next]);
+        if ((slot <= next) ? ((slot < home) && (home <= next)) :
+                             ((slot < home) || (home <= next))) {
+            /* The entry is still reachable from its home slot */
+            continue;
+        }
+
+        index->slot[slot] = index->slot[next];
+        slot = next;
     }
 
-    return PSA_SUCCESS;
+    index->slot[slot] = PS_OBJ_TABLE_INDEX_EMPTY;
+    ps_table_index_put_free(idx);
 }
+#endif /* PS_OBJ_TABLE_INDEX */
 
 /**
  * \brief Gets table's entry index based on the given object UID and client ID.
@@ -789,6 +2012,24 @@ static psa_status_t ps_get_object_entry_idx(psa_storage_uid_t uid,
     uint32_t i;
     struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
 
+#if PS_OBJ_TABLE_INDEX
+    const struct ps_obj_table_index_t *index = &ps_obj_table_ctx.index;
+
+    /* Free entries are not indexed */
+    if (uid == TFM_PS_INVALID_UID) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    for (i = ps_table_index_hash(uid, client_id);
+         index->slot[i] != PS_OBJ_TABLE_INDEX_EMPTY;
+         i = (i + 1) % PS_OBJ_TABLE_INDEX_SLOTS) {
+        if (p_table->obj_db[index->slot[i]].uid == uid
+            && p_table->obj_db[index->slot[i]].client_id == client_id) {
+            *idx = index->slot[i];
+            return PSA_SUCCESS;
+        }
+    }
+#else
     for (i = 0; i < PS_OBJ_TABLE_ENTRIES; i++) {
         if (p_table->obj_db[i].uid == uid
             && p_table->obj_db[i].client_id == client_id) {
@@ -796,10 +2037,53 @@ static psa_status_t ps_get_object_entry_idx(psa_storage_uid_t uid,
             return PSA_SUCCESS;
         }
     }
+#endif /* PS_OBJ_TABLE_INDEX */
 
     return PSA_ERROR_DOES_NOT_EXIST;
 }
 
+#if PS_OBJ_TABLE_INDEX
+/**
+ * \brief Builds the index from the content of the table.
+ */
+static void ps_table_index_build(void)
+{
+    struct ps_obj_table_index_t *index = &ps_obj_table_ctx.index;
+    const struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+    uint32_t dup_idx;
+    uint32_t i;
+
+    (void)memset(index->slot, 0xFF, sizeof(index->slot));
+    index->num_free = 0;
+
+    /* All the entries are free until they are added. The stack is filled in
+     * the reverse order so that the lowest free entries are used first.
+     */
+    for (i = PS_OBJ_TABLE_ENTRIES; i > 0; i--) {
+        ps_table_index_put_free(i - 1);
+    }
+
+    for (i = 0; i < PS_OBJ_TABLE_ENTRIES; i++) {
+        if (p_table->obj_db[i].uid == TFM_PS_INVALID_UID) {
+            continue;
+        }
+
+        if (ps_get_object_entry_idx(p_table->obj_db[i].uid,
+                                    p_table->obj_db[i].client_id,
+                                    &dup_idx) == PSA_SUCCESS) {
+            /* As for a linear search, only the first entry with a given UID
+             * and client ID can be found. The other ones are neither found nor
+             * free.
+             */
+            ps_table_index_take_free(i);
+            continue;
+        }
+
+        ps_table_index_add(i);
+    }
+}
+#endif /* PS_OBJ_TABLE_INDEX */
+
 /**
  * \brief Gets free index in the table
  *
@@ -818,6 +2102,20 @@ __attribute__ ((always_inline))
 __STATIC_INLINE psa_status_t ps_table_free_idx(uint32_t idx_num,
                                                uint32_t *idx)
 {
+#if PS_OBJ_TABLE_INDEX
+    const struct ps_obj_table_index_t *index = &ps_obj_table_ctx.index;
+
+    if (idx_num == 0) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (index->num_free < idx_num) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    *idx = index->free_idx[index->num_free - 1];
+    return PSA_SUCCESS;
+#else
     uint32_t i;
     uint32_t last_free = 0;
     struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
@@ -839,6 +2137,7 @@ __STATIC_INLINE psa_status_t ps_table_free_idx(uint32_t idx_num,
         *idx = last_free;
         return PSA_SUCCESS;
     }
+#endif /* PS_OBJ_TABLE_INDEX */
 }
 
 /**
@@ -849,6 +2148,12 @@ __STATIC_INLINE psa_status_t ps_table_free_idx(uint32_t idx_num,
  */
 static void ps_table_delete_entry(uint32_t idx)
 {
+#if PS_OBJ_TABLE_INDEX
+    if (ps_obj_table_ctx.obj_table.obj_db[idx].uid != TFM_PS_INVALID_UID) {
+        ps_table_index_remove(idx);
+    }
+#endif
+
     /* Initialise object table entry structure */
     (void)memset(&ps_obj_table_ctx.obj_table.obj_db[idx],
                  PS_DEFAULT_EMPTY_BUFF_VAL, PS_OBJECTS_TABLE_ENTRY_SIZE);
@@ -857,6 +2162,20 @@ static void ps_table_delete_entry(uint32_t idx)
 psa_status_t ps_object_table_create(void)
 {
     struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+    psa_status_t err;
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    uint32_t i;
+
+    /* Remove the records of a previous journal, so that none of them can be
+     * chained to the new table.
+     */
+    for (i = 0; i < PS_OBJ_TABLE_JOURNAL_SIZE; i++) {
+        err = psa_its_remove(PS_JOURNAL_FS_ID(i));
+        if (err != PSA_SUCCESS && err != PSA_ERROR_DOES_NOT_EXIST) {
+            return err;
+        }
+    }
+#endif
 
     /* Initialize object structure */
     (void)memset(&ps_obj_table_ctx, PS_DEFAULT_EMPTY_BUFF_VAL,
@@ -878,8 +2197,34 @@ psa_status_t ps_object_table_create(void)
 
     p_table->version = PS_OBJECT_SYSTEM_VERSION;
 
+#if PS_OBJ_TABLE_INDEX
+    ps_table_index_build();
+#endif
+
+#if PS_OBJ_TABLE_HASH_TREE
+    err = ps_table_tree_build(p_table, &ps_obj_table_ctx.tree);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif
+
     /* Save object table contents */
-    return ps_object_table_save_table(p_table);
+    err = ps_object_table_save_table(p_table);
+
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    if (err == PSA_SUCCESS) {
+        /* Remove the other table, as its journal is no longer there to bring
+         * it up to date and it must not be selected in place of the new one.
+         */
+        err = psa_its_remove(PS_TABLE_FS_ID(ps_obj_table_ctx.scratch_table));
+        if (err == PSA_ERROR_DOES_NOT_EXIST) {
+            err = PSA_SUCCESS;
+        }
+        ps_obj_table_ctx.old_table = 0;
+    }
+#endif /* PS_OBJ_TABLE_JOURNAL_SIZE != 0 */
+
+    return err;
 }
 
 psa_status_t ps_object_table_init(uint8_t *obj_data)
@@ -897,8 +2242,10 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
     TFM_COVERITY_DEVIATE_LINE(MISRA_C_2023_Rule_11_3, "Intentional pointer cast");
     init_ctx.p_table[PS_OBJ_TABLE_IDX_1] = (struct ps_obj_table_t *)obj_data;
 
+    ps_obj_table_ctx.upgrade = 0;
+
     /* Read table from the file system */
-    ps_object_table_fs_read_table(&init_ctx);
+    ps_object_table_fs_read_table(&init_ctx, PS_OBJ_TABLE_SIZE);
 
 #ifdef PS_ENCRYPTION
     for (uint32_t i = 0; i < PS_NUM_OBJ_TABLES; i++) {
@@ -914,17 +2261,41 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
 #else
     ps_object_table_authenticate_ctx_tables(&init_ctx);
 #endif /* PS_ROLLBACK_PROTECTION */
+#if PS_OBJ_TABLE_HASH_TREE
+    ps_object_table_authenticate_entries(&init_ctx);
+#endif
 #endif /* PS_ENCRYPTION */
 
     /* Check tables version */
     ps_object_table_validate_version(&init_ctx);
 
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    /* Bring the valid tables up to date */
+    ps_object_table_replay_journals(&init_ctx);
+#endif
+
     /* Set active tables */
     err = ps_set_active_object_table(&init_ctx);
     if (err != PSA_SUCCESS) {
-        return err;
+        /* The tables may be of the object system version 1 */
+        err = ps_object_table_v1_load(&init_ctx);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
     }
 
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    ps_obj_table_ctx.journal = init_ctx.journal[ps_obj_table_ctx.active_table];
+    ps_obj_table_ctx.old_table = 0;
+#endif
+
+#if PS_OBJ_TABLE_NVC_BATCH
+    /* The first change after boot increments the PS NV counters, so that a
+     * batch never spans a reset, and no IV is issued before it.
+     */
+    ps_obj_table_ctx.nvc_batch_left = 0;
+#endif
+
     /* Remove the old object table file */
     err = psa_its_remove(PS_TABLE_FS_ID(ps_obj_table_ctx.scratch_table));
     if (err != PSA_SUCCESS && err != PSA_ERROR_DOES_NOT_EXIST) {
@@ -932,8 +2303,27 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
     }
 
 #ifdef PS_ENCRYPTION
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    /* The last record of the journal holds the latest IV. With batches of
+     * commits, it is not used, as it may have been rolled back.
+     */
+    ps_crypto_set_iv(&ps_obj_table_ctx.journal.crypto);
+#else
     ps_crypto_set_iv(&ps_obj_table_ctx.obj_table.crypto);
 #endif
+#endif
+
+#if PS_OBJ_TABLE_INDEX
+    ps_table_index_build();
+#endif
+
+#if PS_OBJ_TABLE_HASH_TREE
+    err = ps_table_tree_build(&ps_obj_table_ctx.obj_table,
+                              &ps_obj_table_ctx.tree);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif
 
     return PSA_SUCCESS;
 }
@@ -977,6 +2367,17 @@ psa_status_t ps_object_table_get_free_fid(uint32_t fid_num,
     return PSA_SUCCESS;
 }
 
+psa_status_t ps_object_table_open_batch(void)
+{
+#if PS_OBJ_TABLE_NVC_BATCH
+    if (ps_obj_table_ctx.nvc_batch_left == 0) {
+        return ps_object_table_new_batch();
+    }
+#endif
+
+    return PSA_SUCCESS;
+}
+
 #if PS_AES_KEY_USAGE_LIMIT != 0
 uint32_t ps_object_table_current_gen(void)
 {
@@ -995,6 +2396,13 @@ void ps_object_table_set_gen(uint32_t new_gen)
         tfm_core_panic();
     }
     p_table->crypto.ref.key_gen_nr = new_gen;
+
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    /* The key generation is not journaled, so the whole table is saved on
+     * the next change.
+     */
+    ps_obj_table_ctx.journal.len = PS_OBJ_TABLE_JOURNAL_SIZE;
+#endif
 }
 #endif /* PS_AES_KEY_USAGE_LIMIT != 0 */
 
@@ -1005,6 +2413,8 @@ psa_status_t ps_object_table_set_obj_tbl_info(psa_storage_uid_t uid,
     psa_status_t err;
     uint32_t idx = 0;
     uint32_t backup_idx = 0;
+    uint32_t changes[PS_OBJ_TABLE_MAX_CHANGES];
+    uint32_t num_changes = 0;
     struct ps_obj_table_entry_t backup_entry = {
 #ifdef PS_ENCRYPTION
         .tag = {0U},
@@ -1031,6 +2441,9 @@ psa_status_t ps_object_table_set_obj_tbl_info(psa_storage_uid_t uid,
     idx = PS_OBJECT_FS_ID_TO_IDX(obj_tbl_info->fid);
     p_table->obj_db[idx].uid = uid;
     p_table->obj_db[idx].client_id = client_id;
+#if PS_OBJ_TABLE_INDEX
+    ps_table_index_add(idx);
+#endif
 
     /* Add new object information */
 #ifdef PS_ENCRYPTION
@@ -1042,13 +2455,22 @@ psa_status_t ps_object_table_set_obj_tbl_info(psa_storage_uid_t uid,
 #else
     p_table->obj_db[idx].version = obj_tbl_info->version;
 #endif
+    p_table->obj_db[idx].info = obj_tbl_info->info;
 
-    err = ps_object_table_save_table(p_table);
+    changes[num_changes++] = idx;
+    if (backup_entry.uid != TFM_PS_INVALID_UID && backup_idx != idx) {
+        changes[num_changes++] = backup_idx;
+    }
+
+    err = ps_object_table_save_changes(changes, num_changes);
     if (err != PSA_SUCCESS) {
         if (backup_entry.uid != TFM_PS_INVALID_UID) {
             /* Rollback the change in the table */
             (void)memcpy(&p_table->obj_db[backup_idx], &backup_entry,
                          PS_OBJECTS_TABLE_ENTRY_SIZE);
+#if PS_OBJ_TABLE_INDEX
+            ps_table_index_add(backup_idx);
+#endif
         }
 
         ps_table_delete_entry(idx);
@@ -1081,6 +2503,7 @@ psa_status_t ps_object_table_get_obj_tbl_info(psa_storage_uid_t uid,
 #else
     obj_tbl_info->version = p_table->obj_db[idx].version;
 #endif
+    obj_tbl_info->info = p_table->obj_db[idx].info;
 
     return PSA_SUCCESS;
 }
@@ -1111,11 +2534,14 @@ psa_status_t ps_object_table_delete_object(psa_storage_uid_t uid,
 
     ps_table_delete_entry(backup_idx);
 
-    err = ps_object_table_save_table(p_table);
+    err = ps_object_table_save_changes(&backup_idx, 1);
     if (err != PSA_SUCCESS) {
        /* Rollback the change in the table */
        (void)memcpy(&p_table->obj_db[backup_idx], &backup_entry,
                     PS_OBJECTS_TABLE_ENTRY_SIZE);
+#if PS_OBJ_TABLE_INDEX
+       ps_table_index_add(backup_idx);
+#endif
     }
 
     return err;
@@ -1124,6 +2550,96 @@ psa_status_t ps_object_table_delete_object(psa_storage_uid_t uid,
 psa_status_t ps_object_table_delete_old_table(void)
 {
     uint32_t table_id = PS_TABLE_FS_ID(ps_obj_table_ctx.scratch_table);
+#if PS_OBJ_TABLE_JOURNAL_SIZE != 0
+    psa_status_t err;
+
+    if (!ps_obj_table_ctx.old_table) {
+        /* Only the journal has changed since the old table was removed */
+        return PSA_SUCCESS;
+    }
 
+    err = psa_its_remove(table_id);
+    if (err == PSA_SUCCESS) {
+        ps_obj_table_ctx.old_table = 0;
+    }
+
+    return err;
+#else
     return psa_its_remove(table_id);
+#endif /* PS_OBJ_TABLE_JOURNAL_SIZE != 0 */
+}
+
+psa_status_t ps_object_table_get_upgraded_obj(uint32_t *p_idx,
+                                              psa_storage_uid_t *p_uid,
+                                              int32_t *p_client_id)
+{
+    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+    uint32_t idx;
+
+    if (!ps_obj_table_ctx.upgrade) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    for (idx = *p_idx; idx < PS_OBJ_TABLE_ENTRIES; idx++) {
+        if (p_table->obj_db[idx].uid != TFM_PS_INVALID_UID) {
+            *p_uid = p_table->obj_db[idx].uid;
+            *p_client_id = p_table->obj_db[idx].client_id;
+            *p_idx = idx + 1;
+
+            return PSA_SUCCESS;
+        }
+    }
+
+    *p_idx = idx;
+
+    return PSA_ERROR_DOES_NOT_EXIST;
+}
+
+void ps_object_table_set_upgraded_obj(psa_storage_uid_t uid,
+                                      int32_t client_id,
+                                const struct ps_obj_table_info_t *obj_tbl_info)
+{
+    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+    uint32_t idx;
+
+    if (ps_get_object_entry_idx(uid, client_id, &idx) != PSA_SUCCESS) {
+        return;
+    }
+
+    if (obj_tbl_info == NULL) {
+        /* The object cannot be read */
+        ps_table_delete_entry(idx);
+    } else {
+#ifdef PS_ENCRYPTION
+        (void)memcpy(p_table->obj_db[idx].tag, obj_tbl_info->tag,
+                     PS_TAG_LEN_BYTES);
+#if PS_AES_KEY_USAGE_LIMIT != 0
+        p_table->obj_db[idx].num_blocks = obj_tbl_info->num_blocks;
+#endif
+#endif /* PS_ENCRYPTION */
+        p_table->obj_db[idx].info = obj_tbl_info->info;
+    }
+
+#if PS_OBJ_TABLE_HASH_TREE
+    ps_table_tree_set_dirty(idx);
+#endif
+}
+
+psa_status_t ps_object_table_save_upgrade(void)
+{
+    psa_status_t err;
+
+    if (!ps_obj_table_ctx.upgrade) {
+        return PSA_SUCCESS;
+    }
+
+    err = ps_object_table_save_table(&ps_obj_table_ctx.obj_table);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    ps_obj_table_ctx.upgrade = 0;
+
+    /* Remove the table of version 1 */
+    return ps_object_table_delete_old_table();
 }
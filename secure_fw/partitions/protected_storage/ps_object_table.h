@@ -13,6 +13,7 @@
 #include <stdint.h>
 
 #include "psa/protected_storage.h"
+#include "ps_object_defs.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +34,7 @@ struct ps_obj_table_info_t {
 #else
     uint32_t version;  /*!< Object version */
 #endif
+    struct ps_object_info_t info; /*!< Object information */
 };
 
 /**
@@ -45,7 +47,7 @@ psa_status_t ps_object_table_create(void);
 /**
  * \brief Initializes object table.
  *
- * \param[in,out] obj_data  Pointer to the static object data allocated
+ * \param[in,out] obj_data  Pointer to the static object buffer allocated
  *                          in other to reuse that memory to allocated a
  *                          temporary object table.
  *
@@ -83,6 +85,19 @@ psa_status_t ps_object_table_obj_exist(psa_storage_uid_t uid,
  */
 psa_status_t ps_object_table_get_free_fid(uint32_t fid_num, uint32_t *p_fid);
 
+/**
+ * \brief Opens a batch of commits of the object table, if none is open, before
+ *        new IVs are issued for an object.
+ *
+ * \details With PS_NV_COUNTER_BATCH_SIZE above 1, PS NV counter 1 is
+ *          incremented and the IVs are bound to its new value, so that the
+ *          IVs issued after a rollback within the current batch differ from
+ *          the ones issued before. Otherwise, this has no effect.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t ps_object_table_open_batch(void);
+
 #if PS_AES_KEY_USAGE_LIMIT != 0
 /**
  * \brief Get the generation number to use for key generation
@@ -151,6 +166,47 @@ psa_status_t ps_object_table_delete_object(psa_storage_uid_t uid,
  */
 psa_status_t ps_object_table_delete_old_table(void);
 
+/**
+ * \brief Gets the next object of an object table upgraded from the object
+ *        system version 1, whose object information is only stored in the
+ *        object header.
+ *
+ * \param[in,out] p_idx        Pointer to the table index to look from, 0 for
+ *                             the first object. It is set to the index
+ *                             following the object.
+ * \param[out]    p_uid        Pointer to the location to store the object UID
+ * \param[out]    p_client_id  Pointer to the location to store the client ID
+ *
+ * \return Returns PSA_SUCCESS if there is a next object. Otherwise, it
+ *         returns PSA_ERROR_DOES_NOT_EXIST, which is always the case when the
+ *         object table has not been upgraded.
+ */
+psa_status_t ps_object_table_get_upgraded_obj(uint32_t *p_idx,
+                                              psa_storage_uid_t *p_uid,
+                                              int32_t *p_client_id);
+
+/**
+ * \brief Sets the object table information, read from the object, of an
+ *        object of an upgraded object table, without storing the table.
+ *
+ * \param[in] uid           Identifier for the data.
+ * \param[in] client_id     Identifier of the asset’s owner (client)
+ * \param[in] obj_tbl_info  Pointer to the object table information, with the
+ *                          File ID of the object. NULL to remove the object
+ *                          from the table when it cannot be read.
+ */
+void ps_object_table_set_upgraded_obj(psa_storage_uid_t uid,
+                                      int32_t client_id,
+                                const struct ps_obj_table_info_t *obj_tbl_info);
+
+/**
+ * \brief Stores an upgraded object table, once the object information of all
+ *        its objects is set, and deletes the object table of version 1.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t ps_object_table_save_upgrade(void);
+
 #ifdef __cplusplus
 }
 #endif
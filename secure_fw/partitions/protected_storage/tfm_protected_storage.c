@@ -10,6 +10,7 @@
 #include "config_tfm.h"
 #include "config_ps_check.h"
 #include "tfm_protected_storage.h"
+#include "ps_object_cache.h"
 #include "ps_object_system.h"
 #include "tfm_ps_defs.h"
 #ifndef TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
@@ -155,3 +156,16 @@ uint32_t tfm_ps_get_support(void)
 
     return 0;
 }
+
+psa_status_t tfm_ps_get_cache_stats(struct tfm_ps_cache_stats_t *p_stats)
+{
+#if PS_OBJECT_CACHE_SIZE != 0
+    ps_object_cache_get_stats(p_stats);
+
+    return PSA_SUCCESS;
+#else
+    (void)p_stats;
+
+    return PSA_ERROR_NOT_SUPPORTED;
+#endif
+}
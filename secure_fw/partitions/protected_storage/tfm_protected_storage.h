@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 #include "psa/protected_storage.h"
+#include "tfm_ps_api.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -173,6 +174,18 @@ psa_status_t tfm_ps_remove(int32_t client_id, psa_storage_uid_t uid);
  */
 uint32_t tfm_ps_get_support(void);
 
+/**
+ * \brief Gets the counters of the PS object cache.
+ *
+ * \param[out] p_stats  Counters of the cache
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS              The operation completed successfully
+ * \retval PSA_ERROR_NOT_SUPPORTED  The cache is not enabled
+ */
+psa_status_t tfm_ps_get_cache_stats(struct tfm_ps_cache_stats_t *p_stats);
+
 #ifdef __cplusplus
 }
 #endif
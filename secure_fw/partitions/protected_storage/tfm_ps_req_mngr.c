@@ -136,6 +136,32 @@ static psa_status_t tfm_ps_get_support_req(const psa_msg_t *msg)
     return PSA_SUCCESS;
 }
 
+static psa_status_t tfm_ps_get_cache_stats_req(const psa_msg_t *msg)
+{
+    struct tfm_ps_cache_stats_t stats;
+    psa_status_t status;
+
+    /* The counters reveal the reads of all the clients, so they are only
+     * given to secure partitions
+     */
+    if (msg->client_id < 0) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    if (msg->out_size[0] != sizeof(stats)) {
+        /* The output argument size is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    status = tfm_ps_get_cache_stats(&stats);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    psa_write(msg->handle, 0, &stats, sizeof(stats));
+    return PSA_SUCCESS;
+}
+
 psa_status_t tfm_protected_storage_service_sfn(const psa_msg_t *msg)
 {
     p_msg = msg;
@@ -151,6 +177,8 @@ psa_status_t tfm_protected_storage_service_sfn(const psa_msg_t *msg)
         return tfm_ps_remove_req(msg);
     case TFM_PS_GET_SUPPORT:
         return tfm_ps_get_support_req(msg);
+    case TFM_PS_GET_CACHE_STATS:
+        return tfm_ps_get_cache_stats_req(msg);
     default:
         return PSA_ERROR_PROGRAMMER_ERROR;
     }